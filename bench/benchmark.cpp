@@ -1,9 +1,31 @@
 #include "benchmark.hpp"
 #include "kvstore/core/store.hpp"
 #include "kvstore/core/disk_store.hpp"
+#include "kvstore/core/disk_store_builder.hpp"
+#include "kvstore/core/lsm_store.hpp"
+#include "kvstore/core/btree_store.hpp"
+#include "kvstore/core/mmap_store.hpp"
+#include "kvstore/core/tiered_store.hpp"
+#include "kvstore/net/binary_protocol.hpp"
+#include "kvstore/net/text_protocol.hpp"
 #include "kvstore/net/server/server.hpp"
+#include "kvstore/net/server/uring_loop.hpp"
+#include "kvstore/net/client/async_client.hpp"
 #include "kvstore/net/client/client.hpp"
+#include "kvstore/net/client/connection_pool.hpp"
+#include "kvstore/net/client/pipeline.hpp"
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/io_engine.hpp"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <filesystem>
 #include <iostream>
 #include <thread>
@@ -81,28 +103,722 @@ void bench_store(core::IStore& store, const std::string& store_name, size_t ops)
     std::cout << std::endl;
 }
 
+//=========================================================================================
+// disk store index modes
+// =========================================================================================
+// same workload against the full in-memory key index and the compact hash -> offset table.
+// the interesting number is index memory per key; gets show what verifying keys on disk costs
+void bench_disk_index_modes(size_t ops) {
+    print_header("DiskStore index modes");
+
+    const std::pair<core::IndexMode, std::string> modes[] = {
+        {core::IndexMode::Full, "full"},
+        {core::IndexMode::Compact, "compact"},
+    };
+
+    for (const auto& [mode, mode_name] : modes) {
+        auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_index";
+        std::filesystem::remove_all(temp_dir);
+        {
+            core::DiskStoreOptions opts;
+            opts.data_dir = temp_dir;
+            opts.index_mode = mode;
+            core::DiskStore store(opts);
+
+            DataSet data(ops, 16, 64);
+            size_t i = 0;
+            Benchmark("put index=" + mode_name)
+                .run_throughput(ops, [&]() {
+                    store.put(data.key(i), data.value(i));
+                    ++i;
+                })
+                .print();
+            i = 0;
+            Benchmark("get index=" + mode_name)
+                .run_throughput(ops, [&]() {
+                    (void)store.get(data.key(i % ops));
+                    ++i;
+                })
+                .print();
+            std::cout << "  index memory: " << store.index_memory_usage() / ops
+                      << " bytes/key\n";
+        }
+        std::filesystem::remove_all(temp_dir);
+    }
+
+    std::cout << std::endl;
+}
+
+//=========================================================================================
+// disk store key-value separation
+// =========================================================================================
+// 4KB values, every key written twice, then a compaction. with the values in the blob log the
+// compaction only copies pointer records; reclaiming the overwritten values is the GC's job
+void bench_disk_blob_separation(size_t ops) {
+    print_header("DiskStore key-value separation");
+
+    const std::pair<std::size_t, std::string> modes[] = {
+        {0, "inline"},
+        {1024, "blob"},
+    };
+
+    for (const auto& [threshold, mode_name] : modes) {
+        auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_blob";
+        std::filesystem::remove_all(temp_dir);
+        {
+            core::DiskStoreOptions opts;
+            opts.data_dir = temp_dir;
+            opts.blob_threshold = threshold;
+            opts.compaction_threshold = ops * 2;  // only the explicit compaction below
+            opts.blob_segment_size = 1024 * 1024;  // small enough that GC has sealed segments
+            opts.blob_gc_interval = util::Duration(0);
+            core::DiskStore store(opts);
+
+            DataSet data(ops, 16, 4096);
+            size_t i = 0;
+            Benchmark("put 4KB values=" + mode_name)
+                .run_throughput(ops, [&]() {
+                    store.put(data.key(i), data.value(i));
+                    ++i;
+                })
+                .print();
+            for (size_t j = 0; j < ops; ++j) {
+                store.put(data.key(j), data.value(j));
+            }
+            Benchmark("compact values=" + mode_name)
+                .run_throughput(1, [&]() { store.compact(); })
+                .print();
+            Benchmark("blob gc values=" + mode_name)
+                .run_throughput(1, [&]() { (void)store.collect_blob_garbage(); })
+                .print();
+        }
+        std::filesystem::remove_all(temp_dir);
+    }
+
+    std::cout << std::endl;
+}
+
+//=========================================================================================
+// I/O backends
+// =========================================================================================
+// random 4KB reads, one op per call vs batches of 32, then DiskStore get vs multi_get on top.
+// the file is in the page cache, so this measures per-op overhead (syscalls, copies) - on a cold
+// SSD the io_uring batches also overlap the device latency
+void bench_io_backends(size_t ops) {
+    print_header("I/O backends (sync vs io_uring)");
+
+    auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_io";
+    std::filesystem::remove_all(temp_dir);
+    std::filesystem::create_directories(temp_dir);
+
+    constexpr size_t kBlock = 4096;
+    constexpr size_t kBlocks = 4096;  // 16MB
+    {
+        int fd = util::open_file(temp_dir / "blocks");
+        std::string block(kBlock, 'x');
+        for (size_t i = 0; i < kBlocks; ++i) {
+            util::pwrite_all(fd, block.data(), block.size(), i * kBlock);
+        }
+
+        std::vector<util::IoBackend> backends{util::IoBackend::Sync};
+        if (util::io_uring_available()) {
+            backends.push_back(util::IoBackend::IoUring);
+        }
+        RandomGenerator rng(7);
+        std::vector<uint64_t> offsets(ops);
+        for (auto& offset : offsets) {
+            offset = rng.uniform(0, kBlocks - 1) * kBlock;
+        }
+
+        for (auto backend : backends) {
+            auto engine = util::make_io_engine(backend);
+            engine->register_file(fd);
+            std::string name(util::to_string(backend));
+            for (size_t batch_size : {size_t{1}, size_t{32}}) {
+                std::vector<std::string> buffers(batch_size, std::string(kBlock, '\0'));
+                std::vector<util::IoOp> batch(batch_size);
+                size_t i = 0;
+                Benchmark("read 4KB " + name + " batch=" + std::to_string(batch_size))
+                    .run_throughput(ops / batch_size, [&]() {
+                        for (size_t j = 0; j < batch_size; ++j, ++i) {
+                            batch[j] = {util::IoOp::Kind::Read, fd, buffers[j].data(), kBlock,
+                                        offsets[i % ops]};
+                        }
+                        engine->run(batch);
+                    })
+                    .print();
+            }
+            engine->unregister_file(fd);
+        }
+        ::close(fd);
+        std::filesystem::remove_all(temp_dir);
+
+        for (auto backend : backends) {
+            core::DiskStoreOptions opts;
+            opts.data_dir = temp_dir;
+            opts.io_backend = backend;
+            core::DiskStore store(opts);
+            std::string name(util::to_string(backend));
+
+            DataSet data(ops, 16, 1024);
+            for (size_t i = 0; i < ops; ++i) {
+                store.put(data.key(i), data.value(i));
+            }
+            std::vector<std::string_view> keys;
+            for (size_t i = 0; i < 32; ++i) {
+                keys.push_back(data.key(i));
+            }
+            size_t i = 0;
+            Benchmark("get " + name)
+                .run_throughput(ops, [&]() {
+                    (void)store.get(data.key(i % ops));
+                    ++i;
+                })
+                .print();
+            Benchmark("multi_get x32 " + name)
+                .run_throughput(ops / 32, [&]() {
+                    for (auto& key : keys) {
+                        key = data.key(i++ % ops);
+                    }
+                    (void)store.multi_get(keys);
+                })
+                .print();
+            Benchmark("compact " + name)
+                .run_throughput(1, [&]() { store.compact(); })
+                .print();
+        }
+    }
+    std::filesystem::remove_all(temp_dir);
+
+    std::cout << std::endl;
+}
+
+//=========================================================================================
+// disk store value cache
+// =========================================================================================
+// zipf-like skew: 60% of the gets go to the hottest 1% of keys, the rest spread over all of them.
+// buffered misses are page cache hits, direct ones go to the device - where a hit saves the most
+void bench_disk_value_cache(size_t ops) {
+    print_header("DiskStore value cache");
+
+    struct Mode {
+        bool direct;
+        std::size_t cache_bytes;
+        std::string name;
+    };
+    const Mode modes[] = {
+        {false, 0, "buffered off"},
+        {false, 16 * 1024 * 1024, "buffered 16MB"},
+        {false, 64 * 1024 * 1024, "buffered 64MB"},
+        {true, 0, "direct off"},
+        {true, 16 * 1024 * 1024, "direct 16MB"},
+    };
+
+    for (const auto& [direct, cache_bytes, mode_name] : modes) {
+        auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_value_cache";
+        std::filesystem::remove_all(temp_dir);
+        {
+            core::DiskStoreOptions opts;
+            opts.data_dir = temp_dir;
+            opts.value_cache_bytes = cache_bytes;
+            opts.direct_io = direct;
+            opts.block_cache_bytes = 0;  // only the value cache in front of the device
+            core::DiskStore store(opts);
+
+            DataSet data(ops, 16, 256);
+            for (size_t i = 0; i < ops; ++i) {
+                store.put(data.key(i), data.value(i));
+            }
+            RandomGenerator rng(13);
+            std::vector<size_t> picks(ops);
+            for (auto& pick : picks) {
+                bool hot = rng.uniform_real() < 0.6;
+                pick = hot ? rng.uniform(0, ops / 100) : rng.uniform(0, ops - 1);
+            }
+            // one untimed pass first - the number of interest is the warm cache, not its fill
+            for (size_t pick : picks) {
+                (void)store.get(data.key(pick));
+            }
+            size_t i = 0;
+            Benchmark("get skewed " + mode_name)
+                .run_throughput(ops, [&]() {
+                    (void)store.get(data.key(picks[i++ % ops]));
+                })
+                .print();
+            if (cache_bytes > 0) {
+                std::cout << "  value cache hit ratio: " << store.value_cache_stats().hit_ratio()
+                          << std::endl;
+            }
+        }
+        std::filesystem::remove_all(temp_dir);
+    }
+
+    std::cout << std::endl;
+}
+
+//=========================================================================================
+// tiered store
+// =========================================================================================
+// the same skewed gets as above, plus a 90/10 read/write mix - every write drops the key from
+// the hot tier, so the mix shows what invalidation costs
+void bench_tiered_store(size_t ops) {
+    print_header("TieredStore (hot tier over DiskStore)");
+
+    auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_tiered";
+    DataSet data(ops, 16, 256);
+    RandomGenerator rng(17);
+    std::vector<size_t> picks(ops);
+    for (auto& pick : picks) {
+        bool hot = rng.uniform_real() < 0.6;
+        pick = hot ? rng.uniform(0, ops / 100) : rng.uniform(0, ops - 1);
+    }
+
+    for (std::size_t hot_bytes : {std::size_t{0}, std::size_t{16 * 1024 * 1024}}) {
+        std::filesystem::remove_all(temp_dir);
+        {
+            core::DiskStoreOptions disk_opts;
+            disk_opts.data_dir = temp_dir;
+            std::unique_ptr<core::IStore> store;
+            core::TieredStore* tiered = nullptr;
+            std::string name;
+            if (hot_bytes == 0) {
+                store = std::make_unique<core::DiskStore>(disk_opts);
+                name = "disk only";
+            } else {
+                core::TieredStoreOptions opts;
+                opts.disk = disk_opts;
+                opts.hot_tier_bytes = hot_bytes;
+                auto tiered_store = std::make_unique<core::TieredStore>(opts);
+                tiered = tiered_store.get();
+                store = std::move(tiered_store);
+                name = "tiered 16MB";
+            }
+            for (size_t i = 0; i < ops; ++i) {
+                store->put(data.key(i), data.value(i));
+            }
+            for (size_t pick : picks) {
+                (void)store->get(data.key(pick));
+            }
+
+            size_t i = 0;
+            Benchmark("get skewed " + name)
+                .run_throughput(ops, [&]() {
+                    (void)store->get(data.key(picks[i++ % ops]));
+                })
+                .print();
+            i = 0;
+            Benchmark("mixed 90/10 " + name)
+                .run_throughput(ops, [&]() {
+                    size_t pick = picks[i % ops];
+                    if (i++ % 10 == 0) {
+                        store->put(data.key(pick), data.value(pick));
+                    } else {
+                        (void)store->get(data.key(pick));
+                    }
+                })
+                .print();
+            if (tiered != nullptr) {
+                std::cout << "  hot tier hit ratio: " << tiered->stats().hot_hit_ratio()
+                          << std::endl;
+            }
+        }
+        std::filesystem::remove_all(temp_dir);
+    }
+
+    std::cout << std::endl;
+}
+
+// hot hits only, from several threads: every get is served from memory, so what is left is the
+// hot tier's locking. one shard is one store-wide lock - the baseline the sharding is measured
+// against
+void bench_tiered_store_threads(size_t ops) {
+    print_header("TieredStore hot reads (threads)");
+
+    auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_tiered_mt";
+    size_t hot_keys = std::max<size_t>(ops / 100, 1);
+    DataSet data(hot_keys, 16, 256);
+
+    for (std::size_t shards : {std::size_t{1}, std::size_t{16}}) {
+        std::filesystem::remove_all(temp_dir);
+        {
+            core::TieredStoreOptions opts;
+            opts.disk.data_dir = temp_dir;
+            opts.hot_tier_bytes = 16 * 1024 * 1024;
+            opts.hot_tier_shards = shards;
+            core::TieredStore store(opts);
+            for (size_t i = 0; i < hot_keys; ++i) {
+                store.put(data.key(i), data.value(i));
+                (void)store.get(data.key(i));  // promoted
+            }
+
+            for (size_t num_threads : {1, 4, 8}) {
+                size_t ops_per_thread = ops / num_threads;
+                std::vector<std::thread> threads;
+                auto start = Clock::now();
+                for (size_t t = 0; t < num_threads; ++t) {
+                    threads.emplace_back([&, t]() {
+                        RandomGenerator rng(static_cast<uint32_t>(t + 1));
+                        for (size_t i = 0; i < ops_per_thread; ++i) {
+                            (void)store.get(data.key(rng.uniform(0, hot_keys - 1)));
+                        }
+                    });
+                }
+                for (auto& th : threads) {
+                    th.join();
+                }
+                double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                MultiThreadResult{"get hot shards=" + std::to_string(shards), num_threads,
+                                  ops_per_thread * num_threads, seconds}
+                    .print();
+            }
+            std::cout << "  hot tier hit ratio: " << store.stats().hot_hit_ratio() << std::endl;
+        }
+        std::filesystem::remove_all(temp_dir);
+    }
+
+    std::cout << std::endl;
+}
+
+//=========================================================================================
+// disk store direct I/O
+// =========================================================================================
+// skewed gets (90% to the hottest 10% of keys). buffered reads hit the page cache; direct reads
+// only hit the in-process block cache, so its size decides how often a get goes to the device
+void bench_disk_direct_io(size_t ops) {
+    print_header("DiskStore direct I/O + block cache");
+
+    struct Mode {
+        bool direct;
+        std::size_t cache_bytes;
+        std::string name;
+    };
+    const Mode modes[] = {
+        {false, 0, "buffered"},
+        {true, 0, "direct no-cache"},
+        {true, 64 * 1024 * 1024, "direct cache=64MB"},
+    };
+
+    for (const auto& mode : modes) {
+        auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_direct";
+        std::filesystem::remove_all(temp_dir);
+        {
+            core::DiskStoreOptions opts;
+            opts.data_dir = temp_dir;
+            opts.direct_io = mode.direct;
+            opts.block_cache_bytes = mode.cache_bytes;
+            core::DiskStore store(opts);
+
+            DataSet data(ops, 16, 512);
+            for (size_t i = 0; i < ops; ++i) {
+                store.put(data.key(i), data.value(i));
+            }
+            RandomGenerator rng(11);
+            std::vector<size_t> picks(ops);
+            for (auto& pick : picks) {
+                pick = rng.uniform_real() < 0.9 ? rng.uniform(0, ops / 10) : rng.uniform(0, ops - 1);
+            }
+            size_t i = 0;
+            Benchmark("get skewed " + mode.name)
+                .run_throughput(ops, [&]() {
+                    (void)store.get(data.key(picks[i++ % ops]));
+                })
+                .print();
+            if (mode.direct && mode.cache_bytes > 0) {
+                std::cout << "  block cache hit ratio: " << store.block_cache_stats().hit_ratio()
+                          << std::endl;
+            }
+        }
+        std::filesystem::remove_all(temp_dir);
+    }
+
+    std::cout << std::endl;
+}
+
+//=========================================================================================
+// disk store durability modes
+// =========================================================================================
+// concurrent writers are where group commit pays off: with N threads one leader writes (and
+// syncs) everybody's records at once, so always-mode throughput should scale with threads
+void bench_disk_sync_modes(size_t ops) {
+    print_header("DiskStore sync modes (group commit)");
+
+    const std::pair<core::SyncMode, std::string> modes[] = {
+        {core::SyncMode::Always, "always"},
+        {core::SyncMode::Batch, "batch"},
+        {core::SyncMode::Os, "os"},
+    };
+
+    for (const auto& [mode, mode_name] : modes) {
+        for (size_t num_threads : {1, 4, 8}) {
+            auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_sync";
+            std::filesystem::remove_all(temp_dir);
+
+            core::DiskStoreOptions opts;
+            opts.data_dir = temp_dir;
+            opts.sync_mode = mode;
+            opts.use_hint_file = false;
+            core::DiskStore store(opts);
+
+            DataSet data(ops, 16, 64);
+            size_t ops_per_thread = ops / num_threads;
+
+            std::vector<std::thread> threads;
+            auto start = Clock::now();
+            for (size_t t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&, t]() {
+                    for (size_t i = 0; i < ops_per_thread; ++i) {
+                        size_t k = t * ops_per_thread + i;
+                        store.put(data.key(k), data.value(k));
+                    }
+                });
+            }
+            for (auto& th : threads) {
+                th.join();
+            }
+            auto end = Clock::now();
+
+            double seconds = std::chrono::duration<double>(end - start).count();
+            MultiThreadResult{"put sync=" + mode_name, num_threads, ops_per_thread * num_threads,
+                              seconds}
+                .print();
+
+            std::filesystem::remove_all(temp_dir);
+        }
+    }
+    std::cout << std::endl;
+}
+
+// seeding an empty store: a put() per entry vs DiskStoreBuilder writing the compacted file
+void bench_disk_bulk_ingest(size_t ops) {
+    print_header("DiskStore bulk ingest");
+
+    auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_ingest";
+    DataSet data(ops, 16, 100);
+
+    std::filesystem::remove_all(temp_dir);
+    {
+        core::DiskStoreOptions opts;
+        opts.data_dir = temp_dir;
+        opts.sync_mode = core::SyncMode::Os;
+        core::DiskStore store(opts);
+        auto start = Clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            store.put(data.key(i), data.value(i));
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        MultiThreadResult{"put() loop sync=os", 1, ops, seconds}.print();
+    }
+
+    std::vector<size_t> thread_counts = {1};
+    if (std::thread::hardware_concurrency() > 1) {
+        thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+    for (size_t num_threads : thread_counts) {
+        std::filesystem::remove_all(temp_dir);
+        core::DiskStoreBuilderOptions opts;
+        opts.output_dir = temp_dir;
+        opts.threads = num_threads;
+        auto start = Clock::now();
+        core::DiskStoreBuilder builder(opts);
+        for (size_t i = 0; i < ops; ++i) {
+            builder.add(data.key(i), data.value(i));
+        }
+        (void)builder.finish();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        MultiThreadResult{"DiskStoreBuilder", num_threads, ops, seconds}.print();
+    }
+
+    std::filesystem::remove_all(temp_dir);
+    std::cout << std::endl;
+}
+
+//=========================================================================================
+// restart time
+// =========================================================================================
+// time to reopen a store of ops keys: DiskStore rebuilds its index from the hint file or by
+// scanning the data file, the mmap store only maps its file. the first gets after the open pay for whatever has to be faulted in
+void bench_restart_time(size_t ops) {
+    print_header("Restart time");
+
+    auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_restart";
+    DataSet data(ops, 16, 100);
+
+    auto report = [&](const std::string& name, auto open) {
+        auto start = Clock::now();
+        auto store = open();
+        double open_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        start = Clock::now();
+        for (size_t i = 0; i < 1000; ++i) {
+            (void)store->get(data.key(i * 7919 % ops));
+        }
+        double get_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::cout << "  " << name << ": open " << open_ms << " ms, first 1000 gets " << get_ms
+                  << " ms (" << store->size() << " keys)\n";
+    };
+
+    std::filesystem::remove_all(temp_dir);
+    {
+        core::DiskStoreOptions opts;
+        opts.data_dir = temp_dir;
+        opts.sync_mode = core::SyncMode::Os;
+        {
+            core::DiskStore store(opts);
+            for (size_t i = 0; i < ops; ++i) {
+                store.put(data.key(i), data.value(i));
+            }
+        }
+        report("DiskStore (hint file)", [&] { return std::make_unique<core::DiskStore>(opts); });
+        opts.use_hint_file = false;
+        report("DiskStore (data file scan)",
+               [&] { return std::make_unique<core::DiskStore>(opts); });
+    }
+
+    std::filesystem::remove_all(temp_dir);
+    {
+        core::MmapStoreOptions opts;
+        opts.data_dir = temp_dir;
+        opts.sync_mode = core::SyncMode::Os;
+        {
+            core::MmapStore store(opts);
+            for (size_t i = 0; i < ops; ++i) {
+                store.put(data.key(i), data.value(i));
+            }
+        }
+        report("MmapStore", [&] { return std::make_unique<core::MmapStore>(opts); });
+    }
+
+    std::filesystem::remove_all(temp_dir);
+    std::cout << std::endl;
+}
+
+// the client's own socket calls per op since before (Client::syscalls) - a line under the
+// throughput line of the same run
+void print_client_syscalls(const net::client::Client& client, uint64_t before, size_t ops) {
+    std::cout << "  client syscalls/op=" << std::fixed << std::setprecision(2)
+              << static_cast<double>(client.syscalls() - before) / static_cast<double>(ops)
+              << std::endl;
+}
+
+//=========================================================================================
+// large values over the network
+// =========================================================================================
+// 1MB GETs from a DiskStore-backed server: copied through a std::string and the encoded response,
+// or sent from the data file with sendfile (ServerOptions::sendfile_threshold)
+void bench_network_large_values(size_t ops, bool use_binary) {
+    print_header("Network 1MB GET from DiskStore (" +
+                 std::string(use_binary ? "binary" : "text") + ")");
+
+    auto temp_dir = std::filesystem::temp_directory_path() / "kvstore_bench_sendfile";
+    std::filesystem::remove_all(temp_dir);
+    {
+        core::DiskStoreOptions store_opts;
+        store_opts.data_dir = temp_dir;
+        core::DiskStore store(store_opts);
+        const std::string value(1024 * 1024, 'v');
+        for (int i = 0; i < 16; ++i) {
+            store.put("large" + std::to_string(i), value);
+        }
+
+        for (std::size_t threshold : {std::size_t{0}, std::size_t{64 * 1024}}) {
+            net::server::ServerOptions server_opts;
+            server_opts.port = 0;
+            server_opts.sendfile_threshold = threshold;
+            net::server::Server server(store, server_opts);
+            server.start();
+
+            net::client::ClientOptions client_opts;
+            client_opts.port = server.port();
+            client_opts.binary = use_binary;
+            net::client::Client client(client_opts);
+            client.connect();
+
+            size_t i = 0;
+            uint64_t before = client.syscalls();
+            Benchmark(threshold == 0 ? "get 1MB copy" : "get 1MB sendfile")
+                .run_throughput(ops, [&]() {
+                    (void)client.get("large" + std::to_string(i++ % 16));
+                })
+                .print();
+            print_client_syscalls(client, before, ops);
+            client.disconnect();
+            server.stop();
+        }
+    }
+    std::filesystem::remove_all(temp_dir);
+    std::cout << std::endl;
+}
+
 //=========================================================================================
 // network benchmarks
 // =========================================================================================
+// decoding alone, no sockets: a request copied out into a Request vs a RequestView pointing into
+// the bytes - what the server does per request
+void bench_request_decoding(size_t ops) {
+    print_header("Request decoding (PUT key=16, val=64)");
+    DataSet data(1000, 16, 64);
+    std::vector<std::string> text_lines;
+    std::vector<std::vector<uint8_t>> binary_messages;
+    for (size_t i = 0; i < data.size(); ++i) {
+        net::Request req{net::Command::Put, data.key(i), data.value(i), 0};
+        std::string line = net::TextProtocol::encode_request(req);
+        line.pop_back();  // the server hands the parser a line without its newline
+        text_lines.push_back(std::move(line));
+        binary_messages.push_back(net::BinaryProtocol::encode_request(req));
+    }
+
+    size_t checksum = 0;  // keeps the decodes from being optimized away
+    size_t i = 0;
+    Benchmark("text copy").run_throughput(ops, [&]() {
+        checksum += net::TextProtocol::decode_request(text_lines[i++ % text_lines.size()])
+                        .value.size();
+    }).print();
+    i = 0;
+    Benchmark("text view").run_throughput(ops, [&]() {
+        checksum += net::TextProtocol::decode_request_view(text_lines[i++ % text_lines.size()])
+                        .value.size();
+    }).print();
+    i = 0;
+    size_t consumed = 0;
+    Benchmark("binary copy").run_throughput(ops, [&]() {
+        const auto& msg = binary_messages[i++ % binary_messages.size()];
+        checksum += net::BinaryProtocol::decode_request(msg.data(), msg.size(), consumed)
+                        ->value.size();
+    }).print();
+    i = 0;
+    Benchmark("binary view").run_throughput(ops, [&]() {
+        const auto& msg = binary_messages[i++ % binary_messages.size()];
+        checksum += net::BinaryProtocol::decode_request_view(msg.data(), msg.size(), consumed)
+                        ->value.size();
+    }).print();
+    if (checksum == 0) {
+        std::cout << "(no values decoded)" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
 void bench_network_throughput(net::client::Client& client, core::Store& store, size_t ops) {
     // PING
+    uint64_t before = client.syscalls();
     Benchmark("ping")
         .run_throughput(ops, [&](){
             (void) client.ping();
         })
         .print();
+    print_client_syscalls(client, before, ops);
 
     // PUT small
     {
         DataSet data(ops, 16, 64);
         size_t i = 0;
         store.clear();
+        uint64_t before = client.syscalls();
         Benchmark("put (key=16, val=64)")
             .run_throughput(ops, [&]() { 
                 client.put(data.key(i), data.value(i)); 
                 ++i; 
             })
             .print();
+        print_client_syscalls(client, before, ops);
     }
 
     // PUT large
@@ -110,12 +826,14 @@ void bench_network_throughput(net::client::Client& client, core::Store& store, s
         DataSet data(ops, 16, 1024);
         size_t i = 0;
         store.clear();
+        uint64_t before = client.syscalls();
         Benchmark("put (key=16, val=1024)")
             .run_throughput(ops, [&]() { 
                 client.put(data.key(i), data.value(i)); 
                 ++i; 
             })
             .print();
+        print_client_syscalls(client, before, ops);
     }
 
     // GET
@@ -125,15 +843,95 @@ void bench_network_throughput(net::client::Client& client, core::Store& store, s
             client.put("key" + std::to_string(i), "value" + std::to_string(i));
         }
         size_t i = 0;
+        uint64_t before = client.syscalls();
         Benchmark("get")
             .run_throughput(ops, [&]() { 
                 (void) client.get("key" + std::to_string(i % 1000)); 
                 ++i; 
             })
             .print();
+        print_client_syscalls(client, before, ops);
+    }
+}
+
+// the same calls through client::Pipeline, depth calls per execute(): the round trip is paid once
+// per batch. ops and latency are per call, not per batch
+void bench_network_pipeline(net::client::Client& client, core::Store& store, size_t ops) {
+    DataSet data(ops, 16, 64);
+    net::client::Pipeline pipeline(client);
+    for (size_t depth : {size_t{1}, size_t{16}, size_t{128}}) {
+        size_t batches = std::max<size_t>(ops / depth, 1);
+        size_t calls = batches * depth;
+        size_t i = 0;
+        store.clear();
+        uint64_t before = client.syscalls();
+        auto puts = Benchmark("").run_throughput(batches, [&]() {
+            for (size_t d = 0; d < depth; ++d, ++i) {
+                pipeline.put(data.key(i % ops), data.value(i % ops));
+            }
+            (void)pipeline.execute();
+        });
+        ThroughputResult{"pipelined put depth=" + std::to_string(depth), calls, puts.total_seconds}
+            .print();
+        print_client_syscalls(client, before, calls);
+
+        i = 0;
+        before = client.syscalls();
+        auto gets = Benchmark("").run_throughput(batches, [&]() {
+            for (size_t d = 0; d < depth; ++d, ++i) {
+                pipeline.get(data.key(i % ops));
+            }
+            (void)pipeline.execute();
+        });
+        ThroughputResult{"pipelined get depth=" + std::to_string(depth), calls, gets.total_seconds}
+            .print();
+        print_client_syscalls(client, before, calls);
     }
 }
 
+// one thread keeping up to `concurrency` calls in flight through client::AsyncClient (4
+// connections): a call is made as soon as the oldest one answered. the time includes waiting for
+// the last calls
+void bench_async_client(uint16_t port, core::Store& store, size_t ops, bool use_binary) {
+    DataSet data(ops, 16, 64);
+    net::client::AsyncClientOptions opts;
+    opts.port = port;
+    opts.binary = use_binary;
+    net::client::AsyncClient client(opts);
+    client.connect();
+
+    auto run = [&](const std::string& name, size_t concurrency, auto call) {
+        std::deque<decltype(call(size_t{0}))> window;
+        uint64_t before = client.syscalls();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            if (window.size() == concurrency) {
+                window.front().get();
+                window.pop_front();
+            }
+            window.push_back(call(i));
+        }
+        for (auto& future : window) {
+            future.get();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        ThroughputResult{name + " concurrency=" + std::to_string(concurrency), ops,
+                         elapsed.count()}
+            .print();
+        std::cout << "  client syscalls/op=" << std::fixed << std::setprecision(2)
+                  << static_cast<double>(client.syscalls() - before) / static_cast<double>(ops)
+                  << std::endl;
+    };
+
+    for (size_t concurrency : {size_t{1}, size_t{64}, size_t{1024}}) {
+        store.clear();
+        run("async put", concurrency,
+            [&](size_t i) { return client.put(data.key(i), data.value(i)); });
+        run("async get", concurrency, [&](size_t i) { return client.get(data.key(i)); });
+    }
+    client.disconnect();
+}
+
 void bench_network_latency(net::client::Client& client, core::Store& store, size_t ops) {
     // PING
     Benchmark("ping")
@@ -278,6 +1076,224 @@ void bench_multithread_scaling(
     }
 }
 
+//=========================================================================================
+// server modes
+// =========================================================================================
+// raises the soft fd limit as far as the hard one goes, returns it
+size_t raise_fd_limit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return 1024;
+    }
+    if (limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    return static_cast<size_t>(limit.rlim_cur);
+}
+
+// blocking text-protocol socket to the server, -1 on failure
+int connect_raw(uint16_t port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// count response lines, each a short "OK ...". nothing else is in flight on the socket, so
+// whatever arrives belongs to these
+bool read_responses(int sock, size_t count) {
+    char buf[4096];
+    size_t lines = 0;
+    while (lines < count) {
+        ssize_t n = recv(sock, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        lines += static_cast<size_t>(std::count(buf, buf + n, '\n'));
+    }
+    return true;
+}
+
+// thread per connection vs the epoll event loop vs the io_uring one with 100, 1k and 10k open
+// connections. a few driver threads each own a slice of the connections and go round it in waves:
+// depth GETs sent on every socket in one write, then every response read - so all connections
+// have requests in flight at once. "threads" is what the server runs: one per connection, or the
+// reactors. syscalls/req is the server's own count (Server::stats), the clients' are not in it
+// threads sharing a client::ConnectionPool of 4 connections, one lease per GET: however many
+// threads there are, the server sees 4 connections. acquisition latency includes the waits for a
+// connection to come back
+void bench_connection_pool(net::server::Server& server, core::Store& store,
+                           size_t ops_per_thread, bool binary) {
+    DataSet data(ops_per_thread, 16, 64);
+    store.clear();
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+        store.put(data.key(i), data.value(i));
+    }
+
+    for (size_t threads : {1, 4, 16}) {
+        net::client::ConnectionPoolOptions opts;
+        opts.client.port = server.port();
+        opts.client.binary = binary;
+        opts.min_size = 4;
+        opts.max_size = 4;
+        net::client::ConnectionPool pool(opts);
+
+        auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = 0; i < ops_per_thread; ++i) {
+                    auto lease = pool.acquire();
+                    (void)lease->get(data.key(i));
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        auto stats = pool.stats();
+        MultiThreadResult{"pooled get", threads, threads * ops_per_thread, elapsed.count()}
+            .print();
+        std::cout << "  connections=" << stats.open << "  waits=" << stats.waits
+                  << "  acquire avg=" << std::fixed << std::setprecision(2)
+                  << static_cast<double>(stats.avg_acquire_time().count()) / 1000.0 << " us"
+                  << "  max=" << static_cast<double>(stats.max_acquire_time.count()) / 1000.0
+                  << " us" << std::endl;
+    }
+}
+
+void bench_server_modes(size_t ops) {
+    print_header("Server modes (text, GET, all connections busy)");
+
+    // each connection costs two fds in this process: the client end and the server end
+    size_t fd_limit = raise_fd_limit();
+    size_t max_conns = fd_limit > 128 ? (fd_limit - 128) / 2 : 0;
+
+    core::Store store;
+    for (size_t i = 0; i < 1000; ++i) {
+        store.put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    const size_t drivers = 4;
+
+    std::vector<net::server::ServerMode> modes{net::server::ServerMode::ThreadPerConnection,
+                                               net::server::ServerMode::EventLoop};
+    if (net::server::UringLoop::supported()) {
+        modes.push_back(net::server::ServerMode::IoUring);
+    } else {
+        std::cout << "(io_uring networking not available, skipped)" << std::endl;
+    }
+
+    // {connections, pipeline depth}
+    for (auto [wanted, depth] : {std::pair<size_t, size_t>{100, 1},
+                                 {1000, 1},
+                                 {10000, 1},
+                                 {100, 16}}) {
+        size_t conns = std::min(wanted, max_conns);
+        if (conns < wanted) {
+            std::cout << "(" << wanted << " connections capped to " << conns
+                      << " by RLIMIT_NOFILE=" << fd_limit << ")" << std::endl;
+        }
+        if (conns < drivers) {
+            continue;
+        }
+        // at least a few waves even with 10k connections
+        size_t waves = std::max<size_t>(ops / (conns * depth), 3);
+
+        for (auto mode : modes) {
+            net::server::ServerOptions server_opts;
+            server_opts.port = 0;
+            server_opts.max_connections = conns + 16;
+            server_opts.mode = mode;
+            net::server::Server server(store, server_opts);
+            server.start();
+
+            std::vector<int> socks;
+            socks.reserve(conns);
+            for (size_t i = 0; i < conns; ++i) {
+                int sock = connect_raw(server.port());
+                if (sock < 0) {
+                    break;
+                }
+                socks.push_back(sock);
+            }
+            if (socks.size() < conns) {
+                std::cout << "only " << socks.size() << " of " << conns << " connections opened"
+                          << std::endl;
+            }
+
+            std::atomic<size_t> failed{0};
+            std::vector<std::thread> threads;
+            auto start = Clock::now();
+            for (size_t d = 0; d < drivers; ++d) {
+                threads.emplace_back([&, d]() {
+                    RandomGenerator rng;
+                    for (size_t w = 0; w < waves; ++w) {
+                        for (size_t i = d; i < socks.size(); i += drivers) {
+                            std::string msg;
+                            for (size_t r = 0; r < depth; ++r) {
+                                msg += "GET key" + std::to_string(rng.uniform(0, 999)) + "\n";
+                            }
+                            if (send(socks[i], msg.data(), msg.size(), MSG_NOSIGNAL) <= 0) {
+                                failed.fetch_add(depth);
+                            }
+                        }
+                        for (size_t i = d; i < socks.size(); i += drivers) {
+                            if (!read_responses(socks[i], depth)) {
+                                failed.fetch_add(depth);
+                            }
+                        }
+                    }
+                });
+            }
+            for (auto& th : threads) {
+                th.join();
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            bool per_conn = mode == net::server::ServerMode::ThreadPerConnection;
+            size_t server_threads =
+                per_conn ? socks.size() + 1 : std::max(1u, std::thread::hardware_concurrency());
+            std::string name = per_conn ? "thread per conn"
+                               : mode == net::server::ServerMode::EventLoop ? "event loop"
+                                                                             : "io_uring";
+            name += " conns=" + std::to_string(socks.size());
+            if (depth > 1) {
+                name += " depth=" + std::to_string(depth);
+            }
+            MultiThreadResult{name, server_threads, waves * socks.size() * depth, seconds}.print();
+            if (failed > 0) {
+                std::cout << "  " << failed << " requests failed" << std::endl;
+            }
+
+            for (int sock : socks) {
+                close(sock);
+            }
+            server.stop();
+            auto stats = server.stats();
+            if (stats.requests > 0) {
+                std::cout << "  syscalls/req=" << std::fixed << std::setprecision(2)
+                          << static_cast<double>(stats.syscalls) /
+                                 static_cast<double>(stats.requests)
+                          << std::endl;
+            }
+        }
+    }
+    std::cout << std::endl;
+}
+
 //=========================================================================================
 // protocol comparison
 // =========================================================================================
@@ -294,12 +1310,14 @@ void bench_protocol_comparison(net::server::Server& server, core::Store& store,
 
         store.clear();
         size_t i = 0;
+        uint64_t before = client.syscalls();
         Benchmark("text: put (key=16, val=64)")
             .run_throughput(ops, [&]() { 
                 client.put(data.key(i), data.value(i)); 
                 ++i; 
             })
             .print();
+        print_client_syscalls(client, before, ops);
 
         client.disconnect();
     }
@@ -314,12 +1332,14 @@ void bench_protocol_comparison(net::server::Server& server, core::Store& store,
 
         store.clear();
         size_t i = 0;
+        uint64_t before = client.syscalls();
         Benchmark("binary: put (key=16, val=64)")
             .run_throughput(ops, [&]() { 
                 client.put(data.key(i), data.value(i)); 
                 ++i; 
             })
             .print();
+        print_client_syscalls(client, before, ops);
 
         client.disconnect();
     }
@@ -357,7 +1377,7 @@ int main(int argc, char* argv[]) {
             std::cout << "Usage: " << argv[0] << " [options]\n"
                       << "Options:\n"
                       << "  --ops N           number of operatiosn (default: 100000)\n"
-                      << "  --no-disk         skip DiskStore benchmarks\n"
+                      << "  --no-disk         skip DiskStore/LsmStore/BTreeStore/MmapStore benchmarks\n"
                       << "  --no-network      skip network benchmarks\n"
                       << "  --no-latency      skip latency histogram benchmarks\n"
                       << "  --no-multithread  skip multi-threaded benchmarks\n"
@@ -391,10 +1411,64 @@ int main(int argc, char* argv[]) {
         bench_store(store, "DiskStore", ops/10);
         
         std::filesystem::remove_all(temp_dir);
+
+        bench_disk_index_modes(ops / 10);
+
+        bench_disk_blob_separation(ops / 100);
+
+        bench_io_backends(ops / 10);
+
+        bench_disk_direct_io(ops / 10);
+
+        bench_disk_value_cache(ops / 10);
+
+        bench_tiered_store(ops / 10);
+
+        bench_tiered_store_threads(ops);
+
+        // fdatasync per group is expensive on real disks - keep the op count modest
+        bench_disk_sync_modes(ops / 50);
+
+        bench_disk_bulk_ingest(ops);
+
+        // LSM store - same op count as DiskStore so the two are directly comparable
+        std::filesystem::remove_all(temp_dir);
+        std::filesystem::create_directories(temp_dir);
+        {
+            core::LsmStoreOptions lsm_opts;
+            lsm_opts.data_dir = temp_dir;
+            core::LsmStore lsm(lsm_opts);
+            bench_store(lsm, "LsmStore", ops/10);
+        }
+        std::filesystem::remove_all(temp_dir);
+
+        // B+tree store - same op count again; reads are page lookups through the buffer pool
+        std::filesystem::create_directories(temp_dir);
+        {
+            core::BTreeStoreOptions btree_opts;
+            btree_opts.data_dir = temp_dir;
+            core::BTreeStore btree(btree_opts);
+            bench_store(btree, "BTreeStore", ops/10);
+        }
+        std::filesystem::remove_all(temp_dir);
+
+        // mmap store - same op count; reads are probes into the mapped table
+        std::filesystem::create_directories(temp_dir);
+        {
+            core::MmapStoreOptions mmap_opts;
+            mmap_opts.data_dir = temp_dir;
+            core::MmapStore mmap_store(mmap_opts);
+            bench_store(mmap_store, "MmapStore", ops/10);
+        }
+        std::filesystem::remove_all(temp_dir);
+
+        bench_restart_time(ops);
     }
 
     // network benchmarks
     if(run_network) {
+        bench_request_decoding(ops * 10);
+
         core::Store store;
 
         net::server::ServerOptions server_opts;
@@ -414,6 +1488,16 @@ int main(int argc, char* argv[]) {
         print_header("Network throughput (" + protocol_name + ")");
         bench_network_throughput(client, store, ops);
         std::cout << std::endl;
+
+        print_header("Network pipelining (" + protocol_name + ")");
+        bench_network_pipeline(client, store, ops);
+        std::cout << std::endl;
+
+        print_header("Async client, one thread (" + protocol_name + ")");
+        bench_async_client(server.port(), store, ops, use_binary);
+        std::cout << std::endl;
+
+        bench_network_large_values(std::max<size_t>(ops / 1000, 100), use_binary);
     
         if(run_latency) {
             print_header("Network latency (" + protocol_name + ")");
@@ -428,6 +1512,10 @@ int main(int argc, char* argv[]) {
             print_header("Multi-threaded (" + protocol_name + ")");
             bench_multithread_scaling(server, store, ops/10, use_binary);
             std::cout << std::endl;
+
+            print_header("Connection pool (" + protocol_name + ")");
+            bench_connection_pool(server, store, ops / 10, use_binary);
+            std::cout << std::endl;
         }
 
         //protocol comparison
@@ -438,6 +1526,10 @@ int main(int argc, char* argv[]) {
         }
         
         server.stop();
+
+        if(run_multithread) {
+            bench_server_modes(ops);
+        }
     } 
 
     std::cout << "Benchmark complete" << std::endl;
@@ -0,0 +1,134 @@
+#include "kvstore/core/disk_store_builder.hpp"
+#include "kvstore/util/binary_io.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using kvstore::core::DiskStoreBuilder;
+using kvstore::core::DiskStoreBuilderOptions;
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " --output DIR [options]\n"
+              << "Builds a DiskStore data directory (data.kvds + data.hint) from a dataset.\n"
+              << "Options:\n"
+              << "  --input FILE      Input file, - for stdin (default: -)\n"
+              << "  --format FORMAT   tsv: key<TAB>value per line (default)\n"
+              << "                    binary: [u32 key len][key][u32 value len][value]...,\n"
+              << "                    little endian\n"
+              << "  --output DIR      Output directory, must not hold a data file yet\n"
+              << "  --threads N       Build threads (default: one per core)\n"
+              << "  --help            Show this help\n"
+              << "\n"
+              << "Later entries of a key win. A running server started with --ingest-dir DIR\n"
+              << "adopts the result on SIGHUP (DIR must be on the data directory's filesystem).\n";
+}
+
+// returns false on a malformed line
+bool read_tsv(std::istream& in, DiskStoreBuilder& builder) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        auto tab = line.find('\t');
+        if (tab == std::string::npos) {
+            std::cerr << "No tab in line: " << line.substr(0, 80) << std::endl;
+            return false;
+        }
+        std::string_view view(line);
+        builder.add(view.substr(0, tab), view.substr(tab + 1));
+    }
+    return true;
+}
+
+// returns false on a truncated record
+bool read_binary(std::istream& in, DiskStoreBuilder& builder) {
+    std::string key;
+    std::string value;
+    uint32_t key_len = 0;
+    while (kvstore::util::read_int<uint32_t>(in, key_len)) {
+        uint32_t value_len = 0;
+        key.resize(key_len);
+        if (!in.read(key.data(), key_len) ||
+            !kvstore::util::read_int<uint32_t>(in, value_len)) {
+            std::cerr << "Truncated record" << std::endl;
+            return false;
+        }
+        value.resize(value_len);
+        if (!in.read(value.data(), value_len)) {
+            std::cerr << "Truncated record" << std::endl;
+            return false;
+        }
+        builder.add(key, value);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    DiskStoreBuilderOptions opts;
+    std::string input = "-";
+    std::string format = "tsv";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--input" && i + 1 < argc) {
+            input = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            opts.output_dir = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            opts.threads = std::stoull(argv[++i]);
+        } else if (arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opts.output_dir.empty() || (format != "tsv" && format != "binary")) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::ifstream file;
+        if (input != "-") {
+            file.open(input, std::ios::binary);
+            if (!file) {
+                std::cerr << "Cannot open " << input << std::endl;
+                return 1;
+            }
+        }
+        std::istream& in = input == "-" ? std::cin : file;
+
+        auto start = std::chrono::steady_clock::now();
+        DiskStoreBuilder builder(opts);
+        bool ok = format == "tsv" ? read_tsv(in, builder) : read_binary(in, builder);
+        if (!ok) {
+            return 1;
+        }
+        auto read_done = std::chrono::steady_clock::now();
+        auto stats = builder.finish();
+        auto done = std::chrono::steady_clock::now();
+
+        auto ms = [](auto duration) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+        };
+        std::cout << "Wrote " << (opts.output_dir / "data.kvds").string() << ": " << stats.keys
+                  << " keys from " << stats.records << " records, " << stats.data_bytes
+                  << " bytes (read " << ms(read_done - start) << " ms, build "
+                  << ms(done - read_done) << " ms)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Ingest failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -2,11 +2,56 @@
 
 #include "kvstore/core/store.hpp"
 #include "kvstore/core/disk_store.hpp"
+#include "kvstore/core/lsm_store.hpp"
+#include "kvstore/core/btree_store.hpp"
+#include "kvstore/core/mmap_store.hpp"
+#include "kvstore/core/tiered_store.hpp"
 #include "kvstore/net/server/server.hpp"
 #include "kvstore/util/signal_handler.hpp"
 #include "kvstore/util/logger.hpp"
 #include "kvstore/util/config.hpp"
 
+//the disk store settings, also used for the tiered store's cold tier
+static kvstore::core::DiskStoreOptions disk_store_options(const kvstore::util::Config& config) {
+    kvstore::core::DiskStoreOptions opts;
+    opts.data_dir = config.data_dir;
+    opts.compaction_threshold = config.compaction_threshold;
+    if(config.compact_index) {
+        opts.index_mode = kvstore::core::IndexMode::Compact;
+    }
+    opts.blob_threshold = config.blob_threshold;
+    if(config.use_io_uring) {
+        opts.io_backend = kvstore::util::IoBackend::IoUring;
+    }
+    opts.direct_io = config.direct_io;
+    opts.block_cache_bytes = config.block_cache_mb * 1024 * 1024;
+    opts.value_cache_bytes = config.value_cache_mb * 1024 * 1024;
+    return opts;
+}
+
+//SIGHUP: swap in the data file kvstore-ingest built in ingest_dir. a failed adoption leaves the
+//store as it was and the server running
+static void adopt_ingested(const kvstore::util::Config& config, kvstore::core::IStore& store) {
+    if(config.ingest_dir.empty()) {
+        LOG_WARN("SIGHUP ignored: no ingest_dir configured");
+        return;
+    }
+    try {
+        if(auto* tiered = dynamic_cast<kvstore::core::TieredStore*>(&store)) {
+            tiered->adopt(config.ingest_dir);
+        } else if(auto* disk = dynamic_cast<kvstore::core::DiskStore*>(&store)) {
+            disk->adopt(config.ingest_dir);
+        } else {
+            LOG_WARN("SIGHUP ignored: only the disk and tiered stores adopt ingested data");
+            return;
+        }
+        LOG_INFO("Adopted ingested data from " + config.ingest_dir.string() + " (" +
+                 std::to_string(store.size()) + " keys)");
+    } catch (const std::exception& e) {
+        LOG_ERROR("ingest adoption failed: " + std::string(e.what()));
+    }
+}
+
 int main(int argc, char* argv[]) {
     try {
         kvstore::util::Config defaults;
@@ -51,11 +96,29 @@ int main(int argc, char* argv[]) {
         //setup store
         std::unique_ptr<kvstore::core::IStore> store;
 
-        if(config.use_disk_store) {
-            kvstore::core::DiskStoreOptions opts;
-            opts.data_dir = config.data_dir;
-            opts.compaction_threshold = config.compaction_threshold;
-            store = std::make_unique<kvstore::core::DiskStore>(opts);
+        if(config.use_lsm_store) {
+            kvstore::core::LsmStoreOptions opts;
+            opts.data_dir = config.data_dir / "lsm";
+            store = std::make_unique<kvstore::core::LsmStore>(opts);
+            LOG_INFO("Using LSM-tree storage");
+        } else if(config.use_btree_store) {
+            kvstore::core::BTreeStoreOptions opts;
+            opts.data_dir = config.data_dir / "btree";
+            store = std::make_unique<kvstore::core::BTreeStore>(opts);
+            LOG_INFO("Using B+tree storage");
+        } else if(config.use_mmap_store) {
+            kvstore::core::MmapStoreOptions opts;
+            opts.data_dir = config.data_dir / "mmap";
+            store = std::make_unique<kvstore::core::MmapStore>(opts);
+            LOG_INFO("Using memory-mapped hash table storage");
+        } else if(config.use_tiered_store) {
+            kvstore::core::TieredStoreOptions opts;
+            opts.disk = disk_store_options(config);
+            opts.hot_tier_bytes = config.hot_tier_mb * 1024 * 1024;
+            store = std::make_unique<kvstore::core::TieredStore>(opts);
+            LOG_INFO("Using tiered storage (in-memory hot tier over disk)");
+        } else if(config.use_disk_store) {
+            store = std::make_unique<kvstore::core::DiskStore>(disk_store_options(config));
             LOG_INFO("Using disk-based storage");
         } else {
             kvstore::core::StoreOptions opts;
@@ -72,6 +135,11 @@ int main(int argc, char* argv[]) {
         server_opts.port = config.port;
         server_opts.max_connections = config.max_connections;
         server_opts.client_timeout_seconds = config.client_timeout_seconds;
+        if(config.event_loop || config.io_uring) {
+            server_opts.mode = config.io_uring ? kvstore::net::server::ServerMode::IoUring
+                                               : kvstore::net::server::ServerMode::EventLoop;
+            server_opts.reactor_threads = config.reactor_threads;
+        }
 
         kvstore::net::server::Server server(*store, server_opts);
 
@@ -83,8 +151,11 @@ int main(int argc, char* argv[]) {
 
         LOG_INFO("Press Ctrl+C to shutdown");
 
-        //wait for shutdown signal
-        kvstore::util::SignalHandler::wait_for_shutdown();
+        //wait for shutdown signal, adopting ingested data on every SIGHUP until then
+        while(kvstore::util::SignalHandler::wait_for_event() ==
+              kvstore::util::SignalEvent::Reload) {
+            adopt_ingested(config, *store);
+        }
 
         //stop server
         server.stop();
@@ -0,0 +1,97 @@
+#ifndef KVSTORE_CORE_BLOB_LOG_HPP
+#define KVSTORE_CORE_BLOB_LOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace kvstore::core {
+
+// where a separated value lives. segment 0 = not a blob (the value is inline in the data file)
+struct BlobPointer {
+    uint32_t segment = 0;
+    uint64_t offset = 0;  // record start inside the segment
+    uint32_t size = 0;    // value bytes
+};
+
+/*
+    value log for DiskStore's key-value separation (WiscKey). large values are appended here and
+   the data file only keeps a BlobPointer, so compacting the data file never copies them.
+    - split into segment files (000001.blob, ...) of ~segment_size. only the newest one (the
+   active segment) is appended to; sealed segments are immutable until garbage collection deletes
+   them as a whole
+    - record: [key len u32][key][value len u32][value]. the key lets GC find the index entry that
+   still points at a record - records nobody points at are garbage
+    - not thread safe on its own. DiskStore appends under its io_mutex_ and changes the segment set
+   (roll, remove_segment, clear) only while readers are excluded
+*/
+class BlobLog {
+   public:
+    BlobLog(const std::filesystem::path& dir, std::size_t segment_size);
+    ~BlobLog();
+
+    BlobLog(const BlobLog&) = delete;
+    BlobLog& operator=(const BlobLog&) = delete;
+
+    // encode a record into buf, which the caller will append() next. returns where it will live
+    BlobPointer encode(std::string& buf, std::string_view key, std::string_view value) const;
+    void append(const std::string& buf);
+    void sync();
+
+    // start a new active segment once the current one reached segment_size
+    [[nodiscard]] bool needs_roll() const;
+    void roll();
+
+    // one pread, straight from the value bytes
+    [[nodiscard]] std::string read(const BlobPointer& pointer, std::size_t key_size) const;
+    // the segment fd and file offset of the value bytes, for reading them without read()
+    [[nodiscard]] std::pair<int, uint64_t> locate(const BlobPointer& pointer,
+                                                  std::size_t key_size) const;
+    // does the segment hold a complete record there? (startup check after a crash)
+    [[nodiscard]] bool contains(const BlobPointer& pointer, std::size_t key_size) const;
+
+    [[nodiscard]] uint32_t active_segment() const;
+    [[nodiscard]] std::vector<uint32_t> segments() const;
+    [[nodiscard]] uint64_t segment_bytes(uint32_t segment) const;
+
+    // sequential scan of a sealed segment for GC. return false from the callback to stop early
+    void for_each_record(
+        uint32_t segment,
+        const std::function<bool(const BlobPointer&, std::string_view, std::string_view)>&
+            callback) const;
+
+    void remove_segment(uint32_t segment);
+    // delete every segment and start over with an empty one
+    void clear();
+
+    // bytes a record for this key/value takes in a segment
+    [[nodiscard]] static uint64_t record_size(std::size_t key_size, std::size_t value_size);
+
+   private:
+    struct Segment {
+        int fd = -1;
+        uint64_t size = 0;
+    };
+
+    [[nodiscard]] std::filesystem::path segment_path(uint32_t segment) const;
+    void open_segment(uint32_t segment);
+
+    static constexpr uint32_t kMagic = 0x4B56424C;  // "KVBL"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint64_t kHeaderSize = 8;
+
+    std::filesystem::path dir_;
+    std::size_t segment_size_;
+    std::map<uint32_t, Segment> segments_;
+    uint32_t active_ = 0;
+};
+
+}  // namespace kvstore::core
+
+#endif
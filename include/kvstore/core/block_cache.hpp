@@ -0,0 +1,96 @@
+#ifndef KVSTORE_CORE_BLOCK_CACHE_HPP
+#define KVSTORE_CORE_BLOCK_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace kvstore::core {
+
+struct BlockCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    std::size_t used_bytes = 0;
+    std::size_t capacity_bytes = 0;
+
+    [[nodiscard]] double hit_ratio() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
+
+// kBlockSize aligned heap memory, as O_DIRECT wants it
+struct AlignedFree {
+    void operator()(char* p) const;
+};
+using AlignedBuffer = std::unique_ptr<char[], AlignedFree>;
+[[nodiscard]] AlignedBuffer make_aligned_buffer(std::size_t bytes);
+
+/*
+    read cache of fixed 4KB file blocks for DiskStore's direct I/O mode, where the kernel page
+   cache is bypassed and this is the only cache left.
+    - capacity is allocated up front (per shard arenas), so memory use is exactly what was asked
+   for, not whatever the kernel decides
+    - sharded by block: each shard has its own mutex, map and CLOCK hand, so concurrent readers
+   rarely meet. CLOCK like BufferPool: a hit only sets a reference bit
+    - blocks are immutable copies of file content. the owner only inserts blocks that will never
+   change (fully written, append-only file) and clears the cache when the file is rewritten
+    - keyed by (file id, block number) so several files can share one cache
+*/
+class BlockCache {
+   public:
+    static constexpr std::size_t kBlockSize = 4096;
+
+    explicit BlockCache(std::size_t capacity_bytes, std::size_t shards = 16);
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    // copy len bytes starting at offset_in_block out of a cached block. false = miss
+    bool read(uint64_t file_id, uint64_t block, std::size_t offset_in_block, char* dst,
+              std::size_t len);
+    // data = kBlockSize bytes. replaces the block if it is already cached
+    void insert(uint64_t file_id, uint64_t block, const char* data);
+    void clear();
+
+    [[nodiscard]] BlockCacheStats stats() const;
+
+   private:
+    struct Key {
+        uint64_t file_id;
+        uint64_t block;
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const;
+    };
+    struct Slot {
+        Key key{};
+        bool referenced = false;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Key, std::size_t, KeyHash> map;  // -> slot
+        std::vector<Slot> slots;
+        AlignedBuffer arena;  // slots.size() blocks
+        std::size_t hand = 0;
+        std::size_t used = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shard_for(const Key& key);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t capacity_bytes_ = 0;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef KVSTORE_CORE_BLOOM_FILTER_HPP
+#define KVSTORE_CORE_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kvstore::core {
+
+/*
+    bloom filter - answers "is this key possibly in the set?" with no false negatives and a tunable
+   false positive rate. the LSM store keeps one per SSTable so a point lookup can skip every table
+   that definitely doesnt hold the key without touching disk.
+    - bits_per_key = 10 gives ~1% false positives
+    - probes are derived from one 64-bit hash by double hashing (kirsch-mitzenmacher) so we only
+   hash each key once
+    - serialized form: [bit array][1 byte: probe count], the same layout leveldb uses
+*/
+class BloomFilter {
+   public:
+    // build a serialized filter from the keys' util::hash64 values
+    [[nodiscard]] static std::string build(const std::vector<uint64_t>& key_hashes,
+                                           std::size_t bits_per_key);
+
+    // wrap a serialized filter. an empty/malformed filter matches everything
+    explicit BloomFilter(std::string data);
+
+    [[nodiscard]] bool may_contain(std::string_view key) const;
+    [[nodiscard]] bool may_contain_hash(uint64_t key_hash) const;
+
+    [[nodiscard]] const std::string& data() const;
+
+   private:
+    std::string data_;
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef KVSTORE_CORE_BTREE_STORE_HPP
+#define KVSTORE_CORE_BTREE_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "kvstore/core/istore.hpp"
+#include "kvstore/util/clock.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core {
+
+/*
+    page-based B+tree store. built for large, read-mostly data sets: nothing is kept in memory per
+   key, only a fixed-size buffer pool of pages (DiskStore keeps every key in RAM).
+    - point lookups read one page per tree level (+ overflow pages for big values), ordered range
+   scans walk the leaves in key order
+    - crash safety: shadow paging + WAL. pages reachable from the last checkpoint are never
+   overwritten - the first change to such a page after a checkpoint copies it to a new page. a
+   checkpoint flushes the new pages, fsyncs, then flips one of two meta pages to the new root. a
+   crash always leaves one intact tree; writes since its checkpoint are replayed from the WAL
+    - deletes are lazy: entries are removed from their leaf, empty pages are freed, but half empty
+   pages are not merged
+    - keys are limited to ~1/8 of a page (like LMDB's key limit). values larger than ~1/4 of a
+   page go to a chain of overflow pages
+*/
+struct BTreeStoreOptions {
+    std::filesystem::path data_dir;
+    std::size_t page_size = 4096;                // power of two, 1KB..64KB
+    std::size_t cache_size = 32 * 1024 * 1024;   // buffer pool bytes - the memory bound
+    std::size_t checkpoint_wal_size = 4 * 1024 * 1024;  // checkpoint once the WAL grows past this
+    std::shared_ptr<util::Clock> clock = std::make_shared<util::SystemClock>();
+};
+
+class BTreeStore : public IStore {
+   public:
+    explicit BTreeStore(const BTreeStoreOptions& options);
+    ~BTreeStore();
+
+    BTreeStore(const BTreeStore&) = delete;
+    BTreeStore& operator=(const BTreeStore&) = delete;
+    BTreeStore(BTreeStore&&) noexcept;
+    BTreeStore& operator=(BTreeStore&&) noexcept;
+
+    void put(std::string_view key, std::string_view value) override;
+    void put(std::string_view key, std::string_view value, util::Duration ttl) override;
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) override;
+    [[nodiscard]] bool remove(std::string_view key) override;
+    [[nodiscard]] bool contains(std::string_view key) override;
+    [[nodiscard]] std::size_t size() const override;
+    [[nodiscard]] bool empty() const override;
+
+    void clear() override;
+    // checkpoint: make every write so far part of the on-disk tree and truncate the WAL
+    void flush() override;
+
+    // live entries with start <= key < end, in key order. empty end = no upper bound,
+    // limit 0 = no limit
+    [[nodiscard]] std::vector<std::pair<std::string, std::string>> scan(
+        std::string_view start, std::string_view end, std::size_t limit = 0) const;
+
+    // pages in the tree file, including free ones
+    [[nodiscard]] std::size_t page_count() const;
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef KVSTORE_CORE_BUFFER_POOL_HPP
+#define KVSTORE_CORE_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace kvstore::core {
+
+/*
+    fixed-size page cache over one file, with CLOCK eviction.
+    - fetch() returns a pinned PageRef. a pinned frame is never evicted or reused
+    - CLOCK (second chance) approximates LRU with one reference bit per frame instead of a list
+   splice on every hit - hits only set a bit
+    - dirty frames are written back when evicted or on flush_all(). the pool itself never decides
+   what is safe to write - the caller only dirties pages it is allowed to overwrite in place
+    - capacity is a soft limit: if every frame is pinned a new one is added rather than failing.
+   pins are short lived, so this only happens under heavy concurrency and shrinks back in practice
+   as frames are recycled
+    - note: page I/O on a miss happens under the pool mutex, so concurrent misses serialize. hits
+   only take the mutex to pin/unpin
+*/
+class BufferPool {
+    struct Frame;
+
+   public:
+    // pinned page. unpins on destruction
+    class PageRef {
+       public:
+        PageRef() = default;
+        ~PageRef();
+        PageRef(PageRef&& other) noexcept;
+        PageRef& operator=(PageRef&& other) noexcept;
+        PageRef(const PageRef&) = delete;
+        PageRef& operator=(const PageRef&) = delete;
+
+        [[nodiscard]] uint32_t id() const;
+        [[nodiscard]] const char* data() const;
+        [[nodiscard]] char* mutable_data();
+        void mark_dirty();
+
+       private:
+        friend class BufferPool;
+        PageRef(BufferPool* pool, Frame* frame) : pool_(pool), frame_(frame) {}
+        void release();
+
+        BufferPool* pool_ = nullptr;
+        Frame* frame_ = nullptr;
+    };
+
+    BufferPool(int fd, std::size_t page_size, std::size_t capacity);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // read page id (from disk on a miss)
+    [[nodiscard]] PageRef fetch(uint32_t id);
+    // frame for a page whose old on-disk content doesnt matter. zeroed and dirty, no read
+    [[nodiscard]] PageRef create(uint32_t id);
+    // forget a page without writing it back (the page was freed)
+    void discard(uint32_t id);
+    // forget every page without writing anything back (the file was reset)
+    void reset();
+    // write back every dirty frame. does not sync
+    void flush_all();
+
+    [[nodiscard]] std::size_t page_size() const;
+    [[nodiscard]] std::size_t capacity() const;
+    [[nodiscard]] uint64_t hits() const;
+    [[nodiscard]] uint64_t misses() const;
+
+   private:
+    struct Frame {
+        uint32_t page_id = 0;
+        bool in_use = false;  // holds a page (vs an empty slot)
+        bool dirty = false;
+        bool referenced = false;
+        uint32_t pins = 0;
+        std::unique_ptr<char[]> data;
+    };
+
+    // mutex_ must be held
+    Frame* frame_for(uint32_t id);
+    void write_back(Frame& frame);
+    void unpin(Frame* frame);
+
+    int fd_;
+    std::size_t page_size_;
+    std::size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Frame>> frames_;
+    std::unordered_map<uint32_t, Frame*> table_;
+    std::size_t clock_hand_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+}  // namespace kvstore::core
+
+#endif
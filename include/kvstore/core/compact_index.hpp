@@ -0,0 +1,65 @@
+#ifndef KVSTORE_CORE_COMPACT_INDEX_HPP
+#define KVSTORE_CORE_COMPACT_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace kvstore::core {
+
+/*
+    hash -> record offset table for DiskStore's IndexMode::Compact. one 8 byte slot per entry and
+   no keys at all: [24 bit hash tag][40 bit record offset], open addressing with linear probing.
+    - a lookup walks the probe sequence and hands every slot whose tag matches to the caller's
+   `match`, which reads the record at that offset and compares the key. with 24 tag bits a wrong
+   candidate (= a wasted disk read) turns up about once per 16M probes
+    - home bucket = top bits of the hash, tag = low 24 bits. they never overlap, so the tag still
+   tells keys apart when the table gets big
+    - since there are no keys, the table cannot re-hash itself. when full() the owner builds a
+   bigger one from the records on disk (see DiskStore's rebuild_compact_index)
+    - removed entries leave a "deleted" marker so probe sequences stay intact. markers count as
+   used slots: an insert probing past one reuses it, the rest are dropped by the next rebuild
+    - offsets 0 and 1 encode empty/deleted slots. fine for DiskStore: its file header is 8 bytes
+*/
+class CompactIndex {
+   public:
+    static constexpr uint64_t kMaxOffset = (uint64_t{1} << 40) - 1;  // 1TB data file
+
+    // capacity is rounded up to a power of two. 0 = no slots until the first rebuild
+    explicit CompactIndex(std::size_t capacity = 0);
+
+    // a table sized so `entries` entries fill half of it
+    [[nodiscard]] static std::size_t capacity_for(std::size_t entries);
+
+    // first slot with the hash's tag for which match(offset) is true
+    [[nodiscard]] std::optional<uint64_t> find(
+        uint64_t hash, const std::function<bool(uint64_t)>& match) const;
+
+    // caller guarantees the key isnt in the table yet and the table isnt full()
+    void insert(uint64_t hash, uint64_t offset);
+    // point the entry at old_offset to new_offset. false if there is no such entry
+    bool replace(uint64_t hash, uint64_t old_offset, uint64_t new_offset);
+    bool erase(uint64_t hash, uint64_t offset);
+    void clear();
+
+    // no room for another insert at the max load factor (7/8, deleted markers included)
+    [[nodiscard]] bool full() const;
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] std::size_t capacity() const;
+    [[nodiscard]] std::size_t memory_usage() const;
+
+   private:
+    [[nodiscard]] std::size_t home(uint64_t hash) const;
+    [[nodiscard]] std::optional<std::size_t> position(uint64_t hash, uint64_t offset) const;
+
+    std::vector<uint64_t> slots_;
+    int bits_ = 0;          // capacity = 1 << bits_
+    std::size_t size_ = 0;  // live entries
+    std::size_t used_ = 0;  // live entries + deleted markers
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef KVSTORE_CORE_DATA_FILE_HPP
+#define KVSTORE_CORE_DATA_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "kvstore/util/types.hpp"
+
+/*
+    the on-disk format of DiskStore's data file (data.kvds), shared by DiskStore itself and the
+   offline builder (disk_store_builder.hpp).
+    file:   [magic u32 "KVDS"][version u32][record]...
+    record: [crc u32][body len u32][body]
+    body:   [type u8][key len u32][key][value len u32][value][has_exp u8][exp u64 - if has_exp]
+    crc is the CRC-32C of body len + body, so the scan on open catches a torn append or flipped
+   bits - in the length too - and truncates the file there. version 1 files had bare bodies
+*/
+namespace kvstore::core::data_file {
+
+constexpr uint32_t kMagic = 0x4B564453;  //"KVDS"
+constexpr uint32_t kVersion = 2;
+constexpr uint32_t kLegacyVersion = 1;  // records without checksums - upgraded on open
+constexpr uint8_t kEntryRegular = 0;
+constexpr uint8_t kEntryTombstone = 1;
+constexpr uint8_t kEntryBlob = 2;  // value field holds an encoded BlobPointer
+constexpr uint64_t kHeaderSize = sizeof(kMagic) + sizeof(kVersion);
+
+constexpr std::size_t kFrameSize = 4 + 4;
+constexpr std::size_t kMinBodySize = 1 + 4 + 4 + 1;
+constexpr std::size_t kRecordOverhead = kFrameSize + 1 + 4 + 4 + 1 + 8;  // with an expiration
+
+void append_header(std::string& buf);
+
+// appends one framed record to buf
+void encode_record(std::string& buf, uint8_t entry_type, std::string_view key,
+                   std::string_view value, util::ExpirationTime expires_at_ms);
+
+// splits a record body into its fields, key and value point into body. false = the lengths
+// inside dont add up to its size
+[[nodiscard]] bool decode_body(std::string_view body, uint8_t& type, std::string_view& key,
+                               std::string_view& value, util::ExpirationTime& expires_at_ms);
+
+// one record as read back by a sequential scan of the file. key and value point into the scan's
+// mapping of the file - valid until the scan returns
+struct ScannedRecord {
+    uint64_t offset = 0;
+    uint8_t type = kEntryRegular;
+    std::string_view key;
+    std::string_view value;
+    util::ExpirationTime expires_at_ms = std::nullopt;
+};
+
+struct ScanOptions {
+    // chunks checksummed and decoded ahead of the callback, each on its own thread. 1 = all on
+    // the calling thread
+    std::size_t threads = 1;
+    std::size_t chunk_bytes = 8 * 1024 * 1024;
+    // called once before the first record with the number of records the range is expected to
+    // hold (extrapolated from the first chunk) - to size an index up front
+    std::function<void(uint64_t)> on_estimate;
+};
+
+/*
+    calls fn for every intact record of a version 2 data file in [from, end), in file order and on
+   the calling thread - so later records of a key win, as with a plain sequential read. from must
+   be a record boundary. stops at the first torn or corrupt record (short, impossible length,
+   checksum mismatch) and returns where it stopped: the end of the last good record.
+    the file is mapped, not read: no copies, and values are never allocated. it is cut into
+   chunks on record boundaries (only the length fields are read for that); the chunks ahead of
+   the one fn is working through are checksummed and decoded in parallel, and prefetched
+*/
+uint64_t scan(int fd, uint64_t from, uint64_t end, const ScanOptions& options,
+              const std::function<void(const ScannedRecord&)>& fn);
+
+// bytes encode_record appends
+[[nodiscard]] constexpr uint64_t record_size(std::size_t key_size, std::size_t value_size,
+                                             bool has_expiration) {
+    return kFrameSize + 1 + 4 + key_size + 4 + value_size + 1 + (has_expiration ? 8 : 0);
+}
+
+// offset of the value bytes inside a record that starts at record_offset
+[[nodiscard]] constexpr uint64_t value_offset(uint64_t record_offset, std::size_t key_size) {
+    return record_offset + kFrameSize + 1 + 4 + key_size + 4;
+}
+
+}  // namespace kvstore::core::data_file
+
+#endif
@@ -2,24 +2,124 @@
 #define KVSTORE_CORE_DISK_STORE_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include "kvstore/core/block_cache.hpp"
 #include "kvstore/core/istore.hpp"
+#include "kvstore/core/value_cache.hpp"
 #include "kvstore/util/clock.hpp"
+#include "kvstore/util/io_engine.hpp"
 #include "kvstore/util/types.hpp"
 
 namespace kvstore::core {
 
+/*
+    durability of acknowledged writes (same knobs as redis' appendfsync):
+    - Always: fdatasync every group commit before acknowledging. concurrent writers share one sync
+    - Batch: fdatasync at most once per sync_interval - on a write, or from a background thread
+   once the interval is up. a crash can lose the last interval
+    - Os: never sync, leave it to the kernel's writeback. survives process crashes, not power loss
+    every record carries a CRC-32C. whatever a crash tears off the end of the data file fails it,
+   and the next open truncates the file back to the last intact record
+*/
+enum class SyncMode : uint8_t { Always, Batch, Os };
+
+/*
+    what the in-memory index keeps per key:
+    - Full: the key itself + offset, value size and expiration. lookups never touch the disk
+   before the value read. ~100+ bytes per key (string + map node + entry)
+    - Compact: an 8 byte hash tag + offset slot (see compact_index.hpp), ~10-16 bytes per key.
+   a lookup reads the record and compares the key, usually in one pread that also returns the
+   value. costs: overwrites/removes read the old record to find their slot, the table grows by
+   re-reading the data file, no hint file is written, and the data file is capped at 1TB
+*/
+enum class IndexMode : uint8_t { Full, Compact };
+
+/*
+    key-value separation (WiscKey): values of at least blob_threshold bytes are appended to a
+   separate blob log (blob_log.hpp) and the data file only keeps a small pointer record.
+    - compaction of the data file copies pointers, never the large values
+    - overwritten/removed values become garbage in their blob segment. garbage collection is a
+   separate pass: a sealed segment with at least blob_gc_ratio garbage has its live values copied
+   to the active segment (through the normal write path, so racing writes win) and is deleted.
+   GC reads + rewrites at most blob_gc_rate bytes per second so it doesnt starve foreground I/O
+    - GC runs on a background thread every blob_gc_interval, or on demand via
+   collect_blob_garbage()
+    - Full index mode only
+*/
+
 struct DiskStoreOptions {
     std::filesystem::path data_dir;
     std::size_t compaction_threshold = 1000;  // compact after N tombstones
+    bool use_hint_file = true;  // write data.hint on compaction/close, load index from it on open
+    SyncMode sync_mode = SyncMode::Os;
+    IndexMode index_mode = IndexMode::Full;
+    std::size_t blob_threshold = 0;  // 0 = keep every value inline
+    std::size_t blob_segment_size = 64 * 1024 * 1024;
+    double blob_gc_ratio = 0.5;
+    std::size_t blob_gc_rate = 32 * 1024 * 1024;  // bytes/s, 0 = unthrottled
+    util::Duration blob_gc_interval = util::Duration(10000);  // 0 = no background GC
+    util::Duration sync_interval = util::Duration(1000);  // SyncMode::Batch only
+    // reserve data file blocks ahead of the appends in extents of this size (fallocate, the file
+    // size is unchanged), so small appends dont each allocate. 0 = grow one write at a time
+    std::size_t preallocate_bytes = 16 * 1024 * 1024;
+    // batched value reads (multi_get, compaction). IoUring keeps a whole batch in flight at once
+    util::IoBackend io_backend = util::IoBackend::Sync;
+    // read the data file with O_DIRECT, past the kernel page cache, and cache blocks in-process
+    // instead (block_cache.hpp, 0 = no cache). for hosts shared with other services: the store
+    // then holds what is configured here, not whatever the page cache grows to. appends stay
+    // buffered but their pages are handed back every MB. blob log reads stay buffered
+    bool direct_io = false;
+    std::size_t block_cache_bytes = 64 * 1024 * 1024;  // direct_io only
+    // whole values of recently read keys (value_cache.hpp), so a hot key's get skips the data
+    // file read and its allocation. 0 = off. Full index mode only - the compact index exists to
+    // keep keys out of memory
+    std::size_t value_cache_bytes = 0;
+    // sequential scans of the data file (index rebuild on open, compact mode compaction) decode
+    // chunks ahead of the index updates on this many threads. 0 = one per core, at most 8
+    std::size_t scan_threads = 0;
     std::shared_ptr<util::Clock> clock = std::make_shared<util::SystemClock>();
 };
 
+/*
+    where a value's bytes sit in one of DiskStore's files - for sending them to a socket without
+   copying them through user space (sendfile). owns a dup of the file's fd, so it keeps reading
+   the same bytes after compaction or clear() replaced the data file, or blob GC deleted the
+   segment
+*/
+class ValueRegion {
+   public:
+    ValueRegion(int fd, uint64_t offset, std::size_t size) noexcept;
+    ~ValueRegion();
+
+    ValueRegion(const ValueRegion&) = delete;
+    ValueRegion& operator=(const ValueRegion&) = delete;
+    ValueRegion(ValueRegion&& other) noexcept;
+    ValueRegion& operator=(ValueRegion&& other) noexcept;
+
+    [[nodiscard]] int fd() const noexcept {
+        return fd_;
+    }
+    [[nodiscard]] uint64_t offset() const noexcept {
+        return offset_;
+    }
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+   private:
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    std::size_t size_ = 0;
+};
+
 class DiskStore : public IStore {
    public:
     explicit DiskStore(const DiskStoreOptions& options);
@@ -34,15 +134,58 @@ class DiskStore : public IStore {
     void put(std::string_view key, std::string_view value, util::Duration ttl) override;
 
     [[nodiscard]] std::optional<std::string> get(std::string_view key) override;
+    // get() that also hands back the key's expiration (nullopt = none), e.g. to copy the entry
+    // into another store with the same deadline
+    [[nodiscard]] std::optional<std::string> get_with_expiry(
+        std::string_view key, std::optional<util::TimePoint>& expires_at);
     [[nodiscard]] bool remove(std::string_view key) override;
     [[nodiscard]] bool contains(std::string_view key) override;
     [[nodiscard]] std::size_t size() const override;
     [[nodiscard]] bool empty() const override;
 
+    // the file region of a live value of at least min_size bytes, instead of the value itself.
+    // nullopt = read it with get() - missing, expired, smaller, or not a plain buffered file read
+    // (Compact index mode and direct_io)
+    [[nodiscard]] std::optional<ValueRegion> open_value(std::string_view key,
+                                                        std::size_t min_size);
+
+    // get() for many keys at once: one index lookup pass, then all value reads as one I/O batch
+    [[nodiscard]] std::vector<std::optional<std::string>> multi_get(
+        std::span<const std::string_view> keys) override;
+    // multi_get() that hands back values of at least min_region_size as their open_value()
+    // region instead of reading them, from the same index lookup: regions[i] set = values[i] is
+    // nullopt but the key is there. regions is resized to keys.size() (all nullopt in Compact
+    // index mode and with direct_io)
+    [[nodiscard]] std::vector<std::optional<std::string>> multi_get(
+        std::span<const std::string_view> keys, std::size_t min_region_size,
+        std::vector<std::optional<ValueRegion>>& regions);
+    // put() for many entries at once: one group commit batch (one write, one sync) per
+    // kMaxBatchBytes instead of one per entry
+    void multi_put(std::span<const KeyValue> entries) override;
+
     void clear() override;
     void flush() override;
     void compact();
 
+    // replace the whole contents with a prebuilt data file (DiskStoreBuilder): dir/data.kvds -
+    // and dir/data.hint, if there is one - are renamed into the data directory, so dir has to be
+    // on the same filesystem. readers and writers wait for the swap and then see only the new
+    // contents. throws std::runtime_error (store untouched) if dir holds no valid data file
+    void adopt(const std::filesystem::path& dir);
+
+    // bytes the key index holds in memory. Full mode is an estimate of the node allocations
+    [[nodiscard]] std::size_t index_memory_usage() const;
+
+    // one blob GC pass over every sealed segment past blob_gc_ratio. returns the bytes freed
+    std::size_t collect_blob_garbage();
+
+    // SyncMode::Batch: acknowledged writes are waiting for the next sync. always false otherwise
+    [[nodiscard]] bool pending_sync() const;
+
+    // hit/miss counters of the value cache and the direct_io block cache. all zero without one
+    [[nodiscard]] ValueCacheStats value_cache_stats() const;
+    [[nodiscard]] BlockCacheStats block_cache_stats() const;
+
    private:
     class Impl;
     std::unique_ptr<Impl> impl_;
@@ -0,0 +1,63 @@
+#ifndef KVSTORE_CORE_DISK_STORE_BUILDER_HPP
+#define KVSTORE_CORE_DISK_STORE_BUILDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core {
+
+struct DiskStoreBuilderOptions {
+    std::filesystem::path output_dir;  // gets data.kvds + data.hint. must not hold a data file
+    std::size_t threads = 0;           // 0 = one per core
+};
+
+struct DiskStoreBuildStats {
+    uint64_t records = 0;     // add() calls
+    uint64_t keys = 0;        // distinct keys written
+    uint64_t data_bytes = 0;  // size of the data file
+};
+
+/*
+    builds a complete DiskStore data directory offline - seeding a node from a dataset without a
+   put() (and a group commit) per entry.
+    - add() just copies the entry into memory. finish() does the work on every core: entries are
+   hash partitioned across the threads, each sorts its partition by key (cheap if the input was
+   sorted already), keeps the last add() of every key and encodes its records - checksums included
+   - straight into its own range of the output file, in large sequential writes
+    - the result is what compaction produces: one record per key, no tombstones, plus a hint so
+   opening it reads no values. DiskStore opens it in either index mode, a running one takes it
+   over with DiskStore::adopt()
+    - the whole input stays in memory until finish(): keys + values + ~32 bytes per entry, ~45
+   while finishing
+    - values are written inline, whatever blob_threshold the store later runs with
+*/
+class DiskStoreBuilder {
+   public:
+    explicit DiskStoreBuilder(const DiskStoreBuilderOptions& options);
+    ~DiskStoreBuilder();
+
+    DiskStoreBuilder(const DiskStoreBuilder&) = delete;
+    DiskStoreBuilder& operator=(const DiskStoreBuilder&) = delete;
+    DiskStoreBuilder(DiskStoreBuilder&&) noexcept;
+    DiskStoreBuilder& operator=(DiskStoreBuilder&&) noexcept;
+
+    // expires_at_ms: absolute deadline in ms since the epoch, like DiskStore persists it
+    void add(std::string_view key, std::string_view value,
+             util::ExpirationTime expires_at_ms = std::nullopt);
+
+    // writes the files. the builder is empty afterwards
+    DiskStoreBuildStats finish();
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::core
+
+#endif
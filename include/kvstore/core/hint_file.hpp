@@ -0,0 +1,74 @@
+#ifndef KVSTORE_CORE_HINT_FILE_HPP
+#define KVSTORE_CORE_HINT_FILE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+#include "kvstore/core/blob_log.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core {
+
+/*
+    a hint file is a compact summary of a DiskStore data file: for every live record it keeps the
+   key, the record offset, the value size and the expiration time - but not the value itself.
+    - rebuilding the index from the hint reads a fraction of the bytes a full data file scan does
+    - the hint only describes a prefix of the data file ([0, data_end)). records appended after
+   the hint was written (the "tail") still have to be scanned from the data file.
+    - invariant kept by DiskStore: whenever the data file is rewritten (compaction, clear) the old
+   hint is removed first, so an existing hint always describes a prefix of the current data file
+    - entries whose value was separated into the blob log carry its BlobPointer (segment 0 = the
+   value is inline). version 1 hints have no blob pointers and are still read
+    - a crc32c after the entries covers them and the header counts (version 3). a hint that fails
+   it is treated like a missing one. versions 1 and 2 have none and are still read
+*/
+using HintEmitter = std::function<void(std::string_view, uint64_t, uint32_t,
+                                       util::ExpirationTime, const BlobPointer&)>;
+using HintIterator = std::function<void(HintEmitter)>;
+
+struct HintHeader {
+    uint64_t data_end = 0;         // data file offset covered by this hint
+    uint64_t tombstone_count = 0;  // dead records in the covered prefix (drives auto compaction)
+    uint64_t entry_count = 0;
+};
+
+class HintFile {
+   public:
+    explicit HintFile(const std::filesystem::path& path);
+
+    HintFile(const HintFile&) = delete;
+    HintFile& operator=(const HintFile&) = delete;
+
+    HintFile(HintFile&&) noexcept = default;
+    HintFile& operator=(HintFile&&) noexcept = default;
+
+    // same emitter pattern as Snapshot::save - caller decides which entries, we decide the format.
+    // written to a temp file, synced and renamed so a crash never leaves a half written hint
+    // behind. durable also syncs the directory, so the rename itself survives a power loss
+    void save(uint64_t data_end, uint64_t tombstone_count, const HintIterator& iterate,
+              bool durable = false);
+
+    // returns nullopt if the hint is missing, unreadable or fails its checksum. a bad hint is not
+    // an error - the caller falls back to a full data file scan - so unlike Snapshot::load we never
+    // throw here. the checksum is checked before the first callback, but for a version 1/2 hint
+    // callback may have been invoked for some entries before a truncated hint is detected
+    [[nodiscard]] std::optional<HintHeader> load(const HintEmitter& callback);
+
+    void remove();
+
+    [[nodiscard]] bool exists() const;
+    [[nodiscard]] std::filesystem::path path() const;
+
+   private:
+    static constexpr uint32_t kMagic = 0x4B564448;  // "KVDH"
+    static constexpr uint32_t kVersion = 3;
+
+    std::filesystem::path path_;
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -3,13 +3,20 @@
 
 #include <cstddef>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "kvstore/util/types.hpp"
 
 namespace kvstore::core {
 
+struct KeyValue {
+    std::string_view key;
+    std::string_view value;
+};
+
 class IStore {
    public:
     virtual ~IStore() = default;
@@ -25,6 +32,26 @@ class IStore {
 
     virtual void clear() = 0;
     virtual void flush() = 0;
+
+    // batches, e.g. a client's pipelined requests. the defaults just loop - a store overrides them
+    // where the batch can share a lock, a log write or an I/O round trip
+    // get() for every key, results in key order
+    [[nodiscard]] virtual std::vector<std::optional<std::string>> multi_get(
+        std::span<const std::string_view> keys) {
+        std::vector<std::optional<std::string>> values;
+        values.reserve(keys.size());
+        for (std::string_view key : keys) {
+            values.push_back(get(key));
+        }
+        return values;
+    }
+
+    // put() for every entry, in order - a key that repeats ends up with its last value
+    virtual void multi_put(std::span<const KeyValue> entries) {
+        for (const KeyValue& entry : entries) {
+            put(entry.key, entry.value);
+        }
+    }
 };
 
 }  // namespace kvstore::core
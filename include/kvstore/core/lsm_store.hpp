@@ -0,0 +1,79 @@
+#ifndef KVSTORE_CORE_LSM_STORE_HPP
+#define KVSTORE_CORE_LSM_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "kvstore/core/istore.hpp"
+#include "kvstore/util/clock.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core {
+
+/*
+    log-structured merge tree store. built for write heavy workloads and data sets that dont fit
+   in memory (DiskStore keeps every key in RAM).
+    - writes go to the WAL and a sorted in-memory memtable. a full memtable becomes immutable and a
+   background thread flushes it to a level 0 SSTable
+    - L0 tables may overlap each other. L1+ are leveled: each level is a sorted run of
+   non-overlapping tables and is ~10x bigger than the one above
+    - background compaction merges a table into the next level when a level outgrows its budget,
+   dropping overwritten values and (at the bottom level) tombstones and expired entries
+    - reads check memtable -> immutable memtable -> L0 newest first -> one table per level. bloom
+   filters skip tables that dont hold the key
+    - MANIFEST records which tables make up each level, rewritten atomically (tmp + rename)
+*/
+struct LsmStoreOptions {
+    std::filesystem::path data_dir;
+    std::size_t memtable_size = 4 * 1024 * 1024;        // flush memtable to L0 past this
+    std::size_t block_size = 4096;                      // sstable data block size
+    std::size_t bloom_bits_per_key = 10;                // ~1% false positives
+    std::size_t l0_compaction_trigger = 4;              // compact L0 at this many files
+    uint64_t level_base_size = 10 * 1024 * 1024;        // L1 budget, x10 per level below
+    uint64_t target_file_size = 2 * 1024 * 1024;        // split compaction output at this size
+    std::shared_ptr<util::Clock> clock = std::make_shared<util::SystemClock>();
+};
+
+class LsmStore : public IStore {
+   public:
+    explicit LsmStore(const LsmStoreOptions& options);
+    ~LsmStore();
+
+    LsmStore(const LsmStore&) = delete;
+    LsmStore& operator=(const LsmStore&) = delete;
+    LsmStore(LsmStore&&) noexcept;
+    LsmStore& operator=(LsmStore&&) noexcept;
+
+    void put(std::string_view key, std::string_view value) override;
+    void put(std::string_view key, std::string_view value, util::Duration ttl) override;
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) override;
+    [[nodiscard]] bool remove(std::string_view key) override;
+    [[nodiscard]] bool contains(std::string_view key) override;
+    // note: O(n) - counts live keys with a merged scan over every table, like a full range scan
+    [[nodiscard]] std::size_t size() const override;
+    [[nodiscard]] bool empty() const override;
+
+    void clear() override;
+    // write the memtable out to an L0 table and wait for it to land
+    void flush() override;
+    // flush, then block until background compaction has nothing left to do
+    void compact();
+
+    // number of tables in each level, L0 first
+    [[nodiscard]] std::vector<std::size_t> files_per_level() const;
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef KVSTORE_CORE_MMAP_STORE_HPP
+#define KVSTORE_CORE_MMAP_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "kvstore/core/disk_store.hpp"
+#include "kvstore/core/istore.hpp"
+#include "kvstore/util/clock.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core {
+
+/*
+    hash table store whose table lives in a memory-mapped file (mmap.kvm), next to an append-only
+   heap of records. nothing is rebuilt at startup: opening maps the file and reads the meta page,
+   so a restart costs the same for 10 keys or 100M, and whatever the page cache still holds is
+   served at in-memory speed.
+    - the table is open addressing with linear probing, 16 byte slots. a key keeps its slot until
+   the file is rewritten - a remove points it at a tombstone record instead of freeing it. so every
+   change is one slot update, never a move between slots
+    - reads take no lock against writers: a slot is two 8 byte words updated atomically, records
+   are immutable once written
+    - crash safety (like LMDB: two checksummed meta pages, the newer valid one wins). a slot holds
+   the key's newest record and its newest *durable* one - any record the last msync covered. the
+   kernel may write table pages back before the records they point to, so after a crash every
+   record newer than the last checkpoint is checked (CRC-32C over its offset + contents) and a torn
+   one is replaced by the durable version. that scan only happens after a crash: it reads the
+   table plus the records written since the last checkpoint
+    - overwrites leave dead records in the heap. once max_garbage_ratio of it is dead, or the
+   table passes max_load_factor, the whole file is rewritten with only the live entries (writers
+   and readers wait for it, like DiskStore compaction)
+    - size() counts expired keys until a read finds them expired, like Store
+*/
+struct MmapStoreOptions {
+    std::filesystem::path data_dir;
+    std::size_t initial_capacity = 1 << 16;  // slots, rounded up to a power of two
+    double max_load_factor = 0.7;            // used slots (tombstones too) / capacity
+    double max_garbage_ratio = 0.5;          // dead heap bytes / heap bytes
+    // Always: msync the record and its slot before put() returns. Batch: checkpoint (msync
+    // everything, commit a meta page) at most every sync_interval - on a write, or from a
+    // background thread once the interval is up. Os: only on flush and close
+    SyncMode sync_mode = SyncMode::Batch;
+    util::Duration sync_interval = util::Duration(1000);
+    std::shared_ptr<util::Clock> clock = std::make_shared<util::SystemClock>();
+};
+
+class MmapStore : public IStore {
+   public:
+    explicit MmapStore(const MmapStoreOptions& options);
+    ~MmapStore() override;
+
+    MmapStore(const MmapStore&) = delete;
+    MmapStore& operator=(const MmapStore&) = delete;
+    MmapStore(MmapStore&&) noexcept;
+    MmapStore& operator=(MmapStore&&) noexcept;
+
+    void put(std::string_view key, std::string_view value) override;
+    void put(std::string_view key, std::string_view value, util::Duration ttl) override;
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) override;
+    [[nodiscard]] bool remove(std::string_view key) override;
+    [[nodiscard]] bool contains(std::string_view key) override;
+    [[nodiscard]] std::size_t size() const override;
+    [[nodiscard]] bool empty() const override;
+
+    void clear() override;
+    // checkpoint: every write so far is durable and the next open needs no recovery
+    void flush() override;
+
+    // rewrite the file with only the live entries
+    void compact();
+
+    // changes the next checkpoint will commit. SyncMode::Batch: at most sync_interval away
+    [[nodiscard]] bool pending_sync() const;
+
+    [[nodiscard]] std::size_t capacity() const;
+    [[nodiscard]] uint64_t file_size() const;
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef KVSTORE_CORE_SSTABLE_HPP
+#define KVSTORE_CORE_SSTABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "kvstore/core/bloom_filter.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core {
+
+/*
+    SSTable - immutable file of entries sorted by key. the on-disk unit of the LSM store.
+
+    file layout:
+        [data block 0][data block 1]...[index block][bloom block][properties block][footer]
+    - data block: entries back to back, ~block_size bytes. a lookup reads exactly one block
+        entry: [flags u8][key len u32][key][value len u32][value][expires_at i64 - if flagged]
+    - index block: one entry per data block: [last key][offset u64][size u32]. kept in memory, so
+   finding the block that may hold a key is a binary search with no I/O
+    - bloom block: BloomFilter over every key in the table
+    - properties block: [smallest key][largest key]
+    - footer (fixed size, at the very end): offsets/sizes of the three blocks above, entry count,
+   magic, version
+    integers use the same native byte order as the rest of our file formats (util::append_int)
+*/
+
+struct TableEntry {
+    std::string key;
+    std::string value;
+    bool tombstone = false;
+    util::ExpirationTime expires_at_ms = std::nullopt;
+};
+
+// forward iterator over entries in key order
+class TableIterator {
+   public:
+    virtual ~TableIterator() = default;
+
+    [[nodiscard]] virtual bool valid() const = 0;
+    [[nodiscard]] virtual const TableEntry& entry() const = 0;
+    virtual void next() = 0;
+};
+
+class SSTableWriter {
+   public:
+    SSTableWriter(const std::filesystem::path& path, std::size_t block_size,
+                  std::size_t bloom_bits_per_key);
+    // an unfinished table is deleted - a half written file must never be picked up
+    ~SSTableWriter();
+
+    SSTableWriter(const SSTableWriter&) = delete;
+    SSTableWriter& operator=(const SSTableWriter&) = delete;
+
+    // keys must be strictly increasing
+    void add(const TableEntry& entry);
+
+    // write index/bloom/footer and fsync. returns the final file size
+    uint64_t finish();
+
+    [[nodiscard]] uint64_t estimated_size() const;
+    [[nodiscard]] std::size_t entry_count() const;
+
+   private:
+    void flush_block();
+
+    std::filesystem::path path_;
+    int fd_ = -1;
+    std::size_t block_size_;
+    std::size_t bloom_bits_per_key_;
+
+    std::string block_;
+    std::string index_;
+    std::string last_key_;
+    std::string smallest_key_;
+    std::vector<uint64_t> key_hashes_;
+    uint64_t offset_ = 0;
+    std::size_t entry_count_ = 0;
+    bool finished_ = false;
+};
+
+class SSTable : public std::enable_shared_from_this<SSTable> {
+   public:
+    // opens the file and loads index, bloom filter and properties into memory
+    static std::shared_ptr<SSTable> open(const std::filesystem::path& path, uint64_t number);
+    ~SSTable();
+
+    SSTable(const SSTable&) = delete;
+    SSTable& operator=(const SSTable&) = delete;
+
+    // point lookup. tombstones are returned too - the caller needs them to stop searching older
+    // tables. nullopt means this table knows nothing about the key
+    [[nodiscard]] std::optional<TableEntry> get(std::string_view key) const;
+
+    // reads one data block at a time
+    [[nodiscard]] std::unique_ptr<TableIterator> iterator() const;
+
+    [[nodiscard]] uint64_t number() const;
+    [[nodiscard]] const std::filesystem::path& path() const;
+    [[nodiscard]] uint64_t file_size() const;
+    [[nodiscard]] uint64_t entry_count() const;
+    [[nodiscard]] const std::string& smallest_key() const;
+    [[nodiscard]] const std::string& largest_key() const;
+
+    // key range intersects [smallest, largest]
+    [[nodiscard]] bool overlaps(std::string_view smallest, std::string_view largest) const;
+
+   private:
+    struct BlockHandle {
+        std::string last_key;
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    class Iterator;
+
+    SSTable(std::filesystem::path path, uint64_t number, int fd);
+
+    [[nodiscard]] std::string read_block(const BlockHandle& handle) const;
+
+    std::filesystem::path path_;
+    uint64_t number_;
+    int fd_;
+    uint64_t file_size_ = 0;
+    uint64_t entry_count_ = 0;
+    std::vector<BlockHandle> index_;
+    std::unique_ptr<BloomFilter> bloom_;
+    std::string smallest_key_;
+    std::string largest_key_;
+};
+
+// iterates an in-memory vector of entries that is already sorted by key (memtable snapshots)
+class VectorIterator : public TableIterator {
+   public:
+    explicit VectorIterator(std::vector<TableEntry> entries);
+
+    [[nodiscard]] bool valid() const override;
+    [[nodiscard]] const TableEntry& entry() const override;
+    void next() override;
+
+   private:
+    std::vector<TableEntry> entries_;
+    std::size_t pos_ = 0;
+};
+
+/*
+    merges several sorted iterators into one sorted stream. children are passed newest first: when
+   several children hold the same key only the newest version is yielded, the older ones are
+   skipped. this is the core of both LSM compaction and full scans.
+*/
+class MergingIterator : public TableIterator {
+   public:
+    explicit MergingIterator(std::vector<std::unique_ptr<TableIterator>> children);
+
+    [[nodiscard]] bool valid() const override;
+    [[nodiscard]] const TableEntry& entry() const override;
+    void next() override;
+
+   private:
+    void find_smallest();
+
+    std::vector<std::unique_ptr<TableIterator>> children_;
+    int current_ = -1;
+};
+
+}  // namespace kvstore::core
+
+#endif
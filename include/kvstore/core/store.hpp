@@ -74,6 +74,12 @@ class Store : public IStore {
     void clear() override;
     void flush() override;
 
+    // one shared lock for all the keys (expired ones are left for a later get() to erase)
+    [[nodiscard]] std::vector<std::optional<std::string>> multi_get(
+        std::span<const std::string_view> keys) override;
+    // one exclusive lock and one WAL write for all the entries
+    void multi_put(std::span<const KeyValue> entries) override;
+
     void snapshot();
     void cleanup_expired();
 
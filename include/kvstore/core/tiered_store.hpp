@@ -0,0 +1,88 @@
+#ifndef KVSTORE_CORE_TIERED_STORE_HPP
+#define KVSTORE_CORE_TIERED_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "kvstore/core/disk_store.hpp"
+#include "kvstore/core/istore.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core {
+
+struct TieredStoreOptions {
+    DiskStoreOptions disk;  // the cold tier. its clock is shared with the hot tier
+    std::size_t hot_tier_bytes = 64 * 1024 * 1024;
+    // the hot tier is split by key hash, each shard with its own lock, LRU and an equal share of
+    // hot_tier_bytes. values larger than a share are never promoted
+    std::size_t hot_tier_shards = 16;
+};
+
+struct TieredStoreStats {
+    uint64_t hot_hits = 0;   // served from memory
+    uint64_t cold_hits = 0;  // read from the DiskStore (and promoted, if there was room)
+    uint64_t misses = 0;     // in neither tier
+    uint64_t promotions = 0;
+    uint64_t demotions = 0;
+    std::size_t hot_entries = 0;
+    std::size_t hot_bytes = 0;
+    std::size_t hot_capacity_bytes = 0;
+
+    // share of the gets that never touched the disk
+    [[nodiscard]] double hot_hit_ratio() const {
+        uint64_t total = hot_hits + cold_hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hot_hits) / static_cast<double>(total);
+    }
+};
+
+/*
+    hot keys in memory, every key in a DiskStore.
+    - writes go through to the DiskStore and drop the key from the hot tier - the disk always has
+   every key, so a crash loses nothing and demoting a key is just forgetting the in-memory copy
+    - a get that misses the hot tier reads the DiskStore and promotes the key, together with its
+   expiration. past its share of hot_tier_bytes a shard demotes its least recently read keys
+    - expiration is the DiskStore's: a hot entry carries the same deadline and is dropped once it
+   passes. remove, size and contains answer for the DiskStore as a whole
+    - a promotion is skipped if a write to a key of the same shard finished while the value was
+   being read, so a slow reader can never put an old value back into the hot tier
+    - a hot hit takes only its shard's lock: reads of hot keys scale with the threads
+*/
+class TieredStore : public IStore {
+   public:
+    explicit TieredStore(const TieredStoreOptions& options);
+    ~TieredStore() override;
+
+    TieredStore(const TieredStore&) = delete;
+    TieredStore& operator=(const TieredStore&) = delete;
+    TieredStore(TieredStore&&) noexcept;
+    TieredStore& operator=(TieredStore&&) noexcept;
+
+    void put(std::string_view key, std::string_view value) override;
+    void put(std::string_view key, std::string_view value, util::Duration ttl) override;
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) override;
+    [[nodiscard]] bool remove(std::string_view key) override;
+    [[nodiscard]] bool contains(std::string_view key) override;
+    [[nodiscard]] std::size_t size() const override;
+    [[nodiscard]] bool empty() const override;
+
+    void clear() override;
+    void flush() override;
+
+    // DiskStore::adopt, and the hot tier starts over empty
+    void adopt(const std::filesystem::path& dir);
+
+    [[nodiscard]] TieredStoreStats stats() const;
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::core
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef KVSTORE_CORE_VALUE_CACHE_HPP
+#define KVSTORE_CORE_VALUE_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace kvstore::core {
+
+struct ValueCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t used_bytes = 0;
+    std::size_t capacity_bytes = 0;
+
+    [[nodiscard]] double hit_ratio() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
+
+/*
+    DiskStore's cache of whole values, keyed by key. every entry carries a version - the record's
+   offset in the data file - and a lookup only hits if the caller's current version matches, so a
+   value that was overwritten on disk can never come back from here.
+    - admission (TinyLFU's doorkeeper): the first put of a key only sets a bit for its hash, the
+   value is stored from the second one on. most misses of a skewed workload are keys that are
+   never read again - copying them in would cost more than the hits they bring. the bits are
+   reset once a quarter of them were set, so "seen before" means recently
+    - S3-FIFO eviction per shard: admitted keys go to a small FIFO (10% of the shard). one that
+   gets a hit before it reaches the end moves to the main FIFO, the rest leave and are remembered
+   in a ghost FIFO (hashes only). a key put again while still a ghost goes straight to main. main
+   gives entries with hits another round (2 bit counter) instead of evicting them, so a burst of
+   new keys never pushes the hot set out
+    - sharded by key hash, one mutex per shard
+    - capacity counts key + value + a fixed per-entry overhead. values larger than a shard's
+   share are not cached at all
+*/
+class ValueCache {
+   public:
+    explicit ValueCache(std::size_t capacity_bytes, std::size_t shards = 16);
+
+    ValueCache(const ValueCache&) = delete;
+    ValueCache& operator=(const ValueCache&) = delete;
+
+    // the cached value if it is there with this version. an older version is dropped
+    [[nodiscard]] std::optional<std::string> get(std::string_view key, uint64_t version);
+    // may not store it - see admission above
+    void put(std::string_view key, uint64_t version, std::string_view value);
+    void erase(std::string_view key);
+    void clear();
+
+    // give every entry a new version (compaction moved the records). nullopt = drop it
+    void remap(const std::function<std::optional<uint64_t>(std::string_view key)>& new_version);
+
+    [[nodiscard]] ValueCacheStats stats() const;
+
+   private:
+    // one allocation per entry: header, then the key bytes, then the value bytes
+    struct Entry {
+        Entry* prev = nullptr;  // FIFO links, towards the oldest
+        Entry* next = nullptr;
+        uint64_t hash = 0;
+        uint64_t version = 0;
+        uint32_t key_size = 0;
+        uint32_t value_size = 0;
+        uint8_t freq = 0;  // hits, saturates at 3
+        bool in_main = false;
+
+        [[nodiscard]] std::string_view key() const;
+        [[nodiscard]] std::string_view value() const;
+        [[nodiscard]] std::size_t charge() const;
+    };
+    // intrusive FIFO: push at the tail, evict from the head
+    struct Queue {
+        Entry* head = nullptr;
+        Entry* tail = nullptr;
+        std::size_t bytes = 0;
+
+        void push_back(Entry* entry);
+        void unlink(Entry* entry);
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        // by key hash - the one already computed for the shard pick. two keys of a shard with the
+        // same 64 bit hash just can't be cached at the same time
+        std::unordered_map<uint64_t, Entry*> map;
+        Queue small;
+        Queue main;
+        std::deque<uint64_t> ghost_order;
+        std::unordered_set<uint64_t> ghosts;  // hashes of keys recently evicted from small
+        std::vector<uint64_t> doorkeeper;     // bloom filter of recently put hashes
+        std::size_t doorkeeper_set = 0;
+        uint64_t evictions = 0;
+
+        ~Shard();
+    };
+
+    static Entry* make_entry(uint64_t hash, std::string_view key, uint64_t version,
+                             std::string_view value);
+    static void free_entry(Entry* entry);
+
+    Shard& shard_for(uint64_t hash);
+    void remove(Shard& shard, Entry* entry);
+    void evict(Shard& shard);
+    void evict_small(Shard& shard);
+    void evict_main(Shard& shard);
+    void add_ghost(Shard& shard, uint64_t hash);
+    bool seen_before(Shard& shard, uint64_t hash);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shard_capacity_ = 0;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace kvstore::core
+
+#endif
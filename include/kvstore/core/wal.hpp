@@ -10,6 +10,7 @@
 #include <string>
 #include <string_view>
 
+#include "kvstore/core/istore.hpp"
 #include "kvstore/util/types.hpp"
 
 namespace kvstore::core {
@@ -33,6 +34,8 @@ class WriteAheadLog {
     WriteAheadLog& operator=(WriteAheadLog&&) noexcept;
 
     void log_put(std::string_view key, std::string_view value);
+    // one Put entry per key/value, flushed together
+    void log_puts(std::span<const KeyValue> entries);
     void log_put_with_ttl(std::string_view key, std::string_view value, int64_t expires_at_ms);
     void log_remove(std::string_view key);
     void log_clear();
@@ -13,13 +13,24 @@ class BinaryProtocol {
    public:
     // encode
     static std::vector<uint8_t> encode_request(const Request& req);
+    // the same bytes as pieces for a gathered write: key and value are not copied, out points at
+    // them
+    static void encode_request(const RequestView& req, EncodedRequest& out);
     static std::vector<uint8_t> encode_response(const Response& resp);
 
     // decode (return nullopt if incomplete)
     static std::optional<Request> decode_request(const std::vector<uint8_t>& data,
                                                  size_t& bytes_consumed);
+    // same, over size bytes at data (a connection's receive buffer)
+    static std::optional<Request> decode_request(const uint8_t* data, size_t size,
+                                                 size_t& bytes_consumed);
+    // same again, but key and value point into data instead of being copied out. no allocation
+    static std::optional<RequestView> decode_request_view(const uint8_t* data, size_t size,
+                                                          size_t& bytes_consumed);
     static std::optional<Response> decode_response(const std::vector<uint8_t>& data,
                                                    size_t& bytes_consumed);
+    static std::optional<Response> decode_response(const uint8_t* data, size_t size,
+                                                   size_t& bytes_consumed);
 
     // helpers
     static bool has_complete_message(const std::vector<uint8_t>& data);
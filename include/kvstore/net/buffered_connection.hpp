@@ -0,0 +1,80 @@
+#ifndef KVSTORE_NET_BUFFERED_CONNECTION_HPP
+#define KVSTORE_NET_BUFFERED_CONNECTION_HPP
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "kvstore/net/read_buffer.hpp"
+
+namespace kvstore::net {
+
+/*
+    the socket I/O under a protocol handler, client or server side - one per connection:
+    - reads go into a ReadBuffer the protocol decodes straight out of. one fill() is one readv over
+   the buffer's free space and a 64KB spill area on the stack: a burst bigger than the buffer still
+   comes in with one syscall, without every idle connection holding a big buffer. what lands in the
+   spill is appended behind the rest
+    - writes are gathered (sendmsg, writev with flags): a message goes out as the pieces it is
+   made of - framing, key, value - without concatenating them into one buffer first
+    - counts its syscalls, so a benchmark can show syscalls per request
+    - on a non-blocking socket fill() and write_some() return -1 with EAGAIN instead of waiting
+    it doesnt own the socket: whoever opened it closes it
+*/
+class BufferedConnection {
+   public:
+    // bytes a fill() can take beyond the buffer's free space
+    static constexpr std::size_t kSpillSize = 64 * 1024;
+
+    explicit BufferedConnection(int fd = -1,
+                                std::size_t base_capacity = ReadBuffer::kDefaultBaseCapacity);
+
+    BufferedConnection(const BufferedConnection&) = delete;
+    BufferedConnection& operator=(const BufferedConnection&) = delete;
+    BufferedConnection(BufferedConnection&&) noexcept = default;
+    BufferedConnection& operator=(BufferedConnection&&) noexcept = default;
+
+    [[nodiscard]] int fd() const noexcept {
+        return fd_;
+    }
+    // another socket (a reconnect): the bytes buffered from the old one are dropped, the syscall
+    // count keeps going
+    void reset(int fd) noexcept;
+
+    // received bytes the protocol hasnt consumed yet
+    [[nodiscard]] ReadBuffer& in() noexcept {
+        return in_;
+    }
+
+    // one read into in(), with at least min_free bytes of room in the buffer itself. the bytes
+    // read, 0 = the peer closed, -1 = error (errno). views into in() die here
+    [[nodiscard]] ssize_t fill(std::size_t min_free = 1);
+
+    // every byte of every piece, in order. as many calls as the socket needs, usually one.
+    // flags go to sendmsg next to MSG_NOSIGNAL (MSG_MORE: more follows right after)
+    [[nodiscard]] bool write(std::span<const std::string_view> pieces, int flags = 0);
+    [[nodiscard]] bool write(std::string_view bytes, int flags = 0);
+    // one send of as much of bytes as the socket takes now, for a non-blocking socket. the bytes
+    // sent, -1 = error (errno, EAGAIN: nothing fit)
+    [[nodiscard]] ssize_t write_some(std::string_view bytes);
+    // size bytes of file_fd from offset, file -> socket inside the kernel (sendfile). false also
+    // when the file ends early
+    [[nodiscard]] bool send_file(int file_fd, uint64_t offset, std::size_t size);
+
+    // recv/send/sendfile calls made so far
+    [[nodiscard]] uint64_t syscalls() const noexcept {
+        return syscalls_;
+    }
+
+   private:
+    int fd_;
+    ReadBuffer in_;
+    uint64_t syscalls_ = 0;
+};
+
+}  // namespace kvstore::net
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef KVSTORE_NET_CLIENT_ASYNC_CLIENT_HPP
+#define KVSTORE_NET_CLIENT_ASYNC_CLIENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::net::client {
+
+struct AsyncClientOptions {
+    std::string host = "127.0.0.1";
+    uint16_t port = 6379;
+    bool binary = false;
+    std::size_t connections = 4;  // sockets the calls are spread over (by key)
+    // how long a call may wait for its response. 0 = forever
+    util::Duration request_timeout = util::Duration(30000);
+};
+
+// per call settings
+struct CallOptions {
+    // overrides AsyncClientOptions::request_timeout when not 0
+    util::Duration timeout = util::Duration(0);
+};
+
+// what a future holds when its call didnt get a response in time
+class TimeoutError : public std::runtime_error {
+   public:
+    using std::runtime_error::runtime_error;
+};
+
+/*
+    the client for many calls in flight at once without a thread each: every call returns a future
+   right away, one event loop thread does all the socket I/O.
+    - calls are spread over a few non-blocking connections by key, so the calls on one key are
+   answered in the order they were made (a get sees the put before it). on each, requests are
+   pipelined: written back to back (everything queued since the last write goes out with one send)
+   and answered in order, so a connection carries any number of calls at a time
+    - the loop thread reads responses a buffer at a time and fulfills the futures, in order per
+   connection. a future holds what the Client call would return, or the exception it would throw
+    - a call that gets no response within its timeout fails with TimeoutError. its response still
+   arrives later and is dropped: the connection stays in step
+    - a connection the server closes fails the calls in flight on it; new calls go to the others.
+   with none left, calls fail straight away - disconnect() and connect() to start over
+    - thread-safe: any thread may make calls and wait on their futures
+*/
+class AsyncClient {
+   public:
+    explicit AsyncClient(const AsyncClientOptions& options = {});
+    // disconnects: calls still in flight fail
+    ~AsyncClient();
+
+    AsyncClient(const AsyncClient&) = delete;
+    AsyncClient& operator=(const AsyncClient&) = delete;
+
+    // opens every connection and starts the loop thread. throws if one cant be opened
+    void connect();
+    // stops the loop and closes the connections. calls in flight fail with runtime_error
+    void disconnect();
+    [[nodiscard]] bool connected() const noexcept;
+
+    [[nodiscard]] std::future<void> put(std::string_view key, std::string_view value,
+                                        const CallOptions& options = {});
+    [[nodiscard]] std::future<void> put(std::string_view key, std::string_view value,
+                                        util::Duration ttl, const CallOptions& options = {});
+    [[nodiscard]] std::future<std::optional<std::string>> get(std::string_view key,
+                                                              const CallOptions& options = {});
+    [[nodiscard]] std::future<bool> remove(std::string_view key, const CallOptions& options = {});
+    [[nodiscard]] std::future<bool> contains(std::string_view key,
+                                             const CallOptions& options = {});
+    [[nodiscard]] std::future<bool> ping(const CallOptions& options = {});
+
+    // calls sent or queued whose future isnt set yet
+    [[nodiscard]] std::size_t in_flight() const noexcept;
+    // socket, epoll and eventfd calls made so far (the loop's, and the callers' wakeups)
+    [[nodiscard]] uint64_t syscalls() const noexcept;
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::net::client
+
+#endif
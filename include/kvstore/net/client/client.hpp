@@ -7,6 +7,7 @@
 #include <string>
 #include <string_view>
 
+#include "kvstore/net/types.hpp"
 #include "kvstore/util/types.hpp"
 
 namespace kvstore::net::client {
@@ -18,6 +19,8 @@ struct ClientOptions {
     bool binary = false;
 };
 
+class Pipeline;
+
 class Client {
    public:
     explicit Client(const ClientOptions& options = {});
@@ -31,6 +34,8 @@ class Client {
     void connect();
     void disconnect();
     [[nodiscard]] bool connected() const noexcept;
+    // socket reads and writes made so far, over every connection this client had
+    [[nodiscard]] uint64_t syscalls() const noexcept;
 
     /*
         note: use cases for client APIs:
@@ -60,6 +65,13 @@ class Client {
     [[nodiscard]] bool ping();
 
    private:
+    friend class Pipeline;
+    // for Pipeline: requests encoded back to back and sent with one write, then their responses
+    // read one by one. a broken connection disconnects and throws, like every call here
+    void append_request(std::string& out, const RequestView& request);
+    void write_encoded(std::string_view bytes);
+    [[nodiscard]] Response read_response();
+
     class Impl;
     std::unique_ptr<Impl> impl_;
 };
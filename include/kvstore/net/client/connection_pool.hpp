@@ -0,0 +1,120 @@
+#ifndef KVSTORE_NET_CLIENT_CONNECTION_POOL_HPP
+#define KVSTORE_NET_CLIENT_CONNECTION_POOL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "kvstore/net/client/client.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::net::client {
+
+struct ConnectionPoolOptions {
+    ClientOptions client;  // every connection's
+    std::size_t min_size = 1;  // opened by the constructor, kept open while idle
+    // at most this many server connections, however many threads acquire: the rest wait
+    std::size_t max_size = 8;
+    // how long acquire() waits for a connection to come back before it throws. 0 = forever
+    util::Duration acquire_timeout = util::Duration(5000);
+    // a connection idle this long is pinged before it is handed out. 0 = on every acquire
+    util::Duration health_check_interval = util::Duration(5000);
+    // connections above min_size idle this long are closed. 0 = as soon as they come back
+    util::Duration idle_timeout = util::Duration(60000);
+};
+
+// what the pool did so far
+struct ConnectionPoolStats {
+    std::size_t open = 0;  // connections, leased or idle
+    std::size_t idle = 0;
+    uint64_t acquisitions = 0;
+    uint64_t waits = 0;     // acquisitions that waited for a lease to come back
+    uint64_t timeouts = 0;  // acquisitions that gave up waiting
+    uint64_t failed_health_checks = 0;
+    uint64_t reconnects = 0;  // connections reopened: found closed, or failed their ping
+    // time acquire() took, waiting, connecting and pinging included
+    std::chrono::nanoseconds total_acquire_time{0};
+    std::chrono::nanoseconds max_acquire_time{0};
+
+    [[nodiscard]] std::chrono::nanoseconds avg_acquire_time() const {
+        return acquisitions == 0 ? std::chrono::nanoseconds(0)
+                                 : total_acquire_time / static_cast<int64_t>(acquisitions);
+    }
+};
+
+/*
+    Client is one socket and not thread-safe. the pool shares a bounded set of them between
+   threads: acquire() leases a connection for as long as the Lease lives, its destructor gives it
+   back.
+    - at most max_size connections exist, so any number of threads maps to at most max_size server
+   connections (and with ServerMode::ThreadPerConnection, server threads). when all are leased,
+   acquire() waits for one to come back, up to acquire_timeout
+    - the most recently returned connection is handed out first, so under light load the same few
+   stay warm and the rest go idle and are closed after idle_timeout (never below min_size)
+    - lazy reconnect: a connection that broke while leased (Client disconnects itself on socket
+   errors) goes back like any other and is reopened by the acquire() that gets it next. one idle
+   for health_check_interval is pinged first and reopened if the ping fails - the server may have
+   restarted or dropped it meanwhile
+    - acquire() throws when it cant connect: the connection it would have opened doesnt count
+   against max_size
+    thread-safe. a Lease must not outlive its pool
+*/
+class ConnectionPool {
+   public:
+    class Lease;
+
+    // opens min_size connections, throws if one cant be opened
+    explicit ConnectionPool(const ConnectionPoolOptions& options = {});
+    // closes the idle connections. every Lease must be gone by now
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    [[nodiscard]] Lease acquire();
+    [[nodiscard]] Lease acquire(util::Duration timeout);  // instead of acquire_timeout
+
+    [[nodiscard]] ConnectionPoolStats stats() const;
+
+   private:
+    class Impl;
+    struct Slot;
+    std::unique_ptr<Impl> impl_;
+};
+
+// a connected Client of the pool, given back when this is destroyed (or release()d)
+class ConnectionPool::Lease {
+   public:
+    Lease(Lease&& other) noexcept;
+    Lease& operator=(Lease&& other) noexcept;
+    ~Lease();
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    [[nodiscard]] Client& client() const noexcept;
+    Client& operator*() const noexcept {
+        return client();
+    }
+    Client* operator->() const noexcept {
+        return &client();
+    }
+
+    // gives the connection back now. the lease is empty afterwards
+    void release() noexcept;
+    [[nodiscard]] explicit operator bool() const noexcept {
+        return slot_ != nullptr;
+    }
+
+   private:
+    friend class ConnectionPool;
+    Lease(Impl* pool, Slot* slot) noexcept : pool_(pool), slot_(slot) {}
+
+    Impl* pool_ = nullptr;
+    Slot* slot_ = nullptr;
+};
+
+}  // namespace kvstore::net::client
+
+#endif
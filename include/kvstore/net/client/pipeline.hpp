@@ -0,0 +1,89 @@
+#ifndef KVSTORE_NET_CLIENT_PIPELINE_HPP
+#define KVSTORE_NET_CLIENT_PIPELINE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "kvstore/net/client/client.hpp"
+#include "kvstore/net/types.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::net::client {
+
+// the answer to one pipelined call
+struct PipelineResult {
+    Command command = Command::Unknown;  // the call: Put, PutEx, Get, Del or Exists
+    Status status = Status::Ok;
+    std::string data;  // GET: the value. an error: the server's message
+
+    // false = the server answered with an error. the typed accessors then throw, as the Client
+    // call would have
+    [[nodiscard]] bool ok() const noexcept {
+        return status != Status::Error;
+    }
+    // put: throws if it failed
+    void check() const;
+    // get: the value, nullopt = not found
+    [[nodiscard]] std::optional<std::string> value() const;
+    // remove: whether the key was there
+    [[nodiscard]] bool removed() const;
+    // contains
+    [[nodiscard]] bool exists() const;
+};
+
+/*
+    calls queued on a connected Client and sent together: execute() writes everything queued with
+   one write and then reads the responses, one result per call in the order they were queued. the
+   round trip is paid once per batch instead of once per call, so a bulk load or a fan-out read
+   keeps a single connection busy instead of waiting on it.
+    - a call is encoded for the client's protocol (text or binary) when it is queued: key and value
+   are copied into the batch then, the caller's strings are free again right away
+    - execute() writes at most kMaxWriteBytes before reading the responses to it. a client that
+   wrote a huge batch without reading could fill the server's receive buffer while the server
+   blocks on sending responses into the client's full one - neither would ever move again
+    - the server runs a batch as it runs any pipelined requests (consecutive GETs and PUTs reach the
+   store as one multi_get / multi_put) - answers come back in order, a failed call doesnt stop the
+   ones behind it
+    - not thread-safe, and nothing else may use the client while execute() runs
+*/
+class Pipeline {
+   public:
+    // bytes of requests in flight at once. more is sent once their responses are read
+    static constexpr std::size_t kMaxWriteBytes = 64 * 1024;
+
+    // client must outlive the pipeline
+    explicit Pipeline(Client& client);
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+    Pipeline(Pipeline&&) noexcept;
+    Pipeline& operator=(Pipeline&&) noexcept;
+
+    Pipeline& put(std::string_view key, std::string_view value);
+    Pipeline& put(std::string_view key, std::string_view value, util::Duration ttl);
+    Pipeline& get(std::string_view key);
+    Pipeline& remove(std::string_view key);
+    Pipeline& contains(std::string_view key);
+
+    // calls queued since the last execute()
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+    void clear() noexcept;
+
+    // sends the queued calls and returns their results in order. the queue is empty afterwards,
+    // also when it throws: no connection, or a broken one (the client is then disconnected)
+    [[nodiscard]] std::vector<PipelineResult> execute();
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::net::client
+
+#endif
@@ -1,44 +1,60 @@
 #ifndef KVSTORE_NET_CLIENT_PROTOCOL_HANDLER_HPP
 #define KVSTORE_NET_CLIENT_PROTOCOL_HANDLER_HPP
 
-#include <cstdint>
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <string>
-#include <vector>
+#include <string_view>
 
+#include "kvstore/net/buffered_connection.hpp"
 #include "kvstore/net/types.hpp"
 
 namespace kvstore::net::client {
 
+/*
+    encodes requests and decodes responses over the client's BufferedConnection: a request goes out
+   with one gathered write of its framing, key and value (nothing concatenated), a response is
+   decoded out of the connection's read buffer - filled a buffer at a time, not a recv per byte
+*/
 class IProtocolHandler {
    public:
     virtual ~IProtocolHandler() = default;
 
-    [[nodiscard]] virtual bool write_request(int fd, const Request& request) = 0;
-    [[nodiscard]] virtual std::optional<Response> read_response(int fd) = 0;
+    [[nodiscard]] virtual bool write_request(BufferedConnection& conn,
+                                             const RequestView& request) = 0;
+    // the request's bytes appended to out, for several requests sent with one write
+    virtual void append_request(std::string& out, const RequestView& request) = 0;
+    // nullopt = the connection broke or closed before a whole response came in
+    [[nodiscard]] virtual std::optional<Response> read_response(BufferedConnection& conn) = 0;
+    // the first complete response in data, for a caller that reads the socket itself.
+    // nullopt = incomplete, wait for more bytes. consumed = the bytes it took
+    [[nodiscard]] virtual std::optional<Response> parse_response(std::string_view data,
+                                                                 std::size_t& consumed) = 0;
 };
 
 class TextProtocolHandler : public IProtocolHandler {
    public:
-    [[nodiscard]] bool write_request(int fd, const Request& request) override;
-    [[nodiscard]] std::optional<Response> read_response(int fd) override;
-
-   private:
-    std::string buffer_;
+    [[nodiscard]] bool write_request(BufferedConnection& conn,
+                                     const RequestView& request) override;
+    void append_request(std::string& out, const RequestView& request) override;
+    [[nodiscard]] std::optional<Response> read_response(BufferedConnection& conn) override;
+    [[nodiscard]] std::optional<Response> parse_response(std::string_view data,
+                                                         std::size_t& consumed) override;
 };
 
 class BinaryProtocolHandler : public IProtocolHandler {
    public:
-    [[nodiscard]] bool write_request(int fd, const Request& request) override;
-    [[nodiscard]] std::optional<Response> read_response(int fd) override;
-
-   private:
-    std::vector<uint8_t> buffer_;
+    [[nodiscard]] bool write_request(BufferedConnection& conn,
+                                     const RequestView& request) override;
+    void append_request(std::string& out, const RequestView& request) override;
+    [[nodiscard]] std::optional<Response> read_response(BufferedConnection& conn) override;
+    [[nodiscard]] std::optional<Response> parse_response(std::string_view data,
+                                                         std::size_t& consumed) override;
 };
 
 std::unique_ptr<IProtocolHandler> create_protocol_handler(bool binary);
 
 }  // namespace kvstore::net::client
 
-#endif
\ No newline at end of file
+#endif
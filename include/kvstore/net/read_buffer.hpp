@@ -0,0 +1,79 @@
+#ifndef KVSTORE_NET_READ_BUFFER_HPP
+#define KVSTORE_NET_READ_BUFFER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace kvstore::net {
+
+/*
+    a connection's receive buffer: bytes come in at the back (prepare + commit, or append), requests
+   are decoded straight out of data() and consumed from the front.
+    - consume() only moves the read position, so decoded requests can point into the buffer (see
+   RequestView) until the next prepare(). once everything is consumed both positions go back to
+   the start - with whole requests per read, that is the common case and nothing is ever moved
+    - the unread tail of a request split across reads is moved to the front only when the free space
+   behind it runs short. that is a few bytes, not the O(n) erase from the front per request of a
+   string buffer
+    - adaptive size: starts empty (an idle connection costs no buffer) at base_capacity on the first
+   prepare. a read that fills all the space offered doubles it for the next one, a request larger
+   than the buffer grows it to fit. once drained after small reads it shrinks back to the base
+    - not a true ring: a decoder needs every request contiguous, which wrapping around would break
+*/
+class ReadBuffer {
+   public:
+    static constexpr std::size_t kDefaultBaseCapacity = 16 * 1024;
+    // reads filling the buffer grow it up to here. a single larger request still fits
+    static constexpr std::size_t kMaxAdaptiveCapacity = 1024 * 1024;
+
+    explicit ReadBuffer(std::size_t base_capacity = kDefaultBaseCapacity);
+
+    ReadBuffer(const ReadBuffer&) = delete;
+    ReadBuffer& operator=(const ReadBuffer&) = delete;
+    ReadBuffer(ReadBuffer&&) noexcept = default;
+    ReadBuffer& operator=(ReadBuffer&&) noexcept = default;
+
+    // the bytes not consumed yet
+    [[nodiscard]] std::string_view data() const noexcept {
+        return {buffer_.get() + begin_, end_ - begin_};
+    }
+    [[nodiscard]] std::size_t size() const noexcept {
+        return end_ - begin_;
+    }
+    [[nodiscard]] bool empty() const noexcept {
+        return begin_ == end_;
+    }
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    // all the free space behind data(), at least min_free bytes of it - read into it, then
+    // commit() what arrived. may move or reallocate the bytes: views into data() die here
+    [[nodiscard]] std::span<char> prepare(std::size_t min_free = 1);
+    // n bytes of the last prepare() now hold data
+    void commit(std::size_t n) noexcept;
+    // prepare + copy + commit, for bytes that already landed somewhere else
+    void append(std::string_view bytes);
+    // drop n bytes from the front. views into data() stay valid
+    void consume(std::size_t n) noexcept;
+    void clear() noexcept;
+
+   private:
+    void reallocate(std::size_t capacity);
+
+    std::unique_ptr<char[]> buffer_;
+    std::size_t capacity_ = 0;
+    std::size_t begin_ = 0;  // first unread byte
+    std::size_t end_ = 0;    // one past the last byte read
+    std::size_t base_capacity_;
+    std::size_t target_capacity_ = 0;  // what the next prepare() grows to, after a full read
+    std::size_t offered_ = 0;          // free bytes the last prepare() handed out
+    bool drained_ = false;             // everything was consumed since the last prepare()
+    bool big_reads_ = false;  // some read since the buffer was last drained needed the growth
+};
+
+}  // namespace kvstore::net
+
+#endif
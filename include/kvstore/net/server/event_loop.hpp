@@ -0,0 +1,79 @@
+#ifndef KVSTORE_NET_SERVER_EVENT_LOOP_HPP
+#define KVSTORE_NET_SERVER_EVENT_LOOP_HPP
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "kvstore/core/disk_store.hpp"
+#include "kvstore/net/server/server.hpp"
+#include "kvstore/net/types.hpp"
+
+namespace kvstore::net::server {
+
+// what the event loop needs from the server: an answer to every request
+class RequestHandler {
+   public:
+    virtual ~RequestHandler() = default;
+    // a run of one connection's pipelined requests, answered in order: one response each,
+    // appended to responses. consecutive GETs and PUTs reach the store as one batch call. stops
+    // after a response that closes the connection - the requests behind it are not run. must not
+    // throw - failures become error responses. regions, from a caller that can sendfile: one
+    // entry per response. a GET of a large DiskStore value is answered with its file region
+    // there, found in the same index lookup as the rest - responses holds a placeholder Ok for it
+    virtual void handle_batch(std::span<const RequestView> requests,
+                              std::vector<Response>& responses,
+                              std::vector<std::optional<core::ValueRegion>>* regions) = 0;
+};
+
+struct EventLoopOptions {
+    std::size_t threads = 0;  // reactors. 0 = one per core
+    std::size_t max_connections = 1000;
+    int client_timeout_seconds = 300;  // idle connections are closed after this. 0 = never
+    bool binary_only = false;
+};
+
+/*
+    N reactor threads serving every connection of one listening socket, instead of a thread per
+   connection:
+    - each reactor runs its own epoll loop over the non-blocking sockets it accepted. the listening
+   socket is in every reactor's epoll with EPOLLEXCLUSIVE, so a new connection wakes one reactor,
+   which keeps it for good - no locks, no hand-off between threads
+    - a connection owns a read buffer (bytes not yet a complete request) and a write queue
+   (responses the socket didnt take yet, plus sendfile regions for large DiskStore values). every
+   complete request in a read is answered before one write goes out, so pipelined requests cost one
+   send
+    - a slow reader doesnt grow the write queue without bound: past a limit the reactor stops
+   reading from that connection until the queue drains
+    - over max_connections a new connection is accepted and closed straight away
+    - the store calls still block the reactor. with a slow store (DiskStore reads under compaction)
+   use enough reactors, or the thread per connection server
+*/
+class EventLoop {
+   public:
+    // listen_fd: a bound, listening socket. it is made non-blocking, the caller still owns it
+    EventLoop(int listen_fd, RequestHandler& handler, const EventLoopOptions& options = {});
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void start();
+    // closes every connection and joins the reactors
+    void stop();
+
+    [[nodiscard]] std::size_t threads() const noexcept;
+    [[nodiscard]] std::size_t connections() const noexcept;
+    // totals of the reactors that ended - complete after stop()
+    [[nodiscard]] ServerStats stats() const noexcept;
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::net::server
+
+#endif
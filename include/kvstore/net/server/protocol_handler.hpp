@@ -1,41 +1,102 @@
 #ifndef KVSTORE_NET_SERVER_PROTOCOL_HANDLER_HPP
 #define KVSTORE_NET_SERVER_PROTOCOL_HANDLER_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "kvstore/net/buffered_connection.hpp"
 #include "kvstore/net/types.hpp"
 
 namespace kvstore::net::server {
 
+// the bytes a protocol sends around a GET value that comes straight from a file
+struct FileValueFraming {
+    std::string prefix;
+    std::string suffix;
+};
+
+/*
+    one protocol, two ways to drive it:
+    - blocking, one connection per thread: the handler does the socket I/O itself, through a
+   BufferedConnection, and buffers both ways. read_requests hands out every request a client
+   pipelined at once, their responses are queued and flushed with one send. a handler serves one
+   connection: fd is the same on every call
+    - event loop: the caller owns the buffers and the non-blocking socket, the handler only
+   decodes (parse_request) and encodes (append_response, file_value_framing)
+    requests come out as RequestViews into the receive buffer: decoding copies and allocates
+   nothing
+*/
 class IProtocolHandler {
    public:
     virtual ~IProtocolHandler() = default;
-    [[nodiscard]] virtual std::optional<Request> read_request(int fd) = 0;
-    [[nodiscard]] virtual bool write_response(int fd, const Response& response) = 0;
+
+    // every complete request already buffered, in order. reads from fd only while there is none.
+    // empty = the client is gone. a malformed request throws, once the ones before it are out.
+    // the requests stay valid until the next call
+    [[nodiscard]] std::span<const RequestView> read_requests(int fd);
+
+    // responses wait in the handler until flush() sends them together
+    void queue_response(const Response& response);
+    // the Ok response to a GET, with the value sent straight from size bytes of file_fd at offset
+    // (sendfile) - only the protocol framing goes through user space. what is queued goes out
+    // ahead of it, in the same segment. false = connection broken, including a file that turned
+    // out shorter than size (the response is already half sent)
+    [[nodiscard]] bool queue_file_value(int fd, int file_fd, uint64_t offset, std::size_t size);
+    [[nodiscard]] bool flush(int fd);
+    [[nodiscard]] std::size_t queued() const noexcept {
+        return out_.size();
+    }
+
+    // one response, sent right away
+    [[nodiscard]] bool write_response(int fd, const Response& response);
+    [[nodiscard]] bool write_file_value(int fd, int file_fd, uint64_t offset, std::size_t size);
+
+    // the first complete request in data, pointing into it. nullopt = incomplete, wait for more
+    // bytes. consumed = the bytes it took. throws on a malformed request (the connection cant be
+    // resynced)
+    [[nodiscard]] virtual std::optional<RequestView> parse_request(std::string_view data,
+                                                                   std::size_t& consumed) = 0;
+    virtual void append_response(std::string& out, const Response& response) = 0;
+    [[nodiscard]] virtual FileValueFraming file_value_framing(std::size_t size) = 0;
+
+    // recv/send/sendfile calls the blocking side made so far
+    [[nodiscard]] uint64_t syscalls() const noexcept {
+        return conn_.syscalls();
+    }
+
+   private:
+    BufferedConnection& connection(int fd) noexcept;
+
+    BufferedConnection conn_;  // its read buffer: bytes not yet a complete request
+    std::vector<RequestView> requests_;  // what read_requests handed out last
+    std::string out_;                    // queued responses
 };
 
 class TextProtocolHandler : public IProtocolHandler {
    public:
-    [[nodiscard]] std::optional<Request> read_request(int fd) override;
-    [[nodiscard]] bool write_response(int fd, const Response& response) override;
-
-   private:
-    std::string buffer_;
+    [[nodiscard]] std::optional<RequestView> parse_request(std::string_view data,
+                                                           std::size_t& consumed) override;
+    void append_response(std::string& out, const Response& response) override;
+    [[nodiscard]] FileValueFraming file_value_framing(std::size_t size) override;
 };
 
 class BinaryProtocolHandler : public IProtocolHandler {
    public:
-    [[nodiscard]] std::optional<Request> read_request(int fd) override;
-    [[nodiscard]] bool write_response(int fd, const Response& response) override;
-
-   private:
-    std::vector<uint8_t> buffer_;
+    [[nodiscard]] std::optional<RequestView> parse_request(std::string_view data,
+                                                           std::size_t& consumed) override;
+    void append_response(std::string& out, const Response& response) override;
+    [[nodiscard]] FileValueFraming file_value_framing(std::size_t size) override;
 };
 
+// the handler for a connection whose first byte is first_byte
+std::unique_ptr<IProtocolHandler> protocol_handler_for(uint8_t first_byte);
+
 std::unique_ptr<IProtocolHandler> create_protocol_handler(int fd, bool force_binary = false);
 
 }  // namespace kvstore::net::server
@@ -10,12 +10,31 @@
 
 namespace kvstore::net::server {
 
+enum class ServerMode {
+    ThreadPerConnection,  // one blocking thread per client
+    EventLoop,            // reactor_threads epoll loops serve every client (event_loop.hpp)
+    IoUring,  // reactor_threads io_uring loops (uring_loop.hpp). EventLoop if the kernel cant
+};
+
+// what the server did so far. complete once stop() returned - running connections and loops
+// report when they end
+struct ServerStats {
+    uint64_t requests = 0;
+    // network syscalls: accept/recv/send/sendfile/close, epoll_wait/epoll_ctl, io_uring_enter
+    uint64_t syscalls = 0;
+};
+
 struct ServerOptions {
     std::string host = "127.0.0.1";  // local host
     uint16_t port = 6379;            // redis' default port. convention for k-v stores
     std::size_t max_connections = 1000;
     int client_timeout_seconds = 300;  // 5 minutes
     bool binary_only = false;
+    // DiskStore only: GET values of at least this many bytes go from the data file to the socket
+    // with sendfile, never through a std::string. 0 = always copy
+    std::size_t sendfile_threshold = 64 * 1024;
+    ServerMode mode = ServerMode::ThreadPerConnection;
+    std::size_t reactor_threads = 0;  // EventLoop and IoUring. 0 = one per core
 };
 
 class Server {
@@ -38,6 +57,7 @@ class Server {
 
     [[nodiscard]] bool running() const noexcept;
     [[nodiscard]] uint16_t port() const noexcept;
+    [[nodiscard]] ServerStats stats() const noexcept;
 
    private:
     class Impl;
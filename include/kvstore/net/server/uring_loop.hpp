@@ -0,0 +1,56 @@
+#ifndef KVSTORE_NET_SERVER_URING_LOOP_HPP
+#define KVSTORE_NET_SERVER_URING_LOOP_HPP
+
+#include <cstddef>
+#include <memory>
+
+#include "kvstore/net/server/event_loop.hpp"
+#include "kvstore/net/server/server.hpp"
+
+namespace kvstore::net::server {
+
+/*
+    the event loop again, but driven by io_uring instead of readiness + syscalls:
+    - each thread owns a ring. one multishot accept per ring on the shared listening socket, one
+   multishot recv per connection. recvs land in a provided buffer ring (the kernel picks a free
+   buffer), get copied into the connection's read buffer and the buffer goes straight back
+    - responses to every request of a round of completions are queued as one send per
+   connection, and the sends of all connections go to the kernel together with the wait for the
+   next completions: one io_uring_enter per round. under pipelined load that is well below one
+   syscall per request
+    - a connection with too much unsent output gets its recv cancelled until the output drains
+    - no sendfile: large DiskStore values are copied like any other response
+    - needs Linux 6.0 (multishot recv, IORING_SETUP_SINGLE_ISSUER) and a kernel that allows
+   io_uring at all - containers often forbid it. supported() probes once; Server falls back to
+   the epoll EventLoop without it
+*/
+class UringLoop {
+   public:
+    // listen_fd: a bound, listening socket, the caller still owns it
+    UringLoop(int listen_fd, RequestHandler& handler, const EventLoopOptions& options = {});
+    ~UringLoop();
+
+    UringLoop(const UringLoop&) = delete;
+    UringLoop& operator=(const UringLoop&) = delete;
+
+    // throws std::runtime_error if a ring cant be set up (nothing keeps running then)
+    void start();
+    // closes every connection and joins the ring threads
+    void stop();
+
+    [[nodiscard]] std::size_t threads() const noexcept;
+    [[nodiscard]] std::size_t connections() const noexcept;
+    // totals of the ring threads that ended - complete after stop()
+    [[nodiscard]] ServerStats stats() const noexcept;
+
+    // built with io_uring and the running kernel has everything this loop uses
+    [[nodiscard]] static bool supported();
+
+   private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace kvstore::net::server
+
+#endif
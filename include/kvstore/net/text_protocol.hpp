@@ -2,25 +2,39 @@
 #define KVSTORE_NET_TEXT_PROTOCOL_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "kvstore/net/types.hpp"
 
 namespace kvstore::net {
 
+/*
+    one request per line: COMMAND [key] [ttl_ms] [value...], words separated by whitespace.
+    - the command is case-insensitive, aliases included (SET = PUT, DELETE = DEL, ...)
+    - the value is the rest of the line after the key (PUTEX: after the ttl) - spaces inside it are
+   kept as sent, whitespace around it is not part of it
+    - a missing key/value or a bad ttl makes the request Unknown, extra words after a key are
+   ignored
+*/
 class TextProtocol {
    public:
     // Encode
     static std::string encode_request(const Request& req);
+    // the same line as pieces for a gathered write: key and value are not copied, out points at
+    // them
+    static void encode_request(const RequestView& req, EncodedRequest& out);
     static std::string encode_response(const Response& resp);
 
     // Decode
-    static Request decode_request(const std::string& line);
-    static Response decode_response(const std::string& line);
+    // line without its newline. one pass over it, no allocation: key and value point into line
+    static RequestView decode_request_view(std::string_view line);
+    static Request decode_request(std::string_view line);
+    static Response decode_response(std::string_view line);
 
     // Conversions
     static std::string command_to_string(Command cmd);
-    static Command parse_command(const std::string& str);
+    static Command parse_command(std::string_view str);
 };
 
 }  // namespace kvstore::net
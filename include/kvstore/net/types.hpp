@@ -1,8 +1,12 @@
 #ifndef KVSTORE_NET_TYPES_HPP
 #define KVSTORE_NET_TYPES_HPP
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 
 namespace kvstore::net {
 
@@ -36,6 +40,53 @@ struct Request {
     int64_t ttl_ms = 0;
 };
 
+// a request whose key and value point into bytes someone else owns - usually a connection's read
+// buffer, so decoding copies nothing. valid as long as those bytes are
+struct RequestView {
+    Command command = Command::Unknown;
+    std::string_view key;
+    std::string_view value;
+    int64_t ttl_ms = 0;
+
+    static RequestView of(const Request& req) {
+        return {req.command, req.key, req.value, req.ttl_ms};
+    }
+
+    [[nodiscard]] Request to_request() const {
+        return {command, std::string(key), std::string(value), ttl_ms};
+    }
+};
+
+// an encoded request as the pieces a gathered write sends in order: key and value go out from
+// where they already are instead of being copied in behind the protocol's framing. the framing
+// bytes that arent constants live in frame - pieces point into it, so it cant be copied
+struct EncodedRequest {
+    static constexpr std::size_t kMaxPieces = 6;
+
+    EncodedRequest() = default;
+    EncodedRequest(const EncodedRequest&) = delete;
+    EncodedRequest& operator=(const EncodedRequest&) = delete;
+
+    std::array<char, 32> frame{};
+    std::array<std::string_view, kMaxPieces> pieces{};
+    std::size_t count = 0;
+
+    void add(std::string_view piece) noexcept {
+        pieces[count++] = piece;
+    }
+    [[nodiscard]] std::span<const std::string_view> view() const noexcept {
+        return {pieces.data(), count};
+    }
+    // the bytes in one string, as encode_request returns them
+    [[nodiscard]] std::string join() const {
+        std::string bytes;
+        for (std::string_view piece : view()) {
+            bytes += piece;
+        }
+        return bytes;
+    }
+};
+
 // protocol-agnostic response
 struct Response {
     Status status = Status::Ok;
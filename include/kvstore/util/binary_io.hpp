@@ -2,6 +2,7 @@
 #define KVSTORE_UTIL_BINARY_IO_HPP
 
 #include <cstdint>
+#include <cstring>
 #include <istream>
 #include <optional>
 #include <ostream>
@@ -97,6 +98,41 @@ inline bool read_string(std::istream& in, std::string& str) {
 //     return value;
 // }
 
+// ============================================================================
+// Raw buffer I/O (for files - records encoded in memory, written with one syscall)
+// ============================================================================
+/*
+    same byte layout as the stream-based functions above (native byte order, raw bytes) so a
+   record built in a buffer is bit-identical to one written field by field through an ostream.
+    note: these are NOT the big-endian network helpers below - never mix the two on one format
+*/
+
+template <typename T>
+void append_int(std::string& buf, T value) {
+    static_assert(std::is_integral_v<T>, "T must be integral");
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void append_string(std::string& buf, std::string_view str) {
+    append_int<uint32_t>(buf, static_cast<uint32_t>(str.size()));
+    buf.append(str.data(), str.size());
+}
+
+template <typename T>
+T load_int(const char* data) {
+    static_assert(std::is_integral_v<T>, "T must be integral");
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// write at a fixed position (e.g. a page header) instead of appending
+template <typename T>
+void store_int(char* data, T value) {
+    static_assert(std::is_integral_v<T>, "T must be integral");
+    std::memcpy(data, &value, sizeof(value));
+}
+
 // ============================================================================
 // Buffer-based I/O (for network - binary protocol)
 // ============================================================================
@@ -132,6 +168,15 @@ T read_int(const uint8_t* data) {
     return value;
 }
 
+// write_int at a fixed position: the same big-endian bytes, into data instead of appended
+template <typename T>
+void write_int(uint8_t* data, T value) {
+    static_assert(std::is_integral_v<T>, "T must be integral");
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        data[i] = static_cast<uint8_t>((value >> ((sizeof(T) - 1 - i) * 8)) & 0xFF);
+    }
+}
+
 inline void write_string(std::vector<uint8_t>& buf, std::string_view s) {
     write_int<uint32_t>(buf, static_cast<uint32_t>(s.size()));
     buf.insert(buf.end(), s.begin(), s.end());
@@ -147,6 +192,17 @@ inline std::string read_string(const uint8_t* data, size_t& offset, size_t max_s
     return result;
 }
 
+// read_string without the copy: a view of the bytes at data
+inline std::string_view read_string_view(const uint8_t* data, size_t& offset, size_t max_size) {
+    uint32_t len = read_int<uint32_t>(data, offset, max_size);
+    if (offset + len > max_size) {
+        throw std::runtime_error("Buffer underflow reading string");
+    }
+    std::string_view result(reinterpret_cast<const char*>(data + offset), len);
+    offset += len;
+    return result;
+}
+
 // inline void write_uint32_be(std::vector<uint8_t>& buf, uint32_t value) {
 //     buf.push_back((value >> 24) & 0xFF);  // most significant byte
 //     buf.push_back((value >> 16) & 0xFF);
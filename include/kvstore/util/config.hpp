@@ -17,12 +17,27 @@ struct Config {
     uint16_t port = 6379;
     std::size_t max_connections = 1000;
     int client_timeout_seconds = 300;
+    bool event_loop = false;          // epoll reactors instead of a thread per connection
+    std::size_t reactor_threads = 0;  // event loop: reactor count, 0 = one per core
+    bool io_uring = false;            // event loop on io_uring rings, epoll if the kernel cant
 
     // storage
     std::filesystem::path data_dir = "./data";
     std::size_t snapshot_threshold = 10000;
     std::size_t compaction_threshold = 1000;
     bool use_disk_store = false;
+    bool compact_index = false;  // DiskStore: hash -> offset index instead of keys in memory
+    std::size_t blob_threshold = 0;  // DiskStore: values this big go to the blob log, 0 = off
+    bool use_io_uring = false;       // DiskStore: batched reads through io_uring
+    bool direct_io = false;          // DiskStore: O_DIRECT reads + in-process block cache
+    std::size_t block_cache_mb = 64;  // DiskStore: block cache size with direct_io
+    std::size_t value_cache_mb = 0;   // DiskStore: cache of hot values, 0 = off
+    bool use_tiered_store = false;  // in-memory hot tier over a DiskStore, wins over use_disk_store
+    std::size_t hot_tier_mb = 64;     // tiered store: memory budget of the hot tier
+    std::filesystem::path ingest_dir;  // DiskStore: SIGHUP adopts the kvstore-ingest output here
+    bool use_lsm_store = false;  // LSM-tree engine, takes precedence over use_disk_store
+    bool use_btree_store = false;  // B+tree engine, used if use_lsm_store is off
+    bool use_mmap_store = false;   // mmap'd hash table engine, after the lsm and btree flags
 
     // logging
     LogLevel log_level = LogLevel::Info;
@@ -0,0 +1,24 @@
+#ifndef KVSTORE_UTIL_CRC32C_HPP
+#define KVSTORE_UTIL_CRC32C_HPP
+
+#include <cstdint>
+#include <string_view>
+
+namespace kvstore::util {
+
+/*
+    CRC-32C (Castagnoli) - the checksum of iSCSI, ext4 metadata, leveldb/rocksdb log records.
+    - x86-64 with SSE4.2 uses the crc32 instruction (8 bytes per instruction), picked at runtime so
+   the build doesnt need -msse4.2. everything else: table driven, slicing-by-8
+    - both produce the same value, so files move freely between machines
+    unlike hash64 this detects every burst error up to 32 bits, which is what torn/partial writes
+   and flipped bits look like
+*/
+[[nodiscard]] uint32_t crc32c(std::string_view data);
+
+// continue a checksum: crc32c_extend(crc32c(a), b) == crc32c(a + b)
+[[nodiscard]] uint32_t crc32c_extend(uint32_t crc, std::string_view data);
+
+}  // namespace kvstore::util
+
+#endif
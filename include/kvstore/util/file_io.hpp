@@ -0,0 +1,38 @@
+#ifndef KVSTORE_UTIL_FILE_IO_HPP
+#define KVSTORE_UTIL_FILE_IO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace kvstore::util {
+
+/*
+    thin wrappers over POSIX file descriptors for the storage engines.
+    - pread/pwrite may transfer less than asked (signals, huge buffers) - these loop until done
+    - all of them throw std::runtime_error on failure, like the stream helpers in binary_io.hpp
+    - short reads at EOF are errors here: callers only read ranges they know exist
+*/
+
+// open for read+write, creating the file if needed
+[[nodiscard]] int open_file(const std::filesystem::path& path);
+
+void pwrite_all(int fd, const char* data, std::size_t len, uint64_t offset);
+void pread_all(int fd, char* data, std::size_t len, uint64_t offset);
+
+// fdatasync where available - skips metadata that isnt needed to read the data back (e.g. mtime)
+void sync_file(int fd);
+
+[[nodiscard]] uint64_t file_size(int fd);
+
+// make a create/rename/unlink inside dir durable - fdatasync only covers the file's own contents
+void sync_directory(const std::filesystem::path& dir);
+
+// reserve disk blocks for [offset, offset + len) without changing the file size, so appends into
+// the range dont allocate (no block allocation/extent updates per write). best effort: false where
+// the filesystem or platform cant, and on errors such as ENOSPC - the writes then allocate as usual
+bool preallocate(int fd, uint64_t offset, uint64_t len);
+
+}  // namespace kvstore::util
+
+#endif
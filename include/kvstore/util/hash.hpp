@@ -0,0 +1,45 @@
+#ifndef KVSTORE_UTIL_HASH_HPP
+#define KVSTORE_UTIL_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace kvstore::util {
+
+/*
+    stable 64-bit string hash for anything that gets persisted (bloom filters, on-disk indexes).
+    std::hash is fine for in-memory containers but its output is implementation defined - a file
+   written by one standard library build must read back the same with another.
+    FNV-1a over the bytes, then the splitmix64 finalizer: FNV alone mixes the high bits poorly,
+   which matters when we derive several probe positions from one hash.
+*/
+inline uint64_t hash64(std::string_view data) {
+    uint64_t h = 0xcbf29ce484222325ULL;  // FNV offset basis
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 0x100000001b3ULL;  // FNV prime
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// std::hash for unordered containers keyed by std::string that are looked up by string_view.
+// together with std::equal_to<> as the key equality, find() takes the view as it is instead of
+// building a std::string from it first
+struct StringHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view str) const noexcept {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+}  // namespace kvstore::util
+
+#endif
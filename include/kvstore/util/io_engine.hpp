@@ -0,0 +1,78 @@
+#ifndef KVSTORE_UTIL_IO_ENGINE_HPP
+#define KVSTORE_UTIL_IO_ENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace kvstore::util {
+
+/*
+    positional file I/O for the storage engines, behind one interface with two backends:
+    - Sync: pread/pwrite on the calling thread, one syscall per op. always available
+    - IoUring: a shared io_uring (raw syscalls, no liburing needed). a batch goes to the kernel
+   with one io_uring_enter and all of it is in flight at once, so one thread keeps many reads
+   outstanding instead of blocking on each in turn. built when the kernel headers have
+   linux/io_uring.h (KVSTORE_HAVE_IO_URING) and used when the running kernel allows it - otherwise
+   make_io_engine falls back to Sync
+    - every backend is thread safe. with IoUring concurrent callers share the ring: whoever waits
+   reaps completions for everybody
+*/
+enum class IoBackend : uint8_t { Sync, IoUring };
+
+struct IoOp {
+    enum class Kind : uint8_t { Read, Write };
+
+    Kind kind = Kind::Read;
+    int fd = -1;
+    char* data = nullptr;  // read: destination, write: source
+    std::size_t len = 0;
+    uint64_t offset = 0;
+};
+
+// bytes transferred, or -errno
+using IoCallback = std::function<void(int64_t result)>;
+
+class IoEngine {
+   public:
+    virtual ~IoEngine() = default;
+
+    // run every op and return once all of them are done. transfers are always complete (short
+    // ones are continued) - like pread_all/pwrite_all this throws std::runtime_error on failure,
+    // but only after every op of the batch finished, so the buffers are free again either way
+    virtual void run(std::span<const IoOp> ops) = 0;
+
+    // async: start op and return. callback gets the raw result (may be a short transfer) and
+    // runs on the thread that calls poll(). data must stay valid until then
+    virtual void submit(const IoOp& op, IoCallback callback) = 0;
+    // run the callbacks of finished submit()s. wait = block until at least one is done (returns
+    // right away if nothing is outstanding). returns the number of callbacks run
+    virtual std::size_t poll(bool wait) = 0;
+
+    // let the kernel keep the file / buffers mapped instead of looking them up per op. ops that
+    // use a registered fd, or whose data lies in a registered buffer, pick it up automatically.
+    // false = not supported by this backend (still correct, just not faster)
+    virtual bool register_file(int fd) = 0;
+    virtual void unregister_file(int fd) = 0;  // before closing it
+    // replaces any earlier registration
+    virtual bool register_buffers(const std::vector<std::span<char>>& buffers) = 0;
+
+    [[nodiscard]] virtual IoBackend backend() const = 0;
+};
+
+// queue_depth: io_uring submission queue size - ops past that wait for a free slot
+[[nodiscard]] std::unique_ptr<IoEngine> make_io_engine(IoBackend backend,
+                                                       unsigned queue_depth = 256);
+
+// compiled in and allowed by the running kernel (containers often forbid io_uring_setup)
+[[nodiscard]] bool io_uring_available();
+
+[[nodiscard]] std::string_view to_string(IoBackend backend);
+
+}  // namespace kvstore::util
+
+#endif
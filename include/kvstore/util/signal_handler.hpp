@@ -6,16 +6,23 @@
 
 namespace kvstore::util {
 
+enum class SignalEvent { Shutdown, Reload };
+
+// SIGINT/SIGTERM ask for a shutdown, SIGHUP for a reload (the server adopts an ingested data file)
 class SignalHandler {
    public:
     static void install();
     static bool should_shutdown();
     static void wait_for_shutdown();
     static void request_shutdown();
+    static void request_reload();
+    // blocks until either is requested. a shutdown wins, a reload is consumed by returning it
+    static SignalEvent wait_for_event();
     static void reset();
 
    private:
     static std::atomic<bool> shutdown_requested_;
+    static std::atomic<bool> reload_requested_;
 };
 
 }  // namespace kvstore::util
@@ -0,0 +1,211 @@
+#include "kvstore/core/blob_log.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/file_io.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+BlobLog::BlobLog(const std::filesystem::path& dir, std::size_t segment_size)
+    : dir_(dir), segment_size_(segment_size) {
+    std::filesystem::create_directories(dir_);
+
+    // pick up existing segments: NNNNNN.blob
+    try {
+        for (const auto& file : std::filesystem::directory_iterator(dir_)) {
+            const auto& path = file.path();
+            if (path.extension() != ".blob") {
+                continue;
+            }
+            const std::string stem = path.stem().string();
+            if (stem.empty() || stem.find_first_not_of("0123456789") != std::string::npos) {
+                continue;
+            }
+            open_segment(static_cast<uint32_t>(std::stoul(stem)));
+        }
+        if (segments_.empty()) {
+            open_segment(1);
+        }
+        active_ = segments_.rbegin()->first;
+        // a crash can leave a torn record at the end of the old active segment. never append
+        // behind it - GC's sequential scan would stop there and miss everything after
+        if (segments_.at(active_).size > kHeaderSize) {
+            roll();
+        }
+    } catch (...) {
+        for (auto& [id, segment] : segments_) {
+            ::close(segment.fd);
+        }
+        throw;
+    }
+}
+
+BlobLog::~BlobLog() {
+    for (auto& [id, segment] : segments_) {
+        ::close(segment.fd);
+    }
+}
+
+BlobPointer BlobLog::encode(std::string& buf, std::string_view key, std::string_view value) const {
+    BlobPointer pointer{active_, segments_.at(active_).size + buf.size(),
+                        static_cast<uint32_t>(value.size())};
+    util::append_string(buf, key);
+    util::append_string(buf, value);
+    return pointer;
+}
+
+void BlobLog::append(const std::string& buf) {
+    Segment& segment = segments_.at(active_);
+    util::pwrite_all(segment.fd, buf.data(), buf.size(), segment.size);
+    segment.size += buf.size();
+}
+
+void BlobLog::sync() {
+    util::sync_file(segments_.at(active_).fd);
+}
+
+bool BlobLog::needs_roll() const {
+    return segments_.at(active_).size >= segment_size_;
+}
+
+void BlobLog::roll() {
+    open_segment(active_ + 1);
+    active_ += 1;
+}
+
+std::string BlobLog::read(const BlobPointer& pointer, std::size_t key_size) const {
+    auto it = segments_.find(pointer.segment);
+    if (it == segments_.end()) {
+        throw std::runtime_error("missing blob segment " + std::to_string(pointer.segment));
+    }
+    std::string value(pointer.size, '\0');
+    util::pread_all(it->second.fd, value.data(), value.size(), pointer.offset + 4 + key_size + 4);
+    return value;
+}
+
+std::pair<int, uint64_t> BlobLog::locate(const BlobPointer& pointer, std::size_t key_size) const {
+    auto it = segments_.find(pointer.segment);
+    if (it == segments_.end()) {
+        throw std::runtime_error("missing blob segment " + std::to_string(pointer.segment));
+    }
+    return {it->second.fd, pointer.offset + 4 + key_size + 4};
+}
+
+bool BlobLog::contains(const BlobPointer& pointer, std::size_t key_size) const {
+    auto it = segments_.find(pointer.segment);
+    return it != segments_.end() && pointer.offset >= kHeaderSize &&
+           pointer.offset + record_size(key_size, pointer.size) <= it->second.size;
+}
+
+uint32_t BlobLog::active_segment() const {
+    return active_;
+}
+
+std::vector<uint32_t> BlobLog::segments() const {
+    std::vector<uint32_t> ids;
+    ids.reserve(segments_.size());
+    for (const auto& [id, segment] : segments_) {
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+uint64_t BlobLog::segment_bytes(uint32_t segment) const {
+    auto it = segments_.find(segment);
+    return it == segments_.end() ? 0 : it->second.size;
+}
+
+void BlobLog::for_each_record(
+    uint32_t segment,
+    const std::function<bool(const BlobPointer&, std::string_view, std::string_view)>& callback)
+    const {
+    std::ifstream in(segment_path(segment), std::ios::binary);
+    if (!in.is_open()) {
+        return;
+    }
+    in.seekg(static_cast<std::streamoff>(kHeaderSize));
+
+    std::string key;
+    std::string value;
+    while (in.peek() != EOF) {
+        uint64_t offset = in.tellg();
+        if (!util::read_string(in, key) || !util::read_string(in, value)) {
+            break;  // torn tail
+        }
+        BlobPointer pointer{segment, offset, static_cast<uint32_t>(value.size())};
+        if (!callback(pointer, key, value)) {
+            break;
+        }
+    }
+}
+
+void BlobLog::remove_segment(uint32_t segment) {
+    if (segment == active_) {
+        throw std::logic_error("cannot remove the active blob segment");
+    }
+    auto it = segments_.find(segment);
+    if (it == segments_.end()) {
+        return;
+    }
+    ::close(it->second.fd);
+    segments_.erase(it);
+    std::error_code ec;
+    std::filesystem::remove(segment_path(segment), ec);
+}
+
+void BlobLog::clear() {
+    for (auto& [id, segment] : segments_) {
+        ::close(segment.fd);
+        std::error_code ec;
+        std::filesystem::remove(segment_path(id), ec);
+    }
+    segments_.clear();
+    open_segment(active_ + 1);
+    active_ += 1;
+}
+
+uint64_t BlobLog::record_size(std::size_t key_size, std::size_t value_size) {
+    return 4 + key_size + 4 + value_size;
+}
+
+std::filesystem::path BlobLog::segment_path(uint32_t segment) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%06u.blob", segment);
+    return dir_ / name;
+}
+
+void BlobLog::open_segment(uint32_t segment) {
+    int fd = util::open_file(segment_path(segment));
+    Segment entry{fd, 0};
+    try {
+        entry.size = util::file_size(fd);
+        if (entry.size < kHeaderSize) {
+            std::string header;
+            util::append_int<uint32_t>(header, kMagic);
+            util::append_int<uint32_t>(header, kVersion);
+            util::pwrite_all(fd, header.data(), header.size(), 0);
+            entry.size = kHeaderSize;
+        } else {
+            char header[kHeaderSize];
+            util::pread_all(fd, header, sizeof(header), 0);
+            if (util::load_int<uint32_t>(header) != kMagic ||
+                util::load_int<uint32_t>(header + 4) != kVersion) {
+                throw std::runtime_error("invalid blob segment: " +
+                                         segment_path(segment).string());
+            }
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    segments_[segment] = entry;
+}
+
+}  // namespace kvstore::core
@@ -0,0 +1,128 @@
+#include "kvstore/core/block_cache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace kvstore::core {
+
+void AlignedFree::operator()(char* p) const {
+    std::free(p);
+}
+
+AlignedBuffer make_aligned_buffer(std::size_t bytes) {
+    // aligned_alloc wants a multiple of the alignment
+    std::size_t rounded = (bytes + BlockCache::kBlockSize - 1) / BlockCache::kBlockSize *
+                          BlockCache::kBlockSize;
+    void* p = std::aligned_alloc(BlockCache::kBlockSize, rounded == 0 ? BlockCache::kBlockSize
+                                                                      : rounded);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return AlignedBuffer(static_cast<char*>(p));
+}
+
+// splitmix64 finalizer over both halves - block numbers are sequential, the shard pick shouldnt be
+std::size_t BlockCache::KeyHash::operator()(const Key& key) const {
+    uint64_t x = key.block + key.file_id * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<std::size_t>(x ^ (x >> 31));
+}
+
+BlockCache::BlockCache(std::size_t capacity_bytes, std::size_t shards) {
+    if (shards == 0) {
+        shards = 1;
+    }
+    // at least one block per shard, otherwise every insert would evict right away
+    std::size_t blocks_per_shard = std::max<std::size_t>(1, capacity_bytes / kBlockSize / shards);
+    capacity_bytes_ = blocks_per_shard * shards * kBlockSize;
+
+    shards_.reserve(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->slots.resize(blocks_per_shard);
+        shard->map.reserve(blocks_per_shard);
+        shard->arena = make_aligned_buffer(blocks_per_shard * kBlockSize);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+bool BlockCache::read(uint64_t file_id, uint64_t block, std::size_t offset_in_block, char* dst,
+                      std::size_t len) {
+    Key key{file_id, block};
+    Shard& shard = shard_for(key);
+    {
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            shard.slots[it->second].referenced = true;
+            std::memcpy(dst, shard.arena.get() + it->second * kBlockSize + offset_in_block, len);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void BlockCache::insert(uint64_t file_id, uint64_t block, const char* data) {
+    Key key{file_id, block};
+    Shard& shard = shard_for(key);
+    std::lock_guard lock(shard.mutex);
+
+    std::size_t slot = 0;
+    if (auto it = shard.map.find(key); it != shard.map.end()) {
+        slot = it->second;
+    } else if (shard.used < shard.slots.size()) {
+        slot = shard.used++;
+    } else {
+        // CLOCK: skip (and clear) referenced slots until one wasnt touched since the last pass
+        while (shard.slots[shard.hand].referenced) {
+            shard.slots[shard.hand].referenced = false;
+            shard.hand = (shard.hand + 1) % shard.slots.size();
+        }
+        slot = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.slots.size();
+        shard.map.erase(shard.slots[slot].key);
+        ++shard.evictions;
+    }
+
+    Slot& entry = shard.slots[slot];
+    entry.key = key;
+    entry.referenced = false;  // earns its bit on the first hit - one-off reads go first
+    shard.map[key] = slot;
+    std::memcpy(shard.arena.get() + slot * kBlockSize, data, kBlockSize);
+}
+
+void BlockCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        shard->map.clear();
+        for (Slot& slot : shard->slots) {
+            slot = Slot{};
+        }
+        shard->used = 0;
+        shard->hand = 0;
+    }
+}
+
+BlockCacheStats BlockCache::stats() const {
+    BlockCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.capacity_bytes = capacity_bytes_;
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        stats.used_bytes += shard->map.size() * kBlockSize;
+        stats.evictions += shard->evictions;
+    }
+    return stats;
+}
+
+BlockCache::Shard& BlockCache::shard_for(const Key& key) {
+    return *shards_[KeyHash{}(key) % shards_.size()];
+}
+
+}  // namespace kvstore::core
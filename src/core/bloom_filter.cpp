@@ -0,0 +1,75 @@
+#include "kvstore/core/bloom_filter.hpp"
+
+#include <algorithm>
+
+#include "kvstore/util/hash.hpp"
+
+namespace kvstore::core {
+
+namespace {
+
+// optimal probe count is bits_per_key * ln(2). clamp to something sane
+uint8_t probe_count(std::size_t bits_per_key) {
+    auto k = static_cast<std::size_t>(static_cast<double>(bits_per_key) * 0.69);
+    return static_cast<uint8_t>(std::clamp<std::size_t>(k, 1, 30));
+}
+
+// second hash for double hashing: the 64-bit hash rotated, so probes walk the bit array with a
+// key dependent stride
+uint64_t probe_delta(uint64_t h) {
+    return (h >> 17) | (h << 47);
+}
+
+}  // namespace
+
+std::string BloomFilter::build(const std::vector<uint64_t>& key_hashes, std::size_t bits_per_key) {
+    // tiny filters have a terrible false positive rate - enforce a minimum size
+    std::size_t bits = std::max<std::size_t>(key_hashes.size() * bits_per_key, 64);
+    std::size_t bytes = (bits + 7) / 8;
+    bits = bytes * 8;
+
+    std::string data(bytes, '\0');
+    uint8_t k = probe_count(bits_per_key);
+    for (uint64_t h : key_hashes) {
+        uint64_t delta = probe_delta(h);
+        for (uint8_t i = 0; i < k; ++i) {
+            uint64_t bit = h % bits;
+            auto byte = static_cast<uint8_t>(data[bit / 8]);
+            data[bit / 8] = static_cast<char>(byte | (1 << (bit % 8)));
+            h += delta;
+        }
+    }
+    data.push_back(static_cast<char>(k));
+    return data;
+}
+
+BloomFilter::BloomFilter(std::string data) : data_(std::move(data)) {}
+
+bool BloomFilter::may_contain(std::string_view key) const {
+    return may_contain_hash(util::hash64(key));
+}
+
+bool BloomFilter::may_contain_hash(uint64_t key_hash) const {
+    if (data_.size() < 2) {
+        return true;
+    }
+    uint64_t bits = (data_.size() - 1) * 8;
+    uint8_t k = static_cast<uint8_t>(data_.back());
+
+    uint64_t h = key_hash;
+    uint64_t delta = probe_delta(h);
+    for (uint8_t i = 0; i < k; ++i) {
+        uint64_t bit = h % bits;
+        if ((static_cast<uint8_t>(data_[bit / 8]) & (1 << (bit % 8))) == 0) {
+            return false;
+        }
+        h += delta;
+    }
+    return true;
+}
+
+const std::string& BloomFilter::data() const {
+    return data_;
+}
+
+}  // namespace kvstore::core
@@ -0,0 +1,1041 @@
+#include "kvstore/core/btree_store.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "kvstore/core/buffer_pool.hpp"
+#include "kvstore/core/wal.hpp"
+#include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/hash.hpp"
+#include "kvstore/util/logger.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+namespace {
+
+constexpr uint32_t kMetaMagic = 0x4B564254;  // "KVBT"
+constexpr uint32_t kVersion = 1;
+
+// pages 0 and 1 are the two meta slots, so 0 never names a tree page
+constexpr uint32_t kNoPage = 0;
+constexpr uint32_t kFirstDataPage = 2;
+
+constexpr uint8_t kPageLeaf = 1;
+constexpr uint8_t kPageInternal = 2;
+constexpr uint8_t kPageOverflow = 3;
+constexpr uint8_t kPageFreelist = 4;
+
+// every page: [type u8][unused u8][count u16][aux u32]
+// - leaf/internal: count = cells, aux = leftmost child (internal only)
+// - overflow: count = bytes used, aux = next page
+// - freelist: count = ids stored, aux = next page
+constexpr std::size_t kHeaderSize = 8;
+
+// leaf/internal pages are slotted: after the header a u16 offset per cell, sorted by key, then
+// the cells. binary search runs over the slots straight on the page bytes - no decoding
+//   leaf cell:     [key len u16][key][flags u8][value len u32][expires_at i64 - if flagged]
+//                  [value | first overflow page u32]
+//   internal cell: [key len u16][key][child u32] - child holds keys >= key
+constexpr uint8_t kCellOverflow = 0x01;
+constexpr uint8_t kCellHasExpiry = 0x02;
+
+constexpr std::size_t kMinFrames = 16;
+
+// in-memory form of a leaf/internal page, used by the write path
+struct Node {
+    bool leaf = true;
+    std::vector<std::string> keys;
+    std::vector<std::string> payloads;  // leaf: cell bytes after the key
+    std::vector<uint32_t> children;     // internal: keys.size() + 1
+};
+
+// read-only accessor over a slotted page in the buffer pool
+class PageView {
+   public:
+    explicit PageView(const char* page) : page_(page) {}
+
+    [[nodiscard]] uint8_t type() const {
+        return static_cast<uint8_t>(page_[0]);
+    }
+
+    [[nodiscard]] uint16_t count() const {
+        return util::load_int<uint16_t>(page_ + 2);
+    }
+
+    [[nodiscard]] uint32_t aux() const {
+        return util::load_int<uint32_t>(page_ + 4);
+    }
+
+    [[nodiscard]] std::string_view key(std::size_t i) const {
+        const char* cell = cell_at(i);
+        return {cell + 2, util::load_int<uint16_t>(cell)};
+    }
+
+    // leaf: the payload. internal: the child pointer
+    [[nodiscard]] const char* after_key(std::size_t i) const {
+        auto k = key(i);
+        return k.data() + k.size();
+    }
+
+    // child i of an internal page, 0..count
+    [[nodiscard]] uint32_t child(std::size_t i) const {
+        return i == 0 ? aux() : util::load_int<uint32_t>(after_key(i - 1));
+    }
+
+    // first cell with key >= k
+    [[nodiscard]] std::size_t lower_bound(std::string_view k) const {
+        std::size_t lo = 0;
+        std::size_t hi = count();
+        while (lo < hi) {
+            std::size_t mid = (lo + hi) / 2;
+            if (key(mid) < k) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // first cell with key > k. for an internal page this is the index of the child to descend
+    [[nodiscard]] std::size_t upper_bound(std::string_view k) const {
+        std::size_t lo = 0;
+        std::size_t hi = count();
+        while (lo < hi) {
+            std::size_t mid = (lo + hi) / 2;
+            if (key(mid) <= k) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+   private:
+    [[nodiscard]] const char* cell_at(std::size_t i) const {
+        return page_ + util::load_int<uint16_t>(page_ + kHeaderSize + 2 * i);
+    }
+
+    const char* page_;
+};
+
+struct ValueRef {
+    bool overflow = false;
+    uint32_t size = 0;
+    util::ExpirationTime expires_at_ms = std::nullopt;
+    const char* data = nullptr;  // inline value, or the first overflow page id
+};
+
+ValueRef parse_payload(const char* payload) {
+    ValueRef ref;
+    auto flags = static_cast<uint8_t>(payload[0]);
+    ref.overflow = (flags & kCellOverflow) != 0;
+    ref.size = util::load_int<uint32_t>(payload + 1);
+    const char* pos = payload + 5;
+    if ((flags & kCellHasExpiry) != 0) {
+        ref.expires_at_ms = util::load_int<int64_t>(pos);
+        pos += 8;
+    }
+    ref.data = pos;
+    return ref;
+}
+
+std::size_t encoded_size(const Node& node) {
+    std::size_t size = kHeaderSize;
+    for (std::size_t i = 0; i < node.keys.size(); ++i) {
+        size += 2 + 2 + node.keys[i].size() + (node.leaf ? node.payloads[i].size() : 4);
+    }
+    return size;
+}
+
+void encode_node(const Node& node, char* page) {
+    auto count = static_cast<uint16_t>(node.keys.size());
+    page[0] = static_cast<char>(node.leaf ? kPageLeaf : kPageInternal);
+    util::store_int<uint16_t>(page + 2, count);
+    util::store_int<uint32_t>(page + 4, node.leaf ? kNoPage : node.children[0]);
+
+    std::size_t slot = kHeaderSize;
+    std::size_t offset = kHeaderSize + 2 * static_cast<std::size_t>(count);
+    for (std::size_t i = 0; i < node.keys.size(); ++i) {
+        util::store_int<uint16_t>(page + slot, static_cast<uint16_t>(offset));
+        slot += 2;
+        const auto& key = node.keys[i];
+        util::store_int<uint16_t>(page + offset, static_cast<uint16_t>(key.size()));
+        std::memcpy(page + offset + 2, key.data(), key.size());
+        offset += 2 + key.size();
+        if (node.leaf) {
+            std::memcpy(page + offset, node.payloads[i].data(), node.payloads[i].size());
+            offset += node.payloads[i].size();
+        } else {
+            util::store_int<uint32_t>(page + offset, node.children[i + 1]);
+            offset += 4;
+        }
+    }
+}
+
+Node decode_node(const char* page) {
+    PageView view(page);
+    Node node;
+    node.leaf = view.type() == kPageLeaf;
+    if (!node.leaf) {
+        node.children.push_back(view.aux());
+    }
+    for (std::size_t i = 0; i < view.count(); ++i) {
+        node.keys.emplace_back(view.key(i));
+        if (node.leaf) {
+            // payload runs to the next cell - recompute its length from the header instead
+            const char* payload = view.after_key(i);
+            ValueRef ref = parse_payload(payload);
+            std::size_t len = static_cast<std::size_t>(ref.data - payload) +
+                              (ref.overflow ? sizeof(uint32_t) : ref.size);
+            node.payloads.emplace_back(payload, len);
+        } else {
+            node.children.push_back(view.child(i + 1));
+        }
+    }
+    return node;
+}
+
+}  // namespace
+
+/*
+    note on crash safety (shadow paging):
+    - the committed tree is whatever the newest valid meta page points to. its pages are never
+   written in place
+    - fresh_ holds pages allocated since the last checkpoint. only those may be modified in place
+   or written back by the buffer pool - nothing committed references them yet
+    - modifying a committed page allocates a fresh copy, which changes the parent's child pointer,
+   which copies the parent... up to a new root. after the first write to a path, later writes to
+   the same pages are in place until the next checkpoint
+    - pages replaced by a copy are still part of the committed tree, so they go to pending_free_
+   and only become reusable once the next checkpoint has committed
+*/
+class BTreeStore::Impl {
+   public:
+    explicit Impl(const BTreeStoreOptions& options)
+        : options_(options), clock_(options.clock), page_size_(options.page_size) {
+        if (page_size_ < 1024 || page_size_ > 65536 || (page_size_ & (page_size_ - 1)) != 0) {
+            throw std::invalid_argument("btree page_size must be a power of two in [1KB, 64KB]");
+        }
+        // a page must hold at least 4 cells for splits to always produce two fitting halves
+        max_cell_ = (page_size_ - kHeaderSize) / 4 - 2;
+        max_key_size_ = page_size_ / 8;
+
+        std::filesystem::create_directories(options_.data_dir);
+        fd_ = util::open_file(options_.data_dir / "btree.db");
+        try {
+            pool_ = std::make_unique<BufferPool>(
+                fd_, page_size_, std::max(options_.cache_size / page_size_, kMinFrames));
+            wal_ = std::make_unique<WriteAheadLog>(options_.data_dir / "btree.wal");
+            if (util::file_size(fd_) == 0) {
+                init_empty();
+            } else {
+                load_meta();
+                replay_wal();
+            }
+        } catch (...) {
+            pool_.reset();
+            ::close(fd_);
+            throw;
+        }
+    }
+
+    // clean shutdown: checkpoint so the next open has nothing to replay
+    ~Impl() {
+        try {
+            std::unique_lock lock(mutex_);
+            if (!fresh_.empty() || !pending_free_.empty()) {
+                checkpoint();
+            }
+        } catch (const std::exception& e) {
+            LOG_WARN("BTreeStore close: " + std::string(e.what()));
+        }
+        pool_.reset();
+        ::close(fd_);
+    }
+
+    void put(std::string_view key, std::string_view value) {
+        check_key(key);
+        std::unique_lock lock(mutex_);
+        wal_->log_put(key, value);
+        wal_bytes_ += key.size() + value.size() + 9;
+        do_put(key, value, std::nullopt);
+        maybe_checkpoint();
+    }
+
+    void put(std::string_view key, std::string_view value, util::Duration ttl) {
+        check_key(key);
+        std::unique_lock lock(mutex_);
+        int64_t expires_at_ms = util::to_epoch_ms(clock_->now() + ttl);
+        wal_->log_put_with_ttl(key, value, expires_at_ms);
+        wal_bytes_ += key.size() + value.size() + 17;
+        do_put(key, value, expires_at_ms);
+        maybe_checkpoint();
+    }
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) {
+        {
+            std::shared_lock lock(mutex_);
+            auto hit = lookup(key, true);
+            if (!hit.has_value()) {
+                return std::nullopt;
+            }
+            if (!is_expired(hit->expires_at_ms)) {
+                return std::move(hit->value);
+            }
+        }
+        expire(key);
+        return std::nullopt;
+    }
+
+    [[nodiscard]] bool remove(std::string_view key) {
+        std::unique_lock lock(mutex_);
+        auto hit = lookup(key, false);
+        if (!hit.has_value()) {
+            return false;
+        }
+        wal_->log_remove(key);
+        wal_bytes_ += key.size() + 9;
+        do_remove(key);
+        maybe_checkpoint();
+        return !is_expired(hit->expires_at_ms);
+    }
+
+    [[nodiscard]] bool contains(std::string_view key) {
+        {
+            std::shared_lock lock(mutex_);
+            auto hit = lookup(key, false);
+            if (!hit.has_value()) {
+                return false;
+            }
+            if (!is_expired(hit->expires_at_ms)) {
+                return true;
+            }
+        }
+        expire(key);
+        return false;
+    }
+
+    // note: like Store, expired entries count until something touches them
+    [[nodiscard]] std::size_t size() const {
+        std::shared_lock lock(mutex_);
+        return entry_count_;
+    }
+
+    [[nodiscard]] bool empty() const {
+        std::shared_lock lock(mutex_);
+        return entry_count_ == 0;
+    }
+
+    /*
+        drop the WAL first: a crash before the file reset then just loses the clear, never
+       resurrects half of the old data on top of an empty tree
+    */
+    void clear() {
+        std::unique_lock lock(mutex_);
+        wal_->truncate();
+        wal_bytes_ = 0;
+
+        pool_->reset();
+        if (::ftruncate(fd_, 0) != 0) {
+            throw std::runtime_error("failed to truncate btree file: " +
+                                     std::string(strerror(errno)));
+        }
+        fresh_.clear();
+        free_.clear();
+        pending_free_.clear();
+        freelist_pages_.clear();
+        init_empty();
+    }
+
+    void flush() {
+        std::unique_lock lock(mutex_);
+        checkpoint();
+    }
+
+    [[nodiscard]] std::vector<std::pair<std::string, std::string>> scan(std::string_view start,
+                                                                        std::string_view end,
+                                                                        std::size_t limit) const {
+        std::shared_lock lock(mutex_);
+        std::vector<std::pair<std::string, std::string>> out;
+        scan_page(root_, start, end, limit, util::to_epoch_ms(clock_->now()), out);
+        return out;
+    }
+
+    [[nodiscard]] std::size_t page_count() const {
+        std::shared_lock lock(mutex_);
+        return page_count_;
+    }
+
+   private:
+    struct Hit {
+        std::string value;
+        util::ExpirationTime expires_at_ms;
+    };
+
+    struct InsertResult {
+        uint32_t page;
+        std::optional<std::pair<std::string, uint32_t>> split;  // separator, new right sibling
+    };
+
+    struct RemoveResult {
+        uint32_t page;  // kNoPage: the node became empty and was freed
+        bool removed;
+    };
+
+    void check_key(std::string_view key) const {
+        if (key.size() > max_key_size_) {
+            throw std::invalid_argument("key too large for btree page size (max " +
+                                        std::to_string(max_key_size_) + " bytes)");
+        }
+    }
+
+    [[nodiscard]] bool is_expired(const util::ExpirationTime& expires_at_ms) const {
+        return expires_at_ms.has_value() &&
+               util::to_epoch_ms(clock_->now()) >= expires_at_ms.value();
+    }
+
+    // lazy expiration: re-check under the write lock, someone may have rewritten the key
+    void expire(std::string_view key) {
+        std::unique_lock lock(mutex_);
+        auto hit = lookup(key, false);
+        if (hit.has_value() && is_expired(hit->expires_at_ms)) {
+            wal_->log_remove(key);
+            wal_bytes_ += key.size() + 9;
+            do_remove(key);
+            maybe_checkpoint();
+        }
+    }
+
+    // ========================================================================
+    // page allocation
+    // ========================================================================
+
+    uint32_t alloc_page() {
+        uint32_t id;
+        if (!free_.empty()) {
+            id = free_.back();
+            free_.pop_back();
+        } else {
+            id = page_count_++;
+        }
+        fresh_.insert(id);
+        return id;
+    }
+
+    void free_page(uint32_t id) {
+        if (fresh_.erase(id) > 0) {
+            // never committed - nothing can reference it, reuse right away
+            pool_->discard(id);
+            free_.push_back(id);
+        } else {
+            pending_free_.push_back(id);
+        }
+    }
+
+    // page id to write a new version of page_id to - itself if it is fresh, else a copy
+    uint32_t writable(uint32_t page_id) {
+        if (fresh_.count(page_id) > 0) {
+            return page_id;
+        }
+        free_page(page_id);
+        return alloc_page();
+    }
+
+    // ========================================================================
+    // nodes
+    // ========================================================================
+
+    Node read_node(uint32_t page_id) {
+        auto ref = pool_->fetch(page_id);
+        return decode_node(ref.data());
+    }
+
+    void store_node(uint32_t page_id, const Node& node) {
+        auto ref = pool_->create(page_id);
+        encode_node(node, ref.mutable_data());
+    }
+
+    // write node back (copy-on-write), splitting it in two if it no longer fits a page
+    InsertResult write_node(uint32_t page_id, Node& node) {
+        uint32_t target = writable(page_id);
+        if (encoded_size(node) <= page_size_) {
+            store_node(target, node);
+            return {target, std::nullopt};
+        }
+
+        // split by bytes, not by count - cells vary a lot in size
+        std::size_t total = encoded_size(node) - kHeaderSize;
+        std::size_t n = node.keys.size();
+        std::size_t acc = 0;
+        std::size_t mid = 0;
+        while (mid < n - 1) {
+            acc += 4 + node.keys[mid].size() + (node.leaf ? node.payloads[mid].size() : 4);
+            ++mid;
+            if (acc >= total / 2) {
+                break;
+            }
+        }
+        if (!node.leaf && mid >= n - 1) {
+            mid = n - 2;  // internal split moves keys[mid] up - both sides need a key
+        }
+
+        Node right;
+        right.leaf = node.leaf;
+        std::string separator;
+        if (node.leaf) {
+            right.keys.assign(node.keys.begin() + static_cast<std::ptrdiff_t>(mid),
+                              node.keys.end());
+            right.payloads.assign(node.payloads.begin() + static_cast<std::ptrdiff_t>(mid),
+                                  node.payloads.end());
+            node.keys.resize(mid);
+            node.payloads.resize(mid);
+            separator = right.keys.front();
+        } else {
+            separator = node.keys[mid];
+            right.keys.assign(node.keys.begin() + static_cast<std::ptrdiff_t>(mid) + 1,
+                              node.keys.end());
+            right.children.assign(node.children.begin() + static_cast<std::ptrdiff_t>(mid) + 1,
+                                  node.children.end());
+            node.keys.resize(mid);
+            node.children.resize(mid + 1);
+        }
+
+        store_node(target, node);
+        uint32_t right_page = alloc_page();
+        store_node(right_page, right);
+        return {target, std::make_pair(std::move(separator), right_page)};
+    }
+
+    // ========================================================================
+    // values
+    // ========================================================================
+
+    std::string build_payload(std::string_view key, std::string_view value,
+                              util::ExpirationTime expires_at_ms) {
+        std::size_t inline_cell = 2 + key.size() + 1 + 4 + 8 + value.size();
+        bool overflow = inline_cell > max_cell_;
+
+        uint8_t flags = 0;
+        if (overflow) {
+            flags |= kCellOverflow;
+        }
+        if (expires_at_ms.has_value()) {
+            flags |= kCellHasExpiry;
+        }
+        std::string payload;
+        util::append_int<uint8_t>(payload, flags);
+        util::append_int<uint32_t>(payload, static_cast<uint32_t>(value.size()));
+        if (expires_at_ms.has_value()) {
+            util::append_int<int64_t>(payload, expires_at_ms.value());
+        }
+        if (overflow) {
+            util::append_int<uint32_t>(payload, write_overflow(value));
+        } else {
+            payload.append(value);
+        }
+        return payload;
+    }
+
+    // big value -> chain of overflow pages. returns the first page
+    uint32_t write_overflow(std::string_view value) {
+        std::size_t chunk = page_size_ - kHeaderSize;
+        std::size_t pages = (value.size() + chunk - 1) / chunk;
+        std::vector<uint32_t> ids;
+        for (std::size_t i = 0; i < pages; ++i) {
+            ids.push_back(alloc_page());
+        }
+        for (std::size_t i = 0; i < pages; ++i) {
+            std::size_t len = std::min(chunk, value.size() - i * chunk);
+            auto ref = pool_->create(ids[i]);
+            char* page = ref.mutable_data();
+            page[0] = static_cast<char>(kPageOverflow);
+            util::store_int<uint16_t>(page + 2, static_cast<uint16_t>(len));
+            util::store_int<uint32_t>(page + 4, i + 1 < pages ? ids[i + 1] : kNoPage);
+            std::memcpy(page + kHeaderSize, value.data() + i * chunk, len);
+        }
+        return ids.front();
+    }
+
+    std::string read_overflow(uint32_t page_id, uint32_t size) const {
+        std::string value;
+        value.reserve(size);
+        while (page_id != kNoPage) {
+            auto ref = pool_->fetch(page_id);
+            const char* page = ref.data();
+            value.append(page + kHeaderSize, util::load_int<uint16_t>(page + 2));
+            page_id = util::load_int<uint32_t>(page + 4);
+        }
+        return value;
+    }
+
+    void free_payload(const std::string& payload) {
+        ValueRef ref = parse_payload(payload.data());
+        if (!ref.overflow) {
+            return;
+        }
+        uint32_t page_id = util::load_int<uint32_t>(ref.data);
+        while (page_id != kNoPage) {
+            uint32_t next;
+            {
+                auto page = pool_->fetch(page_id);
+                next = util::load_int<uint32_t>(page.data() + 4);
+            }
+            free_page(page_id);
+            page_id = next;
+        }
+    }
+
+    // ========================================================================
+    // read path
+    // ========================================================================
+
+    // one page per level, pins released before descending
+    std::optional<Hit> lookup(std::string_view key, bool want_value) const {
+        uint32_t page_id = root_;
+        while (true) {
+            auto ref = pool_->fetch(page_id);
+            PageView view(ref.data());
+            if (view.type() == kPageInternal) {
+                page_id = view.child(view.upper_bound(key));
+                continue;
+            }
+
+            std::size_t i = view.lower_bound(key);
+            if (i >= view.count() || view.key(i) != key) {
+                return std::nullopt;
+            }
+            ValueRef value = parse_payload(view.after_key(i));
+            Hit hit{std::string(), value.expires_at_ms};
+            if (!want_value) {
+                return hit;
+            }
+            if (!value.overflow) {
+                hit.value.assign(value.data, value.size);
+                return hit;
+            }
+            uint32_t head = util::load_int<uint32_t>(value.data);
+            ref = BufferPool::PageRef();
+            hit.value = read_overflow(head, value.size);
+            return hit;
+        }
+    }
+
+    // returns false once the scan is done (end key or limit reached)
+    bool scan_page(uint32_t page_id, std::string_view start, std::string_view end,
+                   std::size_t limit, int64_t now_ms,
+                   std::vector<std::pair<std::string, std::string>>& out) const {
+        std::vector<uint32_t> children;
+        std::vector<std::string> lower_keys;  // smallest possible key under children[i], i > 0
+        {
+            auto ref = pool_->fetch(page_id);
+            PageView view(ref.data());
+            if (view.type() == kPageLeaf) {
+                for (std::size_t i = view.lower_bound(start); i < view.count(); ++i) {
+                    std::string_view key = view.key(i);
+                    if (!end.empty() && key >= end) {
+                        return false;
+                    }
+                    ValueRef value = parse_payload(view.after_key(i));
+                    if (value.expires_at_ms.has_value() && now_ms >= value.expires_at_ms.value()) {
+                        continue;
+                    }
+                    std::string data = value.overflow
+                                           ? read_overflow(util::load_int<uint32_t>(value.data),
+                                                           value.size)
+                                           : std::string(value.data, value.size);
+                    out.emplace_back(std::string(key), std::move(data));
+                    if (limit != 0 && out.size() >= limit) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            for (std::size_t i = view.upper_bound(start); i <= view.count(); ++i) {
+                children.push_back(view.child(i));
+                lower_keys.emplace_back(i == 0 ? std::string_view() : view.key(i - 1));
+            }
+        }
+
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            if (i > 0 && !end.empty() && lower_keys[i] >= end) {
+                return false;
+            }
+            if (!scan_page(children[i], start, end, limit, now_ms, out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // ========================================================================
+    // write path
+    // ========================================================================
+
+    void do_put(std::string_view key, std::string_view value, util::ExpirationTime expires_at_ms) {
+        std::string payload = build_payload(key, value, expires_at_ms);
+        bool inserted = false;
+        InsertResult result = insert(root_, key, payload, inserted);
+        root_ = result.page;
+        if (result.split.has_value()) {
+            // root split - the tree grows one level
+            Node new_root;
+            new_root.leaf = false;
+            new_root.keys.push_back(std::move(result.split->first));
+            new_root.children = {result.page, result.split->second};
+            root_ = alloc_page();
+            store_node(root_, new_root);
+        }
+        if (inserted) {
+            ++entry_count_;
+        }
+    }
+
+    InsertResult insert(uint32_t page_id, std::string_view key, std::string& payload,
+                        bool& inserted) {
+        Node node = read_node(page_id);
+        if (node.leaf) {
+            auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
+            auto pos = static_cast<std::size_t>(it - node.keys.begin());
+            if (it != node.keys.end() && *it == key) {
+                free_payload(node.payloads[pos]);
+                node.payloads[pos] = std::move(payload);
+            } else {
+                node.keys.insert(it, std::string(key));
+                node.payloads.insert(node.payloads.begin() + static_cast<std::ptrdiff_t>(pos),
+                                     std::move(payload));
+                inserted = true;
+            }
+            return write_node(page_id, node);
+        }
+
+        auto idx = static_cast<std::size_t>(
+            std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin());
+        InsertResult child = insert(node.children[idx], key, payload, inserted);
+        // child updated in place - this node is unchanged
+        if (child.page == node.children[idx] && !child.split.has_value()) {
+            return {page_id, std::nullopt};
+        }
+        node.children[idx] = child.page;
+        if (child.split.has_value()) {
+            node.keys.insert(node.keys.begin() + static_cast<std::ptrdiff_t>(idx),
+                             std::move(child.split->first));
+            node.children.insert(node.children.begin() + static_cast<std::ptrdiff_t>(idx) + 1,
+                                 child.split->second);
+        }
+        return write_node(page_id, node);
+    }
+
+    void do_remove(std::string_view key) {
+        RemoveResult result = remove_from(root_, key);
+        if (!result.removed) {
+            return;
+        }
+        --entry_count_;
+        if (result.page == kNoPage) {
+            Node empty_leaf;
+            root_ = alloc_page();
+            store_node(root_, empty_leaf);
+            return;
+        }
+        root_ = result.page;
+
+        // an internal root left with a single child is just an extra level - drop it
+        while (true) {
+            Node root = read_node(root_);
+            if (root.leaf || !root.keys.empty()) {
+                break;
+            }
+            uint32_t old_root = root_;
+            root_ = root.children[0];
+            free_page(old_root);
+        }
+    }
+
+    RemoveResult remove_from(uint32_t page_id, std::string_view key) {
+        Node node = read_node(page_id);
+        if (node.leaf) {
+            auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
+            if (it == node.keys.end() || *it != key) {
+                return {page_id, false};
+            }
+            auto pos = static_cast<std::ptrdiff_t>(it - node.keys.begin());
+            free_payload(node.payloads[static_cast<std::size_t>(pos)]);
+            node.keys.erase(it);
+            node.payloads.erase(node.payloads.begin() + pos);
+            if (node.keys.empty() && page_id != root_) {
+                free_page(page_id);
+                return {kNoPage, true};
+            }
+            return {write_node(page_id, node).page, true};
+        }
+
+        auto idx = static_cast<std::size_t>(
+            std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin());
+        RemoveResult child = remove_from(node.children[idx], key);
+        if (!child.removed) {
+            return {page_id, false};
+        }
+        if (child.page == node.children[idx]) {
+            return {page_id, true};
+        }
+
+        if (child.page == kNoPage) {
+            // lazy delete: unlink the empty child, no rebalancing of half empty siblings
+            node.children.erase(node.children.begin() + static_cast<std::ptrdiff_t>(idx));
+            if (!node.keys.empty()) {
+                std::size_t key_idx = idx == 0 ? 0 : idx - 1;
+                node.keys.erase(node.keys.begin() + static_cast<std::ptrdiff_t>(key_idx));
+            }
+            if (node.children.empty()) {
+                free_page(page_id);
+                return {kNoPage, true};
+            }
+        } else {
+            node.children[idx] = child.page;
+        }
+        return {write_node(page_id, node).page, true};
+    }
+
+    // ========================================================================
+    // checkpoint / meta
+    // ========================================================================
+
+    void maybe_checkpoint() {
+        if (!replaying_ && wal_bytes_ >= options_.checkpoint_wal_size) {
+            checkpoint();
+        }
+    }
+
+    /*
+        1. write the free list (everything reusable once this commits) into pages taken from free_
+        2. write back every dirty page, fsync
+        3. write the meta page into the slot the current meta is NOT in, fsync. this is the commit
+       point - a torn meta write fails its checksum and the other slot is used
+        4. the WAL is now redundant
+    */
+    void checkpoint() {
+        std::vector<uint32_t> reusable = free_;
+        reusable.insert(reusable.end(), pending_free_.begin(), pending_free_.end());
+        reusable.insert(reusable.end(), freelist_pages_.begin(), freelist_pages_.end());
+
+        std::size_t per_page = (page_size_ - kHeaderSize) / 4;
+        std::size_t list_pages = (reusable.size() + per_page - 1) / per_page;
+        std::vector<uint32_t> storage;
+        for (std::size_t i = 0; i < list_pages; ++i) {
+            if (!free_.empty()) {
+                storage.push_back(free_.back());
+                free_.pop_back();
+            } else {
+                storage.push_back(page_count_++);
+            }
+        }
+        std::unordered_set<uint32_t> storage_set(storage.begin(), storage.end());
+        std::erase_if(reusable, [&](uint32_t id) { return storage_set.count(id) > 0; });
+
+        for (std::size_t p = 0; p < storage.size(); ++p) {
+            auto ref = pool_->create(storage[p]);
+            char* page = ref.mutable_data();
+            // storage pages were counted before they left the list - the last may be empty
+            std::size_t begin = std::min(p * per_page, reusable.size());
+            std::size_t count = std::min(per_page, reusable.size() - begin);
+            page[0] = static_cast<char>(kPageFreelist);
+            util::store_int<uint16_t>(page + 2, static_cast<uint16_t>(count));
+            util::store_int<uint32_t>(page + 4, p + 1 < storage.size() ? storage[p + 1] : kNoPage);
+            for (std::size_t i = 0; i < count; ++i) {
+                util::store_int<uint32_t>(page + kHeaderSize + 4 * i, reusable[begin + i]);
+            }
+        }
+
+        pool_->flush_all();
+        util::sync_file(fd_);
+
+        ++txn_;
+        write_meta(storage.empty() ? kNoPage : storage.front());
+        util::sync_file(fd_);
+
+        free_ = std::move(reusable);
+        pending_free_.clear();
+        freelist_pages_ = std::move(storage);
+        fresh_.clear();
+
+        wal_->truncate();
+        wal_bytes_ = 0;
+    }
+
+    // [magic][version][page size u32][txn u64][root u32][page count u32][entries u64]
+    // [freelist head u32][checksum u64 - hash of everything before it]
+    void write_meta(uint32_t freelist_head) {
+        std::string buf;
+        util::append_int<uint32_t>(buf, kMetaMagic);
+        util::append_int<uint32_t>(buf, kVersion);
+        util::append_int<uint32_t>(buf, static_cast<uint32_t>(page_size_));
+        util::append_int<uint64_t>(buf, txn_);
+        util::append_int<uint32_t>(buf, root_);
+        util::append_int<uint32_t>(buf, page_count_);
+        util::append_int<uint64_t>(buf, entry_count_);
+        util::append_int<uint32_t>(buf, freelist_head);
+        util::append_int<uint64_t>(buf, util::hash64(buf));
+        util::pwrite_all(fd_, buf.data(), buf.size(), (txn_ % 2) * page_size_);
+    }
+
+    void init_empty() {
+        page_count_ = kFirstDataPage;
+        entry_count_ = 0;
+        root_ = alloc_page();
+        store_node(root_, Node{});
+        checkpoint();
+    }
+
+    void load_meta() {
+        constexpr std::size_t kMetaSize = 4 + 4 + 4 + 8 + 4 + 4 + 8 + 4 + 8;
+        bool found = false;
+        uint32_t freelist_head = kNoPage;
+        for (uint64_t slot = 0; slot < 2; ++slot) {
+            std::string buf(kMetaSize, '\0');
+            try {
+                util::pread_all(fd_, buf.data(), buf.size(), slot * page_size_);
+            } catch (const std::runtime_error&) {
+                continue;
+            }
+            const char* p = buf.data();
+            if (util::load_int<uint32_t>(p) != kMetaMagic ||
+                util::load_int<uint32_t>(p + 4) != kVersion ||
+                util::load_int<uint64_t>(p + kMetaSize - 8) !=
+                    util::hash64(std::string_view(p, kMetaSize - 8))) {
+                continue;
+            }
+            if (util::load_int<uint32_t>(p + 8) != page_size_) {
+                throw std::runtime_error("btree file was created with page size " +
+                                         std::to_string(util::load_int<uint32_t>(p + 8)));
+            }
+            uint64_t txn = util::load_int<uint64_t>(p + 12);
+            if (found && txn <= txn_) {
+                continue;
+            }
+            found = true;
+            txn_ = txn;
+            root_ = util::load_int<uint32_t>(p + 20);
+            page_count_ = util::load_int<uint32_t>(p + 24);
+            entry_count_ = util::load_int<uint64_t>(p + 28);
+            freelist_head = util::load_int<uint32_t>(p + 36);
+        }
+        if (!found) {
+            throw std::runtime_error("invalid btree file: no valid meta page");
+        }
+
+        uint32_t page_id = freelist_head;
+        while (page_id != kNoPage) {
+            auto ref = pool_->fetch(page_id);
+            const char* page = ref.data();
+            auto count = util::load_int<uint16_t>(page + 2);
+            for (std::size_t i = 0; i < count; ++i) {
+                free_.push_back(util::load_int<uint32_t>(page + kHeaderSize + 4 * i));
+            }
+            freelist_pages_.push_back(page_id);
+            page_id = util::load_int<uint32_t>(page + 4);
+        }
+    }
+
+    // writes since the last checkpoint. replay can run twice over the same ops (crash between
+    // the meta commit and the WAL truncate) - puts and removes are idempotent, so that is fine
+    void replay_wal() {
+        replaying_ = true;
+        wal_->replay([this](EntryType type, std::string_view key, std::string_view value,
+                            util::ExpirationTime expires_at_ms) {
+            switch (type) {
+                case EntryType::Put:
+                case EntryType::PutWithTTL:
+                    do_put(key, value, expires_at_ms);
+                    break;
+                case EntryType::Remove:
+                    do_remove(key);
+                    break;
+                case EntryType::Clear:
+                    // clear() truncates the log instead of logging
+                    break;
+            }
+        });
+        replaying_ = false;
+        wal_bytes_ = wal_->size();
+    }
+
+    BTreeStoreOptions options_;
+    std::shared_ptr<util::Clock> clock_;
+    std::size_t page_size_;
+    std::size_t max_cell_;
+    std::size_t max_key_size_;
+
+    int fd_ = -1;
+    std::unique_ptr<BufferPool> pool_;
+    std::unique_ptr<WriteAheadLog> wal_;
+    std::size_t wal_bytes_ = 0;
+    bool replaying_ = false;
+
+    // note: readers only touch the tree under the shared lock, so page contents never change
+    // under them. the buffer pool has its own mutex for frame bookkeeping
+    mutable std::shared_mutex mutex_;
+    uint64_t txn_ = 0;
+    uint32_t root_ = kNoPage;
+    uint32_t page_count_ = kFirstDataPage;
+    uint64_t entry_count_ = 0;
+
+    std::unordered_set<uint32_t> fresh_;   // allocated since the last checkpoint
+    std::vector<uint32_t> free_;           // reusable now
+    std::vector<uint32_t> pending_free_;   // reusable after the next checkpoint
+    std::vector<uint32_t> freelist_pages_; // hold the committed free list
+};
+
+BTreeStore::BTreeStore(const BTreeStoreOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+BTreeStore::~BTreeStore() = default;
+BTreeStore::BTreeStore(BTreeStore&&) noexcept = default;
+BTreeStore& BTreeStore::operator=(BTreeStore&&) noexcept = default;
+void BTreeStore::put(std::string_view key, std::string_view value) {
+    impl_->put(key, value);
+}
+void BTreeStore::put(std::string_view key, std::string_view value, util::Duration ttl) {
+    impl_->put(key, value, ttl);
+}
+std::optional<std::string> BTreeStore::get(std::string_view key) {
+    return impl_->get(key);
+}
+bool BTreeStore::remove(std::string_view key) {
+    return impl_->remove(key);
+}
+bool BTreeStore::contains(std::string_view key) {
+    return impl_->contains(key);
+}
+std::size_t BTreeStore::size() const {
+    return impl_->size();
+}
+bool BTreeStore::empty() const {
+    return impl_->empty();
+}
+void BTreeStore::clear() {
+    impl_->clear();
+}
+void BTreeStore::flush() {
+    impl_->flush();
+}
+std::vector<std::pair<std::string, std::string>> BTreeStore::scan(std::string_view start,
+                                                                  std::string_view end,
+                                                                  std::size_t limit) const {
+    return impl_->scan(start, end, limit);
+}
+std::size_t BTreeStore::page_count() const {
+    return impl_->page_count();
+}
+
+}  // namespace kvstore::core
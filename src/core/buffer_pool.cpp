@@ -0,0 +1,216 @@
+#include "kvstore/core/buffer_pool.hpp"
+
+#include <cstring>
+
+#include "kvstore/util/file_io.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+// ============================================================================
+// PageRef
+// ============================================================================
+
+BufferPool::PageRef::~PageRef() {
+    release();
+}
+
+BufferPool::PageRef::PageRef(PageRef&& other) noexcept
+    : pool_(other.pool_), frame_(other.frame_) {
+    other.pool_ = nullptr;
+    other.frame_ = nullptr;
+}
+
+BufferPool::PageRef& BufferPool::PageRef::operator=(PageRef&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        frame_ = other.frame_;
+        other.pool_ = nullptr;
+        other.frame_ = nullptr;
+    }
+    return *this;
+}
+
+void BufferPool::PageRef::release() {
+    if (frame_ != nullptr) {
+        pool_->unpin(frame_);
+        frame_ = nullptr;
+        pool_ = nullptr;
+    }
+}
+
+uint32_t BufferPool::PageRef::id() const {
+    return frame_->page_id;
+}
+
+const char* BufferPool::PageRef::data() const {
+    return frame_->data.get();
+}
+
+char* BufferPool::PageRef::mutable_data() {
+    return frame_->data.get();
+}
+
+// note: the caller holds the pin, so the frame cant be evicted - but the flag is read by eviction
+// under the pool mutex, so set it there too
+void BufferPool::PageRef::mark_dirty() {
+    std::lock_guard lock(pool_->mutex_);
+    frame_->dirty = true;
+}
+
+// ============================================================================
+// BufferPool
+// ============================================================================
+
+BufferPool::BufferPool(int fd, std::size_t page_size, std::size_t capacity)
+    : fd_(fd), page_size_(page_size), capacity_(capacity < 1 ? 1 : capacity) {}
+
+BufferPool::PageRef BufferPool::fetch(uint32_t id) {
+    std::lock_guard lock(mutex_);
+    Frame* frame = frame_for(id);
+    if (!frame->in_use) {
+        ++misses_;
+        try {
+            util::pread_all(fd_, frame->data.get(), page_size_,
+                            static_cast<uint64_t>(id) * page_size_);
+        } catch (...) {
+            table_.erase(id);
+            throw;
+        }
+        frame->in_use = true;
+        frame->dirty = false;
+    } else {
+        ++hits_;
+    }
+    frame->referenced = true;
+    ++frame->pins;
+    return PageRef(this, frame);
+}
+
+BufferPool::PageRef BufferPool::create(uint32_t id) {
+    std::lock_guard lock(mutex_);
+    Frame* frame = frame_for(id);
+    std::memset(frame->data.get(), 0, page_size_);
+    frame->in_use = true;
+    frame->dirty = true;
+    frame->referenced = true;
+    ++frame->pins;
+    return PageRef(this, frame);
+}
+
+void BufferPool::discard(uint32_t id) {
+    std::lock_guard lock(mutex_);
+    auto it = table_.find(id);
+    if (it == table_.end()) {
+        return;
+    }
+    Frame* frame = it->second;
+    table_.erase(it);
+    frame->in_use = false;
+    frame->dirty = false;
+    frame->referenced = false;
+}
+
+void BufferPool::reset() {
+    std::lock_guard lock(mutex_);
+    for (auto& frame : frames_) {
+        frame->in_use = false;
+        frame->dirty = false;
+        frame->referenced = false;
+    }
+    table_.clear();
+}
+
+void BufferPool::flush_all() {
+    std::lock_guard lock(mutex_);
+    for (auto& frame : frames_) {
+        if (frame->in_use && frame->dirty) {
+            write_back(*frame);
+        }
+    }
+}
+
+std::size_t BufferPool::page_size() const {
+    return page_size_;
+}
+
+std::size_t BufferPool::capacity() const {
+    return capacity_;
+}
+
+uint64_t BufferPool::hits() const {
+    std::lock_guard lock(mutex_);
+    return hits_;
+}
+
+uint64_t BufferPool::misses() const {
+    std::lock_guard lock(mutex_);
+    return misses_;
+}
+
+/*
+    CLOCK: sweep the hand over the frames. a referenced frame gets its bit cleared and a second
+   chance, the first unreferenced + unpinned one is the victim. two full turns without a victim
+   means everything is pinned
+*/
+BufferPool::Frame* BufferPool::frame_for(uint32_t id) {
+    auto it = table_.find(id);
+    if (it != table_.end()) {
+        return it->second;
+    }
+
+    Frame* victim = nullptr;
+    if (frames_.size() < capacity_) {
+        frames_.push_back(std::make_unique<Frame>());
+        victim = frames_.back().get();
+    } else {
+        for (std::size_t step = 0; step < 2 * frames_.size(); ++step) {
+            Frame* frame = frames_[clock_hand_].get();
+            clock_hand_ = (clock_hand_ + 1) % frames_.size();
+            if (frame->pins > 0) {
+                continue;
+            }
+            if (frame->referenced) {
+                frame->referenced = false;
+                continue;
+            }
+            victim = frame;
+            break;
+        }
+        if (victim == nullptr) {
+            frames_.push_back(std::make_unique<Frame>());
+            victim = frames_.back().get();
+        }
+    }
+
+    if (!victim->data) {
+        victim->data = std::make_unique<char[]>(page_size_);
+    }
+    if (victim->in_use) {
+        if (victim->dirty) {
+            write_back(*victim);
+        }
+        table_.erase(victim->page_id);
+    }
+    victim->page_id = id;
+    victim->in_use = false;
+    victim->dirty = false;
+    victim->referenced = false;
+    table_[id] = victim;
+    return victim;
+}
+
+void BufferPool::write_back(Frame& frame) {
+    util::pwrite_all(fd_, frame.data.get(), page_size_,
+                     static_cast<uint64_t>(frame.page_id) * page_size_);
+    frame.dirty = false;
+}
+
+void BufferPool::unpin(Frame* frame) {
+    std::lock_guard lock(mutex_);
+    --frame->pins;
+}
+
+}  // namespace kvstore::core
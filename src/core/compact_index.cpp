@@ -0,0 +1,153 @@
+#include "kvstore/core/compact_index.hpp"
+
+#include <stdexcept>
+
+namespace kvstore::core {
+
+namespace {
+
+constexpr int kOffsetBits = 40;
+constexpr uint64_t kOffsetMask = CompactIndex::kMaxOffset;
+constexpr uint64_t kTagMask = (uint64_t{1} << 24) - 1;
+constexpr uint64_t kEmpty = 0;
+constexpr uint64_t kDeleted = 1;
+constexpr int kMinBits = 4;
+
+uint64_t tag_of(uint64_t hash) {
+    return hash & kTagMask;
+}
+
+uint64_t make_slot(uint64_t hash, uint64_t offset) {
+    return (tag_of(hash) << kOffsetBits) | offset;
+}
+
+bool is_entry(uint64_t slot) {
+    return slot != kEmpty && slot != kDeleted;
+}
+
+}  // namespace
+
+CompactIndex::CompactIndex(std::size_t capacity) {
+    if (capacity == 0) {
+        return;
+    }
+    bits_ = kMinBits;
+    while ((std::size_t{1} << bits_) < capacity) {
+        ++bits_;
+    }
+    slots_.assign(std::size_t{1} << bits_, kEmpty);
+}
+
+std::size_t CompactIndex::capacity_for(std::size_t entries) {
+    std::size_t capacity = std::size_t{1} << kMinBits;
+    while (capacity / 2 < entries) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+std::optional<uint64_t> CompactIndex::find(uint64_t hash,
+                                           const std::function<bool(uint64_t)>& match) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    uint64_t tag = tag_of(hash);
+    std::size_t mask = slots_.size() - 1;
+    // terminates: full() keeps at least 1/8 of the slots empty
+    for (std::size_t i = home(hash);; i = (i + 1) & mask) {
+        uint64_t slot = slots_[i];
+        if (slot == kEmpty) {
+            return std::nullopt;
+        }
+        if (is_entry(slot) && (slot >> kOffsetBits) == tag && match(slot & kOffsetMask)) {
+            return slot & kOffsetMask;
+        }
+    }
+}
+
+void CompactIndex::insert(uint64_t hash, uint64_t offset) {
+    if (offset > kMaxOffset || offset <= kDeleted) {
+        throw std::invalid_argument("compact index offset out of range");
+    }
+    if (full()) {
+        throw std::logic_error("compact index is full");
+    }
+    std::size_t mask = slots_.size() - 1;
+    std::size_t i = home(hash);
+    while (is_entry(slots_[i])) {
+        i = (i + 1) & mask;
+    }
+    if (slots_[i] == kEmpty) {
+        ++used_;
+    }
+    slots_[i] = make_slot(hash, offset);
+    ++size_;
+}
+
+bool CompactIndex::replace(uint64_t hash, uint64_t old_offset, uint64_t new_offset) {
+    if (new_offset > kMaxOffset || new_offset <= kDeleted) {
+        throw std::invalid_argument("compact index offset out of range");
+    }
+    auto pos = position(hash, old_offset);
+    if (!pos.has_value()) {
+        return false;
+    }
+    slots_[*pos] = make_slot(hash, new_offset);
+    return true;
+}
+
+bool CompactIndex::erase(uint64_t hash, uint64_t offset) {
+    auto pos = position(hash, offset);
+    if (!pos.has_value()) {
+        return false;
+    }
+    slots_[*pos] = kDeleted;
+    --size_;
+    return true;
+}
+
+void CompactIndex::clear() {
+    std::vector<uint64_t>().swap(slots_);
+    bits_ = 0;
+    size_ = 0;
+    used_ = 0;
+}
+
+bool CompactIndex::full() const {
+    return used_ + 1 > slots_.size() - slots_.size() / 8;
+}
+
+std::size_t CompactIndex::size() const {
+    return size_;
+}
+
+std::size_t CompactIndex::capacity() const {
+    return slots_.size();
+}
+
+std::size_t CompactIndex::memory_usage() const {
+    return slots_.capacity() * sizeof(uint64_t);
+}
+
+std::size_t CompactIndex::home(uint64_t hash) const {
+    return static_cast<std::size_t>(hash >> (64 - bits_));
+}
+
+// exact slot lookup - no disk read needed when the caller already knows the offset
+std::optional<std::size_t> CompactIndex::position(uint64_t hash, uint64_t offset) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    uint64_t wanted = make_slot(hash, offset);
+    std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = home(hash);; i = (i + 1) & mask) {
+        if (slots_[i] == kEmpty) {
+            return std::nullopt;
+        }
+        if (slots_[i] == wanted) {
+            return i;
+        }
+    }
+}
+
+}  // namespace kvstore::core
@@ -0,0 +1,246 @@
+#include "kvstore/core/data_file.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/crc32c.hpp"
+#include "kvstore/util/file_io.hpp"
+
+namespace kvstore::core::data_file {
+
+namespace {
+
+// the decoded records of one chunk of the file
+struct Chunk {
+    std::vector<ScannedRecord> records;
+    uint64_t end = 0;  // end of the last intact record
+};
+
+// a read-only mapping of [0, size) of a file
+class Mapping {
+   public:
+    Mapping(int fd, uint64_t size) : size_(size) {
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("failed to map data file: " + std::string(strerror(errno)));
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    ~Mapping() {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    [[nodiscard]] const char* data() const {
+        return data_;
+    }
+
+    // best effort, like the fadvise hints DiskStore gives
+    void advise(uint64_t offset, uint64_t len, int advice) const {
+        static const auto page = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+        uint64_t begin = offset / page * page;
+        (void)::madvise(const_cast<char*>(data_) + begin, offset + len - begin, advice);
+    }
+
+   private:
+    const char* data_ = nullptr;
+    uint64_t size_;
+};
+
+// the body length of the record at offset, 0 if its frame is short or impossible
+[[nodiscard]] uint32_t frame_body_size(const char* file, uint64_t offset, uint64_t end) {
+    if (end - offset < kFrameSize) {
+        return 0;
+    }
+    uint32_t body_size = util::load_int<uint32_t>(file + offset + 4);
+    if (body_size < kMinBodySize || body_size > end - offset - kFrameSize) {
+        return 0;
+    }
+    return body_size;
+}
+
+// where the chunk starting at begin ends: the first record boundary chunk_bytes or more past it.
+// a bad frame ends it early - decoding the chunk stops there. counts the records it walked
+[[nodiscard]] uint64_t chunk_limit(const char* file, uint64_t begin, uint64_t end,
+                                   uint64_t chunk_bytes, uint64_t& records) {
+    uint64_t offset = begin;
+    records = 0;
+    while (offset < end && offset - begin < chunk_bytes) {
+        uint32_t body_size = frame_body_size(file, offset, end);
+        if (body_size == 0) {
+            return offset == begin ? end : offset;
+        }
+        offset += kFrameSize + body_size;
+        ++records;
+    }
+    return offset;
+}
+
+// checksum and decode the records in [begin, limit)
+[[nodiscard]] Chunk decode_chunk(const char* file, uint64_t begin, uint64_t limit,
+                                 uint64_t expected_records) {
+    Chunk chunk;
+    chunk.records.reserve(expected_records);
+    uint64_t offset = begin;
+    while (offset < limit) {
+        uint32_t body_size = frame_body_size(file, offset, limit);
+        if (body_size == 0) {
+            break;
+        }
+        const char* frame = file + offset;
+        std::string_view body(frame + kFrameSize, body_size);
+        if (util::crc32c_extend(util::crc32c(std::string_view(frame + 4, 4)), body) !=
+            util::load_int<uint32_t>(frame)) {
+            break;
+        }
+        ScannedRecord& record = chunk.records.emplace_back();
+        record.offset = offset;
+        if (!decode_body(body, record.type, record.key, record.value, record.expires_at_ms)) {
+            chunk.records.pop_back();
+            break;
+        }
+        offset += kFrameSize + body_size;
+    }
+    chunk.end = offset;
+    return chunk;
+}
+
+}  // namespace
+
+void append_header(std::string& buf) {
+    util::append_int<uint32_t>(buf, kMagic);
+    util::append_int<uint32_t>(buf, kVersion);
+}
+
+void encode_record(std::string& buf, uint8_t entry_type, std::string_view key,
+                   std::string_view value, util::ExpirationTime expires_at_ms) {
+    std::size_t frame = buf.size();
+    buf.append(kFrameSize, '\0');
+    util::append_int<uint8_t>(buf, entry_type);
+    util::append_string(buf, key);
+    util::append_string(buf, value);
+    util::append_int<uint8_t>(buf, expires_at_ms.has_value() ? 1 : 0);
+    if (expires_at_ms.has_value()) {
+        util::append_int<uint64_t>(buf, static_cast<uint64_t>(expires_at_ms.value()));
+    }
+    auto body_size = static_cast<uint32_t>(buf.size() - frame - kFrameSize);
+    util::store_int<uint32_t>(buf.data() + frame + 4, body_size);
+    util::store_int<uint32_t>(buf.data() + frame,
+                              util::crc32c(std::string_view(buf).substr(frame + 4)));
+}
+
+bool decode_body(std::string_view body, uint8_t& type, std::string_view& key,
+                 std::string_view& value, util::ExpirationTime& expires_at_ms) {
+    std::size_t pos = 0;
+    auto take = [&](std::size_t len) {
+        if (body.size() - pos < len) {
+            return std::string_view();
+        }
+        std::string_view part = body.substr(pos, len);
+        pos += len;
+        return part;
+    };
+    if (body.size() < kMinBodySize) {
+        return false;
+    }
+    type = static_cast<uint8_t>(take(1)[0]);
+    std::string_view key_len = take(4);
+    std::string_view key_bytes = take(util::load_int<uint32_t>(key_len.data()));
+    if (key_bytes.size() != util::load_int<uint32_t>(key_len.data())) {
+        return false;
+    }
+    std::string_view value_len = take(4);
+    if (value_len.empty()) {
+        return false;
+    }
+    uint32_t value_size = util::load_int<uint32_t>(value_len.data());
+    std::string_view value_bytes = take(value_size);
+    std::string_view has_expiration = take(1);
+    if (value_bytes.size() != value_size || has_expiration.empty()) {
+        return false;
+    }
+    expires_at_ms = std::nullopt;
+    if (has_expiration[0] != 0) {
+        std::string_view exp = take(8);
+        if (exp.empty()) {
+            return false;
+        }
+        expires_at_ms = static_cast<int64_t>(util::load_int<uint64_t>(exp.data()));
+    }
+    key = key_bytes;
+    value = value_bytes;
+    return pos == body.size();
+}
+
+/*
+    up to options.threads chunks are in flight at once, as futures in file order. the oldest one
+   is handed to fn while the others decode - with one thread the future is deferred and decodes
+   on the calling thread when it is asked for. futures block in their destructor, so an exception
+   from fn waits for the workers before the mapping goes away
+*/
+uint64_t scan(int fd, uint64_t from, uint64_t end, const ScanOptions& options,
+              const std::function<void(const ScannedRecord&)>& fn) {
+    end = std::min(end, util::file_size(fd));
+    if (from >= end) {
+        return from;
+    }
+    Mapping mapping(fd, end);
+    const char* file = mapping.data();
+    mapping.advise(from, end - from, MADV_SEQUENTIAL);
+
+    std::size_t threads = std::max<std::size_t>(options.threads, 1);
+    uint64_t chunk_bytes = std::max<uint64_t>(options.chunk_bytes, 1);
+    struct InFlight {
+        uint64_t limit;
+        std::future<Chunk> chunk;
+    };
+    std::deque<InFlight> in_flight;
+    uint64_t next = from;
+    bool estimated = false;
+    auto launch = [&]() {
+        while (in_flight.size() < threads && next < end) {
+            uint64_t records = 0;
+            uint64_t begin = next;
+            uint64_t limit = chunk_limit(file, begin, end, chunk_bytes, records);
+            if (!estimated && options.on_estimate) {
+                estimated = true;
+                options.on_estimate(records * (end - from) / std::max<uint64_t>(limit - from, 1));
+            }
+            mapping.advise(begin, limit - begin, MADV_WILLNEED);
+            auto policy = threads > 1 ? std::launch::async : std::launch::deferred;
+            in_flight.push_back(
+                {limit, std::async(policy, decode_chunk, file, begin, limit, records)});
+            next = limit;
+        }
+    };
+
+    uint64_t stopped = from;
+    launch();
+    while (!in_flight.empty()) {
+        InFlight front = std::move(in_flight.front());
+        in_flight.pop_front();
+        Chunk chunk = front.chunk.get();
+        launch();  // keep the workers busy while fn runs
+        for (const ScannedRecord& record : chunk.records) {
+            fn(record);
+        }
+        stopped = chunk.end;
+        if (chunk.end < front.limit) {
+            break;  // torn or corrupt record - everything after it is ignored
+        }
+    }
+    return stopped;
+}
+
+}  // namespace kvstore::core::data_file
@@ -1,12 +1,39 @@
 #include "kvstore/core/disk_store.hpp"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <mutex>
 #include <shared_mutex>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
-
+#include <utility>
+#include <vector>
+
+#include "kvstore/core/blob_log.hpp"
+#include "kvstore/core/block_cache.hpp"
+#include "kvstore/core/compact_index.hpp"
+#include "kvstore/core/data_file.hpp"
+#include "kvstore/core/hint_file.hpp"
+#include "kvstore/core/value_cache.hpp"
 #include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/crc32c.hpp"
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/hash.hpp"
+#include "kvstore/util/logger.hpp"
 
 namespace kvstore::core {
 
@@ -14,10 +41,90 @@ namespace util = kvstore::util;
 
 namespace {
 
-constexpr uint32_t kMagic = 0x4B564453;  //"KVDS"
-constexpr uint32_t kVersion = 1;
-constexpr uint8_t kEntryRegular = 0;
-constexpr uint8_t kEntryTombstone = 1;
+using data_file::encode_record;
+using data_file::kEntryBlob;
+using data_file::kEntryRegular;
+using data_file::kEntryTombstone;
+using data_file::kFrameSize;
+using data_file::kHeaderSize;
+using data_file::kLegacyVersion;
+using data_file::kMagic;
+using data_file::kMinBodySize;
+using data_file::kRecordOverhead;
+using data_file::kVersion;
+using data_file::ScannedRecord;
+using data_file::value_offset;
+
+// a group commit stops taking writers once the batch reaches this size. bounds the latency a
+// leader adds for the followers queued behind a huge batch
+constexpr std::size_t kMaxBatchBytes = 1 << 20;
+// compaction writes the new file in chunks of this size
+constexpr std::size_t kCompactionChunkBytes = 1 << 20;
+// default scan_threads cap. each holds a decoded chunk, and one thread applying the records to
+// the index is the limit long before this
+constexpr std::size_t kMaxScanThreads = 8;
+// compact index lookups read this much from the record start, so one pread returns the whole
+// record (key check + value) unless the value is big
+constexpr std::size_t kLookupWindow = 4096;
+
+// direct mode reads: the whole run of missing blocks in one read, at most this many blocks
+constexpr uint64_t kDirectReadBlocks = 64;
+// direct mode writes: hand appended data back to the kernel every this many bytes
+constexpr uint64_t kReleaseInterval = 1 << 20;
+// block cache key of the data file (the cache could hold other files' blocks too)
+constexpr uint64_t kDataFileId = 0;
+
+// O_DIRECT read-only descriptor, or -1 where the filesystem refuses it (tmpfs, some overlays)
+int open_direct(const std::filesystem::path& path) {
+#ifdef O_DIRECT
+    return ::open(path.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+#else
+    (void)path;
+    return -1;
+#endif
+}
+
+// drop [offset, offset + len) from the page cache. len 0 = to EOF. only clean pages go, so
+// written data has to be synced (or written back) first. best effort only
+void drop_cached_pages(int fd, uint64_t offset, uint64_t len) {
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(len), POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+    (void)offset;
+    (void)len;
+#endif
+}
+
+// start async writeback of a range, so a later drop_cached_pages finds it clean. best effort
+void start_writeback(int fd, uint64_t offset, uint64_t len) {
+#ifdef SYNC_FILE_RANGE_WRITE
+    ::sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(len),
+                      SYNC_FILE_RANGE_WRITE);
+#else
+    (void)fd;
+    (void)offset;
+    (void)len;
+#endif
+}
+
+// blob pointer as stored in a kEntryBlob record's value field: [segment u32][offset u64][size u32]
+std::string encode_blob_pointer(const BlobPointer& blob) {
+    std::string buf;
+    util::append_int<uint32_t>(buf, blob.segment);
+    util::append_int<uint64_t>(buf, blob.offset);
+    util::append_int<uint32_t>(buf, blob.size);
+    return buf;
+}
+
+BlobPointer decode_blob_pointer(std::string_view value) {
+    if (value.size() != 16) {
+        throw std::runtime_error("Invalid data file: bad blob pointer");
+    }
+    return BlobPointer{util::load_int<uint32_t>(value.data()),
+                       util::load_int<uint64_t>(value.data() + 4),
+                       util::load_int<uint32_t>(value.data() + 12)};
+}
 
 }  // namespace
 
@@ -26,120 +133,342 @@ struct IndexEntry {
     uint32_t value_size;
     std::optional<util::TimePoint> expires_at;
     bool is_tombstone;
+    uint32_t blob_segment = 0;  // != 0: the value lives in the blob log, value_size = its size
+    uint64_t blob_offset = 0;
+
+    [[nodiscard]] BlobPointer blob() const {
+        return BlobPointer{blob_segment, blob_offset, value_size};
+    }
+};
+
+// looked up by string_view on every read: the transparent hash skips the std::string a plain
+// unordered_map<std::string, ...>::find would build per lookup
+using FullIndex = std::unordered_map<std::string, IndexEntry, util::StringHash, std::equal_to<>>;
+
+// compact mode: a record read back through its index slot
+struct CompactRecord {
+    std::string value;
+    util::ExpirationTime expires_at_ms = std::nullopt;
 };
 
 // TODO: implement background compaction?
 
 class DiskStore::Impl {
    public:
-    explicit Impl(const DiskStoreOptions& options) : options_(options), clock_(options.clock) {
+    explicit Impl(const DiskStoreOptions& options)
+        : options_(options), clock_(options.clock), hint_(options.data_dir / "data.hint") {
         std::filesystem::create_directories(options_.data_dir);
         data_path_ = options_.data_dir / "data.kvds";
 
-        bool file_exists = std::filesystem::exists(data_path_);
-
-        // open file for read+write
-        data_file_.open(data_path_, std::ios::binary | std::ios::in | std::ios::out);
-        if (!data_file_.is_open()) {
-            data_file_.open(data_path_, std::ios::binary | std::ios::out);
-            data_file_.close();
-            data_file_.open(data_path_, std::ios::binary | std::ios::in | std::ios::out);
+        if (options_.blob_threshold > 0 && compact_mode()) {
+            throw std::invalid_argument("blob separation needs IndexMode::Full");
         }
 
-        if (!data_file_.is_open()) {
-            throw std::runtime_error("failed to open data file: " + data_path_.string());
-        }
+        io_ = util::make_io_engine(options_.io_backend);
+        fd_ = util::open_file(data_path_);
+        io_->register_file(fd_);
 
         // write header if new file. existing file - rebuild index by reading entries
-        if (!file_exists || std::filesystem::file_size(data_path_) == 0) {
-            util::write_int<uint32_t>(data_file_, kMagic);
-            util::write_int<uint32_t>(data_file_, kVersion);
-            data_file_.flush();
-        } else {
-            load_index();
+        try {
+            if (options_.value_cache_bytes > 0 && !compact_mode()) {
+                value_cache_ = std::make_unique<ValueCache>(options_.value_cache_bytes);
+            }
+            if (options_.direct_io) {
+                open_direct_fd();
+                if (options_.block_cache_bytes > 0) {
+                    block_cache_ = std::make_unique<BlockCache>(options_.block_cache_bytes);
+                }
+            }
+            // existing segments are opened even with separation turned off - old pointers in the
+            // data file still have to resolve
+            if (options_.blob_threshold > 0 || has_blob_segments()) {
+                blob_log_ =
+                    std::make_unique<BlobLog>(options_.data_dir, options_.blob_segment_size);
+            }
+            uint64_t size = util::file_size(fd_);
+            if (size == 0) {
+                write_header();
+                hint_.remove();
+                if (options_.sync_mode != SyncMode::Os) {
+                    util::sync_file(fd_);
+                    util::sync_directory(options_.data_dir);  // the new file's directory entry
+                }
+            } else {
+                file_end_ = size;
+                upgrade_legacy_file();
+                load_index();
+            }
+            if (!compact_mode()) {
+                account_blobs();
+            }
+            if (options_.direct_io) {
+                // the load scan went through the page cache - nothing is dirty, all of it can go
+                drop_cached_pages(fd_, 0, 0);
+                released_to_ = file_end_;
+                writeback_from_ = file_end_;
+            }
+        } catch (...) {
+            io_->unregister_file(fd_);
+            ::close(fd_);
+            close_direct_fd();
+            throw;
+        }
+        last_sync_ = std::chrono::steady_clock::now();
+
+        if (options_.blob_threshold > 0 && options_.blob_gc_interval.count() > 0) {
+            gc_thread_ = std::thread([this] { gc_loop(); });
+        }
+        if (options_.sync_mode == SyncMode::Batch && options_.sync_interval.count() > 0) {
+            sync_thread_ = std::thread([this] { sync_loop(); });
         }
     }
 
-    void put(std::string_view key, std::string_view value) {
-        bool should_compact = false;
-        {
+    // clean shutdown: leave a hint behind so the next startup doesnt have to scan the data file
+    ~Impl() {
+        stop_background();
+        try {
             std::unique_lock lock(mutex_);
-            append_entry(key, value, std::nullopt, false);
-            should_compact = (tombstone_count_ >= options_.compaction_threshold);
-        }
-        if (should_compact) {
-            try_auto_compact();
+            if (writes_hint() && hint_dirty_) {
+                write_hint();
+            }
+            if (options_.sync_mode != SyncMode::Os) {
+                util::sync_file(fd_);
+            }
+        } catch (const std::exception& e) {
+            LOG_WARN("DiskStore close: " + std::string(e.what()));
         }
+        io_->unregister_file(fd_);
+        ::close(fd_);
+        close_direct_fd();
+    }
+
+    void put(std::string_view key, std::string_view value) {
+        PendingWrite write;
+        write.kind = WriteKind::Put;
+        write.key = key;
+        write.value = value;
+        commit(write);
+        maybe_auto_compact();
     }
 
     void put(std::string_view key, std::string_view value, util::Duration ttl) {
-        bool should_compact = false;
-        {
-            std::unique_lock lock(mutex_);
-            auto expires_at = clock_->now() + ttl;
-            append_entry(key, value, util::to_epoch_ms(expires_at), false);
-            should_compact = (tombstone_count_ >= options_.compaction_threshold);
+        PendingWrite write;
+        write.kind = WriteKind::Put;
+        write.key = key;
+        write.value = value;
+        write.expires_at_ms = util::to_epoch_ms(clock_->now() + ttl);
+        commit(write);
+        maybe_auto_compact();
+    }
+
+    // the entries are one writer's batch already: no need to queue them one by one behind the
+    // leaders, write_batch (under io_mutex_) serializes them with every other write
+    void multi_put(std::span<const KeyValue> entries) {
+        std::vector<PendingWrite> writes(entries.size());
+        std::vector<PendingWrite*> batch;
+        std::size_t batch_bytes = 0;
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            writes[i].key = entries[i].key;
+            writes[i].value = entries[i].value;
+            std::size_t bytes = kRecordOverhead + entries[i].key.size() + entries[i].value.size();
+            if (!batch.empty() && batch_bytes + bytes > kMaxBatchBytes) {
+                write_batch(batch);
+                batch.clear();
+                batch_bytes = 0;
+            }
+            batch.push_back(&writes[i]);
+            batch_bytes += bytes;
         }
-        if (should_compact) {
-            try_auto_compact();
+        if (!batch.empty()) {
+            write_batch(batch);
         }
+        maybe_auto_compact();
     }
 
     // design decision: we dont try to compact at get when we lazy delete an expired entry to keep
     // reads fast.
-    [[nodiscard]] std::optional<std::string> get(std::string_view key) {
-        std::unique_lock lock(mutex_);
+    // expires_at: if given, set to the key's expiration (nullopt = none) when it is found
+    [[nodiscard]] std::optional<std::string> get(
+        std::string_view key, std::optional<util::TimePoint>* expires_at = nullptr) {
+        uint64_t expired_offset = 0;
+        {
+            std::shared_lock lock(mutex_);
+
+            if (compact_mode()) {
+                std::optional<CompactRecord> record;
+                auto offset = find_compact(key, [&](uint64_t candidate) {
+                    record = read_compact_record(candidate, key, true);
+                    return record.has_value();
+                });
+                if (!offset.has_value()) {
+                    return std::nullopt;
+                }
+                if (!is_expired(record->expires_at_ms)) {
+                    if (expires_at != nullptr && record->expires_at_ms.has_value()) {
+                        *expires_at = util::from_epoch_ms(*record->expires_at_ms);
+                    }
+                    return std::move(record->value);
+                }
+                expired_offset = *offset;
+            } else {
+                auto it = index_.find(key);
+                if (it == index_.end()) {
+                    return std::nullopt;
+                }
 
-        auto it = index_.find(std::string(key));
-        if (it == index_.end()) {
-            return std::nullopt;
+                if (!is_expired(it->second)) {
+                    if (expires_at != nullptr) {
+                        *expires_at = it->second.expires_at;
+                    }
+                    return cached_read_value(it->first, it->second);
+                }
+                expired_offset = it->second.offset;
+            }
         }
+        expire(key, expired_offset);
+        return std::nullopt;
+    }
 
-        if (is_expired(it->second)) {
-            append_entry(key, "", std::nullopt, true);
-            return std::nullopt;
+    [[nodiscard]] std::optional<ValueRegion> open_value(std::string_view key,
+                                                        std::size_t min_size) {
+        std::shared_lock lock(mutex_);
+        if (compact_mode() || options_.direct_io) {
+            return std::nullopt;  // no value size in the index / must not fill the page cache
         }
-
-        return read_value(it->second);
+        auto it = index_.find(key);
+        if (it == index_.end() || is_expired(it->second) || it->second.value_size < min_size) {
+            return std::nullopt;  // an expired key is left to get() to drop
+        }
+        auto region = region_of(key, it->second);
+        if (!region) {
+            throw std::runtime_error("failed to dup data file: " + std::string(strerror(errno)));
+        }
+        return region;
     }
 
     [[nodiscard]] bool remove(std::string_view key) {
-        bool should_compact = false;
-        bool removed = false;
-        {
-            std::unique_lock lock(mutex_);
-
-            auto it = index_.find(std::string(key));
-            if (it == index_.end()) {
-                return false;
-            }
-
-            append_entry(key, "", std::nullopt, true);
-            removed = true;
-            should_compact = (tombstone_count_ >= options_.compaction_threshold);
-        }
-        if (should_compact) {
-            try_auto_compact();
+        PendingWrite write;
+        write.kind = WriteKind::Remove;
+        write.key = key;
+        commit(write);
+        if (write.applied) {
+            maybe_auto_compact();
         }
-        return removed;
+        return write.applied;
     }
 
     // design decision: we dont try to compact at contains when we lazy delete an expired entry to
     // keep reads fast.
     [[nodiscard]] bool contains(std::string_view key) {
-        std::unique_lock lock(mutex_);
+        uint64_t expired_offset = 0;
+        {
+            std::shared_lock lock(mutex_);
+
+            if (compact_mode()) {
+                std::optional<CompactRecord> record;
+                auto offset = find_compact(key, [&](uint64_t candidate) {
+                    record = read_compact_record(candidate, key, false);
+                    return record.has_value();
+                });
+                if (!offset.has_value()) {
+                    return false;
+                }
+                if (!is_expired(record->expires_at_ms)) {
+                    return true;
+                }
+                expired_offset = *offset;
+            } else {
+                auto it = index_.find(key);
+                if (it == index_.end()) {
+                    return false;
+                }
 
-        auto it = index_.find(std::string(key));
-        if (it == index_.end()) {
-            return false;
+                if (!is_expired(it->second)) {
+                    return true;
+                }
+                expired_offset = it->second.offset;
+            }
         }
+        expire(key, expired_offset);
+        return false;
+    }
 
-        if (is_expired(it->second)) {
-            append_entry(key, "", std::nullopt, true);
-            return false;
+    // regions != nullptr: values of at least min_region_size come back as regions[i] (see
+    // open_value) instead of being read - in the same index lookup
+    [[nodiscard]] std::vector<std::optional<std::string>> multi_get(
+        std::span<const std::string_view> keys, std::size_t min_region_size = 0,
+        std::vector<std::optional<ValueRegion>>* regions = nullptr) {
+        std::vector<std::optional<std::string>> values(keys.size());
+        if (regions != nullptr) {
+            regions->clear();
+            regions->resize(keys.size());
+            if (options_.direct_io) {
+                regions = nullptr;  // must not fill the page cache, like open_value
+            }
+        }
+        if (compact_mode()) {
+            // every lookup is already a disk read to verify the key - nothing left to batch
+            for (std::size_t i = 0; i < keys.size(); ++i) {
+                values[i] = get(keys[i]);
+            }
+            return values;
         }
 
-        return true;
+        std::vector<std::pair<std::string_view, uint64_t>> expired;
+        {
+            std::shared_lock lock(mutex_);
+            std::vector<util::IoOp> reads;
+            reads.reserve(keys.size());
+            std::vector<std::size_t> read_keys;  // reads[j] is keys[read_keys[j]]
+            std::vector<uint64_t> read_versions;
+            for (std::size_t i = 0; i < keys.size(); ++i) {
+                auto it = index_.find(keys[i]);
+                if (it == index_.end()) {
+                    continue;
+                }
+                const IndexEntry& entry = it->second;
+                if (is_expired(entry)) {
+                    expired.emplace_back(keys[i], entry.offset);
+                    continue;
+                }
+                if (regions != nullptr && entry.value_size >= min_region_size) {
+                    (*regions)[i] = region_of(keys[i], entry);
+                    if ((*regions)[i]) {
+                        continue;
+                    }
+                    // out of fds: read like any other value
+                }
+                if (value_cache_) {
+                    if (auto cached = value_cache_->get(keys[i], entry.offset)) {
+                        values[i] = std::move(cached);
+                        continue;
+                    }
+                }
+                // direct mode: one at a time through the block cache (O_DIRECT needs aligned
+                // buffers, the batch reads straight into the result strings)
+                if (entry.blob_segment != 0 || options_.direct_io) {
+                    values[i] = read_value(keys[i].size(), entry);
+                    cache_value(keys[i], entry, *values[i]);
+                    continue;
+                }
+                std::string& value = values[i].emplace(entry.value_size, '\0');
+                reads.push_back({util::IoOp::Kind::Read, fd_, value.data(), value.size(),
+                                 value_offset(entry.offset, keys[i].size())});
+                read_keys.push_back(i);
+                read_versions.push_back(entry.offset);
+            }
+            // still under the lock: compaction swaps fd_
+            io_->run(reads);
+            if (value_cache_) {
+                for (std::size_t j = 0; j < read_keys.size(); ++j) {
+                    value_cache_->put(keys[read_keys[j]], read_versions[j], *values[read_keys[j]]);
+                }
+            }
+        }
+        for (const auto& [key, offset] : expired) {
+            expire(key, offset);
+        }
+        return values;
     }
 
     [[nodiscard]] std::size_t size() const {
@@ -153,19 +482,55 @@ class DiskStore::Impl {
     }
 
     void clear() {
+        std::lock_guard io_lock(io_mutex_);
         std::unique_lock lock(mutex_);
 
-        data_file_.close();
+        // hint must go before the data file is rewritten - see hint_file.hpp
+        hint_.remove();
+        hint_dirty_ = false;
 
-        data_file_.open(data_path_, std::ios::binary | std::ios::out | std::ios::trunc);
-        util::write_int<uint32_t>(data_file_, kMagic);
-        util::write_int<uint32_t>(data_file_, kVersion);
-        data_file_.flush();
-        data_file_.close();
-
-        data_file_.open(data_path_, std::ios::binary | std::ios::in | std::ios::out);
+        // a new empty file swapped in, not a truncate: a ValueRegion handed out before (a sendfile
+        // in flight) holds the old file and keeps reading its bytes, like across compaction
+        std::filesystem::path temp_path = data_path_.string() + ".tmp";
+        int temp_fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (temp_fd < 0) {
+            throw std::runtime_error("failed to open temp file for clear");
+        }
+        try {
+            std::string header;
+            data_file::append_header(header);
+            util::pwrite_all(temp_fd, header.data(), header.size(), 0);
+            if (options_.sync_mode != SyncMode::Os) {
+                util::sync_file(temp_fd);
+            }
+        } catch (...) {
+            ::close(temp_fd);
+            std::filesystem::remove(temp_path);
+            throw;
+        }
+        ::close(temp_fd);
+        replace_data_file(temp_path, options_.sync_mode != SyncMode::Os);
+        file_end_ = kHeaderSize;
+        if (options_.direct_io) {
+            close_direct_fd();
+            open_direct_fd();
+        }
+        if (block_cache_) {
+            block_cache_->clear();
+        }
+        if (value_cache_) {
+            value_cache_->clear();
+        }
+        released_to_ = file_end_;
+        writeback_from_ = file_end_;
+        if (blob_log_) {
+            blob_log_->clear();
+            blob_live_.clear();
+            blob_dirty_ = false;
+        }
 
         index_.clear();
+        compact_.clear();
         tombstone_count_ = 0;
         entry_count_ = 0;
     }
@@ -174,135 +539,1093 @@ class DiskStore::Impl {
         compact();
     }
 
+    void adopt(const std::filesystem::path& dir) {
+        // everything that can reject dir happens before the old file is touched
+        std::filesystem::path source = dir / "data.kvds";
+        std::ifstream in(source, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("no data file to adopt: " + source.string());
+        }
+        (void)read_header(in);
+        in.close();
+        struct stat source_stat {};
+        struct stat target_stat {};
+        if (::stat(source.c_str(), &source_stat) != 0 ||
+            ::stat(options_.data_dir.c_str(), &target_stat) != 0) {
+            throw std::runtime_error("failed to stat " + source.string());
+        }
+        if (source_stat.st_dev != target_stat.st_dev) {
+            throw std::runtime_error(source.string() +
+                                     " is not on the data directory's filesystem");
+        }
+
+        std::lock_guard io_lock(io_mutex_);
+        std::unique_lock lock(mutex_);
+        replace_data_file(source, true);
+        // after the data file: a crash in between leaves no hint rather than the old one
+        std::filesystem::path source_hint = dir / "data.hint";
+        if (std::filesystem::exists(source_hint)) {
+            std::filesystem::rename(source_hint, hint_.path());
+        }
+
+        index_.clear();
+        compact_.clear();
+        tombstone_count_ = 0;
+        entry_count_ = 0;
+        hint_dirty_ = false;
+        if (block_cache_) {
+            block_cache_->clear();
+        }
+        if (value_cache_) {
+            value_cache_->clear();
+        }
+        if (blob_log_) {
+            // nothing in the new file points into the old segments
+            blob_log_->clear();
+            blob_live_.clear();
+            blob_dirty_ = false;
+        }
+
+        file_end_ = util::file_size(fd_);
+        upgrade_legacy_file();
+        load_index();
+        if (!compact_mode()) {
+            account_blobs();
+        }
+        if (options_.direct_io) {
+            close_direct_fd();
+            open_direct_fd();
+            drop_cached_pages(fd_, 0, 0);
+            released_to_ = file_end_;
+            writeback_from_ = file_end_;
+        }
+    }
+
     void compact() {
+        std::lock_guard io_lock(io_mutex_);
         std::unique_lock lock(mutex_);
         do_compact();
     }
 
-   private:
-    void load_index() {
-        // go to beginning
-        data_file_.seekg(0);
+    [[nodiscard]] ValueCacheStats value_cache_stats() const {
+        return value_cache_ ? value_cache_->stats() : ValueCacheStats{};
+    }
 
-        // header check
-        if (!validate_header()) {
-            throw std::runtime_error("Invalid data file: bad header");
+    [[nodiscard]] bool pending_sync() const {
+        return unsynced_.load();
+    }
+
+    [[nodiscard]] BlockCacheStats block_cache_stats() const {
+        return block_cache_ ? block_cache_->stats() : BlockCacheStats{};
+    }
+
+    [[nodiscard]] std::size_t index_memory_usage() const {
+        std::shared_lock lock(mutex_);
+        if (compact_mode()) {
+            return compact_.memory_usage();
         }
+        // libstdc++ node: next pointer + cached hash + the pair. keys past the SSO buffer add
+        // their own heap block
+        std::size_t bytes = index_.bucket_count() * sizeof(void*);
+        for (const auto& [key, entry] : index_) {
+            bytes += 2 * sizeof(void*) + sizeof(std::pair<const std::string, IndexEntry>);
+            const char* inline_begin = reinterpret_cast<const char*>(&key);
+            if (key.data() < inline_begin || key.data() >= inline_begin + sizeof(key)) {
+                bytes += key.capacity() + 1;
+            }
+        }
+        return bytes;
+    }
 
-        // read every entry
-        while (data_file_.peek() != EOF) {
-            // keep current offset
-            uint64_t offset = data_file_.tellg();
+    std::size_t collect_blob_garbage() {
+        if (!blob_log_) {
+            return 0;
+        }
+        std::lock_guard gc_lock(gc_mutex_);
 
-            // fetch type, key, value, expiration time
-            uint8_t entry_type;
-            if (!util::read_int<uint8_t>(data_file_, entry_type)) {
-                break;
+        std::vector<std::pair<uint32_t, uint64_t>> candidates;  // segment, file bytes
+        {
+            std::lock_guard io_lock(io_mutex_);
+            std::shared_lock lock(mutex_);
+            for (uint32_t segment : blob_log_->segments()) {
+                if (segment == blob_log_->active_segment()) {
+                    continue;
+                }
+                uint64_t bytes = blob_log_->segment_bytes(segment);
+                uint64_t live = 0;
+                if (auto it = blob_live_.find(segment); it != blob_live_.end()) {
+                    live = it->second;
+                }
+                double garbage = static_cast<double>(bytes - std::min(live, bytes));
+                if (bytes > 0 && garbage / static_cast<double>(bytes) >= options_.blob_gc_ratio) {
+                    candidates.emplace_back(segment, bytes);
+                }
             }
-            std::string key;
-            if (!util::read_string(data_file_, key)) {
+        }
+
+        std::size_t freed = 0;
+        for (const auto& [segment, bytes] : candidates) {
+            if (stopping_) {
                 break;
             }
-            std::string value;
-            if (!util::read_string(data_file_, value)) {
-                break;
+            relocate_live_blobs(segment);
+
+            // the relocated values must be durable before their old copies go away
+            std::lock_guard io_lock(io_mutex_);
+            if (blob_dirty_) {
+                blob_log_->sync();
+                blob_dirty_ = false;
+            }
+            util::sync_file(fd_);
+
+            std::unique_lock lock(mutex_);
+            auto it = blob_live_.find(segment);
+            if (it != blob_live_.end() && it->second != 0) {
+                continue;  // a relocation lost a race (e.g. to compaction). next pass
+            }
+            blob_live_.erase(segment);
+            if (segment != blob_log_->active_segment()) {
+                blob_log_->remove_segment(segment);
+                freed += bytes;
+            }
+        }
+        return freed;
+    }
+
+   private:
+    /*
+        group commit (the leveldb/rocksdb writer queue):
+        - every mutation becomes a PendingWrite on the caller's stack and joins write_queue_
+        - the writer at the front of the queue is the leader. it takes every queued writer (up to
+       kMaxBatchBytes), encodes all their records into one contiguous buffer, issues ONE pwrite and
+       - depending on sync_mode - ONE fdatasync, applies the index updates and wakes the followers
+        - followers just sleep until a leader marks them done
+        under load N concurrent writers cost one syscall (+ one sync) instead of N. with a single
+       writer it degenerates to the old behaviour minus the per-field writes.
+
+        lock order: queue_mutex_ is never held while taking the others.
+        io_mutex_ -> mutex_. io_mutex_ serializes everything that touches the file layout (group
+       commit leaders, compaction, clear) so a leader's writes never race a file rewrite. mutex_
+       (the index lock) is only held exclusively for the in-memory index update, so readers keep
+       running while a leader is blocked in write/fdatasync.
+    */
+    enum class WriteKind : uint8_t {
+        Put,
+        Remove,
+        Expire,    // tombstone only if the key still points at expected_offset
+        Relocate,  // blob GC: rewrite the value only if the key still points at expected_offset
+    };
+
+    struct PendingWrite {
+        WriteKind kind = WriteKind::Put;
+        std::string_view key;
+        std::string_view value;
+        util::ExpirationTime expires_at_ms = std::nullopt;
+        uint64_t expected_offset = 0;
+
+        bool applied = false;  // remove/expire: a tombstone was written. relocate: value moved
+        bool done = false;
+        std::exception_ptr error;
+        std::condition_variable cv;
+    };
+
+    // what a batch does to the index once its bytes are in the file
+    struct IndexUpdate {
+        std::string_view key;
+        std::optional<IndexEntry> entry;  // nullopt = tombstone
+        // compact mode: the record the key pointed at before this write. lets the apply step find
+        // the slot without going back to the disk
+        std::optional<uint64_t> previous_offset = std::nullopt;
+    };
+
+    void commit(PendingWrite& write) {
+        std::unique_lock lock(queue_mutex_);
+        write_queue_.push_back(&write);
+        while (!write.done && write_queue_.front() != &write) {
+            write.cv.wait(lock);
+        }
+        if (write.done) {
+            // a leader already committed us
+            if (write.error) {
+                std::rethrow_exception(write.error);
             }
-            uint8_t has_expiration;
-            if (!util::read_int<uint8_t>(data_file_, has_expiration)) {
+            return;
+        }
+
+        // we are the leader. the queue only grows at the back, so the batch is a prefix of it and
+        // nobody else touches these entries until we pop them
+        std::vector<PendingWrite*> batch;
+        std::size_t batch_bytes = 0;
+        for (PendingWrite* pending : write_queue_) {
+            std::size_t bytes = kRecordOverhead + pending->key.size() + pending->value.size();
+            if (!batch.empty() && batch_bytes + bytes > kMaxBatchBytes) {
                 break;
             }
+            batch.push_back(pending);
+            batch_bytes += bytes;
+        }
+        lock.unlock();
 
-            std::optional<util::TimePoint> expires_at = std::nullopt;
-            if (has_expiration != 0) {
-                uint64_t expires_at_ms;
-                if (!util::read_int<uint64_t>(data_file_, expires_at_ms)) {
-                    break;
-                }
-                expires_at = util::from_epoch_ms(expires_at_ms);
+        std::exception_ptr error;
+        try {
+            write_batch(batch);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        for (PendingWrite* pending : batch) {
+            write_queue_.pop_front();
+            if (pending != &write) {
+                pending->error = error;
+                pending->done = true;
+                pending->cv.notify_one();
             }
-            bool is_tombstone = (entry_type == kEntryTombstone);
+        }
+        // hand leadership to whoever is next in line
+        if (!write_queue_.empty()) {
+            write_queue_.front()->cv.notify_one();
+        }
+        lock.unlock();
 
-            // if tombstone, remove from index. else add/update in index
-            if (is_tombstone) {
-                auto it = index_.find(key);
-                if (it != index_.end()) {
-                    index_.erase(it);
-                    --entry_count_;
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void write_batch(const std::vector<PendingWrite*>& batch) {
+        std::lock_guard io_lock(io_mutex_);
+
+        if (blob_log_ && blob_log_->needs_roll()) {
+            roll_blob_segment();
+        }
+
+        write_buffer_.clear();
+        blob_buffer_.clear();
+        std::vector<IndexUpdate> updates;
+        updates.reserve(batch.size());
+
+        // decide what each write does. only io_mutex_ holders mutate the index, so what we read
+        // here cant change under us - the shared lock is just for the readers' sake. writes
+        // earlier in the batch are visible to later ones through `batch_view`
+        {
+            std::shared_lock lock(mutex_);
+            std::unordered_map<std::string_view, std::optional<uint64_t>> batch_view;
+            auto current_offset = [&](std::string_view key) -> std::optional<uint64_t> {
+                if (auto it = batch_view.find(key); it != batch_view.end()) {
+                    return it->second;
                 }
-                ++tombstone_count_;
-            } else {
-                IndexEntry entry{offset, static_cast<uint32_t>(value.size()), expires_at, false};
-                auto it = index_.find(key);
-                if (it != index_.end()) {
-                    it->second = entry;
-                } else {
-                    index_[key] = entry;
-                    ++entry_count_;
+                if (compact_mode()) {
+                    return find_compact(key, [&](uint64_t candidate) {
+                        return record_has_key(candidate, key);
+                    });
+                }
+                if (auto it = index_.find(key); it != index_.end()) {
+                    return it->second.offset;
+                }
+                return std::nullopt;
+            };
+
+            for (PendingWrite* write : batch) {
+                uint64_t offset = file_end_ + write_buffer_.size();
+                switch (write->kind) {
+                    case WriteKind::Put:
+                    case WriteKind::Relocate: {
+                        if (write->kind == WriteKind::Relocate &&
+                            current_offset(write->key) != write->expected_offset) {
+                            break;  // overwritten or removed since GC looked at it
+                        }
+                        std::optional<util::TimePoint> expires_at = std::nullopt;
+                        if (write->expires_at_ms.has_value()) {
+                            expires_at = util::from_epoch_ms(write->expires_at_ms.value());
+                        }
+                        std::optional<uint64_t> previous = std::nullopt;
+                        if (compact_mode()) {
+                            previous = current_offset(write->key);
+                        }
+                        auto value_size = static_cast<uint32_t>(write->value.size());
+                        IndexEntry entry{offset, value_size, expires_at, false};
+                        if (separates(write->value.size())) {
+                            BlobPointer blob =
+                                blob_log_->encode(blob_buffer_, write->key, write->value);
+                            encode_record(write_buffer_, kEntryBlob, write->key,
+                                          encode_blob_pointer(blob), write->expires_at_ms);
+                            entry.blob_segment = blob.segment;
+                            entry.blob_offset = blob.offset;
+                        } else {
+                            encode_record(write_buffer_, kEntryRegular, write->key, write->value,
+                                          write->expires_at_ms);
+                        }
+                        batch_view[write->key] = offset;
+                        updates.push_back({write->key, entry, previous});
+                        write->applied = true;
+                        break;
+                    }
+                    case WriteKind::Remove:
+                    case WriteKind::Expire: {
+                        auto current = current_offset(write->key);
+                        if (!current.has_value() || (write->kind == WriteKind::Expire &&
+                                                     *current != write->expected_offset)) {
+                            break;  // already gone, or replaced since the reader saw it expire
+                        }
+                        encode_record(write_buffer_, kEntryTombstone, write->key, "", std::nullopt);
+                        batch_view[write->key] = std::nullopt;
+                        updates.push_back({write->key, std::nullopt, current});
+                        write->applied = true;
+                        break;
+                    }
                 }
             }
         }
 
-        data_file_.clear();
+        if (write_buffer_.empty()) {
+            return;
+        }
+        if (compact_mode() && file_end_ + write_buffer_.size() > CompactIndex::kMaxOffset) {
+            throw std::runtime_error("data file too large for the compact index (1TB max)");
+        }
+
+        // values first: once a pointer record is in the data file its blob must be there too
+        if (!blob_buffer_.empty()) {
+            blob_log_->append(blob_buffer_);
+            blob_dirty_ = true;
+        }
+        reserve_space(file_end_ + write_buffer_.size());
+        util::pwrite_all(fd_, write_buffer_.data(), write_buffer_.size(), file_end_);
+        sync_after_write();
+        release_written_pages(file_end_ + write_buffer_.size());
+
+        std::unique_lock lock(mutex_);
+        for (const auto& update : updates) {
+            apply_index_update(update);
+        }
+        file_end_ += write_buffer_.size();
+        hint_dirty_ = true;
+
+        // dont let one giant batch pin its buffer forever
+        if (write_buffer_.capacity() > 4 * kMaxBatchBytes) {
+            std::string().swap(write_buffer_);
+        }
+        if (blob_buffer_.capacity() > 4 * kMaxBatchBytes) {
+            std::string().swap(blob_buffer_);
+        }
     }
 
-    void append_entry(std::string_view key, std::string_view value,
-                      util::ExpirationTime expires_at_ms, bool is_tombstone) {
-        // write to end of the file (append)
-        data_file_.seekp(0, std::ios::end);
-        uint64_t offset = data_file_.tellp();
+    void sync_after_write() {
+        switch (options_.sync_mode) {
+            case SyncMode::Always:
+                sync_files();
+                break;
+            case SyncMode::Batch: {
+                // a write that doesnt sync here is left to sync_loop, at most sync_interval later
+                unsynced_ = true;
+                auto now = std::chrono::steady_clock::now();
+                if (now - last_sync_ >= options_.sync_interval) {
+                    sync_files();
+                    last_sync_ = now;
+                    unsynced_ = false;
+                }
+                break;
+            }
+            case SyncMode::Os:
+                break;
+        }
+    }
 
-        // write entry
-        uint8_t entry_type = is_tombstone ? kEntryTombstone : kEntryRegular;
-        util::write_int<uint8_t>(data_file_, entry_type);
-        util::write_string(data_file_, key);
-        util::write_string(data_file_, value);
+    // blob log before the data file, same order as the writes
+    void sync_files() {
+        if (blob_dirty_) {
+            blob_log_->sync();
+            blob_dirty_ = false;
+        }
+        util::sync_file(fd_);
+    }
 
-        uint8_t has_expiration = expires_at_ms.has_value() ? 1 : 0;
-        util::write_int<uint8_t>(data_file_, has_expiration);
-        if (expires_at_ms.has_value()) {
-            util::write_int<uint64_t>(data_file_, expires_at_ms.value());
+    // io_mutex_ held. the segment map changes, so readers have to wait
+    void roll_blob_segment() {
+        // only the active segment gets synced later on - the one we seal has to be durable now
+        if (blob_dirty_ && options_.sync_mode != SyncMode::Os) {
+            blob_log_->sync();
         }
+        blob_dirty_ = false;
+        {
+            std::unique_lock lock(mutex_);
+            blob_log_->roll();
+        }
+        if (options_.sync_mode != SyncMode::Os) {
+            util::sync_directory(options_.data_dir);  // the new segment's directory entry
+        }
+    }
 
-        data_file_.flush();
+    // does a value of this size go to the blob log?
+    [[nodiscard]] bool separates(std::size_t value_size) const {
+        return options_.blob_threshold > 0 && value_size >= options_.blob_threshold;
+    }
 
-        // update index
-        if (is_tombstone) {
-            auto it = index_.find(std::string(key));
+    void apply_index_update(const IndexUpdate& update) {
+        if (compact_mode()) {
+            std::optional<uint64_t> offset = std::nullopt;
+            if (update.entry.has_value()) {
+                offset = update.entry->offset;
+            }
+            apply_compact_update(util::hash64(update.key), offset, update.previous_offset);
+            return;
+        }
+        // the version check alone would keep reads correct, but the old value is dead weight -
+        // and compaction's remap relies on every cached entry being the current one
+        if (value_cache_) {
+            value_cache_->erase(update.key);
+        }
+        if (!update.entry.has_value()) {
+            auto it = index_.find(update.key);
             if (it != index_.end()) {
+                account_blob(update.key.size(), it->second, false);
                 index_.erase(it);
                 --entry_count_;
             }
             ++tombstone_count_;
+            return;
+        }
+
+        auto it = index_.find(update.key);
+        if (it != index_.end()) {
+            account_blob(update.key.size(), it->second, false);
+            it->second = *update.entry;
+        } else {
+            index_.emplace(std::string(update.key), *update.entry);
+            ++entry_count_;
+        }
+        account_blob(update.key.size(), *update.entry, true);
+    }
+
+    // keep blob_live_ in step with the index. mutex_ held exclusively
+    void account_blob(std::size_t key_size, const IndexEntry& entry, bool live) {
+        if (entry.blob_segment == 0) {
+            return;
+        }
+        uint64_t bytes = BlobLog::record_size(key_size, entry.value_size);
+        if (live) {
+            blob_live_[entry.blob_segment] += bytes;
         } else {
+            blob_live_[entry.blob_segment] -= bytes;
+        }
+    }
+
+    // compact mode version of apply_index_update. offset nullopt = tombstone. a rebuild only needs
+    // to look at records before scan_end - the startup scan passes its position, later records
+    // arent indexed yet anyway
+    void apply_compact_update(uint64_t hash, std::optional<uint64_t> offset,
+                              std::optional<uint64_t> previous_offset,
+                              uint64_t scan_end = UINT64_MAX) {
+        if (!offset.has_value()) {
+            if (previous_offset.has_value() && compact_.erase(hash, *previous_offset)) {
+                --entry_count_;
+            }
+            ++tombstone_count_;
+            return;
+        }
+        if (previous_offset.has_value() && compact_.replace(hash, *previous_offset, *offset)) {
+            return;
+        }
+        if (compact_.full()) {
+            rebuild_compact_index(scan_end);
+        }
+        compact_.insert(hash, *offset);
+        ++entry_count_;
+    }
+
+    /*
+        the compact index has no keys, so it cant re-hash itself into a bigger table. instead we
+       read the keys back: one sequential pass over the data file, keeping every record the current
+       table still points at. costs a file scan per doubling (amortized: a few scans over the
+       life of the file) and drops the deleted markers on the way. runs under the exclusive lock
+       like compaction does
+    */
+    void rebuild_compact_index(uint64_t scan_end) {
+        CompactIndex rebuilt(CompactIndex::capacity_for(compact_.size() + 1));
+        if (compact_.size() > 0) {
+            for_each_intact_record(kHeaderSize, scan_end, [&](const ScannedRecord& record) {
+                if (record.type != kEntryRegular) {
+                    return;
+                }
+                uint64_t hash = util::hash64(record.key);
+                if (compact_.find(hash, same_offset(record.offset))) {
+                    rebuilt.insert(hash, record.offset);
+                }
+            });
+        }
+        compact_ = std::move(rebuilt);
+    }
+
+    [[nodiscard]] static std::function<bool(uint64_t)> same_offset(uint64_t offset) {
+        return [offset](uint64_t candidate) { return candidate == offset; };
+    }
+
+    [[nodiscard]] std::optional<uint64_t> find_compact(
+        std::string_view key, const std::function<bool(uint64_t)>& match) const {
+        return compact_.find(util::hash64(key), match);
+    }
+
+    // does the record at offset belong to key? reads just the type, key length and key
+    [[nodiscard]] bool record_has_key(uint64_t offset, std::string_view key) const {
+        uint64_t body = offset + kFrameSize;
+        std::size_t prefix = 1 + 4 + key.size();
+        if (body + prefix > file_end_) {
+            return false;  // too short to hold this key
+        }
+        std::string buf(prefix, '\0');
+        read_data(buf.data(), buf.size(), body);
+        return static_cast<uint8_t>(buf[0]) == kEntryRegular &&
+               util::load_int<uint32_t>(buf.data() + 1) == key.size() &&
+               std::string_view(buf).substr(5) == key;
+    }
+
+    // the record at offset if it belongs to key, else nullopt. reads kLookupWindow bytes at once,
+    // so a record that fits is one pread. bigger ones take a second read for the rest (or just for
+    // the expiration time if the value isnt wanted)
+    [[nodiscard]] std::optional<CompactRecord> read_compact_record(uint64_t record_offset,
+                                                                   std::string_view key,
+                                                                   bool with_value) const {
+        uint64_t offset = record_offset + kFrameSize;  // positions below are within the body
+        std::size_t value_start = 1 + 4 + key.size() + 4;
+        if (offset + value_start + 1 > file_end_) {
+            return std::nullopt;
+        }
+        std::size_t window = std::max(kLookupWindow, value_start + 1 + 8);
+        window = static_cast<std::size_t>(std::min<uint64_t>(window, file_end_ - offset));
+        std::string buf(window, '\0');
+        read_data(buf.data(), buf.size(), offset);
+
+        if (static_cast<uint8_t>(buf[0]) != kEntryRegular ||
+            util::load_int<uint32_t>(buf.data() + 1) != key.size() ||
+            std::string_view(buf).substr(5, key.size()) != key) {
+            return std::nullopt;
+        }
+        uint32_t value_size = util::load_int<uint32_t>(buf.data() + 5 + key.size());
+        std::size_t exp_start = value_start + value_size;
+        if (offset + exp_start + 1 > file_end_) {
+            return std::nullopt;
+        }
+
+        if (buf.size() < exp_start + 1 + 8) {
+            // record runs past the window. read the missing bytes (whole value, or the tail only)
+            std::size_t read_from = with_value ? buf.size() : exp_start;
+            std::size_t read_to = static_cast<std::size_t>(
+                std::min<uint64_t>(exp_start + 1 + 8, file_end_ - offset));
+            if (read_from < read_to) {
+                buf.resize(std::max(buf.size(), read_to));
+                read_data(buf.data() + read_from, read_to - read_from, offset + read_from);
+            }
+        }
+
+        CompactRecord record;
+        if (buf[exp_start] != 0) {
+            if (buf.size() < exp_start + 1 + 8) {
+                return std::nullopt;
+            }
+            record.expires_at_ms =
+                static_cast<int64_t>(util::load_int<uint64_t>(buf.data() + exp_start + 1));
+        }
+        if (with_value) {
+            record.value.assign(buf.data() + value_start, value_size);
+        }
+        return record;
+    }
+
+    // lazily delete an entry a reader found expired
+    void expire(std::string_view key, uint64_t expected_offset) {
+        PendingWrite write;
+        write.kind = WriteKind::Expire;
+        write.key = key;
+        write.expected_offset = expected_offset;
+        commit(write);
+    }
+
+    void write_header() {
+        std::string header;
+        data_file::append_header(header);
+        util::pwrite_all(fd_, header.data(), header.size(), 0);
+        file_end_ = kHeaderSize;
+    }
+
+    void load_index() {
+        // fast path: take everything the hint covers from the hint, scan only the tail
+        uint64_t scan_from = kHeaderSize;
+        if (options_.use_hint_file) {
+            scan_from = load_hint();
+        }
+
+        // the scan maps the file and prefetches it a chunk at a time (data_file::scan)
+        if (scan_from < file_end_) {
+            hint_dirty_ = true;
+        }
+        uint64_t valid_end = scan_entries(scan_from);
+        if (valid_end < file_end_) {
+            truncate_torn_tail(valid_end);
+        }
+    }
+
+    /*
+        a crash in the middle of an append (SyncMode::Batch/Os, or power loss before the
+       fdatasync) leaves a partial record at the end of the file, a bad disk can flip bits in one.
+       either way the scan stops at the first record that fails its checksum and everything from
+       there on is cut off - the state as of the last intact record, and the next append starts
+       on a record boundary again instead of behind garbage
+    */
+    void truncate_torn_tail(uint64_t valid_end) {
+        LOG_WARN("DiskStore: dropping " + std::to_string(file_end_ - valid_end) +
+                 " bytes of torn or corrupt records at offset " + std::to_string(valid_end) +
+                 " of " + data_path_.string());
+        if (::ftruncate(fd_, static_cast<off_t>(valid_end)) != 0) {
+            throw std::runtime_error("failed to truncate data file: " +
+                                     std::string(strerror(errno)));
+        }
+        if (options_.sync_mode != SyncMode::Os) {
+            util::sync_file(fd_);
+        }
+        file_end_ = valid_end;
+    }
+
+    // a v1 file is rewritten as v2 once, record for record - tombstones included, so only the
+    // framing changes. offsets move, so the hint goes too
+    void upgrade_legacy_file() {
+        char header[kHeaderSize];
+        if (file_end_ < kHeaderSize) {
+            return;  // too short for a header, load_index reports it
+        }
+        util::pread_all(fd_, header, kHeaderSize, 0);
+        if (util::load_int<uint32_t>(header) != kMagic ||
+            util::load_int<uint32_t>(header + 4) != kLegacyVersion) {
+            return;
+        }
+        LOG_INFO("upgrading " + data_path_.string() + " to format v" + std::to_string(kVersion) +
+                 " (record checksums)");
+
+        std::filesystem::path temp_path = data_path_.string() + ".tmp";
+        int temp_fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (temp_fd < 0) {
+            throw std::runtime_error("failed to open temp file for the format upgrade");
+        }
+        try {
+            std::string buffer;
+            data_file::append_header(buffer);
+            uint64_t written = 0;
+            for_each_record(kHeaderSize, UINT64_MAX, [&](const ScannedRecord& record) {
+                encode_record(buffer, record.type, record.key, record.value,
+                              record.expires_at_ms);
+                if (buffer.size() >= kCompactionChunkBytes) {
+                    util::pwrite_all(temp_fd, buffer.data(), buffer.size(), written);
+                    written += buffer.size();
+                    buffer.clear();
+                }
+            });
+            util::pwrite_all(temp_fd, buffer.data(), buffer.size(), written);
+            util::sync_file(temp_fd);  // once per store - always durable, whatever sync_mode says
+        } catch (...) {
+            ::close(temp_fd);
+            std::filesystem::remove(temp_path);
+            throw;
+        }
+        ::close(temp_fd);
+        replace_data_file(temp_path, true);
+        file_end_ = util::file_size(fd_);
+    }
+
+    // swap a finished temp file in as the data file. durable: fsync the directory after the
+    // rename, so a crash cant bring the old file back (or leave neither)
+    void replace_data_file(const std::filesystem::path& temp_path, bool durable) {
+        // old hint describes the old file layout - remove it before the rename so a crash in
+        // between never pairs it with the new file
+        hint_.remove();
+        io_->unregister_file(fd_);
+        ::close(fd_);
+        std::filesystem::rename(temp_path, data_path_);
+        fd_ = util::open_file(data_path_);
+        io_->register_file(fd_);
+        if (durable) {
+            util::sync_directory(options_.data_dir);
+        }
+        reserved_end_ = 0;
+    }
+
+    // keep preallocate_bytes of reserved blocks ahead of the appends, so they dont allocate one
+    // small write at a time. io_mutex_ held
+    void reserve_space(uint64_t end) {
+        if (options_.preallocate_bytes == 0 || end <= reserved_end_) {
+            return;
+        }
+        uint64_t extent = options_.preallocate_bytes;
+        uint64_t target = (end / extent + 1) * extent;
+        // a filesystem without fallocate just gets asked again one extent later
+        (void)util::preallocate(fd_, file_end_, target - file_end_);
+        reserved_end_ = target;
+    }
+
+    // returns the data file offset to continue scanning from
+    uint64_t load_hint() {
+        if (!hint_.exists()) {
+            return kHeaderSize;
+        }
+
+        uint64_t file_size = file_end_;
+        auto header = hint_.load([this, file_size](std::string_view key, uint64_t offset,
+                                                   uint32_t value_size,
+                                                   util::ExpirationTime expires_at_ms,
+                                                   const BlobPointer& blob) {
+            if (offset >= file_size) {
+                return;  // caught by the data_end check below
+            }
             std::optional<util::TimePoint> expires_at = std::nullopt;
+            if (compact_mode()) {
+                if (blob.segment != 0) {
+                    throw std::runtime_error("blob values need IndexMode::Full");
+                }
+                // hint keys are unique - nothing to look up, just make room
+                if (compact_.full()) {
+                    rebuild_compact_index(file_size);
+                }
+                compact_.insert(util::hash64(key), offset);
+                return;
+            }
             if (expires_at_ms.has_value()) {
                 expires_at = util::from_epoch_ms(expires_at_ms.value());
             }
+            index_[std::string(key)] =
+                IndexEntry{offset, value_size, expires_at, false, blob.segment, blob.offset};
+        });
+
+        // a hint that is unreadable or claims more data than the file holds doesnt belong to this
+        // data file. drop whatever it gave us and rebuild from scratch
+        if (!header.has_value() || header->data_end < kHeaderSize ||
+            header->data_end > file_size) {
+            LOG_WARN("ignoring stale or corrupt hint file: " + hint_.path().string());
+            index_.clear();
+            compact_.clear();
+            hint_.remove();
+            return kHeaderSize;
+        }
 
-            IndexEntry entry{offset, static_cast<uint32_t>(value.size()), expires_at, false};
+        entry_count_ = compact_mode() ? compact_.size() : index_.size();
+        tombstone_count_ = header->tombstone_count;
+        return header->data_end;
+    }
 
-            auto it = index_.find(std::string(key));
-            if (it != index_.end()) {
-                it->second = entry;
+    // returns the end of the last intact record
+    uint64_t scan_entries(uint64_t from) {
+        auto reserve = [this](uint64_t records) {
+            if (!compact_mode()) {
+                index_.reserve(index_.size() + records);
+            }
+        };
+        auto apply = [this](const ScannedRecord& record) {
+            bool is_tombstone = (record.type == kEntryTombstone);
+            if (compact_mode()) {
+                if (record.type == kEntryBlob) {
+                    throw std::runtime_error("blob values need IndexMode::Full");
+                }
+                // overwrites/removes of a key seen earlier in the scan read that record back to
+                // confirm the match - the file was just streamed, so usually from the page cache
+                auto previous = find_compact(record.key, [&](uint64_t candidate) {
+                    return record_has_key(candidate, record.key);
+                });
+                std::optional<uint64_t> offset = std::nullopt;
+                if (!is_tombstone) {
+                    offset = record.offset;
+                }
+                apply_compact_update(util::hash64(record.key), offset, previous, record.offset);
+                return;
+            }
+
+            // if tombstone, remove from index. else add/update in index
+            if (is_tombstone) {
+                if (index_.erase(std::string(record.key)) > 0) {
+                    --entry_count_;
+                }
+                ++tombstone_count_;
+            } else {
+                std::optional<util::TimePoint> expires_at = std::nullopt;
+                if (record.expires_at_ms.has_value()) {
+                    expires_at = util::from_epoch_ms(record.expires_at_ms.value());
+                }
+                IndexEntry entry{record.offset, static_cast<uint32_t>(record.value.size()),
+                                 expires_at, false};
+                if (record.type == kEntryBlob) {
+                    BlobPointer blob = decode_blob_pointer(record.value);
+                    entry.value_size = blob.size;
+                    entry.blob_segment = blob.segment;
+                    entry.blob_offset = blob.offset;
+                }
+                auto [it, inserted] = index_.try_emplace(std::string(record.key), entry);
+                if (inserted) {
+                    ++entry_count_;
+                } else {
+                    it->second = entry;
+                }
+            }
+        };
+        return for_each_record(from, UINT64_MAX, apply, reserve);
+    }
+
+    // read every intact record in [from, end) in file order. stops at the first torn or corrupt
+    // one - short, impossible length or checksum mismatch - and returns where it stopped: the end
+    // of the last good record. a v1 file has no checksums, there only short records are caught.
+    // on_estimate gets the expected record count first (data_file::ScanOptions)
+    uint64_t for_each_record(uint64_t from, uint64_t end,
+                             const std::function<void(const ScannedRecord&)>& callback,
+                             const std::function<void(uint64_t)>& on_estimate = {}) const {
+        int fd = ::open(data_path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open data file: " + data_path_.string());
+        }
+        try {
+            uint64_t stopped = 0;
+            if (read_header(fd) == kLegacyVersion) {
+                stopped = for_each_legacy_record(from, end, callback);
             } else {
-                index_[std::string(key)] = entry;
-                ++entry_count_;
+                data_file::ScanOptions scan_options;
+                scan_options.threads = scan_threads();
+                scan_options.on_estimate = on_estimate;
+                stopped = data_file::scan(fd, from, end, scan_options, callback);
             }
+            ::close(fd);
+            return stopped;
+        } catch (...) {
+            ::close(fd);
+            throw;
         }
     }
 
-    [[nodiscard]] std::string read_value(const IndexEntry& entry) {
-        data_file_.seekg(entry.offset);
-        uint8_t entry_type;
-        util::read_int<uint8_t>(data_file_, entry_type);
+    // a v1 file, record by record through a stream - only ever read once, by the format upgrade
+    uint64_t for_each_legacy_record(
+        uint64_t from, uint64_t end,
+        const std::function<void(const ScannedRecord&)>& callback) const {
+        std::ifstream in(data_path_, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("failed to open data file: " + data_path_.string());
+        }
+        uint64_t size = std::filesystem::file_size(data_path_);
+        in.seekg(static_cast<std::streamoff>(from));
+
+        ScannedRecord record;
         std::string key;
-        util::read_string(data_file_, key);
         std::string value;
-        util::read_string(data_file_, value);
+        uint64_t offset = from;
+        while (offset < end && offset < size) {
+            record.offset = offset;
+            if (!read_legacy_record(in, record, key, value)) {
+                break;
+            }
+            offset = static_cast<uint64_t>(in.tellg());
+            callback(record);
+        }
+        return offset;
+    }
 
+    // for_each_record over records that were all completely written - startup already cut off
+    // a torn tail, so a bad record here is corruption. compaction and index rebuilds must not
+    // silently drop everything past it
+    void for_each_intact_record(uint64_t from, uint64_t end,
+                                const std::function<void(const ScannedRecord&)>& callback) const {
+        uint64_t stopped = for_each_record(from, end, callback);
+        if (stopped < std::min(end, file_end_)) {
+            throw std::runtime_error("Invalid data file: corrupt record at offset " +
+                                     std::to_string(stopped));
+        }
+    }
+
+    // a v1 record: the bare body, read field by field. record points into key and value
+    static bool read_legacy_record(std::istream& in, ScannedRecord& record, std::string& key,
+                                   std::string& value) {
+        // fetch type, key, value, expiration time
+        if (!util::read_int<uint8_t>(in, record.type)) {
+            return false;
+        }
+        if (!util::read_string(in, key)) {
+            return false;
+        }
+        if (!util::read_string(in, value)) {
+            return false;
+        }
+        record.key = key;
+        record.value = value;
+        uint8_t has_expiration;
+        if (!util::read_int<uint8_t>(in, has_expiration)) {
+            return false;
+        }
+
+        record.expires_at_ms = std::nullopt;
+        if (has_expiration != 0) {
+            uint64_t expires_at_ms;
+            if (!util::read_int<uint64_t>(in, expires_at_ms)) {
+                return false;
+            }
+            record.expires_at_ms = static_cast<int64_t>(expires_at_ms);
+        }
+        return true;
+    }
+
+    // one pread straight into the result - the index already knows where the value starts
+    [[nodiscard]] std::string read_value(std::size_t key_size, const IndexEntry& entry) const {
+        if (entry.blob_segment != 0) {
+            return blob_log_->read(entry.blob(), key_size);
+        }
+        std::string value(entry.value_size, '\0');
+        read_data(value.data(), value.size(), value_offset(entry.offset, key_size));
+        return value;
+    }
+
+    // read_value behind the value cache, versioned by the record's offset. shared mutex_ held
+    // shared lock held. the fd is dup'd before compaction or GC can close the file. nullopt (errno
+    // set) if the dup failed
+    [[nodiscard]] std::optional<ValueRegion> region_of(std::string_view key,
+                                                       const IndexEntry& entry) const {
+        int fd = fd_;
+        uint64_t offset = value_offset(entry.offset, key.size());
+        if (entry.blob_segment != 0) {
+            std::tie(fd, offset) = blob_log_->locate(entry.blob(), key.size());
+        }
+        int dup_fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dup_fd < 0) {
+            return std::nullopt;
+        }
+        return ValueRegion(dup_fd, offset, entry.value_size);
+    }
+
+    [[nodiscard]] std::string cached_read_value(const std::string& key, const IndexEntry& entry) {
+        if (value_cache_) {
+            if (auto cached = value_cache_->get(key, entry.offset)) {
+                return std::move(*cached);
+            }
+        }
+        std::string value = read_value(key.size(), entry);
+        cache_value(key, entry, value);
         return value;
     }
 
+    // filled under the shared lock, so no index update can slip in between the read and this
+    void cache_value(std::string_view key, const IndexEntry& entry, const std::string& value) {
+        if (value_cache_) {
+            value_cache_->put(key, entry.offset, value);
+        }
+    }
+
+    // every data file read of a lookup ends up here. buffered mode: a plain pread. direct mode:
+    // the range is split into 4KB blocks, cached ones are copied out of block_cache_ and each run
+    // of missing ones is one aligned read past the page cache
+    void read_data(char* dst, std::size_t len, uint64_t offset) const {
+        if (!options_.direct_io) {
+            util::pread_all(fd_, dst, len, offset);
+            return;
+        }
+        constexpr uint64_t kBlock = BlockCache::kBlockSize;
+        uint64_t end = offset + len;
+        uint64_t end_block = (end + kBlock - 1) / kBlock;
+
+        // the part of block that lies inside [offset, end) - from the cache. false = miss
+        auto from_cache = [&](uint64_t block) {
+            if (!block_cache_) {
+                return false;
+            }
+            uint64_t from = std::max(offset, block * kBlock);
+            uint64_t to = std::min(end, (block + 1) * kBlock);
+            return block_cache_->read(kDataFileId, block, from - block * kBlock,
+                                      dst + (from - offset), to - from);
+        };
+
+        uint64_t block = offset / kBlock;
+        while (block < end_block) {
+            if (from_cache(block)) {
+                ++block;
+                continue;
+            }
+            uint64_t run_end = block + 1;
+            bool next_hit = false;
+            while (run_end < end_block && run_end - block < kDirectReadBlocks) {
+                if ((next_hit = from_cache(run_end))) {
+                    break;
+                }
+                ++run_end;
+            }
+            read_blocks(block, run_end - block, dst, offset, end);
+            block = next_hit ? run_end + 1 : run_end;
+        }
+    }
+
+    // direct mode miss: read blocks [first, first + count) into an aligned scratch buffer, copy
+    // the wanted part to dst and keep the blocks that can no longer change
+    void read_blocks(uint64_t first, uint64_t count, char* dst, uint64_t offset,
+                     uint64_t end) const {
+        constexpr uint64_t kBlock = BlockCache::kBlockSize;
+        thread_local AlignedBuffer scratch = make_aligned_buffer(kDirectReadBlocks * kBlock);
+
+        uint64_t start = first * kBlock;
+        uint64_t want = count * kBlock;
+        uint64_t need = std::min(end, start + want) - start;  // the rest may lie past EOF
+        int fd = direct_fd_ >= 0 ? direct_fd_ : fd_;
+        uint64_t got = 0;
+        while (got < need) {
+            ssize_t n = ::pread(fd, scratch.get() + got, want - got,
+                                static_cast<off_t>(start + got));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("direct read failed: " + std::string(strerror(errno)));
+            }
+            if (n == 0) {
+                throw std::runtime_error("direct read failed: unexpected end of data file");
+            }
+            uint64_t total = got + static_cast<uint64_t>(n);
+            if (total >= need) {
+                break;
+            }
+            // O_DIRECT continues only from an aligned offset - re-read the partial block
+            got = total / kBlock * kBlock;
+        }
+        if (direct_fd_ < 0) {
+            drop_cached_pages(fd_, start, want);  // fallback: read buffered, then let it go
+        }
+
+        uint64_t from = std::max(offset, start);
+        uint64_t to = std::min(end, start + want);
+        std::memcpy(dst + (from - offset), scratch.get() + (from - start), to - from);
+
+        // the block the next append lands in still grows - only whole blocks below file_end_
+        if (block_cache_) {
+            for (uint64_t i = 0; i < count && (first + i + 1) * kBlock <= file_end_; ++i) {
+                block_cache_->insert(kDataFileId, first + i, scratch.get() + i * kBlock);
+            }
+        }
+    }
+
+    // direct mode writes stay buffered (group commit batches are small and unaligned), so the
+    // kernel would keep every appended page. every kReleaseInterval bytes: start writeback of the
+    // new range and drop the previous one - written back by now, so clean and droppable
+    void release_written_pages(uint64_t end) {
+        if (!options_.direct_io || end - writeback_from_ < kReleaseInterval) {
+            return;
+        }
+        drop_cached_pages(fd_, released_to_, writeback_from_ - released_to_);
+        start_writeback(fd_, writeback_from_, end - writeback_from_);
+        released_to_ = writeback_from_;
+        writeback_from_ = end;
+    }
+
+    void open_direct_fd() {
+        direct_fd_ = open_direct(data_path_);
+        if (direct_fd_ < 0) {
+            LOG_WARN("DiskStore: O_DIRECT not supported for " + data_path_.string() + " (" +
+                     std::string(strerror(errno)) + "), dropping pages after buffered reads");
+        }
+    }
+
+    void close_direct_fd() {
+        if (direct_fd_ >= 0) {
+            ::close(direct_fd_);
+            direct_fd_ = -1;
+        }
+    }
+
     [[nodiscard]] bool is_expired(const IndexEntry& entry) const {
         if (!entry.expires_at.has_value()) {
             return false;
@@ -310,7 +1633,42 @@ class DiskStore::Impl {
         return clock_->now() >= entry.expires_at.value();
     }
 
+    [[nodiscard]] bool is_expired(util::ExpirationTime expires_at_ms) const {
+        if (!expires_at_ms.has_value()) {
+            return false;
+        }
+        return clock_->now() >= util::from_epoch_ms(expires_at_ms.value());
+    }
+
+    [[nodiscard]] bool compact_mode() const {
+        return options_.index_mode == IndexMode::Compact;
+    }
+
+    [[nodiscard]] std::size_t scan_threads() const {
+        if (options_.scan_threads != 0) {
+            return options_.scan_threads;
+        }
+        return std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, kMaxScanThreads);
+    }
+
+    // the hint format carries keys, which the compact index doesnt have. compact mode still loads
+    // a hint left by a Full mode run
+    [[nodiscard]] bool writes_hint() const {
+        return options_.use_hint_file && !compact_mode();
+    }
+
+    void maybe_auto_compact() {
+        {
+            std::shared_lock lock(mutex_);
+            if (tombstone_count_ < options_.compaction_threshold) {
+                return;
+            }
+        }
+        try_auto_compact();
+    }
+
     void try_auto_compact() {
+        std::lock_guard io_lock(io_mutex_);
         std::unique_lock lock(mutex_);
         if (tombstone_count_ >= options_.compaction_threshold) {
             do_compact();
@@ -321,77 +1679,424 @@ class DiskStore::Impl {
         // compact grabs entries from our current index and builds a new data file with it.
         // this just removes all the tombstones that might be present in our old data file
         std::filesystem::path temp_path = data_path_.string() + ".tmp";
+        FullIndex new_index;
+        CompactIndex new_compact(compact_mode() ? CompactIndex::capacity_for(entry_count_) : 0);
+        uint64_t new_file_end = 0;
         {
-            std::ofstream temp_file(temp_path, std::ios::binary);
-            if (!temp_file.is_open()) {
+            int temp_fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (temp_fd < 0) {
                 throw std::runtime_error("failed to open temp file for compaction");
             }
-            util::write_int<uint32_t>(temp_file, kMagic);
-            util::write_int<uint32_t>(temp_file, kVersion);
+            try {
+                std::string buffer;
+                buffer.reserve(kCompactionChunkBytes + kRecordOverhead);
+                data_file::append_header(buffer);
+
+                // returns the record's offset in the new file
+                auto append = [&](uint8_t type, std::string_view key, std::string_view value,
+                                  util::ExpirationTime expires_at_ms) {
+                    uint64_t new_offset = new_file_end + buffer.size();
+                    encode_record(buffer, type, key, value, expires_at_ms);
+                    if (buffer.size() >= kCompactionChunkBytes) {
+                        util::pwrite_all(temp_fd, buffer.data(), buffer.size(), new_file_end);
+                        new_file_end += buffer.size();
+                        buffer.clear();
+                    }
+                    return new_offset;
+                };
+
+                if (compact_mode()) {
+                    // no keys in memory - stream the old file in order and keep the records the
+                    // index still points at. sequential reads instead of one pread per entry
+                    auto keep_live = [&](const ScannedRecord& record) {
+                        if (record.type != kEntryRegular || is_expired(record.expires_at_ms)) {
+                            return;
+                        }
+                        uint64_t hash = util::hash64(record.key);
+                        if (compact_.find(hash, same_offset(record.offset))) {
+                            new_compact.insert(hash, append(kEntryRegular, record.key,
+                                                            record.value, record.expires_at_ms));
+                        }
+                    };
+                    for_each_intact_record(kHeaderSize, UINT64_MAX, keep_live);
+                } else {
+                    // inline values are read in batches into one arena: a whole batch is a single
+                    // I/O submission (all in flight at once with io_uring), not a pread per entry
+                    std::vector<char> arena(kCompactionChunkBytes);
+                    io_->register_buffers({std::span<char>(arena)});
+                    std::vector<util::IoOp> reads;
+                    std::vector<std::pair<const std::string*, const IndexEntry*>> batch;
+                    std::size_t arena_used = 0;
+
+                    auto copy = [&](const std::string& key, const IndexEntry& entry,
+                                    std::string_view value) {
+                        util::ExpirationTime expires_at_ms = std::nullopt;
+                        if (entry.expires_at.has_value()) {
+                            expires_at_ms = util::to_epoch_ms(entry.expires_at.value());
+                        }
+                        IndexEntry new_entry = entry;
+                        if (entry.blob_segment != 0) {
+                            // the value stays where it is - only the small pointer is copied
+                            new_entry.offset = append(kEntryBlob, key,
+                                                      encode_blob_pointer(entry.blob()),
+                                                      expires_at_ms);
+                        } else {
+                            new_entry.offset = append(kEntryRegular, key, value, expires_at_ms);
+                        }
+                        new_index[key] = new_entry;
+                    };
+                    auto flush_reads = [&]() {
+                        io_->run(reads);
+                        for (std::size_t i = 0; i < batch.size(); ++i) {
+                            copy(*batch[i].first, *batch[i].second,
+                                 std::string_view(reads[i].data, reads[i].len));
+                        }
+                        reads.clear();
+                        batch.clear();
+                        arena_used = 0;
+                    };
+
+                    for (auto& [key, entry] : index_) {
+                        if (is_expired(entry)) {
+                            continue;
+                        }
+                        if (entry.blob_segment != 0) {
+                            copy(key, entry, {});
+                        } else if (entry.value_size > arena.size()) {
+                            copy(key, entry, read_value(key.size(), entry));
+                        } else {
+                            if (arena_used + entry.value_size > arena.size()) {
+                                flush_reads();
+                            }
+                            reads.push_back({util::IoOp::Kind::Read, fd_,
+                                             arena.data() + arena_used, entry.value_size,
+                                             value_offset(entry.offset, key.size())});
+                            batch.emplace_back(&key, &entry);
+                            arena_used += entry.value_size;
+                        }
+                    }
+                    flush_reads();
+                    io_->register_buffers({});
+                }
+                util::pwrite_all(temp_fd, buffer.data(), buffer.size(), new_file_end);
+                new_file_end += buffer.size();
 
-            std::unordered_map<std::string, IndexEntry> new_index;
+                // direct mode syncs anyway: the new file's pages must be clean to be dropped
+                if (options_.sync_mode != SyncMode::Os || options_.direct_io) {
+                    util::sync_file(temp_fd);
+                }
+                if (options_.direct_io) {
+                    drop_cached_pages(temp_fd, 0, 0);
+                }
+            } catch (...) {
+                ::close(temp_fd);
+                throw;
+            }
+            ::close(temp_fd);
+        }
+        replace_data_file(temp_path, options_.sync_mode != SyncMode::Os);
+        file_end_ = new_file_end;
+        if (options_.direct_io) {
+            close_direct_fd();
+            open_direct_fd();
+            released_to_ = file_end_;
+            writeback_from_ = file_end_;
+        }
+        if (block_cache_) {
+            block_cache_->clear();  // every record moved
+        }
 
-            for (auto& [key, entry] : index_) {
-                if (is_expired(entry)) {
-                    continue;
+        // new_index already describes the compacted file exactly - no need to scan it again
+        index_ = std::move(new_index);
+        if (value_cache_) {
+            // cached values are all current (see apply_index_update), only their offsets moved
+            value_cache_->remap([this](std::string_view key) -> std::optional<uint64_t> {
+                auto it = index_.find(key);
+                if (it == index_.end()) {
+                    return std::nullopt;  // expired and dropped
                 }
+                return it->second.offset;
+            });
+        }
+        if (blob_log_) {
+            account_blobs();  // expired blob values were dropped
+        }
+        compact_ = std::move(new_compact);
+        entry_count_ = compact_mode() ? compact_.size() : index_.size();
+        tombstone_count_ = 0;
 
-                uint64_t new_offset = temp_file.tellp();
+        hint_dirty_ = true;
+        if (writes_hint()) {
+            write_hint();
+        }
+    }
 
-                std::string value = read_value(entry);
+    void write_hint() {
+        bool durable = options_.sync_mode != SyncMode::Os;
+        hint_.save(file_end_, tombstone_count_, [this](HintEmitter emit) {
+            for (const auto& [key, entry] : index_) {
+                util::ExpirationTime expires_at_ms = std::nullopt;
+                if (entry.expires_at.has_value()) {
+                    expires_at_ms = util::to_epoch_ms(entry.expires_at.value());
+                }
+                BlobPointer blob;
+                if (entry.blob_segment != 0) {
+                    blob = entry.blob();
+                }
+                emit(key, entry.offset, entry.value_size, expires_at_ms, blob);
+            }
+        }, durable);
+        hint_dirty_ = false;
+    }
 
-                util::write_int<uint8_t>(temp_file, kEntryRegular);
-                util::write_string(temp_file, key);
-                util::write_string(temp_file, value);
+    [[nodiscard]] bool has_blob_segments() const {
+        for (const auto& file : std::filesystem::directory_iterator(options_.data_dir)) {
+            if (file.path().extension() == ".blob") {
+                return true;
+            }
+        }
+        return false;
+    }
 
-                uint8_t has_expiration = entry.expires_at.has_value() ? 1 : 0;
-                util::write_int<uint8_t>(temp_file, has_expiration);
-                if (entry.expires_at.has_value()) {
-                    util::write_int<uint64_t>(temp_file,
-                                              util::to_epoch_ms(entry.expires_at.value()));
+    // rebuild the per segment live byte counts from the index. a pointer into a segment that is
+    // gone or too short (a crash between the blob and the data file write, or deleted files) cant
+    // be served - drop the key rather than fail every read of it
+    void account_blobs() {
+        blob_live_.clear();
+        for (auto it = index_.begin(); it != index_.end();) {
+            const IndexEntry& entry = it->second;
+            if (entry.blob_segment == 0) {
+                ++it;
+                continue;
+            }
+            if (!blob_log_ || !blob_log_->contains(entry.blob(), it->first.size())) {
+                LOG_WARN("dropping key whose blob value is missing: " + it->first);
+                if (value_cache_) {
+                    value_cache_->erase(it->first);
                 }
+                it = index_.erase(it);
+                --entry_count_;
+                hint_dirty_ = true;
+                continue;
+            }
+            account_blob(it->first.size(), entry, true);
+            ++it;
+        }
+    }
 
-                new_index[key] = IndexEntry{new_offset, static_cast<uint32_t>(value.size()),
-                                            entry.expires_at, false};
+    // GC, one segment: push every value the index still points at through the write path
+    void relocate_live_blobs(uint32_t segment) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t budget_used = 0;
+        blob_log_->for_each_record(
+            segment, [&](const BlobPointer& blob, std::string_view key, std::string_view value) {
+                if (stopping_) {
+                    return false;
+                }
+                std::optional<IndexEntry> live;
+                {
+                    std::shared_lock lock(mutex_);
+                    auto it = index_.find(key);
+                    if (it != index_.end() && it->second.blob_segment == blob.segment &&
+                        it->second.blob_offset == blob.offset) {
+                        live = it->second;
+                    }
+                }
+                uint64_t bytes = BlobLog::record_size(key.size(), value.size());
+                if (live.has_value()) {
+                    if (is_expired(*live)) {
+                        expire(key, live->offset);
+                    } else {
+                        PendingWrite write;
+                        write.kind = WriteKind::Relocate;
+                        write.key = key;
+                        write.value = value;
+                        write.expected_offset = live->offset;
+                        if (live->expires_at.has_value()) {
+                            write.expires_at_ms = util::to_epoch_ms(live->expires_at.value());
+                        }
+                        commit(write);
+                        bytes *= 2;  // read + write
+                    }
+                }
+                budget_used += bytes;
+                throttle_gc(start, budget_used);
+                return true;
+            });
+    }
+
+    // sleep until `bytes` fit into blob_gc_rate since `start`. wakes early on shutdown
+    void throttle_gc(std::chrono::steady_clock::time_point start, uint64_t bytes) {
+        if (options_.blob_gc_rate == 0) {
+            return;
+        }
+        auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(
+                                   static_cast<double>(bytes) /
+                                   static_cast<double>(options_.blob_gc_rate)));
+        std::unique_lock lock(background_mutex_);
+        background_cv_.wait_until(lock, due, [this] { return stopping_.load(); });
+    }
+
+    void gc_loop() {
+        std::unique_lock lock(background_mutex_);
+        while (!background_cv_.wait_for(lock, options_.blob_gc_interval,
+                                [this] { return stopping_.load(); })) {
+            lock.unlock();
+            try {
+                collect_blob_garbage();
+            } catch (const std::exception& e) {
+                LOG_WARN("blob GC: " + std::string(e.what()));
             }
-            temp_file.flush();
+            lock.lock();
         }
-        data_file_.close();
-        std::filesystem::rename(temp_path, data_path_);
-        data_file_.open(data_path_, std::ios::binary | std::ios::in | std::ios::out);
+    }
 
-        index_.clear();
-        load_index();
-        tombstone_count_ = 0;
+    /*
+        SyncMode::Batch: a write syncs when the last sync is sync_interval old, so without this a
+       burst followed by an idle stretch would stay unsynced until the next write. wakes up when
+       the oldest unsynced write is due and syncs it - the lag stays within one interval
+    */
+    void sync_loop() {
+        std::unique_lock lock(background_mutex_);
+        auto due = std::chrono::steady_clock::now() + options_.sync_interval;
+        while (!background_cv_.wait_until(lock, due, [this] { return stopping_.load(); })) {
+            lock.unlock();
+            try {
+                std::lock_guard io_lock(io_mutex_);
+                auto now = std::chrono::steady_clock::now();
+                if (unsynced_ && now - last_sync_ >= options_.sync_interval) {
+                    sync_files();
+                    last_sync_ = now;
+                    unsynced_ = false;
+                }
+                // still unsynced: a writer synced meanwhile, the rest is due an interval after it.
+                // nothing to sync: a write from now on waits at most one interval
+                due = (unsynced_ ? last_sync_ : now) + options_.sync_interval;
+            } catch (const std::exception& e) {
+                LOG_WARN("DiskStore sync: " + std::string(e.what()));
+                due = std::chrono::steady_clock::now() + options_.sync_interval;
+            }
+            lock.lock();
+        }
     }
 
-    bool validate_header() {
-        uint32_t magic;
-        if (!util::read_int<uint32_t>(data_file_, magic) || magic != kMagic) {
-            return false;
+    void stop_background() {
+        {
+            std::lock_guard lock(background_mutex_);
+            stopping_ = true;
         }
+        background_cv_.notify_all();
+        if (gc_thread_.joinable()) {
+            gc_thread_.join();
+        }
+        if (sync_thread_.joinable()) {
+            sync_thread_.join();
+        }
+    }
+
+    // the file's format version, kVersion or kLegacyVersion
+    static uint32_t read_header(int fd) {
+        char header[kHeaderSize];
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        if (util::file_size(fd) >= kHeaderSize) {
+            util::pread_all(fd, header, kHeaderSize, 0);
+            magic = util::load_int<uint32_t>(header);
+            version = util::load_int<uint32_t>(header + 4);
+        }
+        if (magic != kMagic || (version != kVersion && version != kLegacyVersion)) {
+            throw std::runtime_error("Invalid data file: bad header");
+        }
+        return version;
+    }
 
+    static uint32_t read_header(std::istream& in) {
+        uint32_t magic;
         uint32_t version;
-        if (!util::read_int<uint32_t>(data_file_, version) || version != kVersion) {
-            return false;
+        if (!util::read_int<uint32_t>(in, magic) || magic != kMagic ||
+            !util::read_int<uint32_t>(in, version) ||
+            (version != kVersion && version != kLegacyVersion)) {
+            throw std::runtime_error("Invalid data file: bad header");
         }
-        return true;
+        return version;
     }
 
     DiskStoreOptions options_;
     std::shared_ptr<util::Clock> clock_;
 
     std::filesystem::path data_path_;
-    std::fstream data_file_;
+    std::unique_ptr<util::IoEngine> io_;
+    int fd_ = -1;
+    uint64_t file_end_ = 0;  // next append offset. written only by io_mutex_ holders
+    uint64_t reserved_end_ = 0;  // preallocated up to here (or asked for it). io_mutex_
+
+    // direct I/O mode. direct_fd_ = -1 there if the filesystem refused O_DIRECT. blocks below
+    // file_end_ never change until compaction/clear, which hold mutex_ exclusively and clear
+    // the cache - so readers under the shared lock can fill and use it freely
+    int direct_fd_ = -1;
+    std::unique_ptr<BlockCache> block_cache_;  // null unless direct_io and block_cache_bytes > 0
+    uint64_t released_to_ = 0;     // appended pages before this were dropped. io_mutex_
+    uint64_t writeback_from_ = 0;  // writeback was started up to here. io_mutex_
+
+    // values by key, versioned by record offset. null unless value_cache_bytes > 0 (Full mode).
+    // filled by readers under the shared lock, emptied of a key by every index update
+    std::unique_ptr<ValueCache> value_cache_;
+    HintFile hint_;
+    bool hint_dirty_ = false;  // index changed since the last hint was written
+
+    // group commit state
+    std::mutex queue_mutex_;
+    std::deque<PendingWrite*> write_queue_;
+    std::mutex io_mutex_;
+    std::string write_buffer_;  // reused across batches, only touched by the leader
+    std::chrono::steady_clock::time_point last_sync_;
 
     mutable std::shared_mutex mutex_;
-    std::unordered_map<std::string, IndexEntry> index_;
+    FullIndex index_;  // IndexMode::Full
+    CompactIndex compact_;                               // IndexMode::Compact
     std::size_t tombstone_count_ = 0;
     std::size_t entry_count_ = 0;
+
+    // key-value separation. blob_log_ is null unless enabled or segments exist on disk. appends
+    // happen under io_mutex_, segment set changes additionally under mutex_ (readers use it)
+    std::unique_ptr<BlobLog> blob_log_;
+    std::string blob_buffer_;               // like write_buffer_, for the batch's blob records
+    bool blob_dirty_ = false;               // appended since the last blob sync. io_mutex_
+    std::map<uint32_t, uint64_t> blob_live_;  // segment -> bytes still referenced. mutex_
+
+    std::mutex gc_mutex_;  // one GC pass at a time
+    std::mutex background_mutex_;  // gc_thread_ and sync_thread_ sleep on background_cv_
+    std::condition_variable background_cv_;
+    std::atomic<bool> stopping_{false};
+    std::thread gc_thread_;
+    std::thread sync_thread_;  // SyncMode::Batch
+    std::atomic<bool> unsynced_{false};  // batch writes since the last sync. set under io_mutex_
 };
 
 // PIMPL INTERFACE ---------------------------------------------------------------------------
 
+ValueRegion::ValueRegion(int fd, uint64_t offset, std::size_t size) noexcept
+    : fd_(fd), offset_(offset), size_(size) {}
+ValueRegion::~ValueRegion() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+ValueRegion::ValueRegion(ValueRegion&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), offset_(other.offset_), size_(other.size_) {}
+ValueRegion& ValueRegion::operator=(ValueRegion&& other) noexcept {
+    if (this != &other) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = std::exchange(other.fd_, -1);
+        offset_ = other.offset_;
+        size_ = other.size_;
+    }
+    return *this;
+}
+
 DiskStore::DiskStore(const DiskStoreOptions& options) : impl_(std::make_unique<Impl>(options)) {}
 DiskStore::~DiskStore() = default;
 DiskStore::DiskStore(DiskStore&&) noexcept = default;
@@ -405,12 +2110,32 @@ void DiskStore::put(std::string_view key, std::string_view value, util::Duration
 std::optional<std::string> DiskStore::get(std::string_view key) {
     return impl_->get(key);
 }
+std::optional<std::string> DiskStore::get_with_expiry(std::string_view key,
+                                                     std::optional<util::TimePoint>& expires_at) {
+    expires_at.reset();
+    return impl_->get(key, &expires_at);
+}
+std::optional<ValueRegion> DiskStore::open_value(std::string_view key, std::size_t min_size) {
+    return impl_->open_value(key, min_size);
+}
 bool DiskStore::remove(std::string_view key) {
     return impl_->remove(key);
 }
 bool DiskStore::contains(std::string_view key) {
     return impl_->contains(key);
 }
+std::vector<std::optional<std::string>> DiskStore::multi_get(
+    std::span<const std::string_view> keys) {
+    return impl_->multi_get(keys);
+}
+std::vector<std::optional<std::string>> DiskStore::multi_get(
+    std::span<const std::string_view> keys, std::size_t min_region_size,
+    std::vector<std::optional<ValueRegion>>& regions) {
+    return impl_->multi_get(keys, min_region_size, &regions);
+}
+void DiskStore::multi_put(std::span<const KeyValue> entries) {
+    impl_->multi_put(entries);
+}
 std::size_t DiskStore::size() const {
     return impl_->size();
 }
@@ -423,8 +2148,26 @@ void DiskStore::clear() {
 void DiskStore::flush() {
     impl_->flush();
 }
+void DiskStore::adopt(const std::filesystem::path& dir) {
+    impl_->adopt(dir);
+}
 void DiskStore::compact() {
     impl_->compact();
 }
+std::size_t DiskStore::index_memory_usage() const {
+    return impl_->index_memory_usage();
+}
+std::size_t DiskStore::collect_blob_garbage() {
+    return impl_->collect_blob_garbage();
+}
+bool DiskStore::pending_sync() const {
+    return impl_->pending_sync();
+}
+ValueCacheStats DiskStore::value_cache_stats() const {
+    return impl_->value_cache_stats();
+}
+BlockCacheStats DiskStore::block_cache_stats() const {
+    return impl_->block_cache_stats();
+}
 
-}  // namespace kvstore::core
\ No newline at end of file
+}  // namespace kvstore::core
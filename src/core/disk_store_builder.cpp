@@ -0,0 +1,297 @@
+#include "kvstore/core/disk_store_builder.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kvstore/core/data_file.hpp"
+#include "kvstore/core/hint_file.hpp"
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/hash.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+namespace {
+
+// entries are copied into blocks of this size, so add() never moves the earlier ones
+constexpr std::size_t kArenaBlockBytes = 64 * 1024 * 1024;
+// each thread hands its records to the file this much at a time
+constexpr std::size_t kWriteChunkBytes = 4 * 1024 * 1024;
+
+// fn(0) .. fn(threads - 1), each on its own thread. rethrows the first failure
+void run_parallel(std::size_t threads, const std::function<void(std::size_t)>& fn) {
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            try {
+                fn(t);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+}  // namespace
+
+class DiskStoreBuilder::Impl {
+   public:
+    explicit Impl(const DiskStoreBuilderOptions& options)
+        : options_(options),
+          threads_(options.threads != 0 ? options.threads
+                                        : std::max(1U, std::thread::hardware_concurrency())) {}
+
+    void add(std::string_view key, std::string_view value, util::ExpirationTime expires_at_ms) {
+        if (key.size() > std::numeric_limits<uint32_t>::max() ||
+            value.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::invalid_argument("key or value too large for a DiskStore record");
+        }
+        char* data = allocate(key.size() + value.size());
+        std::memcpy(data, key.data(), key.size());
+        std::memcpy(data + key.size(), value.data(), value.size());
+        entries_.push_back(Entry{data, static_cast<uint32_t>(key.size()),
+                                 static_cast<uint32_t>(value.size()), expires_at_ms});
+    }
+
+    DiskStoreBuildStats finish() {
+        std::filesystem::create_directories(options_.output_dir);
+        std::filesystem::path data_path = options_.output_dir / "data.kvds";
+        if (std::filesystem::exists(data_path)) {
+            throw std::runtime_error("output directory already holds a data file: " +
+                                     data_path.string());
+        }
+
+        std::vector<std::vector<std::size_t>> partitions = partition();
+
+        // every partition gets its own range of the file, in partition order
+        std::vector<uint64_t> starts(threads_);
+        uint64_t data_end = data_file::kHeaderSize;
+        for (std::size_t t = 0; t < threads_; ++t) {
+            starts[t] = data_end;
+            for (std::size_t i : partitions[t]) {
+                data_end += record_size(entries_[i]);
+            }
+        }
+
+        // a leftover hint goes first. the new one is written alongside the data: until the rename
+        // below there is no data.kvds it could be mistaken for, and DiskStore drops a hint next to
+        // a missing data file
+        HintFile hint(options_.output_dir / "data.hint");
+        hint.remove();
+
+        std::filesystem::path temp_path = data_path.string() + ".tmp";
+        int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("failed to create " + temp_path.string());
+        }
+        try {
+            (void)util::preallocate(fd, 0, data_end);
+            std::string header;
+            data_file::append_header(header);
+            util::pwrite_all(fd, header.data(), header.size(), 0);
+            // one more task than partitions: the hint
+            run_parallel(threads_ + 1, [&](std::size_t t) {
+                if (t < threads_) {
+                    write_partition(fd, partitions[t], starts[t]);
+                } else {
+                    write_hint(hint, partitions, starts, data_end);
+                }
+            });
+            util::sync_file(fd);
+        } catch (...) {
+            ::close(fd);
+            std::filesystem::remove(temp_path);
+            hint.remove();
+            throw;
+        }
+        ::close(fd);
+        std::filesystem::rename(temp_path, data_path);
+        util::sync_directory(options_.output_dir);
+
+        DiskStoreBuildStats stats;
+        stats.records = entries_.size();
+        for (const auto& partition : partitions) {
+            stats.keys += partition.size();
+        }
+        stats.data_bytes = data_end;
+
+        entries_.clear();
+        blocks_.clear();
+        oversized_.clear();
+        block_used_ = 0;
+        return stats;
+    }
+
+   private:
+    struct Entry {
+        const char* data;  // key bytes, then value bytes
+        uint32_t key_size;
+        uint32_t value_size;
+        util::ExpirationTime expires_at_ms;
+    };
+
+    [[nodiscard]] static std::string_view key(const Entry& entry) {
+        return {entry.data, entry.key_size};
+    }
+
+    [[nodiscard]] static std::string_view value(const Entry& entry) {
+        return {entry.data + entry.key_size, entry.value_size};
+    }
+
+    [[nodiscard]] static uint64_t record_size(const Entry& entry) {
+        return data_file::record_size(entry.key_size, entry.value_size,
+                                      entry.expires_at_ms.has_value());
+    }
+
+    // bump allocation out of kArenaBlockBytes blocks. big entries get a block of their own
+    char* allocate(std::size_t bytes) {
+        if (bytes > kArenaBlockBytes / 4) {
+            oversized_.push_back(std::make_unique_for_overwrite<char[]>(bytes));
+            return oversized_.back().get();
+        }
+        if (blocks_.empty() || block_used_ + bytes > kArenaBlockBytes) {
+            blocks_.push_back(std::make_unique_for_overwrite<char[]>(kArenaBlockBytes));
+            block_used_ = 0;
+        }
+        char* data = blocks_.back().get() + block_used_;
+        block_used_ += bytes;
+        return data;
+    }
+
+    // entry indexes per thread, by key hash. each partition comes back sorted by key with only
+    // the last add() of every key left
+    std::vector<std::vector<std::size_t>> partition() {
+        std::vector<uint32_t> owner(entries_.size());
+        run_parallel(threads_, [&](std::size_t t) {
+            std::size_t begin = entries_.size() * t / threads_;
+            std::size_t end = entries_.size() * (t + 1) / threads_;
+            for (std::size_t i = begin; i < end; ++i) {
+                owner[i] = static_cast<uint32_t>(util::hash64(key(entries_[i])) % threads_);
+            }
+        });
+
+        std::vector<std::vector<std::size_t>> partitions(threads_);
+        run_parallel(threads_, [&](std::size_t t) {
+            std::vector<SortItem> items;
+            for (std::size_t i = 0; i < owner.size(); ++i) {
+                if (owner[i] == t) {
+                    items.push_back(SortItem{key_prefix(key(entries_[i])), i});
+                }
+            }
+            // the prefix settles most comparisons without a cache miss into the arena
+            auto by_key = [this](const SortItem& a, const SortItem& b) {
+                if (a.prefix != b.prefix) {
+                    return a.prefix < b.prefix;
+                }
+                return key(entries_[a.index]) < key(entries_[b.index]);
+            };
+            // stable: among equal keys the add() order survives, so the last one is the newest
+            if (!std::is_sorted(items.begin(), items.end(), by_key)) {
+                std::stable_sort(items.begin(), items.end(), by_key);
+            }
+            std::vector<std::size_t>& indexes = partitions[t];
+            indexes.reserve(items.size());
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                if (i + 1 < items.size() && items[i].prefix == items[i + 1].prefix &&
+                    key(entries_[items[i].index]) == key(entries_[items[i + 1].index])) {
+                    continue;
+                }
+                indexes.push_back(items[i].index);
+            }
+        });
+        return partitions;
+    }
+
+    struct SortItem {
+        uint64_t prefix;
+        std::size_t index;
+    };
+
+    // the first 8 key bytes, big endian and zero padded: orders like the keys themselves, up to
+    // ties between keys that share them
+    [[nodiscard]] static uint64_t key_prefix(std::string_view key) {
+        uint64_t prefix = 0;
+        for (std::size_t i = 0; i < 8; ++i) {
+            prefix <<= 8;
+            if (i < key.size()) {
+                prefix |= static_cast<unsigned char>(key[i]);
+            }
+        }
+        return prefix;
+    }
+
+    void write_partition(int fd, const std::vector<std::size_t>& indexes, uint64_t offset) const {
+        std::string buffer;
+        buffer.reserve(kWriteChunkBytes + data_file::kRecordOverhead);
+        for (std::size_t i : indexes) {
+            const Entry& entry = entries_[i];
+            data_file::encode_record(buffer, data_file::kEntryRegular, key(entry), value(entry),
+                                     entry.expires_at_ms);
+            if (buffer.size() >= kWriteChunkBytes) {
+                util::pwrite_all(fd, buffer.data(), buffer.size(), offset);
+                offset += buffer.size();
+                buffer.clear();
+            }
+        }
+        util::pwrite_all(fd, buffer.data(), buffer.size(), offset);
+    }
+
+    void write_hint(HintFile& hint, const std::vector<std::vector<std::size_t>>& partitions,
+                    const std::vector<uint64_t>& starts, uint64_t data_end) const {
+        hint.save(data_end, 0, [&](const HintEmitter& emit) {
+            for (std::size_t t = 0; t < partitions.size(); ++t) {
+                uint64_t offset = starts[t];
+                for (std::size_t i : partitions[t]) {
+                    const Entry& entry = entries_[i];
+                    emit(key(entry), offset, entry.value_size, entry.expires_at_ms, BlobPointer{});
+                    offset += record_size(entry);
+                }
+            }
+        });
+    }
+
+    DiskStoreBuilderOptions options_;
+    std::size_t threads_;
+    std::vector<Entry> entries_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::vector<std::unique_ptr<char[]>> oversized_;
+    std::size_t block_used_ = 0;  // of blocks_.back()
+};
+
+// PIMPL INTERFACE ---------------------------------------------------------------------------
+
+DiskStoreBuilder::DiskStoreBuilder(const DiskStoreBuilderOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+DiskStoreBuilder::~DiskStoreBuilder() = default;
+DiskStoreBuilder::DiskStoreBuilder(DiskStoreBuilder&&) noexcept = default;
+DiskStoreBuilder& DiskStoreBuilder::operator=(DiskStoreBuilder&&) noexcept = default;
+void DiskStoreBuilder::add(std::string_view key, std::string_view value,
+                           util::ExpirationTime expires_at_ms) {
+    impl_->add(key, value, expires_at_ms);
+}
+DiskStoreBuildStats DiskStoreBuilder::finish() {
+    return impl_->finish();
+}
+
+}  // namespace kvstore::core
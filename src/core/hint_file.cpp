@@ -0,0 +1,233 @@
+#include "kvstore/core/hint_file.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/crc32c.hpp"
+#include "kvstore/util/file_io.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+namespace {
+
+// hint entries are small and read strictly sequentially. a bigger stream buffer than libstdc++'s
+// default turns thousands of tiny read() calls into a few large ones
+constexpr std::size_t kStreamBufferSize = 1 << 20;
+
+// per-entry flags byte. version 1 wrote a plain has_expiration 0/1 here, which reads the same
+constexpr uint8_t kFlagExpiration = 1;
+constexpr uint8_t kFlagBlob = 2;
+
+// magic, version, data_end, tombstone_count, entry_count
+constexpr std::size_t kHeaderSize = 32;
+// version 3 on: a crc32c trailer after the entries
+constexpr uint32_t kFirstChecksummedVersion = 3;
+constexpr std::size_t kTrailerSize = 4;
+
+// one entry as it is on disk. load() rebuilds the bytes of what it parsed the same way, so both
+// sides checksum the exact same encoding
+void append_entry(std::string& buf, std::string_view key, uint64_t offset, uint32_t value_size,
+                  util::ExpirationTime expires_at, const BlobPointer& blob) {
+    util::append_string(buf, key);
+    util::append_int<uint64_t>(buf, offset);
+    util::append_int<uint32_t>(buf, value_size);
+    uint8_t flags = 0;
+    if (expires_at.has_value()) {
+        flags |= kFlagExpiration;
+    }
+    if (blob.segment != 0) {
+        flags |= kFlagBlob;
+    }
+    util::append_int<uint8_t>(buf, flags);
+    if (expires_at.has_value()) {
+        util::append_int<int64_t>(buf, expires_at.value());
+    }
+    if (blob.segment != 0) {
+        util::append_int<uint32_t>(buf, blob.segment);
+        util::append_int<uint64_t>(buf, blob.offset);
+    }
+}
+
+// the entry count is only known after the entries, so the checksum covers the entries first and
+// the header fields after them: crc32c(entries + data_end + tombstone_count + entry_count)
+uint32_t finish_checksum(uint32_t entries_crc, const HintHeader& header) {
+    std::string fields;
+    util::append_int<uint64_t>(fields, header.data_end);
+    util::append_int<uint64_t>(fields, header.tombstone_count);
+    util::append_int<uint64_t>(fields, header.entry_count);
+    return util::crc32c_extend(entries_crc, fields);
+}
+
+bool verify_checksum(std::istream& in, const HintHeader& header) {
+    // a pass over the raw bytes before any entry is handed out: garbage of the right length
+    // (a torn write, a bad sector) never reaches the index
+    in.seekg(0, std::ios::end);
+    auto file_size = static_cast<uint64_t>(in.tellg());
+    if (file_size < kHeaderSize + kTrailerSize) {
+        return false;
+    }
+    in.seekg(static_cast<std::streamoff>(kHeaderSize));
+
+    std::vector<char> chunk(kStreamBufferSize);
+    uint64_t remaining = file_size - kHeaderSize - kTrailerSize;
+    uint32_t crc = 0;
+    while (remaining > 0) {
+        auto len = static_cast<std::size_t>(std::min<uint64_t>(remaining, chunk.size()));
+        if (!in.read(chunk.data(), static_cast<std::streamsize>(len))) {
+            return false;
+        }
+        crc = util::crc32c_extend(crc, std::string_view(chunk.data(), len));
+        remaining -= len;
+    }
+    uint32_t stored;
+    if (!util::read_int<uint32_t>(in, stored) || stored != finish_checksum(crc, header)) {
+        return false;
+    }
+    in.seekg(static_cast<std::streamoff>(kHeaderSize));
+    return in.good();
+}
+
+}  // namespace
+
+HintFile::HintFile(const std::filesystem::path& path) : path_(path) {}
+
+void HintFile::save(uint64_t data_end, uint64_t tombstone_count, const HintIterator& iterate,
+                    bool durable) {
+    std::filesystem::path temp_path = path_.string() + ".tmp";
+    {
+        std::vector<char> stream_buffer(kStreamBufferSize);
+        std::ofstream out;
+        out.rdbuf()->pubsetbuf(stream_buffer.data(),
+                               static_cast<std::streamsize>(stream_buffer.size()));
+        out.open(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("failed to open hint file: " + temp_path.string());
+        }
+
+        HintHeader header{data_end, tombstone_count, 0};
+        util::write_int<uint32_t>(out, kMagic);
+        util::write_int<uint32_t>(out, kVersion);
+        util::write_int<uint64_t>(out, header.data_end);
+        util::write_int<uint64_t>(out, header.tombstone_count);
+
+        // entry count placeholder, patched once we know it (same trick as Snapshot::save)
+        auto count_pos = out.tellp();
+        util::write_int<uint64_t>(out, 0);
+
+        uint32_t crc = 0;
+        std::string entry;
+        iterate([&](std::string_view key, uint64_t offset, uint32_t value_size,
+                    util::ExpirationTime expires_at, const BlobPointer& blob) {
+            entry.clear();
+            append_entry(entry, key, offset, value_size, expires_at, blob);
+            out.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+            crc = util::crc32c_extend(crc, entry);
+            ++header.entry_count;
+        });
+        util::write_int<uint32_t>(out, finish_checksum(crc, header));
+
+        out.seekp(count_pos);
+        util::write_int<uint64_t>(out, header.entry_count);
+
+        out.flush();
+        if (!out.good()) {
+            throw std::runtime_error("failed to write hint file");
+        }
+    }
+
+    // the rename must not reach the disk before the data it points at: a crash in between would
+    // leave a hint of the right name and size full of zeros
+    int fd = util::open_file(temp_path);
+    try {
+        util::sync_file(fd);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    std::filesystem::rename(temp_path, path_);
+    if (durable) {
+        util::sync_directory(path_.parent_path());
+    }
+}
+
+std::optional<HintHeader> HintFile::load(const HintEmitter& callback) {
+    std::vector<char> stream_buffer(kStreamBufferSize);
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(stream_buffer.data(), static_cast<std::streamsize>(stream_buffer.size()));
+    in.open(path_, std::ios::binary);
+    if (!in.is_open()) {
+        return std::nullopt;
+    }
+
+    uint32_t magic;
+    uint32_t version;
+    if (!util::read_int<uint32_t>(in, magic) || magic != kMagic ||
+        !util::read_int<uint32_t>(in, version) || version < 1 || version > kVersion) {
+        return std::nullopt;
+    }
+
+    HintHeader header;
+    if (!util::read_int<uint64_t>(in, header.data_end) ||
+        !util::read_int<uint64_t>(in, header.tombstone_count) ||
+        !util::read_int<uint64_t>(in, header.entry_count)) {
+        return std::nullopt;
+    }
+    if (version >= kFirstChecksummedVersion && !verify_checksum(in, header)) {
+        return std::nullopt;
+    }
+
+    std::string key;
+    for (uint64_t i = 0; i < header.entry_count; ++i) {
+        uint64_t offset;
+        uint32_t value_size;
+        uint8_t flags;
+        if (!util::read_string(in, key) || !util::read_int<uint64_t>(in, offset) ||
+            !util::read_int<uint32_t>(in, value_size) || !util::read_int<uint8_t>(in, flags)) {
+            return std::nullopt;
+        }
+
+        util::ExpirationTime expires_at = std::nullopt;
+        if ((flags & kFlagExpiration) != 0) {
+            int64_t expires_at_ms;
+            if (!util::read_int<int64_t>(in, expires_at_ms)) {
+                return std::nullopt;
+            }
+            expires_at = expires_at_ms;
+        }
+        BlobPointer blob;
+        if ((flags & kFlagBlob) != 0) {
+            if (!util::read_int<uint32_t>(in, blob.segment) ||
+                !util::read_int<uint64_t>(in, blob.offset)) {
+                return std::nullopt;
+            }
+            blob.size = value_size;
+        }
+        callback(key, offset, value_size, expires_at, blob);
+    }
+
+    return header;
+}
+
+void HintFile::remove() {
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+bool HintFile::exists() const {
+    return std::filesystem::exists(path_);
+}
+
+std::filesystem::path HintFile::path() const {
+    return path_;
+}
+
+}  // namespace kvstore::core
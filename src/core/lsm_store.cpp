@@ -0,0 +1,977 @@
+#include "kvstore/core/lsm_store.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "kvstore/core/sstable.hpp"
+#include "kvstore/core/wal.hpp"
+#include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/logger.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+namespace {
+
+constexpr uint32_t kManifestMagic = 0x4B564C4D;  // "KVLM"
+constexpr uint32_t kManifestVersion = 1;
+constexpr std::size_t kNumLevels = 7;
+// rough cost of a std::map node + bookkeeping, counted against memtable_size per write
+constexpr std::size_t kMemEntryOverhead = 64;
+
+std::string file_name(uint64_t number, const char* ext) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%06llu.%s", static_cast<unsigned long long>(number), ext);
+    return buf;
+}
+
+// "000042.sst" -> 42. anything else in the directory is not ours
+std::optional<uint64_t> parse_file_number(const std::filesystem::path& path, std::string_view ext) {
+    if (path.extension() != ext) {
+        return std::nullopt;
+    }
+    std::string stem = path.stem().string();
+    auto is_digit = [](unsigned char c) { return std::isdigit(c) != 0; };
+    if (stem.empty() || !std::all_of(stem.begin(), stem.end(), is_digit)) {
+        return std::nullopt;
+    }
+    return std::stoull(stem);
+}
+
+struct MemEntry {
+    std::string value;
+    bool tombstone = false;
+    util::ExpirationTime expires_at_ms = std::nullopt;
+};
+
+// note: std::less<> enables lookups by string_view without building a std::string per get
+struct Memtable {
+    std::map<std::string, MemEntry, std::less<>> entries;
+    std::size_t bytes = 0;
+    uint64_t log_number = 0;  // WAL holding exactly this memtable's writes
+};
+
+// level 0 is ordered newest first, L1+ by smallest key
+struct Version {
+    std::array<std::vector<std::shared_ptr<SSTable>>, kNumLevels> levels;
+};
+
+class MemtableIterator : public TableIterator {
+   public:
+    explicit MemtableIterator(std::shared_ptr<const Memtable> mem)
+        : mem_(std::move(mem)), it_(mem_->entries.begin()) {
+        load();
+    }
+
+    [[nodiscard]] bool valid() const override {
+        return it_ != mem_->entries.end();
+    }
+
+    [[nodiscard]] const TableEntry& entry() const override {
+        return entry_;
+    }
+
+    void next() override {
+        ++it_;
+        load();
+    }
+
+   private:
+    void load() {
+        if (valid()) {
+            entry_.key = it_->first;
+            entry_.value = it_->second.value;
+            entry_.tombstone = it_->second.tombstone;
+            entry_.expires_at_ms = it_->second.expires_at_ms;
+        }
+    }
+
+    std::shared_ptr<const Memtable> mem_;
+    std::map<std::string, MemEntry, std::less<>>::const_iterator it_;
+    TableEntry entry_;
+};
+
+// walks the tables of one L1+ level back to back. they are sorted and dont overlap, so the
+// concatenation is sorted too - one merge input per level instead of one per table
+class LevelIterator : public TableIterator {
+   public:
+    explicit LevelIterator(std::vector<std::shared_ptr<SSTable>> tables)
+        : tables_(std::move(tables)) {
+        skip_exhausted();
+    }
+
+    [[nodiscard]] bool valid() const override {
+        return current_ && current_->valid();
+    }
+
+    [[nodiscard]] const TableEntry& entry() const override {
+        return current_->entry();
+    }
+
+    void next() override {
+        current_->next();
+        skip_exhausted();
+    }
+
+   private:
+    void skip_exhausted() {
+        while (!valid() && pos_ < tables_.size()) {
+            current_ = tables_[pos_++]->iterator();
+        }
+    }
+
+    std::vector<std::shared_ptr<SSTable>> tables_;
+    std::size_t pos_ = 0;
+    std::unique_ptr<TableIterator> current_;
+};
+
+// releases a held lock for a scope and re-acquires it on exit, also when unwinding
+class ScopedUnlock {
+   public:
+    explicit ScopedUnlock(std::unique_lock<std::shared_mutex>& lock) : lock_(lock) {
+        lock_.unlock();
+    }
+    ~ScopedUnlock() {
+        lock_.lock();
+    }
+
+    ScopedUnlock(const ScopedUnlock&) = delete;
+    ScopedUnlock& operator=(const ScopedUnlock&) = delete;
+
+   private:
+    std::unique_lock<std::shared_mutex>& lock_;
+};
+
+}  // namespace
+
+/*
+    note on threading:
+    - write_mutex_ serializes writers (WAL append + memtable insert + memtable rotation)
+    - mutex_ protects mem_/imm_/version_ and the background state. readers take it shared just long
+   enough to probe the memtables and grab the current version - table I/O happens unlocked
+    - a Version is immutable once published. compaction builds a new one and swaps the pointer, so
+   a reader holding the old one keeps a consistent view (and its tables open) until it is done
+    - one background thread does all flushes and compactions, so nothing else ever edits version_
+   or the MANIFEST, except clear() which first waits for the thread to go idle
+*/
+class LsmStore::Impl {
+   public:
+    explicit Impl(const LsmStoreOptions& options) : options_(options), clock_(options.clock) {
+        std::filesystem::create_directories(options_.data_dir);
+        manifest_path_ = options_.data_dir / "MANIFEST";
+        recover();
+        bg_thread_ = std::thread(&Impl::background_loop, this);
+    }
+
+    ~Impl() {
+        {
+            std::unique_lock lock(mutex_);
+            stop_ = true;
+        }
+        bg_cv_.notify_all();
+        bg_thread_.join();
+    }
+
+    void put(std::string_view key, std::string_view value) {
+        std::lock_guard write_lock(write_mutex_);
+        write(key, MemEntry{std::string(value), false, std::nullopt});
+    }
+
+    void put(std::string_view key, std::string_view value, util::Duration ttl) {
+        std::lock_guard write_lock(write_mutex_);
+        int64_t expires_at_ms = util::to_epoch_ms(clock_->now() + ttl);
+        write(key, MemEntry{std::string(value), false, expires_at_ms});
+    }
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) const {
+        auto entry = find(key);
+        if (!entry.has_value() || !is_live(entry.value())) {
+            return std::nullopt;
+        }
+        return std::move(entry->value);
+    }
+
+    // check + tombstone under write_mutex_ so two concurrent removes cant both report success
+    [[nodiscard]] bool remove(std::string_view key) {
+        std::lock_guard write_lock(write_mutex_);
+        auto entry = find(key);
+        if (!entry.has_value() || !is_live(entry.value())) {
+            return false;
+        }
+        write(key, MemEntry{std::string(), true, std::nullopt});
+        return true;
+    }
+
+    [[nodiscard]] bool contains(std::string_view key) const {
+        auto entry = find(key);
+        return entry.has_value() && is_live(entry.value());
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        auto it = merged_iterator();
+        std::size_t count = 0;
+        for (; it->valid(); it->next()) {
+            if (is_live(it->entry())) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const {
+        for (auto it = merged_iterator(); it->valid(); it->next()) {
+            if (is_live(it->entry())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void clear() {
+        std::lock_guard write_lock(write_mutex_);
+        std::unique_lock lock(mutex_);
+        // keep the background thread from starting new work, and wait out what it is doing
+        clearing_ = true;
+        bg_cv_.wait(lock, [this] { return !bg_busy_; });
+
+        auto old_version = version_;
+        auto old_imm = imm_;
+        uint64_t log_number = mem_->log_number;
+        try {
+            wal_->truncate();
+            write_manifest(Version{}, next_file_number_, log_number);
+        } catch (...) {
+            clearing_ = false;
+            bg_cv_.notify_all();
+            throw;
+        }
+        // the manifest no longer references anything - from here on the old files are garbage
+        log_number_ = log_number;
+        version_ = std::make_shared<const Version>();
+        imm_.reset();
+        mem_ = std::make_shared<Memtable>();
+        mem_->log_number = log_number;
+        clearing_ = false;
+        bg_cv_.notify_all();
+
+        std::error_code ec;
+        if (old_imm) {
+            std::filesystem::remove(log_path(old_imm->log_number), ec);
+        }
+        for (const auto& level : old_version->levels) {
+            for (const auto& table : level) {
+                std::filesystem::remove(table->path(), ec);
+            }
+        }
+    }
+
+    void flush() {
+        std::lock_guard write_lock(write_mutex_);
+        {
+            std::shared_lock lock(mutex_);
+            throw_if_bg_error();
+        }
+        if (!mem_->entries.empty()) {
+            rotate_memtable();
+        }
+        std::unique_lock lock(mutex_);
+        bg_cv_.wait(lock, [this] { return !imm_ || bg_error_.has_value(); });
+        throw_if_bg_error();
+    }
+
+    void compact() {
+        flush();
+        std::unique_lock lock(mutex_);
+        bg_cv_.wait(lock, [this] {
+            return bg_error_.has_value() || (!imm_ && !bg_busy_ && !needs_compaction());
+        });
+        throw_if_bg_error();
+    }
+
+    [[nodiscard]] std::vector<std::size_t> files_per_level() const {
+        std::shared_lock lock(mutex_);
+        std::vector<std::size_t> counts;
+        for (const auto& level : version_->levels) {
+            counts.push_back(level.size());
+        }
+        return counts;
+    }
+
+   private:
+    struct Compaction {
+        std::size_t level;
+        std::vector<std::shared_ptr<SSTable>> inputs;    // from level
+        std::vector<std::shared_ptr<SSTable>> overlaps;  // from level + 1
+        bool bottommost;                                 // nothing older below the output
+    };
+
+    // ========================================================================
+    // paths / helpers
+    // ========================================================================
+
+    [[nodiscard]] std::filesystem::path table_path(uint64_t number) const {
+        return options_.data_dir / file_name(number, "sst");
+    }
+
+    [[nodiscard]] std::filesystem::path log_path(uint64_t number) const {
+        return options_.data_dir / file_name(number, "log");
+    }
+
+    [[nodiscard]] int64_t now_ms() const {
+        return util::to_epoch_ms(clock_->now());
+    }
+
+    [[nodiscard]] bool is_live(const TableEntry& entry) const {
+        if (entry.tombstone) {
+            return false;
+        }
+        return !entry.expires_at_ms.has_value() || entry.expires_at_ms.value() > now_ms();
+    }
+
+    // mutex_ must be held
+    void throw_if_bg_error() const {
+        if (bg_error_.has_value()) {
+            throw std::runtime_error("LsmStore background error: " + bg_error_.value());
+        }
+    }
+
+    // ========================================================================
+    // read path
+    // ========================================================================
+
+    static std::optional<TableEntry> find_in(const Memtable& mem, std::string_view key) {
+        auto it = mem.entries.find(key);
+        if (it == mem.entries.end()) {
+            return std::nullopt;
+        }
+        return TableEntry{it->first, it->second.value, it->second.tombstone,
+                          it->second.expires_at_ms};
+    }
+
+    // newest version of key, tombstones included. nullopt = no trace of it anywhere
+    [[nodiscard]] std::optional<TableEntry> find(std::string_view key) const {
+        std::shared_ptr<const Version> version;
+        {
+            std::shared_lock lock(mutex_);
+            if (auto entry = find_in(*mem_, key)) {
+                return entry;
+            }
+            if (imm_) {
+                if (auto entry = find_in(*imm_, key)) {
+                    return entry;
+                }
+            }
+            version = version_;
+        }
+
+        // L0 tables overlap each other - check all of them, newest first
+        for (const auto& table : version->levels[0]) {
+            if (table->overlaps(key, key)) {
+                if (auto entry = table->get(key)) {
+                    return entry;
+                }
+            }
+        }
+        // deeper levels: at most one table per level can hold the key
+        for (std::size_t level = 1; level < kNumLevels; ++level) {
+            const auto& tables = version->levels[level];
+            auto it = std::lower_bound(tables.begin(), tables.end(), key,
+                                       [](const std::shared_ptr<SSTable>& table,
+                                          std::string_view k) { return table->largest_key() < k; });
+            if (it != tables.end() && (*it)->smallest_key() <= key) {
+                if (auto entry = (*it)->get(key)) {
+                    return entry;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    // every version of every key, newest wins - memtable, immutable memtable, L0..L6
+    [[nodiscard]] std::unique_ptr<TableIterator> merged_iterator() const {
+        std::shared_ptr<const Memtable> mem;
+        std::shared_ptr<const Memtable> imm;
+        std::shared_ptr<const Version> version;
+        {
+            // the active memtable keeps changing - scan a copy
+            std::shared_lock lock(mutex_);
+            mem = std::make_shared<const Memtable>(*mem_);
+            imm = imm_;
+            version = version_;
+        }
+
+        std::vector<std::unique_ptr<TableIterator>> children;
+        children.push_back(std::make_unique<MemtableIterator>(mem));
+        if (imm) {
+            children.push_back(std::make_unique<MemtableIterator>(imm));
+        }
+        for (const auto& table : version->levels[0]) {
+            children.push_back(table->iterator());
+        }
+        for (std::size_t level = 1; level < kNumLevels; ++level) {
+            if (!version->levels[level].empty()) {
+                children.push_back(std::make_unique<LevelIterator>(version->levels[level]));
+            }
+        }
+        return std::make_unique<MergingIterator>(std::move(children));
+    }
+
+    // ========================================================================
+    // write path
+    // ========================================================================
+
+    // write_mutex_ must be held
+    void write(std::string_view key, MemEntry entry) {
+        {
+            std::shared_lock lock(mutex_);
+            throw_if_bg_error();
+        }
+        if (mem_->bytes >= options_.memtable_size) {
+            rotate_memtable();
+        }
+
+        if (entry.tombstone) {
+            wal_->log_remove(key);
+        } else if (entry.expires_at_ms.has_value()) {
+            wal_->log_put_with_ttl(key, entry.value, entry.expires_at_ms.value());
+        } else {
+            wal_->log_put(key, entry.value);
+        }
+
+        std::unique_lock lock(mutex_);
+        mem_->bytes += key.size() + entry.value.size() + kMemEntryOverhead;
+        mem_->entries.insert_or_assign(std::string(key), std::move(entry));
+    }
+
+    // write_mutex_ must be held. the full memtable becomes immutable and a fresh one (with its
+    // own WAL) takes writes. if the previous one is still being flushed, stall until it lands -
+    // this is the backpressure that keeps writers from outrunning the background thread
+    void rotate_memtable() {
+        {
+            std::unique_lock lock(mutex_);
+            bg_cv_.wait(lock, [this] { return !imm_ || bg_error_.has_value(); });
+            throw_if_bg_error();
+        }
+
+        uint64_t number = next_file_number_++;
+        auto wal = std::make_unique<WriteAheadLog>(log_path(number));
+        auto mem = std::make_shared<Memtable>();
+        mem->log_number = number;
+        {
+            std::unique_lock lock(mutex_);
+            imm_ = std::move(mem_);
+            mem_ = std::move(mem);
+        }
+        wal_ = std::move(wal);
+        bg_cv_.notify_all();
+    }
+
+    // ========================================================================
+    // background work
+    // ========================================================================
+
+    // mutex_ must be held
+    [[nodiscard]] bool has_work() const {
+        return !bg_error_.has_value() && !clearing_ && (imm_ || needs_compaction());
+    }
+
+    void background_loop() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            bg_cv_.wait(lock, [this] { return stop_ || has_work(); });
+            if (stop_) {
+                break;
+            }
+            bg_busy_ = true;
+            try {
+                // flushes first: a pending immutable memtable is what stalls writers
+                if (imm_) {
+                    flush_immutable(lock);
+                } else {
+                    run_compaction(lock);
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("LsmStore background work failed: " + std::string(e.what()));
+                bg_error_ = e.what();
+            }
+            bg_busy_ = false;
+            bg_cv_.notify_all();
+        }
+    }
+
+    // write every entry of the iterator to a new table. nullptr if there was nothing to write
+    std::shared_ptr<SSTable> write_table(uint64_t number, TableIterator& it) const {
+        SSTableWriter writer(table_path(number), options_.block_size, options_.bloom_bits_per_key);
+        for (; it.valid(); it.next()) {
+            writer.add(it.entry());
+        }
+        if (writer.entry_count() == 0) {
+            return nullptr;
+        }
+        writer.finish();
+        return SSTable::open(table_path(number), number);
+    }
+
+    // mutex_ held on entry and exit, released while writing the table
+    void flush_immutable(std::unique_lock<std::shared_mutex>& lock) {
+        auto imm = imm_;
+        uint64_t number = next_file_number_++;
+
+        std::shared_ptr<SSTable> table;
+        {
+            ScopedUnlock unlocked(lock);
+            MemtableIterator it(imm);
+            table = write_table(number, it);
+        }
+
+        auto next = std::make_shared<Version>(*version_);
+        if (table) {
+            next->levels[0].insert(next->levels[0].begin(), table);
+        }
+        // everything older than the active memtable's log now lives in tables
+        uint64_t log_number = mem_->log_number;
+        uint64_t next_file_number = next_file_number_;
+        {
+            ScopedUnlock unlocked(lock);
+            write_manifest(*next, next_file_number, log_number);
+            std::error_code ec;
+            std::filesystem::remove(log_path(imm->log_number), ec);
+        }
+
+        log_number_ = log_number;
+        version_ = std::move(next);
+        imm_.reset();
+    }
+
+    [[nodiscard]] uint64_t max_bytes_for_level(std::size_t level) const {
+        uint64_t bytes = options_.level_base_size;
+        for (std::size_t i = 1; i < level; ++i) {
+            bytes *= 10;
+        }
+        return bytes;
+    }
+
+    static uint64_t level_bytes(const std::vector<std::shared_ptr<SSTable>>& tables) {
+        uint64_t total = 0;
+        for (const auto& table : tables) {
+            total += table->file_size();
+        }
+        return total;
+    }
+
+    // >= 1 means the level is over budget. L0 is scored by file count: every L0 file is one more
+    // table a read may have to probe
+    [[nodiscard]] double level_score(std::size_t level) const {
+        const auto& tables = version_->levels[level];
+        if (level == 0) {
+            return static_cast<double>(tables.size()) /
+                   static_cast<double>(std::max<std::size_t>(options_.l0_compaction_trigger, 1));
+        }
+        return static_cast<double>(level_bytes(tables)) /
+               static_cast<double>(max_bytes_for_level(level));
+    }
+
+    // mutex_ must be held. the last level has nowhere to go
+    [[nodiscard]] bool needs_compaction() const {
+        for (std::size_t level = 0; level + 1 < kNumLevels; ++level) {
+            if (level_score(level) >= 1.0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // mutex_ must be held
+    std::optional<Compaction> pick_compaction() {
+        std::size_t best_level = 0;
+        double best_score = 0;
+        for (std::size_t level = 0; level + 1 < kNumLevels; ++level) {
+            double score = level_score(level);
+            if (score > best_score) {
+                best_score = score;
+                best_level = level;
+            }
+        }
+        if (best_score < 1.0) {
+            return std::nullopt;
+        }
+
+        Compaction c;
+        c.level = best_level;
+        const auto& tables = version_->levels[best_level];
+        if (best_level == 0) {
+            // L0 files overlap each other - they all have to move down together
+            c.inputs = tables;
+        } else {
+            // round robin through the key space so every part of the level gets compacted
+            auto it = std::find_if(tables.begin(), tables.end(), [&](const auto& table) {
+                return table->smallest_key() > compact_pointer_[best_level];
+            });
+            if (it == tables.end()) {
+                it = tables.begin();
+            }
+            c.inputs.push_back(*it);
+            compact_pointer_[best_level] = (*it)->largest_key();
+        }
+
+        std::string smallest = c.inputs.front()->smallest_key();
+        std::string largest = c.inputs.front()->largest_key();
+        for (const auto& table : c.inputs) {
+            smallest = std::min(smallest, table->smallest_key());
+            largest = std::max(largest, table->largest_key());
+        }
+        for (const auto& table : version_->levels[best_level + 1]) {
+            if (table->overlaps(smallest, largest)) {
+                c.overlaps.push_back(table);
+            }
+        }
+
+        c.bottommost = true;
+        for (std::size_t level = best_level + 2; level < kNumLevels && c.bottommost; ++level) {
+            for (const auto& table : version_->levels[level]) {
+                if (table->overlaps(smallest, largest)) {
+                    c.bottommost = false;
+                    break;
+                }
+            }
+        }
+        return c;
+    }
+
+    // merge inputs + overlaps into new tables for the next level, split at target_file_size
+    std::vector<std::shared_ptr<SSTable>> merge_tables(const Compaction& c) {
+        std::vector<std::unique_ptr<TableIterator>> children;
+        for (const auto& table : c.inputs) {
+            children.push_back(table->iterator());
+        }
+        if (!c.overlaps.empty()) {
+            children.push_back(std::make_unique<LevelIterator>(c.overlaps));
+        }
+        MergingIterator it(std::move(children));
+
+        int64_t now = now_ms();
+        std::vector<std::shared_ptr<SSTable>> outputs;
+        std::unique_ptr<SSTableWriter> writer;
+        uint64_t number = 0;
+        auto finish_output = [&] {
+            writer->finish();
+            writer.reset();
+            outputs.push_back(SSTable::open(table_path(number), number));
+        };
+
+        for (; it.valid(); it.next()) {
+            const TableEntry& entry = it.entry();
+            bool expired = entry.expires_at_ms.has_value() && entry.expires_at_ms.value() <= now;
+            // tombstones only exist to shadow older versions. with nothing older below, drop them
+            if ((entry.tombstone || expired) && c.bottommost) {
+                continue;
+            }
+            if (!writer) {
+                number = next_file_number_++;
+                writer = std::make_unique<SSTableWriter>(
+                    table_path(number), options_.block_size, options_.bloom_bits_per_key);
+            }
+            if (expired) {
+                // an older live version may still sit below - keep shadowing it, minus the value
+                writer->add(TableEntry{entry.key, std::string(), true, std::nullopt});
+            } else {
+                writer->add(entry);
+            }
+            if (writer->estimated_size() >= options_.target_file_size) {
+                finish_output();
+            }
+        }
+        if (writer) {
+            finish_output();
+        }
+        return outputs;
+    }
+
+    // mutex_ held on entry and exit, released while merging
+    void run_compaction(std::unique_lock<std::shared_mutex>& lock) {
+        auto c = pick_compaction();
+        if (!c.has_value()) {
+            return;
+        }
+
+        // one table and nothing to merge with: just move it down a level, no rewrite
+        bool trivial_move = c->inputs.size() == 1 && c->overlaps.empty();
+        std::vector<std::shared_ptr<SSTable>> outputs;
+        if (trivial_move) {
+            outputs = c->inputs;
+        } else {
+            ScopedUnlock unlocked(lock);
+            outputs = merge_tables(c.value());
+        }
+
+        std::set<uint64_t> obsolete;
+        for (const auto& table : c->inputs) {
+            obsolete.insert(table->number());
+        }
+        for (const auto& table : c->overlaps) {
+            obsolete.insert(table->number());
+        }
+
+        auto next = std::make_shared<Version>(*version_);
+        auto is_obsolete = [&](const auto& table) { return obsolete.count(table->number()) > 0; };
+        std::erase_if(next->levels[c->level], is_obsolete);
+        auto& output_level = next->levels[c->level + 1];
+        std::erase_if(output_level, is_obsolete);
+        output_level.insert(output_level.end(), outputs.begin(), outputs.end());
+        std::sort(output_level.begin(), output_level.end(), [](const auto& a, const auto& b) {
+            return a->smallest_key() < b->smallest_key();
+        });
+
+        uint64_t next_file_number = next_file_number_;
+        uint64_t log_number = log_number_;
+        {
+            ScopedUnlock unlocked(lock);
+            write_manifest(*next, next_file_number, log_number);
+        }
+        version_ = std::move(next);
+
+        // readers still scanning an old version keep their fds open - unlinking is safe
+        if (!trivial_move) {
+            std::error_code ec;
+            for (const auto& table : c->inputs) {
+                std::filesystem::remove(table->path(), ec);
+            }
+            for (const auto& table : c->overlaps) {
+                std::filesystem::remove(table->path(), ec);
+            }
+        }
+    }
+
+    // ========================================================================
+    // manifest / recovery
+    // ========================================================================
+
+    // [magic][version][next file number u64][log number u64] then per level:
+    // [table count u32][table number u64]...
+    void write_manifest(const Version& version, uint64_t next_file_number,
+                        uint64_t log_number) const {
+        std::string buf;
+        util::append_int<uint32_t>(buf, kManifestMagic);
+        util::append_int<uint32_t>(buf, kManifestVersion);
+        util::append_int<uint64_t>(buf, next_file_number);
+        util::append_int<uint64_t>(buf, log_number);
+        for (const auto& level : version.levels) {
+            util::append_int<uint32_t>(buf, static_cast<uint32_t>(level.size()));
+            for (const auto& table : level) {
+                util::append_int<uint64_t>(buf, table->number());
+            }
+        }
+
+        // same temp + rename dance as snapshots: a crash leaves either the old or the new manifest
+        auto tmp_path = manifest_path_;
+        tmp_path += ".tmp";
+        std::filesystem::remove(tmp_path);
+        int fd = util::open_file(tmp_path);
+        try {
+            util::pwrite_all(fd, buf.data(), buf.size(), 0);
+            util::sync_file(fd);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        std::filesystem::rename(tmp_path, manifest_path_);
+    }
+
+    void load_manifest(Version& version, std::set<uint64_t>& live_tables) {
+        std::ifstream in(manifest_path_, std::ios::binary);
+        uint32_t magic = 0;
+        uint32_t format_version = 0;
+        uint64_t next_file_number = 0;
+        uint64_t log_number = 0;
+        if (!util::read_int<uint32_t>(in, magic) || magic != kManifestMagic ||
+            !util::read_int<uint32_t>(in, format_version) || format_version != kManifestVersion) {
+            throw std::runtime_error("invalid LSM manifest: bad header");
+        }
+        if (!util::read_int<uint64_t>(in, next_file_number) ||
+            !util::read_int<uint64_t>(in, log_number)) {
+            throw std::runtime_error("invalid LSM manifest: truncated");
+        }
+
+        for (auto& level : version.levels) {
+            uint32_t count = 0;
+            if (!util::read_int<uint32_t>(in, count)) {
+                throw std::runtime_error("invalid LSM manifest: truncated");
+            }
+            for (uint32_t i = 0; i < count; ++i) {
+                uint64_t number = 0;
+                if (!util::read_int<uint64_t>(in, number)) {
+                    throw std::runtime_error("invalid LSM manifest: truncated");
+                }
+                level.push_back(SSTable::open(table_path(number), number));
+                live_tables.insert(number);
+            }
+        }
+        next_file_number_ = next_file_number;
+        log_number_ = log_number;
+    }
+
+    /*
+        startup:
+        1. MANIFEST -> which tables make up each level
+        2. delete tables the manifest doesnt know (output of a flush/compaction that crashed before
+       its manifest update) and logs that are already fully in tables
+        3. replay the remaining logs (oldest first) and write the result out as a new L0 table, so
+       every run starts with an empty memtable and a fresh log
+    */
+    void recover() {
+        auto version = std::make_shared<Version>();
+        std::set<uint64_t> live_tables;
+        next_file_number_ = 1;
+        log_number_ = 0;
+        if (std::filesystem::exists(manifest_path_)) {
+            load_manifest(*version, live_tables);
+        }
+
+        uint64_t max_number = 0;
+        std::vector<uint64_t> logs;
+        for (const auto& dir_entry : std::filesystem::directory_iterator(options_.data_dir)) {
+            const auto& path = dir_entry.path();
+            if (auto number = parse_file_number(path, ".sst")) {
+                max_number = std::max(max_number, number.value());
+                if (live_tables.count(number.value()) == 0) {
+                    std::filesystem::remove(path);
+                }
+            } else if (auto log = parse_file_number(path, ".log")) {
+                max_number = std::max(max_number, log.value());
+                if (log.value() >= log_number_) {
+                    logs.push_back(log.value());
+                } else {
+                    std::filesystem::remove(path);
+                }
+            }
+        }
+        next_file_number_ = std::max<uint64_t>(next_file_number_, max_number + 1);
+        std::sort(logs.begin(), logs.end());
+
+        auto recovered = std::make_shared<Memtable>();
+        for (uint64_t number : logs) {
+            WriteAheadLog log(log_path(number));
+            log.replay([&](EntryType type, std::string_view key, std::string_view value,
+                           util::ExpirationTime expires_at_ms) {
+                switch (type) {
+                    case EntryType::Put:
+                        recovered->entries.insert_or_assign(
+                            std::string(key), MemEntry{std::string(value), false, std::nullopt});
+                        break;
+                    case EntryType::PutWithTTL:
+                        recovered->entries.insert_or_assign(
+                            std::string(key), MemEntry{std::string(value), false, expires_at_ms});
+                        break;
+                    case EntryType::Remove:
+                        recovered->entries.insert_or_assign(
+                            std::string(key), MemEntry{std::string(), true, std::nullopt});
+                        break;
+                    case EntryType::Clear:
+                        // clear() never logs - it truncates the log and drops the tables instead
+                        break;
+                }
+            });
+        }
+
+        if (!recovered->entries.empty()) {
+            uint64_t number = next_file_number_++;
+            MemtableIterator it(recovered);
+            version->levels[0].insert(version->levels[0].begin(), write_table(number, it));
+        }
+
+        uint64_t log_number = next_file_number_++;
+        wal_ = std::make_unique<WriteAheadLog>(log_path(log_number));
+        write_manifest(*version, next_file_number_, log_number);
+        for (uint64_t number : logs) {
+            std::filesystem::remove(log_path(number));
+        }
+
+        log_number_ = log_number;
+        mem_ = std::make_shared<Memtable>();
+        mem_->log_number = log_number;
+        version_ = std::move(version);
+        if (!recovered->entries.empty()) {
+            LOG_INFO("LsmStore recovered " + std::to_string(recovered->entries.size()) +
+                     " entries from " + std::to_string(logs.size()) + " log file(s)");
+        }
+    }
+
+    LsmStoreOptions options_;
+    std::shared_ptr<util::Clock> clock_;
+    std::filesystem::path manifest_path_;
+
+    std::mutex write_mutex_;
+    std::unique_ptr<WriteAheadLog> wal_;  // write_mutex_
+
+    mutable std::shared_mutex mutex_;
+    std::shared_ptr<Memtable> mem_;
+    std::shared_ptr<const Memtable> imm_;
+    std::shared_ptr<const Version> version_;
+    std::atomic<uint64_t> next_file_number_{1};
+    uint64_t log_number_ = 0;  // logs below this are fully flushed
+    std::array<std::string, kNumLevels> compact_pointer_;
+
+    std::condition_variable_any bg_cv_;
+    std::thread bg_thread_;
+    bool bg_busy_ = false;
+    bool clearing_ = false;
+    bool stop_ = false;
+    std::optional<std::string> bg_error_;
+};
+
+LsmStore::LsmStore(const LsmStoreOptions& options) : impl_(std::make_unique<Impl>(options)) {}
+LsmStore::~LsmStore() = default;
+LsmStore::LsmStore(LsmStore&&) noexcept = default;
+LsmStore& LsmStore::operator=(LsmStore&&) noexcept = default;
+void LsmStore::put(std::string_view key, std::string_view value) {
+    impl_->put(key, value);
+}
+void LsmStore::put(std::string_view key, std::string_view value, util::Duration ttl) {
+    impl_->put(key, value, ttl);
+}
+std::optional<std::string> LsmStore::get(std::string_view key) {
+    return impl_->get(key);
+}
+bool LsmStore::remove(std::string_view key) {
+    return impl_->remove(key);
+}
+bool LsmStore::contains(std::string_view key) {
+    return impl_->contains(key);
+}
+std::size_t LsmStore::size() const {
+    return impl_->size();
+}
+bool LsmStore::empty() const {
+    return impl_->empty();
+}
+void LsmStore::clear() {
+    impl_->clear();
+}
+void LsmStore::flush() {
+    impl_->flush();
+}
+void LsmStore::compact() {
+    impl_->compact();
+}
+std::vector<std::size_t> LsmStore::files_per_level() const {
+    return impl_->files_per_level();
+}
+
+}  // namespace kvstore::core
@@ -0,0 +1,900 @@
+#include "kvstore/core/mmap_store.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/crc32c.hpp"
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/hash.hpp"
+#include "kvstore/util/logger.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+namespace {
+
+constexpr uint32_t kMagic = 0x4B564D4D;  // "KVMM"
+constexpr uint32_t kVersion = 1;
+
+// file: [meta 0][meta 1][state page][table: capacity x 16 byte slots][heap: records...]
+// the meta pages are written alternately at checkpoints, the newer valid one wins (like
+// BTreeStore). the state page holds the dirty flag, set before the first change after a
+// checkpoint and cleared once the next one committed - a single word, so it cant tear
+constexpr uint64_t kPageSize = 4096;
+constexpr uint64_t kStateOffset = 2 * kPageSize;
+constexpr uint64_t kTableOffset = 3 * kPageSize;
+constexpr std::size_t kMinCapacity = kPageSize / 16;  // the table fills whole pages
+
+// [magic u32][version u32][txn u64][capacity u64][committed end u64][count u64]
+// [used slots u64][garbage u64][checksum u64 - hash of everything before it]
+constexpr std::size_t kMetaSize = 4 + 4 + 8 * 7;
+
+// record: [crc u32][flags u32][key len u32][value len u32][expires_at i64][key][value], padded to
+// 8 bytes. crc = CRC-32C of the record's own file offset + everything after the crc, so a slot
+// can only ever validate against the record it was written for
+constexpr uint64_t kRecordHeader = 24;
+constexpr uint32_t kFlagTombstone = 0x01;
+constexpr uint32_t kFlagExpiration = 0x02;
+
+// slot word: [tag 15 bits][tombstone 1 bit][record offset 48 bits]. 0 = empty slot. a slot
+// recovery found nothing durable for stays taken (probe chains run through it) as kDeadWord
+constexpr uint64_t kOffsetMask = (uint64_t{1} << 48) - 1;
+constexpr uint64_t kTombstoneBit = uint64_t{1} << 48;
+constexpr int kTagShift = 49;
+constexpr uint64_t kDeadWord = kTombstoneBit;
+
+// the file grows in steps of at least this, and is always a multiple of it (mmap offsets must be
+// page aligned, whatever the page size)
+constexpr uint64_t kGrowthAlign = 64 * 1024;
+constexpr uint64_t kMinGrowth = 1024 * 1024;
+// address space reserved up front so growth maps the new tail in place: readers never see the
+// mapping move. past the reservation the mapping is rebuilt under the exclusive lock
+constexpr uint64_t kMinReserve = uint64_t{1} << 30;
+// below this much heap garbage is never worth a rewrite
+constexpr uint64_t kMinCompactBytes = 4 * 1024 * 1024;
+
+struct Slot {
+    uint64_t cur;   // newest record
+    uint64_t prev;  // newest record a sync covered - what a crash falls back to. 0 = none
+};
+static_assert(sizeof(Slot) == 16);
+
+[[nodiscard]] uint64_t round_up(uint64_t value, uint64_t align) {
+    return (value + align - 1) / align * align;
+}
+
+[[nodiscard]] uint64_t word_offset(uint64_t word) {
+    return word & kOffsetMask;
+}
+
+[[nodiscard]] bool word_live(uint64_t word) {
+    return word != 0 && (word & kTombstoneBit) == 0;
+}
+
+[[nodiscard]] uint64_t tag_of(uint64_t hash) {
+    return hash >> kTagShift;
+}
+
+[[nodiscard]] uint64_t make_word(uint64_t offset, bool tombstone, uint64_t tag) {
+    return (tag << kTagShift) | (tombstone ? kTombstoneBit : 0) | offset;
+}
+
+[[nodiscard]] uint64_t record_bytes(std::size_t key_size, std::size_t value_size) {
+    return round_up(kRecordHeader + key_size + value_size, 8);
+}
+
+[[nodiscard]] uint64_t table_bytes(std::size_t capacity) {
+    return capacity * sizeof(Slot);
+}
+
+// slots are read while a writer updates them - every access is atomic
+[[nodiscard]] uint64_t load_word(uint64_t& word) {
+    return std::atomic_ref<uint64_t>(word).load(std::memory_order_acquire);
+}
+
+void store_word(uint64_t& word, uint64_t value) {
+    std::atomic_ref<uint64_t>(word).store(value, std::memory_order_release);
+}
+
+// a record in the mapping
+struct RecordView {
+    const char* data;
+
+    [[nodiscard]] uint32_t flags() const {
+        return util::load_int<uint32_t>(data + 4);
+    }
+    [[nodiscard]] uint32_t key_size() const {
+        return util::load_int<uint32_t>(data + 8);
+    }
+    [[nodiscard]] uint32_t value_size() const {
+        return util::load_int<uint32_t>(data + 12);
+    }
+    [[nodiscard]] util::ExpirationTime expires_at_ms() const {
+        if ((flags() & kFlagExpiration) == 0) {
+            return std::nullopt;
+        }
+        return util::load_int<int64_t>(data + 16);
+    }
+    [[nodiscard]] std::string_view key() const {
+        return {data + kRecordHeader, key_size()};
+    }
+    [[nodiscard]] std::string_view value() const {
+        return {data + kRecordHeader + key_size(), value_size()};
+    }
+    [[nodiscard]] uint64_t bytes() const {
+        return record_bytes(key_size(), value_size());
+    }
+};
+
+[[nodiscard]] uint32_t record_crc(uint64_t offset, const char* record, uint64_t unpadded_size) {
+    char offset_bytes[8];
+    util::store_int<uint64_t>(offset_bytes, offset);
+    uint32_t crc = util::crc32c(std::string_view(offset_bytes, sizeof(offset_bytes)));
+    return util::crc32c_extend(crc, std::string_view(record + 4, unpadded_size - 4));
+}
+
+// fills a record at dst (file offset `offset`), returns its size
+uint64_t write_record(char* dst, uint64_t offset, uint32_t flags, std::string_view key,
+                      std::string_view value, util::ExpirationTime expires_at_ms) {
+    if (expires_at_ms.has_value()) {
+        flags |= kFlagExpiration;
+    }
+    util::store_int<uint32_t>(dst + 4, flags);
+    util::store_int<uint32_t>(dst + 8, static_cast<uint32_t>(key.size()));
+    util::store_int<uint32_t>(dst + 12, static_cast<uint32_t>(value.size()));
+    util::store_int<int64_t>(dst + 16, expires_at_ms.value_or(0));
+    std::memcpy(dst + kRecordHeader, key.data(), key.size());
+    std::memcpy(dst + kRecordHeader + key.size(), value.data(), value.size());
+    util::store_int<uint32_t>(dst,
+                              record_crc(offset, dst, kRecordHeader + key.size() + value.size()));
+    return record_bytes(key.size(), value.size());
+}
+
+[[nodiscard]] long system_page_size() {
+    static const long page_size = ::sysconf(_SC_PAGESIZE);
+    return page_size;
+}
+
+// msync [offset, offset + len) of a mapping, widened to whole pages
+void sync_mapping(char* base, uint64_t offset, uint64_t len) {
+    auto page = static_cast<uint64_t>(system_page_size());
+    uint64_t begin = offset / page * page;
+    if (::msync(base + begin, offset + len - begin, MS_SYNC) != 0) {
+        throw std::runtime_error("msync failed: " + std::string(strerror(errno)));
+    }
+}
+
+// map [0, size) of fd at the start of a fresh reservation of `reserve` bytes
+char* map_file(int fd, uint64_t size, uint64_t reserve) {
+    void* base = ::mmap(nullptr, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                        -1, 0);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("failed to reserve address space: " +
+                                 std::string(strerror(errno)));
+    }
+    if (::mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int error = errno;
+        ::munmap(base, reserve);
+        throw std::runtime_error("failed to map file: " + std::string(strerror(error)));
+    }
+    return static_cast<char*>(base);
+}
+
+void resize_file(int fd, uint64_t size) {
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        throw std::runtime_error("failed to resize mmap store file: " +
+                                 std::string(strerror(errno)));
+    }
+}
+
+}  // namespace
+
+/*
+    note on concurrency:
+    - write_mutex_ serializes writers, and everything that rewrites or remaps the file
+    - readers hold mutex_ shared. only a swap to a new file or mapping takes it exclusively, so
+   reads run concurrently with writes: they load slot words with acquire, a writer fills the
+   record before it publishes it with a release store
+*/
+class MmapStore::Impl {
+   public:
+    explicit Impl(const MmapStoreOptions& options)
+        : options_(options), clock_(options.clock) {
+        if (options_.max_load_factor <= 0 || options_.max_load_factor >= 1) {
+            throw std::invalid_argument("mmap store max_load_factor must be in (0, 1)");
+        }
+        std::filesystem::create_directories(options_.data_dir);
+        path_ = options_.data_dir / "mmap.kvm";
+
+        if (!std::filesystem::exists(path_) || std::filesystem::file_size(path_) == 0) {
+            build_file(initial_capacity(), false);
+            std::filesystem::rename(temp_path(), path_);
+            util::sync_directory(options_.data_dir);
+        }
+        open_file();
+        try {
+            bool both_valid = load_meta();
+            if (!both_valid || util::load_int<uint64_t>(base_ + kStateOffset) != 0) {
+                recover();
+            }
+        } catch (...) {
+            close_file();
+            throw;
+        }
+        last_sync_ = std::chrono::steady_clock::now();
+        if (options_.sync_mode == SyncMode::Batch && options_.sync_interval.count() > 0) {
+            sync_thread_ = std::thread([this] { sync_loop(); });
+        }
+    }
+
+    // clean shutdown: checkpoint, so the next open has nothing to check
+    ~Impl() {
+        stop_sync();
+        try {
+            std::lock_guard write_lock(write_mutex_);
+            checkpoint();
+        } catch (const std::exception& e) {
+            LOG_WARN("MmapStore close: " + std::string(e.what()));
+        }
+        close_file();
+    }
+
+    void put(std::string_view key, std::string_view value) {
+        check_sizes(key, value);
+        std::lock_guard write_lock(write_mutex_);
+        write(key, value, 0, std::nullopt);
+    }
+
+    void put(std::string_view key, std::string_view value, util::Duration ttl) {
+        check_sizes(key, value);
+        std::lock_guard write_lock(write_mutex_);
+        write(key, value, 0, util::to_epoch_ms(clock_->now() + ttl));
+    }
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) {
+        {
+            std::shared_lock lock(mutex_);
+            auto [slot, word] = find(key, util::hash64(key));
+            if (!word_live(word)) {
+                return std::nullopt;
+            }
+            RecordView record = record_at(word);
+            if (!is_expired(record.expires_at_ms())) {
+                return std::string(record.value());
+            }
+        }
+        expire(key);
+        return std::nullopt;
+    }
+
+    [[nodiscard]] bool remove(std::string_view key) {
+        std::lock_guard write_lock(write_mutex_);
+        auto [slot, word] = find(key, util::hash64(key));
+        if (!word_live(word)) {
+            return false;
+        }
+        write(key, {}, kFlagTombstone, std::nullopt);
+        return true;
+    }
+
+    [[nodiscard]] bool contains(std::string_view key) {
+        {
+            std::shared_lock lock(mutex_);
+            auto [slot, word] = find(key, util::hash64(key));
+            if (!word_live(word)) {
+                return false;
+            }
+            if (!is_expired(record_at(word).expires_at_ms())) {
+                return true;
+            }
+        }
+        expire(key);
+        return false;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return count_.load();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return count_.load() == 0;
+    }
+
+    void clear() {
+        std::lock_guard write_lock(write_mutex_);
+        rewrite(initial_capacity(), false);
+    }
+
+    void flush() {
+        std::lock_guard write_lock(write_mutex_);
+        checkpoint();
+    }
+
+    void compact() {
+        std::lock_guard write_lock(write_mutex_);
+        rewrite(capacity_for(count_.load()), true);
+    }
+
+    [[nodiscard]] bool pending_sync() const {
+        std::lock_guard write_lock(write_mutex_);
+        return dirty_;
+    }
+
+    [[nodiscard]] std::size_t capacity() const {
+        std::shared_lock lock(mutex_);
+        return capacity_;
+    }
+
+    [[nodiscard]] uint64_t file_size() const {
+        std::lock_guard write_lock(write_mutex_);
+        return mapped_;
+    }
+
+   private:
+    // ========================================================================
+    // table
+    // ========================================================================
+
+    [[nodiscard]] Slot& slot(std::size_t index) const {
+        return reinterpret_cast<Slot*>(base_ + kTableOffset)[index];
+    }
+
+    [[nodiscard]] RecordView record_at(uint64_t word) const {
+        return RecordView{base_ + word_offset(word)};
+    }
+
+    // the key's slot and its current word, or the empty slot that ends its probe chain and 0
+    [[nodiscard]] std::pair<std::size_t, uint64_t> find(std::string_view key,
+                                                        uint64_t hash) const {
+        uint64_t tag = tag_of(hash);
+        std::size_t mask = capacity_ - 1;
+        for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+            uint64_t word = load_word(slot(i).cur);
+            if (word == 0) {
+                return {i, 0};
+            }
+            if (tag_of(word) == tag && word_offset(word) != 0 && record_at(word).key() == key) {
+                return {i, word};
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t initial_capacity() const {
+        return std::bit_ceil(std::max(options_.initial_capacity, kMinCapacity));
+    }
+
+    // a table that holds count keys at half the max load factor - room to grow before the next
+    // rewrite
+    [[nodiscard]] std::size_t capacity_for(std::size_t count) const {
+        std::size_t capacity = initial_capacity();
+        while (static_cast<double>(count) > static_cast<double>(capacity) *
+                                                 options_.max_load_factor / 2) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    static void check_sizes(std::string_view key, std::string_view value) {
+        if (key.size() > std::numeric_limits<uint32_t>::max() ||
+            value.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::invalid_argument("key or value too large for the mmap store");
+        }
+    }
+
+    [[nodiscard]] bool is_expired(util::ExpirationTime expires_at_ms) const {
+        return expires_at_ms.has_value() &&
+               clock_->now() >= util::from_epoch_ms(expires_at_ms.value());
+    }
+
+    // ========================================================================
+    // write path - write_mutex_ held
+    // ========================================================================
+
+    void write(std::string_view key, std::string_view value, uint32_t flags,
+               util::ExpirationTime expires_at_ms) {
+        uint64_t hash = util::hash64(key);
+        uint64_t size = record_bytes(key.size(), value.size());
+        if (static_cast<double>(used_slots_ + 1) >
+            static_cast<double>(capacity_) * options_.max_load_factor) {
+            rewrite(capacity_for(count_.load() + 1), true);
+        }
+        reserve_heap(heap_end_ + size);
+        mark_dirty();
+
+        uint64_t offset = heap_end_;
+        (void)write_record(base_ + offset, offset, flags, key, value, expires_at_ms);
+        heap_end_ += size;
+        bool always = options_.sync_mode == SyncMode::Always;
+        if (always) {
+            sync_mapping(base_, offset, size);
+            durable_end_ = heap_end_;
+        }
+
+        bool tombstone = (flags & kFlagTombstone) != 0;
+        auto [index, old] = find(key, hash);
+        Slot& target = slot(index);
+        if (old == 0) {
+            ++used_slots_;
+            std::atomic_ref<uint64_t>(target.prev).store(0, std::memory_order_relaxed);
+        } else {
+            // the record the slot falls back to after a crash must have been synced
+            uint64_t prev = word_offset(old) < durable_end_ ? old : target.prev;
+            std::atomic_ref<uint64_t>(target.prev).store(prev, std::memory_order_relaxed);
+            if (word_live(old)) {
+                garbage_ += record_at(old).bytes();  // a tombstone was counted when written
+            }
+        }
+        store_word(target.cur, make_word(offset, tombstone, tag_of(hash)));
+        if (tombstone) {
+            garbage_ += size;  // only there to shadow the old value until the next rewrite
+        }
+        if (word_live(old) && tombstone) {
+            --count_;
+        } else if (!word_live(old) && !tombstone) {
+            ++count_;
+        }
+        if (always) {
+            sync_mapping(base_, kTableOffset + index * sizeof(Slot), sizeof(Slot));
+        }
+
+        maybe_checkpoint();
+        uint64_t heap_size = heap_end_ - heap_start_;
+        if (heap_size > kMinCompactBytes &&
+            static_cast<double>(garbage_) >
+                static_cast<double>(heap_size) * options_.max_garbage_ratio) {
+            rewrite(capacity_for(count_.load()), true);
+        }
+    }
+
+    void expire(std::string_view key) {
+        std::lock_guard write_lock(write_mutex_);
+        auto [slot, word] = find(key, util::hash64(key));
+        if (word_live(word) && is_expired(record_at(word).expires_at_ms())) {
+            write(key, {}, kFlagTombstone, std::nullopt);
+        }
+    }
+
+    // make sure the mapping covers [0, end)
+    void reserve_heap(uint64_t end) {
+        if (end <= mapped_) {
+            return;
+        }
+        uint64_t size = round_up(std::max(end, mapped_ + std::max(mapped_ / 4, kMinGrowth)),
+                                 kGrowthAlign);
+        resize_file(fd_, size);
+        if (size <= reserved_) {
+            // readers never look past heap_end_, so the new tail can be mapped under them
+            if (::mmap(base_ + mapped_, size - mapped_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_FIXED, fd_, static_cast<off_t>(mapped_)) == MAP_FAILED) {
+                throw std::runtime_error("failed to extend mapping: " +
+                                         std::string(strerror(errno)));
+            }
+            mapped_ = size;
+            return;
+        }
+        std::unique_lock lock(mutex_);
+        uint64_t reserve = std::max(kMinReserve, round_up(size * 2, kGrowthAlign));
+        char* base = map_file(fd_, size, reserve);
+        ::munmap(base_, reserved_);
+        base_ = base;
+        mapped_ = size;
+        reserved_ = reserve;
+    }
+
+    // ========================================================================
+    // durability
+    // ========================================================================
+
+    void mark_dirty() {
+        if (dirty_) {
+            return;
+        }
+        util::store_int<uint64_t>(base_ + kStateOffset, 1);
+        sync_mapping(base_, kStateOffset, 8);
+        dirty_ = true;
+    }
+
+    /*
+        SyncMode::Batch: writes checkpoint once the last one is sync_interval old, so a burst
+       followed by an idle stretch would stay uncommitted until the next write. this wakes up when
+       the oldest uncommitted change is due - the lag stays within one interval
+    */
+    void sync_loop() {
+        std::unique_lock lock(sync_wait_mutex_);
+        auto due = std::chrono::steady_clock::now() + options_.sync_interval;
+        while (!sync_cv_.wait_until(lock, due, [this] { return stopping_; })) {
+            lock.unlock();
+            try {
+                std::lock_guard write_lock(write_mutex_);
+                auto now = std::chrono::steady_clock::now();
+                if (dirty_ && now - last_sync_ >= options_.sync_interval) {
+                    checkpoint();
+                }
+                due = (dirty_ ? last_sync_ : now) + options_.sync_interval;
+            } catch (const std::exception& e) {
+                LOG_WARN("MmapStore checkpoint: " + std::string(e.what()));
+                due = std::chrono::steady_clock::now() + options_.sync_interval;
+            }
+            lock.lock();
+        }
+    }
+
+    void stop_sync() {
+        {
+            std::lock_guard lock(sync_wait_mutex_);
+            stopping_ = true;
+        }
+        sync_cv_.notify_all();
+        if (sync_thread_.joinable()) {
+            sync_thread_.join();
+        }
+    }
+
+    void maybe_checkpoint() {
+        if (options_.sync_mode == SyncMode::Os) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sync_ >= options_.sync_interval) {
+            checkpoint();
+        }
+    }
+
+    /*
+        1. sync every dirty page - records and table
+        2. write the meta page the current meta is NOT in, sync it. this is the commit point: a
+       torn meta fails its checksum and the older one is used (with the dirty flag still set)
+        3. clear the dirty flag
+    */
+    void checkpoint() {
+        last_sync_ = std::chrono::steady_clock::now();
+        if (!dirty_) {
+            return;
+        }
+        util::sync_file(fd_);
+        ++txn_;
+        write_meta(base_, txn_, capacity_, heap_end_, count_.load(), used_slots_, garbage_);
+        sync_mapping(base_, (txn_ % 2) * kPageSize, kMetaSize);
+        util::store_int<uint64_t>(base_ + kStateOffset, 0);
+        sync_mapping(base_, kStateOffset, 8);
+        dirty_ = false;
+        durable_end_ = heap_end_;
+        committed_end_ = heap_end_;
+    }
+
+    static void write_meta(char* base, uint64_t txn, uint64_t capacity, uint64_t committed_end,
+                           uint64_t count, uint64_t used_slots, uint64_t garbage) {
+        std::string buf;
+        util::append_int<uint32_t>(buf, kMagic);
+        util::append_int<uint32_t>(buf, kVersion);
+        util::append_int<uint64_t>(buf, txn);
+        util::append_int<uint64_t>(buf, capacity);
+        util::append_int<uint64_t>(buf, committed_end);
+        util::append_int<uint64_t>(buf, count);
+        util::append_int<uint64_t>(buf, used_slots);
+        util::append_int<uint64_t>(buf, garbage);
+        util::append_int<uint64_t>(buf, util::hash64(buf));
+        std::memcpy(base + (txn % 2) * kPageSize, buf.data(), buf.size());
+    }
+
+    // loads the newer valid meta page. false if the other one is damaged: the file may then be
+    // ahead of the meta that was loaded, so it needs the same check as after a crash
+    [[nodiscard]] bool load_meta() {
+        bool found = false;
+        int valid = 0;
+        for (uint64_t page = 0; page < 2; ++page) {
+            const char* p = base_ + page * kPageSize;
+            if (util::load_int<uint32_t>(p) != kMagic ||
+                util::load_int<uint32_t>(p + 4) != kVersion ||
+                util::load_int<uint64_t>(p + kMetaSize - 8) !=
+                    util::hash64(std::string_view(p, kMetaSize - 8))) {
+                continue;
+            }
+            ++valid;
+            uint64_t txn = util::load_int<uint64_t>(p + 8);
+            if (found && txn <= txn_) {
+                continue;
+            }
+            found = true;
+            txn_ = txn;
+            capacity_ = util::load_int<uint64_t>(p + 16);
+            committed_end_ = util::load_int<uint64_t>(p + 24);
+            count_ = util::load_int<uint64_t>(p + 32);
+            used_slots_ = util::load_int<uint64_t>(p + 40);
+            garbage_ = util::load_int<uint64_t>(p + 48);
+        }
+        if (!found) {
+            throw std::runtime_error("invalid mmap store file: no valid meta page");
+        }
+        heap_start_ = kTableOffset + table_bytes(capacity_);
+        if (capacity_ < kMinCapacity || !std::has_single_bit(capacity_) ||
+            committed_end_ < heap_start_ || committed_end_ > mapped_) {
+            throw std::runtime_error("invalid mmap store file: meta page doesnt fit the file");
+        }
+        heap_end_ = committed_end_;
+        durable_end_ = committed_end_;
+        return valid == 2;
+    }
+
+    // ========================================================================
+    // crash recovery
+    // ========================================================================
+
+    // an intact record for this slot word: in the file, right key hash and kind, checksum ok
+    [[nodiscard]] bool valid_record(uint64_t word) const {
+        uint64_t offset = word_offset(word);
+        if (offset < heap_start_ || offset % 8 != 0 || offset + kRecordHeader > mapped_) {
+            return false;
+        }
+        RecordView record{base_ + offset};
+        uint64_t unpadded = kRecordHeader + record.key_size() + record.value_size();
+        if (unpadded > mapped_ - offset) {
+            return false;
+        }
+        return util::load_int<uint32_t>(record.data) ==
+                   record_crc(offset, record.data, unpadded) &&
+               ((record.flags() & kFlagTombstone) != 0) == ((word & kTombstoneBit) != 0) &&
+               tag_of(util::hash64(record.key())) == tag_of(word);
+    }
+
+    /*
+        the dirty flag was set (the process died between two checkpoints) or a meta page is
+       damaged. pages of the table may have reached the disk before the records they point to.
+       every slot pointing past the last commit gets its record checked - a torn one is replaced
+       by the slot's durable version. the counts are recounted from the table, the heap continues
+       after the last intact record
+    */
+    void recover() {
+        LOG_WARN("MmapStore: " + path_.string() +
+                 " was not closed cleanly, checking the writes since the last checkpoint");
+        uint64_t end = committed_end_;
+        std::size_t count = 0;
+        std::size_t used = 0;
+        std::size_t repaired = 0;
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            Slot& s = slot(i);
+            if (s.cur == 0) {
+                continue;
+            }
+            if (word_offset(s.cur) >= committed_end_) {
+                uint64_t word = s.cur;
+                if (!valid_record(word)) {
+                    ++repaired;
+                    word = s.prev != 0 && (word_offset(s.prev) < committed_end_ ||
+                                           valid_record(s.prev))
+                               ? s.prev
+                               : kDeadWord;
+                }
+                // the checkpoint below makes it durable
+                s.cur = word;
+                s.prev = word == kDeadWord ? 0 : word;
+                if (word_offset(word) != 0) {
+                    end = std::max(end, word_offset(word) + record_at(word).bytes());
+                }
+            }
+            ++used;
+            if (word_live(s.cur)) {
+                ++count;
+            }
+        }
+        if (repaired > 0) {
+            LOG_WARN("MmapStore: " + std::to_string(repaired) +
+                     " torn writes rolled back to their last synced version");
+        }
+        count_ = count;
+        used_slots_ = used;
+        heap_end_ = end;
+        dirty_ = true;
+        checkpoint();
+    }
+
+    // ========================================================================
+    // rewrite
+    // ========================================================================
+
+    [[nodiscard]] std::filesystem::path temp_path() const {
+        return path_.string() + ".tmp";
+    }
+
+    // a complete file at temp_path(): a capacity slot table holding the live entries of the
+    // current one (none if !keep_entries), synced and committed
+    void build_file(std::size_t capacity, bool keep_entries) {
+        std::vector<uint64_t> live;
+        uint64_t heap_bytes = 0;
+        if (keep_entries) {
+            for (std::size_t i = 0; i < capacity_; ++i) {
+                uint64_t word = slot(i).cur;
+                if (word_live(word) && !is_expired(record_at(word).expires_at_ms())) {
+                    live.push_back(word);
+                    heap_bytes += record_at(word).bytes();
+                }
+            }
+        }
+
+        uint64_t heap_start = kTableOffset + table_bytes(capacity);
+        uint64_t size = round_up(heap_start + heap_bytes + std::max(heap_bytes / 4, kMinGrowth),
+                                 kGrowthAlign);
+        int fd = ::open(temp_path().c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("failed to create " + temp_path().string());
+        }
+        char* base = nullptr;
+        try {
+            resize_file(fd, size);
+            void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error("failed to map " + temp_path().string());
+            }
+            base = static_cast<char*>(mapped);
+
+            auto* table = reinterpret_cast<Slot*>(base + kTableOffset);
+            std::size_t mask = capacity - 1;
+            uint64_t offset = heap_start;
+            for (uint64_t word : live) {
+                RecordView record = record_at(word);
+                uint64_t hash = util::hash64(record.key());
+                uint64_t bytes = write_record(base + offset, offset,
+                                              record.flags() & ~kFlagExpiration, record.key(),
+                                              record.value(), record.expires_at_ms());
+                std::size_t i = hash & mask;
+                while (table[i].cur != 0) {
+                    i = (i + 1) & mask;
+                }
+                table[i].cur = make_word(offset, false, tag_of(hash));
+                table[i].prev = table[i].cur;
+                offset += bytes;
+            }
+            // both meta pages, so a damaged one always means a torn checkpoint
+            write_meta(base, txn_ + 1, capacity, offset, live.size(), live.size(), 0);
+            write_meta(base, txn_ + 2, capacity, offset, live.size(), live.size(), 0);
+            util::sync_file(fd);
+            ::munmap(base, size);
+            ::close(fd);
+        } catch (...) {
+            if (base != nullptr) {
+                ::munmap(base, size);
+            }
+            ::close(fd);
+            std::filesystem::remove(temp_path());
+            throw;
+        }
+    }
+
+    // replace the file with a fresh one of the given capacity. readers keep using the old
+    // mapping while the new file is built and only wait for the swap
+    void rewrite(std::size_t capacity, bool keep_entries) {
+        build_file(capacity, keep_entries);
+
+        std::unique_lock lock(mutex_);
+        std::filesystem::rename(temp_path(), path_);
+        util::sync_directory(options_.data_dir);
+        close_file();
+        open_file();
+        (void)load_meta();
+        dirty_ = false;
+        last_sync_ = std::chrono::steady_clock::now();
+    }
+
+    void open_file() {
+        fd_ = util::open_file(path_);
+        mapped_ = util::file_size(fd_);
+        if (mapped_ < kTableOffset || mapped_ % kGrowthAlign != 0) {
+            ::close(fd_);
+            fd_ = -1;
+            throw std::runtime_error("invalid mmap store file: " + path_.string());
+        }
+        reserved_ = std::max(kMinReserve, round_up(mapped_ * 2, kGrowthAlign));
+        try {
+            base_ = map_file(fd_, mapped_, reserved_);
+        } catch (...) {
+            ::close(fd_);
+            fd_ = -1;
+            throw;
+        }
+    }
+
+    void close_file() {
+        if (base_ != nullptr) {
+            ::munmap(base_, reserved_);
+            base_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    MmapStoreOptions options_;
+    std::shared_ptr<util::Clock> clock_;
+    std::filesystem::path path_;
+
+    mutable std::shared_mutex mutex_;
+    mutable std::mutex write_mutex_;
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    uint64_t mapped_ = 0;    // file size, all of it mapped
+    uint64_t reserved_ = 0;  // address space behind base_
+
+    std::size_t capacity_ = 0;  // slots, a power of two
+    uint64_t heap_start_ = 0;
+    uint64_t heap_end_ = 0;       // next record goes here. write_mutex_
+    uint64_t durable_end_ = 0;    // records before this were synced. write_mutex_
+    uint64_t committed_end_ = 0;  // heap end of the newest meta. write_mutex_
+    std::atomic<std::size_t> count_{0};
+    std::size_t used_slots_ = 0;  // live + tombstoned + dead. write_mutex_
+    uint64_t garbage_ = 0;        // heap bytes no slot needs. write_mutex_
+    uint64_t txn_ = 0;
+    bool dirty_ = false;  // the state page says dirty. write_mutex_
+    std::chrono::steady_clock::time_point last_sync_;  // write_mutex_
+
+    std::mutex sync_wait_mutex_;
+    std::condition_variable sync_cv_;
+    bool stopping_ = false;  // sync_wait_mutex_
+    std::thread sync_thread_;  // SyncMode::Batch
+};
+
+// PIMPL INTERFACE ---------------------------------------------------------------------------
+
+MmapStore::MmapStore(const MmapStoreOptions& options) : impl_(std::make_unique<Impl>(options)) {}
+MmapStore::~MmapStore() = default;
+MmapStore::MmapStore(MmapStore&&) noexcept = default;
+MmapStore& MmapStore::operator=(MmapStore&&) noexcept = default;
+
+void MmapStore::put(std::string_view key, std::string_view value) {
+    impl_->put(key, value);
+}
+void MmapStore::put(std::string_view key, std::string_view value, util::Duration ttl) {
+    impl_->put(key, value, ttl);
+}
+std::optional<std::string> MmapStore::get(std::string_view key) {
+    return impl_->get(key);
+}
+bool MmapStore::remove(std::string_view key) {
+    return impl_->remove(key);
+}
+bool MmapStore::contains(std::string_view key) {
+    return impl_->contains(key);
+}
+std::size_t MmapStore::size() const {
+    return impl_->size();
+}
+bool MmapStore::empty() const {
+    return impl_->empty();
+}
+void MmapStore::clear() {
+    impl_->clear();
+}
+void MmapStore::flush() {
+    impl_->flush();
+}
+void MmapStore::compact() {
+    impl_->compact();
+}
+bool MmapStore::pending_sync() const {
+    return impl_->pending_sync();
+}
+std::size_t MmapStore::capacity() const {
+    return impl_->capacity();
+}
+uint64_t MmapStore::file_size() const {
+    return impl_->file_size();
+}
+
+}  // namespace kvstore::core
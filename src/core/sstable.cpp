@@ -0,0 +1,446 @@
+#include "kvstore/core/sstable.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "kvstore/util/binary_io.hpp"
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/hash.hpp"
+
+namespace kvstore::core {
+
+namespace util = kvstore::util;
+
+namespace {
+
+constexpr uint32_t kMagic = 0x4B565354;  // "KVST"
+constexpr uint32_t kVersion = 1;
+
+// 6 block offsets/sizes + entry count (u64 each), magic + version (u32 each)
+constexpr std::size_t kFooterSize = 7 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+constexpr uint8_t kFlagTombstone = 0x01;
+constexpr uint8_t kFlagHasExpiry = 0x02;
+
+void encode_entry(std::string& buf, const TableEntry& entry) {
+    uint8_t flags = 0;
+    if (entry.tombstone) {
+        flags |= kFlagTombstone;
+    }
+    if (entry.expires_at_ms.has_value()) {
+        flags |= kFlagHasExpiry;
+    }
+    util::append_int<uint8_t>(buf, flags);
+    util::append_string(buf, entry.key);
+    util::append_string(buf, entry.value);
+    if (entry.expires_at_ms.has_value()) {
+        util::append_int<int64_t>(buf, entry.expires_at_ms.value());
+    }
+}
+
+// bounds-checked cursor over an in-memory block. any overrun means the file is corrupt
+class BlockReader {
+   public:
+    explicit BlockReader(std::string_view data) : data_(data) {}
+
+    [[nodiscard]] bool done() const {
+        return pos_ >= data_.size();
+    }
+
+    template <typename T>
+    T read_int() {
+        need(sizeof(T));
+        T value = util::load_int<T>(data_.data() + pos_);
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    std::string read_string() {
+        auto len = read_int<uint32_t>();
+        need(len);
+        std::string s(data_.substr(pos_, len));
+        pos_ += len;
+        return s;
+    }
+
+    void read_entry(TableEntry& entry) {
+        auto flags = read_int<uint8_t>();
+        entry.key = read_string();
+        entry.value = read_string();
+        entry.tombstone = (flags & kFlagTombstone) != 0;
+        entry.expires_at_ms = std::nullopt;
+        if ((flags & kFlagHasExpiry) != 0) {
+            entry.expires_at_ms = read_int<int64_t>();
+        }
+    }
+
+   private:
+    void need(std::size_t n) const {
+        if (n > data_.size() - pos_) {
+            throw std::runtime_error("corrupt sstable block");
+        }
+    }
+
+    std::string_view data_;
+    std::size_t pos_ = 0;
+};
+
+}  // namespace
+
+// ============================================================================
+// SSTableWriter
+// ============================================================================
+
+SSTableWriter::SSTableWriter(const std::filesystem::path& path, std::size_t block_size,
+                             std::size_t bloom_bits_per_key)
+    : path_(path), block_size_(block_size), bloom_bits_per_key_(bloom_bits_per_key) {
+    // a leftover from a crashed flush may sit under the same name - start from scratch
+    std::filesystem::remove(path_);
+    fd_ = util::open_file(path_);
+    block_.reserve(block_size_ + 1024);
+}
+
+SSTableWriter::~SSTableWriter() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    if (!finished_) {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+}
+
+void SSTableWriter::add(const TableEntry& entry) {
+    if (entry_count_ > 0 && entry.key <= last_key_) {
+        throw std::logic_error("sstable keys must be added in strictly increasing order");
+    }
+    if (entry_count_ == 0) {
+        smallest_key_ = entry.key;
+    }
+    encode_entry(block_, entry);
+    key_hashes_.push_back(util::hash64(entry.key));
+    last_key_ = entry.key;
+    ++entry_count_;
+
+    if (block_.size() >= block_size_) {
+        flush_block();
+    }
+}
+
+void SSTableWriter::flush_block() {
+    if (block_.empty()) {
+        return;
+    }
+    util::pwrite_all(fd_, block_.data(), block_.size(), offset_);
+    util::append_string(index_, last_key_);
+    util::append_int<uint64_t>(index_, offset_);
+    util::append_int<uint32_t>(index_, static_cast<uint32_t>(block_.size()));
+    offset_ += block_.size();
+    block_.clear();
+}
+
+uint64_t SSTableWriter::finish() {
+    flush_block();
+
+    // index, bloom and properties go out in one write together with the footer
+    std::string tail;
+    uint64_t index_offset = offset_;
+    tail += index_;
+    uint64_t bloom_offset = offset_ + tail.size();
+    tail += BloomFilter::build(key_hashes_, bloom_bits_per_key_);
+    uint64_t props_offset = offset_ + tail.size();
+    util::append_string(tail, smallest_key_);
+    util::append_string(tail, last_key_);
+    uint64_t footer_offset = offset_ + tail.size();
+
+    util::append_int<uint64_t>(tail, index_offset);
+    util::append_int<uint64_t>(tail, bloom_offset - index_offset);
+    util::append_int<uint64_t>(tail, bloom_offset);
+    util::append_int<uint64_t>(tail, props_offset - bloom_offset);
+    util::append_int<uint64_t>(tail, props_offset);
+    util::append_int<uint64_t>(tail, footer_offset - props_offset);
+    util::append_int<uint64_t>(tail, entry_count_);
+    util::append_int<uint32_t>(tail, kMagic);
+    util::append_int<uint32_t>(tail, kVersion);
+
+    util::pwrite_all(fd_, tail.data(), tail.size(), offset_);
+    offset_ += tail.size();
+
+    // the table is referenced by the manifest right after this - it has to be durable first
+    util::sync_file(fd_);
+    ::close(fd_);
+    fd_ = -1;
+    finished_ = true;
+    return offset_;
+}
+
+uint64_t SSTableWriter::estimated_size() const {
+    return offset_ + block_.size() + index_.size() + key_hashes_.size() * bloom_bits_per_key_ / 8;
+}
+
+std::size_t SSTableWriter::entry_count() const {
+    return entry_count_;
+}
+
+// ============================================================================
+// SSTable
+// ============================================================================
+
+/*
+    note: the iterator holds a shared_ptr to its table. compaction unlinks obsolete files while a
+   scan may still be walking them - the open fd keeps the data readable until the last reader is
+   done (POSIX unlink semantics)
+*/
+class SSTable::Iterator : public TableIterator {
+   public:
+    explicit Iterator(std::shared_ptr<const SSTable> table) : table_(std::move(table)) {
+        load_block();
+    }
+
+    [[nodiscard]] bool valid() const override {
+        return valid_;
+    }
+
+    [[nodiscard]] const TableEntry& entry() const override {
+        return entry_;
+    }
+
+    void next() override {
+        if (reader_.done()) {
+            ++block_idx_;
+            load_block();
+            return;
+        }
+        reader_.read_entry(entry_);
+    }
+
+   private:
+    void load_block() {
+        // skip empty blocks (none are written, but dont trust the file)
+        while (block_idx_ < table_->index_.size()) {
+            block_ = table_->read_block(table_->index_[block_idx_]);
+            reader_ = BlockReader(block_);
+            if (!reader_.done()) {
+                reader_.read_entry(entry_);
+                valid_ = true;
+                return;
+            }
+            ++block_idx_;
+        }
+        valid_ = false;
+    }
+
+    std::shared_ptr<const SSTable> table_;
+    std::size_t block_idx_ = 0;
+    std::string block_;
+    BlockReader reader_{std::string_view()};
+    TableEntry entry_;
+    bool valid_ = false;
+};
+
+SSTable::SSTable(std::filesystem::path path, uint64_t number, int fd)
+    : path_(std::move(path)), number_(number), fd_(fd) {}
+
+SSTable::~SSTable() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::shared_ptr<SSTable> SSTable::open(const std::filesystem::path& path, uint64_t number) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open sstable " + path.string() + ": " +
+                                 std::string(strerror(errno)));
+    }
+    // constructor is private, so no make_shared
+    std::shared_ptr<SSTable> table(new SSTable(path, number, fd));
+
+    table->file_size_ = util::file_size(fd);
+    if (table->file_size_ < kFooterSize) {
+        throw std::runtime_error("sstable too small: " + path.string());
+    }
+
+    std::string footer(kFooterSize, '\0');
+    util::pread_all(fd, footer.data(), footer.size(), table->file_size_ - kFooterSize);
+    BlockReader fr(footer);
+    auto index_offset = fr.read_int<uint64_t>();
+    auto index_size = fr.read_int<uint64_t>();
+    auto bloom_offset = fr.read_int<uint64_t>();
+    auto bloom_size = fr.read_int<uint64_t>();
+    auto props_offset = fr.read_int<uint64_t>();
+    auto props_size = fr.read_int<uint64_t>();
+    table->entry_count_ = fr.read_int<uint64_t>();
+    auto magic = fr.read_int<uint32_t>();
+    auto version = fr.read_int<uint32_t>();
+    if (magic != kMagic || version != kVersion) {
+        throw std::runtime_error("invalid sstable " + path.string() + ": bad footer");
+    }
+    if (props_offset + props_size > table->file_size_ - kFooterSize ||
+        index_offset + index_size > bloom_offset || bloom_offset + bloom_size > props_offset) {
+        throw std::runtime_error("invalid sstable " + path.string() + ": bad block offsets");
+    }
+
+    // index, bloom and properties are contiguous - one read for all three
+    std::string meta(props_offset + props_size - index_offset, '\0');
+    util::pread_all(fd, meta.data(), meta.size(), index_offset);
+    std::string_view meta_view(meta);
+
+    BlockReader ir(meta_view.substr(0, index_size));
+    while (!ir.done()) {
+        BlockHandle handle;
+        handle.last_key = ir.read_string();
+        handle.offset = ir.read_int<uint64_t>();
+        handle.size = ir.read_int<uint32_t>();
+        table->index_.push_back(std::move(handle));
+    }
+
+    table->bloom_ = std::make_unique<BloomFilter>(
+        std::string(meta_view.substr(bloom_offset - index_offset, bloom_size)));
+
+    BlockReader pr(meta_view.substr(props_offset - index_offset, props_size));
+    table->smallest_key_ = pr.read_string();
+    table->largest_key_ = pr.read_string();
+    return table;
+}
+
+std::string SSTable::read_block(const BlockHandle& handle) const {
+    std::string block(handle.size, '\0');
+    util::pread_all(fd_, block.data(), block.size(), handle.offset);
+    return block;
+}
+
+std::optional<TableEntry> SSTable::get(std::string_view key) const {
+    if (index_.empty() || !bloom_->may_contain(key)) {
+        return std::nullopt;
+    }
+    // first block whose last key is >= key is the only one that can hold it
+    auto it = std::lower_bound(
+        index_.begin(), index_.end(), key,
+        [](const BlockHandle& handle, std::string_view k) { return handle.last_key < k; });
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+
+    std::string block = read_block(*it);
+    BlockReader reader(block);
+    TableEntry entry;
+    while (!reader.done()) {
+        reader.read_entry(entry);
+        if (entry.key == key) {
+            return entry;
+        }
+        if (entry.key > key) {
+            break;
+        }
+    }
+    return std::nullopt;
+}
+
+std::unique_ptr<TableIterator> SSTable::iterator() const {
+    return std::make_unique<Iterator>(shared_from_this());
+}
+
+uint64_t SSTable::number() const {
+    return number_;
+}
+
+const std::filesystem::path& SSTable::path() const {
+    return path_;
+}
+
+uint64_t SSTable::file_size() const {
+    return file_size_;
+}
+
+uint64_t SSTable::entry_count() const {
+    return entry_count_;
+}
+
+const std::string& SSTable::smallest_key() const {
+    return smallest_key_;
+}
+
+const std::string& SSTable::largest_key() const {
+    return largest_key_;
+}
+
+bool SSTable::overlaps(std::string_view smallest, std::string_view largest) const {
+    return !(largest < smallest_key_ || largest_key_ < smallest);
+}
+
+// ============================================================================
+// VectorIterator
+// ============================================================================
+
+VectorIterator::VectorIterator(std::vector<TableEntry> entries) : entries_(std::move(entries)) {}
+
+bool VectorIterator::valid() const {
+    return pos_ < entries_.size();
+}
+
+const TableEntry& VectorIterator::entry() const {
+    return entries_[pos_];
+}
+
+void VectorIterator::next() {
+    ++pos_;
+}
+
+// ============================================================================
+// MergingIterator
+// ============================================================================
+/*
+    note: a linear scan over the children per step instead of a heap. the LSM store merges a
+   handful of tables at a time (L0 files + one level), where this beats heap bookkeeping
+*/
+
+MergingIterator::MergingIterator(std::vector<std::unique_ptr<TableIterator>> children)
+    : children_(std::move(children)) {
+    find_smallest();
+}
+
+bool MergingIterator::valid() const {
+    return current_ >= 0;
+}
+
+const TableEntry& MergingIterator::entry() const {
+    return children_[static_cast<std::size_t>(current_)]->entry();
+}
+
+void MergingIterator::next() {
+    if (current_ < 0) {
+        return;
+    }
+    // skip every older version of the key we just yielded
+    std::string key = entry().key;
+    for (auto& child : children_) {
+        while (child->valid() && child->entry().key == key) {
+            child->next();
+        }
+    }
+    find_smallest();
+}
+
+void MergingIterator::find_smallest() {
+    current_ = -1;
+    const std::string* smallest = nullptr;
+    for (std::size_t i = 0; i < children_.size(); ++i) {
+        if (!children_[i]->valid()) {
+            continue;
+        }
+        // strict < keeps the earliest (newest) child on ties
+        const std::string& key = children_[i]->entry().key;
+        if (smallest == nullptr || key < *smallest) {
+            smallest = &key;
+            current_ = static_cast<int>(i);
+        }
+    }
+}
+
+}  // namespace kvstore::core
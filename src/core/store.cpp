@@ -81,6 +81,41 @@ class Store::Impl {
         }
     }
 
+    void multi_put(std::span<const KeyValue> entries) {
+        bool should_snapshot = false;
+        {
+            std::unique_lock lock(mutex_);
+            if (wal_) {
+                wal_->log_puts(entries);
+                wal_entries_since_snapshot_ += entries.size();
+                should_snapshot =
+                    snapshot_ && (wal_entries_since_snapshot_ >= options_.snapshot_threshold);
+            }
+            for (const KeyValue& entry : entries) {
+                data_[std::string(entry.key)] = Entry{std::string(entry.value), std::nullopt};
+            }
+        }
+        if (should_snapshot) {
+            try_auto_snapshot();
+        }
+    }
+
+    [[nodiscard]] std::vector<std::optional<std::string>> multi_get(
+        std::span<const std::string_view> keys) {
+        std::vector<std::optional<std::string>> values;
+        values.reserve(keys.size());
+        std::shared_lock lock(mutex_);
+        for (std::string_view key : keys) {
+            auto it = data_.find(std::string(key));
+            if (it == data_.end() || is_expired(it->second)) {
+                values.emplace_back(std::nullopt);
+            } else {
+                values.emplace_back(it->second.value);
+            }
+        }
+        return values;
+    }
+
     [[nodiscard]] std::optional<std::string> get(std::string_view key) {
         std::unique_lock lock(mutex_);
         auto it = data_.find(std::string(key));
@@ -281,6 +316,12 @@ void Store::clear() {
 void Store::flush() {
     impl_->flush();
 }
+std::vector<std::optional<std::string>> Store::multi_get(std::span<const std::string_view> keys) {
+    return impl_->multi_get(keys);
+}
+void Store::multi_put(std::span<const KeyValue> entries) {
+    impl_->multi_put(entries);
+}
 void Store::snapshot() {
     impl_->snapshot();
 }
@@ -0,0 +1,280 @@
+#include "kvstore/core/tiered_store.hpp"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "kvstore/util/hash.hpp"
+
+namespace kvstore::core {
+
+namespace {
+
+// our LRU node and map entry - roughly what a hot key costs beyond its bytes
+constexpr std::size_t kHotEntryOverhead = 128;
+
+}  // namespace
+
+class TieredStore::Impl {
+   public:
+    explicit Impl(const TieredStoreOptions& options)
+        : options_(options), clock_(options.disk.clock), cold_(options.disk) {
+        std::size_t count = std::max<std::size_t>(options_.hot_tier_shards, 1);
+        shard_capacity_ = options_.hot_tier_bytes / count;
+        shards_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    void put(std::string_view key, std::string_view value) {
+        cold_.put(key, value);
+        invalidate(key);
+    }
+
+    void put(std::string_view key, std::string_view value, util::Duration ttl) {
+        cold_.put(key, value, ttl);
+        invalidate(key);
+    }
+
+    [[nodiscard]] std::optional<std::string> get(std::string_view key) {
+        Shard& shard = shard_for(key);
+        uint64_t seq = 0;
+        {
+            std::lock_guard lock(shard.mutex);
+            if (auto value = get_hot(shard, key)) {
+                ++shard.hot_hits;
+                return value;
+            }
+            seq = shard.write_seq;
+        }
+
+        // the disk read runs unlocked - the sequence check below catches writes that raced it
+        std::optional<util::TimePoint> expires_at;
+        auto value = cold_.get_with_expiry(key, expires_at);
+
+        std::lock_guard lock(shard.mutex);
+        if (!value.has_value()) {
+            ++shard.misses;
+            return std::nullopt;
+        }
+        ++shard.cold_hits;
+        if (shard.write_seq == seq) {
+            promote(shard, key, *value, expires_at);
+        }
+        return value;
+    }
+
+    [[nodiscard]] bool remove(std::string_view key) {
+        bool removed = cold_.remove(key);
+        invalidate(key);
+        return removed;
+    }
+
+    [[nodiscard]] bool contains(std::string_view key) {
+        {
+            Shard& shard = shard_for(key);
+            std::lock_guard lock(shard.mutex);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                if (!is_expired(it->second)) {
+                    return true;
+                }
+                drop(shard, it);
+            }
+        }
+        return cold_.contains(key);
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return cold_.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return cold_.empty();
+    }
+
+    void clear() {
+        cold_.clear();
+        forget_hot();
+    }
+
+    void adopt(const std::filesystem::path& dir) {
+        cold_.adopt(dir);
+        forget_hot();
+    }
+
+    void flush() {
+        cold_.flush();
+    }
+
+    // each shard is summed under its own lock: not one snapshot while gets run, like ValueCache
+    [[nodiscard]] TieredStoreStats stats() const {
+        TieredStoreStats stats;
+        for (const auto& shard : shards_) {
+            std::lock_guard lock(shard->mutex);
+            stats.hot_hits += shard->hot_hits;
+            stats.cold_hits += shard->cold_hits;
+            stats.misses += shard->misses;
+            stats.promotions += shard->promotions;
+            stats.demotions += shard->demotions;
+            stats.hot_entries += shard->index.size();
+            stats.hot_bytes += shard->bytes;
+        }
+        stats.hot_capacity_bytes = shard_capacity_ * shards_.size();
+        return stats;
+    }
+
+   private:
+    struct HotEntry {
+        std::list<std::string>::iterator lru;  // its node also owns the key the index views
+        std::string value;
+        std::size_t charge = 0;
+        std::optional<util::TimePoint> expires_at;  // the DiskStore's deadline for the key
+    };
+    using HotIndex = std::unordered_map<std::string_view, HotEntry>;
+
+    // one lock, LRU and byte budget per shard, so hot reads of different keys run in parallel.
+    // the LRU order and the budget are per shard too - the same trade ValueCache makes
+    struct Shard {
+        mutable std::mutex mutex;
+        HotIndex index;
+        std::list<std::string> lru;  // most recently read first
+        std::size_t bytes = 0;
+        // bumped by every write to a key of the shard (and clear/adopt): a get only promotes
+        // what it read if none finished meanwhile
+        uint64_t write_seq = 0;
+
+        uint64_t hot_hits = 0;
+        uint64_t cold_hits = 0;
+        uint64_t misses = 0;
+        uint64_t promotions = 0;
+        uint64_t demotions = 0;
+    };
+
+    [[nodiscard]] Shard& shard_for(std::string_view key) {
+        return *shards_[util::hash64(key) % shards_.size()];
+    }
+
+    [[nodiscard]] bool is_expired(const HotEntry& entry) const {
+        return entry.expires_at.has_value() && clock_->now() >= *entry.expires_at;
+    }
+
+    // caller holds shard.mutex
+    [[nodiscard]] std::optional<std::string> get_hot(Shard& shard, std::string_view key) {
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return std::nullopt;
+        }
+        if (is_expired(it->second)) {
+            drop(shard, it);
+            return std::nullopt;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+        return it->second.value;
+    }
+
+    // caller holds shard.mutex. the shard's least recently read keys make room, down to its
+    // share of hot_tier_bytes
+    void promote(Shard& shard, std::string_view key, const std::string& value,
+                 const std::optional<util::TimePoint>& expires_at) {
+        std::size_t charge = key.size() + value.size() + kHotEntryOverhead;
+        if (charge > shard_capacity_ || shard.index.contains(key)) {
+            return;
+        }
+        if (expires_at.has_value() && clock_->now() >= *expires_at) {
+            return;
+        }
+        shard.lru.emplace_front(key);
+        shard.index.emplace(shard.lru.front(),
+                            HotEntry{shard.lru.begin(), value, charge, expires_at});
+        shard.bytes += charge;
+        ++shard.promotions;
+
+        while (shard.bytes > shard_capacity_) {
+            drop(shard, shard.index.find(shard.lru.back()));
+            ++shard.demotions;
+        }
+    }
+
+    // after the DiskStore's contents were replaced as a whole. the sequence bump stops every get
+    // that read the old contents from promoting what it found
+    void forget_hot() {
+        for (auto& shard : shards_) {
+            std::lock_guard lock(shard->mutex);
+            shard->index.clear();
+            shard->lru.clear();
+            shard->bytes = 0;
+            ++shard->write_seq;
+        }
+    }
+
+    // caller holds shard.mutex. forgets the in-memory copy - the DiskStore still has the key
+    static void drop(Shard& shard, HotIndex::iterator it) {
+        shard.bytes -= it->second.charge;
+        auto node = it->second.lru;
+        shard.index.erase(it);  // before the list node - the index key is a view into it
+        shard.lru.erase(node);
+    }
+
+    // after a write reached the DiskStore: no hot copy of the old value, no promotion of a value
+    // read before it
+    void invalidate(std::string_view key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard lock(shard.mutex);
+        ++shard.write_seq;
+        if (auto it = shard.index.find(key); it != shard.index.end()) {
+            drop(shard, it);
+        }
+    }
+
+    TieredStoreOptions options_;
+    std::shared_ptr<util::Clock> clock_;
+    DiskStore cold_;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shard_capacity_ = 0;  // bytes
+};
+
+TieredStore::TieredStore(const TieredStoreOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+TieredStore::~TieredStore() = default;
+TieredStore::TieredStore(TieredStore&&) noexcept = default;
+TieredStore& TieredStore::operator=(TieredStore&&) noexcept = default;
+void TieredStore::put(std::string_view key, std::string_view value) {
+    impl_->put(key, value);
+}
+void TieredStore::put(std::string_view key, std::string_view value, util::Duration ttl) {
+    impl_->put(key, value, ttl);
+}
+std::optional<std::string> TieredStore::get(std::string_view key) {
+    return impl_->get(key);
+}
+bool TieredStore::remove(std::string_view key) {
+    return impl_->remove(key);
+}
+bool TieredStore::contains(std::string_view key) {
+    return impl_->contains(key);
+}
+std::size_t TieredStore::size() const {
+    return impl_->size();
+}
+bool TieredStore::empty() const {
+    return impl_->empty();
+}
+void TieredStore::clear() {
+    impl_->clear();
+}
+void TieredStore::adopt(const std::filesystem::path& dir) {
+    impl_->adopt(dir);
+}
+void TieredStore::flush() {
+    impl_->flush();
+}
+TieredStoreStats TieredStore::stats() const {
+    return impl_->stats();
+}
+
+}  // namespace kvstore::core
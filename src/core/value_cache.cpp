@@ -0,0 +1,283 @@
+#include "kvstore/core/value_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "kvstore/util/hash.hpp"
+
+namespace kvstore::core {
+
+namespace {
+
+// entry header, map node, bucket - roughly what an entry costs beyond its bytes
+constexpr std::size_t kEntryOverhead = 96;
+// hits an entry can bank for later rounds in main
+constexpr uint8_t kMaxFreq = 3;
+// doorkeeper size: a bit per 16 bytes of shard capacity, tens of bits per cacheable entry - so it
+// remembers a few times more keys than the cache holds before the reset
+constexpr std::size_t kBytesPerDoorkeeperBit = 16;
+
+}  // namespace
+
+std::string_view ValueCache::Entry::key() const {
+    return {reinterpret_cast<const char*>(this + 1), key_size};
+}
+
+std::string_view ValueCache::Entry::value() const {
+    return {reinterpret_cast<const char*>(this + 1) + key_size, value_size};
+}
+
+std::size_t ValueCache::Entry::charge() const {
+    return key_size + value_size + kEntryOverhead;
+}
+
+void ValueCache::Queue::push_back(Entry* entry) {
+    entry->prev = tail;
+    entry->next = nullptr;
+    (tail != nullptr ? tail->next : head) = entry;
+    tail = entry;
+    bytes += entry->charge();
+}
+
+void ValueCache::Queue::unlink(Entry* entry) {
+    (entry->prev != nullptr ? entry->prev->next : head) = entry->next;
+    (entry->next != nullptr ? entry->next->prev : tail) = entry->prev;
+    bytes -= entry->charge();
+}
+
+ValueCache::Shard::~Shard() {
+    for (Queue* queue : {&small, &main}) {
+        while (queue->head != nullptr) {
+            Entry* entry = queue->head;
+            queue->head = entry->next;
+            free_entry(entry);
+        }
+    }
+}
+
+ValueCache::ValueCache(std::size_t capacity_bytes, std::size_t shards) {
+    if (shards == 0) {
+        shards = 1;
+    }
+    shard_capacity_ = capacity_bytes / shards;
+    std::size_t doorkeeper_bits = std::max<std::size_t>(shard_capacity_ / kBytesPerDoorkeeperBit,
+                                                        1024);
+    shards_.reserve(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->doorkeeper.resize((doorkeeper_bits + 63) / 64);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+std::optional<std::string> ValueCache::get(std::string_view key, uint64_t version) {
+    uint64_t hash = util::hash64(key);
+    Shard& shard = shard_for(hash);
+    {
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.map.find(hash);
+        if (it != shard.map.end() && it->second->key() == key) {
+            Entry* entry = it->second;
+            if (entry->version == version) {
+                entry->freq = std::min<uint8_t>(entry->freq + 1, kMaxFreq);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return std::string(entry->value());
+            }
+            remove(shard, entry);  // the key was written again since
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+void ValueCache::put(std::string_view key, uint64_t version, std::string_view value) {
+    uint64_t hash = util::hash64(key);
+    Shard& shard = shard_for(hash);
+    std::lock_guard lock(shard.mutex);
+
+    // also drops an entry of another key with the same hash
+    if (auto it = shard.map.find(hash); it != shard.map.end()) {
+        remove(shard, it->second);
+    }
+    std::size_t charge = key.size() + value.size() + kEntryOverhead;
+    if (charge > shard_capacity_) {
+        return;  // would evict everything else for one value
+    }
+    // the bitmap is small enough to stay in the CPU cache - ask it before touching the ghost set
+    if (!seen_before(shard, hash)) {
+        return;
+    }
+
+    Entry* entry = make_entry(hash, key, version, value);
+    // a recent ghost was evicted too early - it gets the main queue this time
+    if (shard.ghosts.erase(hash) > 0) {
+        entry->in_main = true;
+        shard.main.push_back(entry);
+    } else {
+        shard.small.push_back(entry);
+    }
+    shard.map.emplace(hash, entry);
+    evict(shard);
+}
+
+void ValueCache::erase(std::string_view key) {
+    uint64_t hash = util::hash64(key);
+    Shard& shard = shard_for(hash);
+    std::lock_guard lock(shard.mutex);
+    if (auto it = shard.map.find(hash); it != shard.map.end() && it->second->key() == key) {
+        remove(shard, it->second);
+    }
+}
+
+void ValueCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        while (shard->small.head != nullptr) {
+            remove(*shard, shard->small.head);
+        }
+        while (shard->main.head != nullptr) {
+            remove(*shard, shard->main.head);
+        }
+        shard->ghost_order.clear();
+        shard->ghosts.clear();
+        std::fill(shard->doorkeeper.begin(), shard->doorkeeper.end(), 0);
+        shard->doorkeeper_set = 0;
+    }
+}
+
+void ValueCache::remap(
+    const std::function<std::optional<uint64_t>(std::string_view key)>& new_version) {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        for (Queue* queue : {&shard->small, &shard->main}) {
+            for (Entry* entry = queue->head; entry != nullptr;) {
+                Entry* next = entry->next;
+                if (auto version = new_version(entry->key())) {
+                    entry->version = *version;
+                } else {
+                    remove(*shard, entry);
+                }
+                entry = next;
+            }
+        }
+    }
+}
+
+ValueCacheStats ValueCache::stats() const {
+    ValueCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.capacity_bytes = shard_capacity_ * shards_.size();
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        stats.entries += shard->map.size();
+        stats.used_bytes += shard->small.bytes + shard->main.bytes;
+        stats.evictions += shard->evictions;
+    }
+    return stats;
+}
+
+ValueCache::Entry* ValueCache::make_entry(uint64_t hash, std::string_view key, uint64_t version,
+                                          std::string_view value) {
+    void* memory = ::operator new(sizeof(Entry) + key.size() + value.size());
+    auto* entry = new (memory) Entry();
+    entry->hash = hash;
+    entry->version = version;
+    entry->key_size = static_cast<uint32_t>(key.size());
+    entry->value_size = static_cast<uint32_t>(value.size());
+    char* data = reinterpret_cast<char*>(entry + 1);
+    std::memcpy(data, key.data(), key.size());
+    std::memcpy(data + key.size(), value.data(), value.size());
+    return entry;
+}
+
+void ValueCache::free_entry(Entry* entry) {
+    entry->~Entry();
+    ::operator delete(entry);
+}
+
+ValueCache::Shard& ValueCache::shard_for(uint64_t hash) {
+    return *shards_[hash % shards_.size()];
+}
+
+void ValueCache::remove(Shard& shard, Entry* entry) {
+    shard.map.erase(entry->hash);
+    (entry->in_main ? shard.main : shard.small).unlink(entry);
+    free_entry(entry);
+}
+
+void ValueCache::evict(Shard& shard) {
+    while (shard.small.bytes + shard.main.bytes > shard_capacity_) {
+        if (shard.small.bytes > shard_capacity_ / 10 || shard.main.head == nullptr) {
+            evict_small(shard);
+        } else {
+            evict_main(shard);
+        }
+    }
+}
+
+// oldest of small: hit since it came in -> main, else out (remembered as a ghost)
+void ValueCache::evict_small(Shard& shard) {
+    Entry* entry = shard.small.head;
+    if (entry->freq > 0) {
+        shard.small.unlink(entry);
+        entry->freq = 0;
+        entry->in_main = true;
+        shard.main.push_back(entry);
+        return;
+    }
+    uint64_t hash = entry->hash;
+    remove(shard, entry);
+    add_ghost(shard, hash);
+    ++shard.evictions;
+}
+
+// oldest of main: spends one banked hit for another round, or leaves
+void ValueCache::evict_main(Shard& shard) {
+    Entry* entry = shard.main.head;
+    if (entry->freq > 0) {
+        --entry->freq;
+        shard.main.unlink(entry);
+        shard.main.push_back(entry);
+        return;
+    }
+    remove(shard, entry);
+    ++shard.evictions;
+}
+
+// a 2 probe bloom filter: tests and sets hash's bits. the shard pick used the lowest bits, the
+// probes come from higher ones. reset at a quarter full, so at most ~6% of new keys slip through
+bool ValueCache::seen_before(Shard& shard, uint64_t hash) {
+    std::size_t bits = shard.doorkeeper.size() * 64;
+    bool seen = true;
+    for (uint64_t probe : {hash >> 32, (hash >> 8) & 0xFFFFFF}) {
+        std::size_t bit = static_cast<std::size_t>(probe % bits);
+        uint64_t mask = uint64_t{1} << (bit % 64);
+        uint64_t& word = shard.doorkeeper[bit / 64];
+        if ((word & mask) == 0) {
+            seen = false;
+            word |= mask;
+            ++shard.doorkeeper_set;
+        }
+    }
+    if (shard.doorkeeper_set > bits / 4) {
+        std::fill(shard.doorkeeper.begin(), shard.doorkeeper.end(), 0);
+        shard.doorkeeper_set = 0;
+    }
+    return seen;
+}
+
+// as many ghosts as live entries. a hash that was re-admitted may linger in ghost_order - it just
+// ages out of the set a little early
+void ValueCache::add_ghost(Shard& shard, uint64_t hash) {
+    shard.ghost_order.push_back(hash);
+    shard.ghosts.insert(hash);
+    std::size_t limit = std::max<std::size_t>(shard.map.size(), 16);
+    while (shard.ghost_order.size() > limit) {
+        shard.ghosts.erase(shard.ghost_order.front());
+        shard.ghost_order.pop_front();
+    }
+}
+
+}  // namespace kvstore::core
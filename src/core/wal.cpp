@@ -66,6 +66,16 @@ void WriteAheadLog::log_put(std::string_view key, std::string_view value) {
     write_entry(EntryType::Put, key, value);
 }
 
+void WriteAheadLog::log_puts(std::span<const KeyValue> entries) {
+    std::lock_guard lock(mutex_);
+    for (const KeyValue& entry : entries) {
+        util::write_int<uint8_t>(out_, static_cast<uint8_t>(EntryType::Put));
+        util::write_string(out_, entry.key);
+        util::write_string(out_, entry.value);
+    }
+    out_.flush();
+}
+
 void WriteAheadLog::log_put_with_ttl(std::string_view key, std::string_view value,
                                      int64_t expires_at_ms) {
     std::lock_guard lock(mutex_);
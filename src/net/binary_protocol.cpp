@@ -19,51 +19,86 @@ namespace kvstore::net {
 namespace util = kvstore::util;
 
 std::vector<uint8_t> BinaryProtocol::encode_request(const Request& req) {
-    // 1 byte command
-    std::vector<uint8_t> payload;
-    payload.reserve(128);
-    util::write_int<uint8_t>(payload, static_cast<uint8_t>(req.command));
+    EncodedRequest encoded;
+    encode_request(RequestView::of(req), encoded);
+    std::vector<uint8_t> result;
+    for (std::string_view piece : encoded.view()) {
+        result.insert(result.end(), piece.begin(), piece.end());
+    }
+    return result;
+}
+
+void BinaryProtocol::encode_request(const RequestView& req, EncodedRequest& out) {
+    /*
+        frame: [4 bytes length][1 byte command][4 bytes key len][4 bytes value len][8 bytes ttl]
+        pieces: frame head, key, value len, value, ttl - as far as the command goes
+    */
+    auto* frame = reinterpret_cast<uint8_t*>(out.frame.data());
+    std::string_view bytes(out.frame.data(), out.frame.size());
+    out.count = 0;
+
+    uint32_t payload = 1;
+    util::write_int<uint8_t>(frame + 4, static_cast<uint8_t>(req.command));
 
     switch (req.command) {
         case Command::Get:
         case Command::Del:
         case Command::Exists:
-            util::write_string(payload, req.key);  // just key
+            payload += 4 + static_cast<uint32_t>(req.key.size());
+            util::write_int<uint32_t>(frame + 5, static_cast<uint32_t>(req.key.size()));
+            out.add(bytes.substr(0, 9));
+            out.add(req.key);
             break;
 
         case Command::Put:
-            util::write_string(payload, req.key);
-            util::write_string(payload, req.value);  // key + val
-            break;
-
         case Command::PutEx:
-            util::write_string(payload, req.key);
-            util::write_string(payload, req.value);
-            util::write_int<uint64_t>(payload,
-                                      static_cast<uint64_t>(req.ttl_ms));  // key + val + ttl
+            payload += 4 + static_cast<uint32_t>(req.key.size()) + 4 +
+                       static_cast<uint32_t>(req.value.size());
+            util::write_int<uint32_t>(frame + 5, static_cast<uint32_t>(req.key.size()));
+            util::write_int<uint32_t>(frame + 9, static_cast<uint32_t>(req.value.size()));
+            out.add(bytes.substr(0, 9));
+            out.add(req.key);
+            out.add(bytes.substr(9, 4));
+            out.add(req.value);
+            if (req.command == Command::PutEx) {
+                payload += 8;
+                util::write_int<uint64_t>(frame + 13, static_cast<uint64_t>(req.ttl_ms));
+                out.add(bytes.substr(13, 8));
+            }
             break;
+
         default:
+            out.add(bytes.substr(0, 5));
             break;
     }
 
-    std::vector<uint8_t> result;
-    result.reserve(4 + payload.size());
-    util::write_int<uint32_t>(result, static_cast<uint32_t>(payload.size()));  // prepend length
-    result.insert(result.end(), payload.begin(), payload.end());               // insert payload
-
-    return result;
+    util::write_int<uint32_t>(frame, payload);  // the length goes in front once it is known
 }
 
 std::optional<Request> BinaryProtocol::decode_request(const std::vector<uint8_t>& data,
                                                       size_t& bytes_consumed) {
+    return decode_request(data.data(), data.size(), bytes_consumed);
+}
+
+std::optional<Request> BinaryProtocol::decode_request(const uint8_t* data, size_t size,
+                                                      size_t& bytes_consumed) {
+    auto view = decode_request_view(data, size, bytes_consumed);
+    if (!view) {
+        return std::nullopt;
+    }
+    return view->to_request();
+}
+
+std::optional<RequestView> BinaryProtocol::decode_request_view(const uint8_t* data, size_t size,
+                                                               size_t& bytes_consumed) {
     // need atleast 4 bytes for length
-    if (data.size() < 4) {
+    if (size < 4) {
         return std::nullopt;
     }
 
     // check full msg arrived
-    uint32_t msg_len = util::read_int<uint32_t>(data.data());
-    if (data.size() < 4 + msg_len) {
+    uint32_t msg_len = util::read_int<uint32_t>(data);
+    if (size < 4 + static_cast<size_t>(msg_len)) {
         return std::nullopt;
     }
 
@@ -73,33 +108,33 @@ std::optional<Request> BinaryProtocol::decode_request(const std::vector<uint8_t>
         throw std::runtime_error("Empty message");
     }
 
-    Request req;
+    RequestView req;
     size_t offset = 4;  // start of command-specific data
     size_t max_offset = 4 + msg_len;
 
     // get request command from first byte
-    req.command = static_cast<Command>(util::read_int<uint8_t>(data.data(), offset, max_offset));
+    req.command = static_cast<Command>(util::read_int<uint8_t>(data, offset, max_offset));
 
     switch (req.command) {
         case Command::Get:
         case Command::Del:
         case Command::Exists:
-            req.key = util::read_string(data.data(), offset, max_offset);
+            req.key = util::read_string_view(data, offset, max_offset);
             break;
 
         case Command::Put:
-            req.key = util::read_string(data.data(), offset, max_offset);
-            req.value = util::read_string(data.data(), offset, max_offset);
+            req.key = util::read_string_view(data, offset, max_offset);
+            req.value = util::read_string_view(data, offset, max_offset);
             break;
 
         case Command::PutEx:
-            req.key = util::read_string(data.data(), offset, max_offset);
-            req.value = util::read_string(data.data(), offset, max_offset);
+            req.key = util::read_string_view(data, offset, max_offset);
+            req.value = util::read_string_view(data, offset, max_offset);
             if (offset + 8 > max_offset) {
                 throw std::runtime_error("Incomplete TTL");
             }
             req.ttl_ms =
-                static_cast<int64_t>(util::read_int<uint64_t>(data.data(), offset, max_offset));
+                static_cast<int64_t>(util::read_int<uint64_t>(data, offset, max_offset));
             offset += 8;
             break;
 
@@ -138,13 +173,18 @@ std::vector<uint8_t> BinaryProtocol::encode_response(const Response& resp) {
 
 std::optional<Response> BinaryProtocol::decode_response(const std::vector<uint8_t>& data,
                                                         size_t& bytes_consumed) {
-    if (data.size() < 4) {
+    return decode_response(data.data(), data.size(), bytes_consumed);
+}
+
+std::optional<Response> BinaryProtocol::decode_response(const uint8_t* data, size_t size,
+                                                        size_t& bytes_consumed) {
+    if (size < 4) {
         return std::nullopt;
     }
 
     // get length
-    uint32_t msg_len = util::read_int<uint32_t>(data.data());
-    if (data.size() < 4 + msg_len) {
+    uint32_t msg_len = util::read_int<uint32_t>(data);
+    if (size < 4 + static_cast<size_t>(msg_len)) {
         return std::nullopt;
     }
 
@@ -158,12 +198,12 @@ std::optional<Response> BinaryProtocol::decode_response(const std::vector<uint8_
     size_t max_offset = 4 + msg_len;
 
     // response status is first byte after length
-    resp.status = static_cast<Status>(util::read_int<uint8_t>(data.data(), offset, max_offset));
+    resp.status = static_cast<Status>(util::read_int<uint8_t>(data, offset, max_offset));
     resp.close_connection = (resp.status == Status::Bye);
 
     // read the rest of the payload (optional string data)
     if (offset < max_offset) {
-        resp.data = util::read_string(data.data(), offset, max_offset);
+        resp.data = util::read_string(data, offset, max_offset);
     }
 
     return resp;
@@ -0,0 +1,122 @@
+#include "kvstore/net/buffered_connection.hpp"
+
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cerrno>
+
+namespace kvstore::net {
+
+namespace {
+
+// iovecs per sendmsg. more pieces than this take another call
+constexpr std::size_t kMaxIov = 64;
+
+}  // namespace
+
+BufferedConnection::BufferedConnection(int fd, std::size_t base_capacity)
+    : fd_(fd), in_(base_capacity) {}
+
+void BufferedConnection::reset(int fd) noexcept {
+    fd_ = fd;
+    in_.clear();
+}
+
+ssize_t BufferedConnection::fill(std::size_t min_free) {
+    char spill[kSpillSize];
+    std::span<char> space = in_.prepare(min_free);
+    iovec iov[2] = {{space.data(), space.size()}, {spill, sizeof(spill)}};
+
+    ssize_t n = 0;
+    do {
+        ++syscalls_;
+        n = readv(fd_, iov, 2);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        in_.commit(0);
+        return n;
+    }
+    auto read = static_cast<std::size_t>(n);
+    if (read <= space.size()) {
+        in_.commit(read);
+    } else {
+        // the buffer is full (which also makes it grow for the next read), the rest follows it
+        in_.commit(space.size());
+        in_.append({spill, read - space.size()});
+    }
+    return n;
+}
+
+bool BufferedConnection::write(std::span<const std::string_view> pieces, int flags) {
+    std::size_t next = 0;  // the first piece not completely sent
+    std::size_t done = 0;  // bytes of it that are
+    while (next < pieces.size()) {
+        iovec iov[kMaxIov];
+        std::size_t count = 0;
+        for (std::size_t i = next; i < pieces.size() && count < kMaxIov; ++i) {
+            std::string_view piece = i == next ? pieces[i].substr(done) : pieces[i];
+            if (!piece.empty()) {
+                iov[count++] = {const_cast<char*>(piece.data()), piece.size()};
+            }
+        }
+        if (count == 0) {
+            break;  // only empty pieces left
+        }
+
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ++syscalls_;
+        ssize_t sent = sendmsg(fd_, &msg, MSG_NOSIGNAL | flags);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+
+        // a short send stops anywhere, also inside a piece
+        auto left = static_cast<std::size_t>(sent);
+        while (next < pieces.size() && left >= pieces[next].size() - done) {
+            left -= pieces[next].size() - done;
+            ++next;
+            done = 0;
+        }
+        done += left;
+    }
+    return true;
+}
+
+bool BufferedConnection::write(std::string_view bytes, int flags) {
+    return write(std::span<const std::string_view>(&bytes, 1), flags);
+}
+
+ssize_t BufferedConnection::write_some(std::string_view bytes) {
+    ssize_t sent = 0;
+    do {
+        ++syscalls_;
+        sent = send(fd_, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    return sent;
+}
+
+bool BufferedConnection::send_file(int file_fd, uint64_t offset, std::size_t size) {
+    auto file_offset = static_cast<off_t>(offset);
+    while (size > 0) {
+        ++syscalls_;
+        ssize_t sent = sendfile(fd_, file_fd, &file_offset, size);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        // 0 = the file ended early
+        if (sent <= 0) {
+            return false;
+        }
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+}  // namespace kvstore::net
@@ -0,0 +1,573 @@
+#include "kvstore/net/client/async_client.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "kvstore/net/buffered_connection.hpp"
+#include "kvstore/net/client/pipeline.hpp"
+#include "kvstore/net/client/protocol_handler.hpp"
+#include "kvstore/net/types.hpp"
+#include "kvstore/util/logger.hpp"
+
+namespace kvstore::net::client {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+constexpr int kMaxEvents = 64;
+
+// epoll_event.data.ptr tag of the wake eventfd, every other tag is a Connection
+char wake_tag;
+
+// a call waiting for its response
+struct Call {
+    virtual ~Call() = default;
+    // the response arrived: the future gets what the Client call returns, or what it throws
+    virtual void complete(Response& response) noexcept = 0;
+    virtual void fail(std::exception_ptr error) noexcept = 0;
+
+    Command command = Command::Unknown;
+    SteadyClock::time_point deadline{};  // time_point{} = no timeout
+    bool done = false;  // the future is set: a response that comes now is dropped
+    bool timed = false;  // timer is in the loop's timer map
+    std::multimap<SteadyClock::time_point, Call*>::iterator timer;
+};
+
+// the response turned into T the way the Client call does it (PipelineResult's accessors)
+template <typename T>
+struct TypedCall final : Call {
+    using Convert = T (*)(const PipelineResult&);
+
+    explicit TypedCall(Convert convert_) : convert(convert_) {}
+
+    void complete(Response& response) noexcept override {
+        PipelineResult result{command, response.status, std::move(response.data)};
+        try {
+            if constexpr (std::is_void_v<T>) {
+                convert(result);
+                promise.set_value();
+            } else {
+                promise.set_value(convert(result));
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    void fail(std::exception_ptr error) noexcept override {
+        promise.set_exception(std::move(error));
+    }
+
+    std::promise<T> promise;
+    Convert convert;
+};
+
+struct Connection {
+    explicit Connection(int fd) : io(fd) {}
+
+    BufferedConnection io;
+    std::string out;            // encoded requests not sent yet
+    std::size_t out_sent = 0;   // bytes of out the socket took
+    bool want_write = false;    // EPOLLOUT is on: out is waiting for room in the socket
+    // sent (or in out), answered in this order. timed out calls stay until their response
+    std::deque<std::unique_ptr<Call>> in_flight;
+
+    // under Impl::mutex_: what callers queued since the loop last looked, and whether the
+    // connection still takes calls
+    std::string staged;
+    std::vector<std::unique_ptr<Call>> staged_calls;
+    bool alive = true;
+};
+
+std::exception_ptr failure(const std::string& message) {
+    return std::make_exception_ptr(std::runtime_error(message));
+}
+
+}  // namespace
+
+class AsyncClient::Impl {
+   public:
+    explicit Impl(const AsyncClientOptions& options)
+        : options_(options), protocol_(create_protocol_handler(options.binary)) {}
+
+    ~Impl() {
+        disconnect();
+    }
+
+    void connect() {
+        if (thread_.joinable()) {
+            return;
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd_ < 0 || wake_fd_ < 0) {
+            std::string error = strerror(errno);
+            close_fds();
+            throw std::runtime_error("failed to set up the event loop: " + error);
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &wake_tag;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+        try {
+            for (std::size_t i = 0; i < std::max<std::size_t>(options_.connections, 1); ++i) {
+                auto conn = std::make_unique<Connection>(open_socket());
+                ev.events = EPOLLIN;
+                ev.data.ptr = conn.get();
+                epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn->io.fd(), &ev);
+                conns_.push_back(std::move(conn));
+            }
+        } catch (...) {
+            close_fds();
+            throw;
+        }
+
+        wake_pending_ = false;  // a call queued right before the last disconnect left it set
+        running_ = true;
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void disconnect() {
+        if (!thread_.joinable()) {
+            return;
+        }
+        running_ = false;
+        wake();
+        thread_.join();
+
+        // whatever is still waiting fails - the loop is gone, nothing touches the calls now
+        for (auto& conn : conns_) {
+            close_connection(*conn, "disconnected");
+        }
+        publish_syscalls();
+        close_fds();
+    }
+
+    [[nodiscard]] bool connected() const noexcept {
+        return running_;
+    }
+
+    template <typename T>
+    std::future<T> submit(const RequestView& request, const CallOptions& options,
+                          typename TypedCall<T>::Convert convert) {
+        auto call = std::make_unique<TypedCall<T>>(convert);
+        call->command = request.command;
+        util::Duration timeout =
+            options.timeout.count() > 0 ? options.timeout : options_.request_timeout;
+        if (timeout.count() > 0) {
+            call->deadline = SteadyClock::now() + timeout;
+        }
+        std::future<T> future = call->promise.get_future();
+
+        {
+            std::lock_guard lock(mutex_);
+            if (Connection* conn = pick_connection(request.key)) {
+                protocol_->append_request(conn->staged, request);
+                conn->staged_calls.push_back(std::move(call));
+                in_flight_.fetch_add(1, std::memory_order_relaxed);
+                // one wakeup for everything queued until the loop looks
+                if (!wake_pending_) {
+                    wake_pending_ = true;
+                    wake();  // under the lock: disconnect() cant close the eventfd meanwhile
+                }
+            }
+        }
+        if (call) {
+            call->fail(failure("Not connected"));
+        }
+        return future;
+    }
+
+    [[nodiscard]] std::size_t in_flight() const noexcept {
+        return in_flight_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t syscalls() const noexcept {
+        return published_syscalls_.load(std::memory_order_relaxed) +
+               wake_syscalls_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    // blocking connect, then non-blocking for the loop
+    int open_socket() {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::runtime_error("failed to create socket");
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options_.port);
+        if (inet_pton(AF_INET, options_.host.c_str(), &addr.sin_addr) <= 0) {
+            close(fd);
+            throw std::runtime_error("Invalid address: " + options_.host);
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(fd);
+            throw std::runtime_error("failed to connect to " + options_.host + ":" +
+                                     std::to_string(options_.port));
+        }
+        // requests are written as soon as they are queued, while earlier ones are still
+        // unanswered: Nagle would hold them back for an ACK
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return fd;
+    }
+
+    void close_fds() {
+        std::lock_guard lock(mutex_);
+        for (auto& conn : conns_) {
+            if (conn->io.fd() >= 0) {
+                close(conn->io.fd());
+            }
+        }
+        conns_.clear();
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+            epoll_fd_ = -1;
+        }
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+            wake_fd_ = -1;
+        }
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        wake_syscalls_.fetch_add(1, std::memory_order_relaxed);
+        (void)!write(wake_fd_, &one, sizeof(one));
+    }
+
+    // the key's connection: calls on one key are answered in the order they were made. calls
+    // without a key go round robin. when a connection is closed its calls go to the next open
+    // one. under mutex_
+    Connection* pick_connection(std::string_view key) {
+        if (!running_) {
+            return nullptr;
+        }
+        std::size_t first = key.empty() ? next_conn_++ : std::hash<std::string_view>{}(key);
+        for (std::size_t i = 0; i < conns_.size(); ++i) {
+            Connection* conn = conns_[(first + i) % conns_.size()].get();
+            if (conn->alive) {
+                return conn;
+            }
+        }
+        return nullptr;
+    }
+
+    void run() {
+        epoll_event events[kMaxEvents];
+        while (running_) {
+            ++own_syscalls_;
+            int n = epoll_wait(epoll_fd_, events, kMaxEvents, wait_timeout_ms());
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERROR("epoll_wait failed: " + std::string(strerror(errno)));
+                break;
+            }
+
+            bool woken = false;
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.ptr == &wake_tag) {
+                    woken = true;
+                    continue;
+                }
+                auto& conn = *static_cast<Connection*>(events[i].data.ptr);
+                if (conn.io.fd() < 0) {
+                    continue;  // closed earlier in this batch
+                }
+                if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    read_responses(conn);
+                }
+                if (conn.io.fd() >= 0 && (events[i].events & EPOLLOUT)) {
+                    flush(conn);
+                }
+            }
+            if (woken) {
+                take_staged();
+            }
+            expire_timeouts(SteadyClock::now());
+            publish_syscalls();
+        }
+    }
+
+    // until the earliest deadline, or forever
+    int wait_timeout_ms() const {
+        if (timers_.empty()) {
+            return -1;
+        }
+        auto wait = timers_.begin()->first - SteadyClock::now();
+        if (wait <= SteadyClock::duration::zero()) {
+            return 0;
+        }
+        // rounded up: waking before the deadline would only mean waiting again
+        return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wait).count());
+    }
+
+    // the calls queued since the last wakeup move to their connections' output, which is sent
+    void take_staged() {
+        uint64_t count = 0;
+        ++own_syscalls_;
+        (void)!read(wake_fd_, &count, sizeof(count));
+
+        std::vector<Connection*> ready;
+        {
+            std::lock_guard lock(mutex_);
+            wake_pending_ = false;
+            for (auto& conn : conns_) {
+                if (conn->staged_calls.empty()) {
+                    continue;
+                }
+                if (conn->out.empty()) {
+                    conn->out.swap(conn->staged);
+                } else {
+                    conn->out += conn->staged;
+                    conn->staged.clear();
+                }
+                for (auto& call : conn->staged_calls) {
+                    if (call->deadline != SteadyClock::time_point{}) {
+                        call->timer = timers_.emplace(call->deadline, call.get());
+                        call->timed = true;
+                    }
+                    conn->in_flight.push_back(std::move(call));
+                }
+                conn->staged_calls.clear();
+                ready.push_back(conn.get());
+            }
+        }
+        for (Connection* conn : ready) {
+            if (!conn->want_write) {
+                flush(*conn);  // with EPOLLOUT on, the socket is full - epoll says when it isnt
+            }
+        }
+    }
+
+    void flush(Connection& conn) {
+        while (conn.out_sent < conn.out.size()) {
+            ssize_t n = conn.io.write_some(std::string_view(conn.out).substr(conn.out_sent));
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    set_want_write(conn, true);
+                    return;
+                }
+                close_connection(conn, "failed to send request: " + std::string(strerror(errno)));
+                return;
+            }
+            conn.out_sent += static_cast<std::size_t>(n);
+        }
+        conn.out.clear();
+        conn.out_sent = 0;
+        set_want_write(conn, false);
+    }
+
+    void set_want_write(Connection& conn, bool want) {
+        if (conn.want_write == want) {
+            return;
+        }
+        conn.want_write = want;
+        epoll_event ev{};
+        ev.events = want ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        ev.data.ptr = &conn;
+        ++own_syscalls_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.io.fd(), &ev);
+    }
+
+    // one read per wakeup - epoll is level-triggered, whatever is left wakes us again
+    void read_responses(Connection& conn) {
+        ssize_t n = conn.io.fill();
+        if (n == 0) {
+            close_connection(conn, "connection closed by server");
+            return;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_connection(conn, "failed to receive response: " +
+                                           std::string(strerror(errno)));
+            }
+            return;
+        }
+
+        ReadBuffer& in = conn.io.in();
+        std::string_view data = in.data();
+        std::size_t pos = 0;
+        try {
+            while (pos < data.size()) {
+                std::size_t consumed = 0;
+                auto response = protocol_->parse_response(data.substr(pos), consumed);
+                if (!response) {
+                    break;
+                }
+                pos += consumed;
+                if (conn.in_flight.empty()) {
+                    close_connection(conn, "response to no request");
+                    return;
+                }
+                std::unique_ptr<Call> call = std::move(conn.in_flight.front());
+                conn.in_flight.pop_front();
+                if (!call->done) {
+                    finish(*call);
+                    call->complete(*response);
+                }
+            }
+        } catch (const std::exception& e) {
+            close_connection(conn, std::string("malformed response: ") + e.what());
+            return;
+        }
+        in.consume(pos);
+    }
+
+    void expire_timeouts(SteadyClock::time_point now) {
+        while (!timers_.empty() && timers_.begin()->first <= now) {
+            Call* call = timers_.begin()->second;
+            // the call keeps its place in in_flight: its response still comes, and is dropped
+            finish(*call);
+            call->fail(std::make_exception_ptr(TimeoutError("request timed out")));
+        }
+    }
+
+    // right before the call's future is set: whoever waits on it sees in_flight() without it
+    void finish(Call& call) {
+        call.done = true;
+        if (call.timed) {
+            timers_.erase(call.timer);
+            call.timed = false;
+        }
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // fails every call on the connection: in flight, and queued but not taken yet
+    void close_connection(Connection& conn, const std::string& reason) {
+        std::vector<std::unique_ptr<Call>> staged;
+        {
+            std::lock_guard lock(mutex_);
+            conn.alive = false;
+            staged.swap(conn.staged_calls);
+            conn.staged.clear();
+        }
+        if (conn.io.fd() >= 0) {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.io.fd(), nullptr);
+            close(conn.io.fd());
+            own_syscalls_ += 2;
+            conn.io.reset(-1);
+        }
+        auto error = failure(reason);
+        for (auto& call : conn.in_flight) {
+            if (!call->done) {
+                finish(*call);
+                call->fail(error);
+            }
+        }
+        conn.in_flight.clear();
+        for (auto& call : staged) {
+            finish(*call);
+            call->fail(error);
+        }
+        conn.out.clear();
+        conn.out_sent = 0;
+    }
+
+    // syscalls() is read from any thread, the counts it adds up are the loop's
+    void publish_syscalls() {
+        uint64_t total = own_syscalls_;
+        for (const auto& conn : conns_) {
+            total += conn->io.syscalls();
+        }
+        published_syscalls_.store(total, std::memory_order_relaxed);
+    }
+
+    AsyncClientOptions options_;
+    std::unique_ptr<IProtocolHandler> protocol_;  // stateless: shared by callers and the loop
+    std::vector<std::unique_ptr<Connection>> conns_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex mutex_;  // Connection::staged*, alive, wake_pending_, next_conn_, wake_fd_
+    bool wake_pending_ = false;
+    std::size_t next_conn_ = 0;
+
+    // loop thread only
+    std::multimap<SteadyClock::time_point, Call*> timers_;  // calls with a deadline, not done
+    uint64_t own_syscalls_ = 0;  // epoll and eventfd calls, close()
+
+    std::atomic<std::size_t> in_flight_{0};
+    std::atomic<uint64_t> published_syscalls_{0};
+    std::atomic<uint64_t> wake_syscalls_{0};  // eventfd writes, by the callers
+};
+
+// PIMPL INTERFACE ------------------------------------------------------------------------
+AsyncClient::AsyncClient(const AsyncClientOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+AsyncClient::~AsyncClient() = default;
+void AsyncClient::connect() {
+    impl_->connect();
+}
+void AsyncClient::disconnect() {
+    impl_->disconnect();
+}
+bool AsyncClient::connected() const noexcept {
+    return impl_->connected();
+}
+std::future<void> AsyncClient::put(std::string_view key, std::string_view value,
+                                   const CallOptions& options) {
+    return impl_->submit<void>({Command::Put, key, value, 0}, options,
+                               [](const PipelineResult& result) { result.check(); });
+}
+std::future<void> AsyncClient::put(std::string_view key, std::string_view value,
+                                   util::Duration ttl, const CallOptions& options) {
+    return impl_->submit<void>({Command::PutEx, key, value, ttl.count()}, options,
+                               [](const PipelineResult& result) { result.check(); });
+}
+std::future<std::optional<std::string>> AsyncClient::get(std::string_view key,
+                                                         const CallOptions& options) {
+    return impl_->submit<std::optional<std::string>>(
+        {Command::Get, key, {}, 0}, options,
+        [](const PipelineResult& result) { return result.value(); });
+}
+std::future<bool> AsyncClient::remove(std::string_view key, const CallOptions& options) {
+    return impl_->submit<bool>({Command::Del, key, {}, 0}, options,
+                               [](const PipelineResult& result) { return result.removed(); });
+}
+std::future<bool> AsyncClient::contains(std::string_view key, const CallOptions& options) {
+    return impl_->submit<bool>({Command::Exists, key, {}, 0}, options,
+                               [](const PipelineResult& result) { return result.exists(); });
+}
+std::future<bool> AsyncClient::ping(const CallOptions& options) {
+    return impl_->submit<bool>({Command::Ping, {}, {}, 0}, options,
+                               [](const PipelineResult& result) {
+                                   return result.status == Status::Ok && result.data == "PONG";
+                               });
+}
+std::size_t AsyncClient::in_flight() const noexcept {
+    return impl_->in_flight();
+}
+uint64_t AsyncClient::syscalls() const noexcept {
+    return impl_->syscalls();
+}
+
+}  // namespace kvstore::net::client
@@ -7,6 +7,7 @@
 
 #include <stdexcept>
 
+#include "kvstore/net/buffered_connection.hpp"
 #include "kvstore/net/client/protocol_handler.hpp"
 #include "kvstore/net/types.hpp"
 
@@ -24,13 +25,13 @@ class Client::Impl {
     }
 
     void connect() {
-        if (socket_fd_ >= 0) {
+        if (conn_.fd() >= 0) {
             return;
         }
 
-        socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
 
-        if (socket_fd_ < 0) {
+        if (fd < 0) {
             throw std::runtime_error("failed to create socket");
         }
 
@@ -38,8 +39,8 @@ class Client::Impl {
             struct timeval tv;
             tv.tv_sec = options_.timeout_seconds;
             tv.tv_usec = 0;
-            setsockopt(socket_fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-            setsockopt(socket_fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
         }
 
         sockaddr_in addr{};
@@ -47,28 +48,31 @@ class Client::Impl {
         addr.sin_port = htons(options_.port);
 
         if (inet_pton(AF_INET, options_.host.c_str(), &addr.sin_addr) <= 0) {
-            close(socket_fd_);
-            socket_fd_ = -1;
+            close(fd);
             throw std::runtime_error("Invalid address: " + options_.host);
         }
 
-        if (::connect(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-            close(socket_fd_);
-            socket_fd_ = -1;
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(fd);
             throw std::runtime_error("failed to connect to " + options_.host + ":" +
                                      std::to_string(options_.port));
         }
+        conn_.reset(fd);
     }
 
     void disconnect() {
-        if (socket_fd_ >= 0) {
-            close(socket_fd_);
-            socket_fd_ = -1;
+        if (conn_.fd() >= 0) {
+            close(conn_.fd());
+            conn_.reset(-1);
         }
     }
 
     [[nodiscard]] bool connected() const noexcept {
-        return socket_fd_ >= 0;
+        return conn_.fd() >= 0;
+    }
+
+    [[nodiscard]] uint64_t syscalls() const noexcept {
+        return conn_.syscalls();
     }
 
     /*
@@ -76,21 +80,21 @@ class Client::Impl {
     cant continue anyway)
     */
     void put(std::string_view key, std::string_view value) {
-        auto resp = execute({Command::Put, std::string(key), std::string(value), 0});
+        auto resp = execute({Command::Put, key, value, 0});
         if (resp.status != Status::Ok) {
             throw std::runtime_error("PUT failed: " + resp.data);
         }
     }
 
     void put(std::string_view key, std::string_view value, util::Duration ttl) {
-        auto resp = execute({Command::PutEx, std::string(key), std::string(value), ttl.count()});
+        auto resp = execute({Command::PutEx, key, value, ttl.count()});
         if (resp.status != Status::Ok) {
             throw std::runtime_error("PUTEX failed: " + resp.data);
         }
     }
 
     [[nodiscard]] std::optional<std::string> get(std::string_view key) {
-        auto resp = execute({Command::Get, std::string(key), "", 0});
+        auto resp = execute({Command::Get, key, {}, 0});
         if (resp.status == Status::NotFound) {
             return std::nullopt;
         }
@@ -101,7 +105,7 @@ class Client::Impl {
     }
 
     [[nodiscard]] bool remove(std::string_view key) {
-        auto resp = execute({Command::Del, std::string(key), "", 0});
+        auto resp = execute({Command::Del, key, {}, 0});
         if (resp.status == Status::NotFound) {
             return false;
         }
@@ -112,7 +116,7 @@ class Client::Impl {
     }
 
     [[nodiscard]] bool contains(std::string_view key) {
-        auto resp = execute({Command::Exists, std::string(key), "", 0});
+        auto resp = execute({Command::Exists, key, {}, 0});
         if (resp.status != Status::Ok) {
             throw std::runtime_error("EXISTS failed: " + resp.data);
         }
@@ -120,7 +124,7 @@ class Client::Impl {
     }
 
     [[nodiscard]] std::size_t size() {
-        auto resp = execute({Command::Size, "", "", 0});
+        auto resp = execute({Command::Size, {}, {}, 0});
         if (resp.status != Status::Ok) {
             throw std::runtime_error("SIZE failed: " + resp.data);
         }
@@ -128,7 +132,7 @@ class Client::Impl {
     }
 
     void clear() {
-        auto resp = execute({Command::Clear, "", "", 0});
+        auto resp = execute({Command::Clear, {}, {}, 0});
         if (resp.status != Status::Ok) {
             throw std::runtime_error("CLEAR failed: " + resp.data);
         }
@@ -136,36 +140,54 @@ class Client::Impl {
 
     [[nodiscard]] bool ping() {
         try {
-            auto resp = execute({Command::Ping, "", "", 0});
+            auto resp = execute({Command::Ping, {}, {}, 0});
             return resp.status == Status::Ok && resp.data == "PONG";
         } catch (...) {
             return false;
         }
     }
 
-   private:
-    Response execute(const Request& req) {
-        if (socket_fd_ < 0) {
+    void append_request(std::string& out, const RequestView& req) {
+        protocol_->append_request(out, req);
+    }
+
+    void write_encoded(std::string_view bytes) {
+        if (conn_.fd() < 0) {
             throw std::runtime_error("Not connected");
         }
-
-        if (!protocol_->write_request(socket_fd_, req)) {
+        if (!conn_.write(bytes)) {
             disconnect();
             throw std::runtime_error("failed to send request");
         }
+    }
 
-        auto resp = protocol_->read_response(socket_fd_);
+    Response read_response() {
+        auto resp = protocol_->read_response(conn_);
         if (!resp) {
             disconnect();
             throw std::runtime_error("Failed to receive response");
         }
 
-        return *resp;
+        return std::move(*resp);
+    }
+
+   private:
+    Response execute(const RequestView& req) {
+        if (conn_.fd() < 0) {
+            throw std::runtime_error("Not connected");
+        }
+
+        if (!protocol_->write_request(conn_, req)) {
+            disconnect();
+            throw std::runtime_error("failed to send request");
+        }
+
+        return read_response();
     }
 
     ClientOptions options_;
     std::unique_ptr<IProtocolHandler> protocol_;
-    int socket_fd_ = -1;
+    BufferedConnection conn_;
 };
 
 // PIMPL INTERFACE ------------------------------------------------------------------------
@@ -182,6 +204,9 @@ void Client::disconnect() {
 bool Client::connected() const noexcept {
     return impl_->connected();
 }
+uint64_t Client::syscalls() const noexcept {
+    return impl_->syscalls();
+}
 void Client::put(std::string_view key, std::string_view value) {
     impl_->put(key, value);
 }
@@ -206,4 +231,13 @@ void Client::clear() {
 bool Client::ping() {
     return impl_->ping();
 }
+void Client::append_request(std::string& out, const RequestView& request) {
+    impl_->append_request(out, request);
+}
+void Client::write_encoded(std::string_view bytes) {
+    impl_->write_encoded(bytes);
+}
+Response Client::read_response() {
+    return impl_->read_response();
+}
 }  // namespace kvstore::net::client
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "kvstore/net/client/connection_pool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kvstore::net::client {
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct ConnectionPool::Slot {
+    explicit Slot(const ClientOptions& options) : client(options) {}
+
+    Client client;
+    SteadyClock::time_point last_used = SteadyClock::now();
+};
+
+class ConnectionPool::Impl {
+   public:
+    explicit Impl(const ConnectionPoolOptions& options) : options_(options) {
+        options_.max_size = std::max<std::size_t>(options_.max_size, 1);
+        options_.min_size = std::min(options_.min_size, options_.max_size);
+        // release() must not allocate (it runs in Lease's destructor): idle_ never grows past
+        // max_size
+        slots_.reserve(options_.max_size);
+        idle_.reserve(options_.max_size);
+        for (std::size_t i = 0; i < options_.min_size; ++i) {
+            auto slot = std::make_unique<Slot>(options_.client);
+            slot->client.connect();
+            idle_.push_back(slot.get());
+            slots_.push_back(std::move(slot));
+        }
+    }
+
+    Slot* acquire(util::Duration timeout) {
+        auto start = SteadyClock::now();
+        Slot* slot = nullptr;
+        bool opened = false;  // a new slot: connect it, theres nothing to check
+        bool waited = false;
+        {
+            std::unique_lock lock(mutex_);
+            auto available = [this]() {
+                return !idle_.empty() || slots_.size() < options_.max_size;
+            };
+            if (!available()) {
+                waited = true;
+                if (timeout.count() == 0) {
+                    released_.wait(lock, available);
+                } else if (!released_.wait_until(lock, start + timeout, available)) {
+                    ++stats_.timeouts;
+                    throw std::runtime_error("no pooled connection free within " +
+                                             std::to_string(timeout.count()) + "ms");
+                }
+            }
+            if (!idle_.empty()) {
+                slot = idle_.back();
+                idle_.pop_back();
+            } else {
+                // reserved now so max_size holds, connected below outside the lock
+                slots_.push_back(std::make_unique<Slot>(options_.client));
+                slot = slots_.back().get();
+                opened = true;
+            }
+        }
+
+        // connecting and pinging without the lock: other threads keep getting connections
+        try {
+            prepare(*slot, opened);
+        } catch (...) {
+            discard(slot);
+            throw;
+        }
+
+        auto elapsed = SteadyClock::now() - start;
+        std::lock_guard lock(mutex_);
+        ++stats_.acquisitions;
+        stats_.waits += waited ? 1 : 0;
+        stats_.total_acquire_time += elapsed;
+        stats_.max_acquire_time = std::max<std::chrono::nanoseconds>(stats_.max_acquire_time,
+                                                                     elapsed);
+        return slot;
+    }
+
+    void release(Slot* slot) noexcept {
+        auto now = SteadyClock::now();
+        {
+            std::lock_guard lock(mutex_);
+            slot->last_used = now;
+            idle_.push_back(slot);  // within the capacity reserved up front
+            trim(now);
+        }
+        released_.notify_one();
+    }
+
+    [[nodiscard]] util::Duration acquire_timeout() const noexcept {
+        return options_.acquire_timeout;
+    }
+
+    [[nodiscard]] ConnectionPoolStats stats() const {
+        std::lock_guard lock(mutex_);
+        ConnectionPoolStats stats = stats_;
+        stats.open = slots_.size();
+        stats.idle = idle_.size();
+        return stats;
+    }
+
+   private:
+    // a connection ready for calls: opened, reopened, or pinged when idle for long
+    void prepare(Slot& slot, bool opened) {
+        if (opened) {
+            slot.client.connect();
+            return;
+        }
+        if (slot.client.connected() &&
+            SteadyClock::now() - slot.last_used >= options_.health_check_interval) {
+            if (slot.client.ping()) {
+                return;
+            }
+            count(&ConnectionPoolStats::failed_health_checks);
+            slot.client.disconnect();
+        }
+        if (!slot.client.connected()) {
+            count(&ConnectionPoolStats::reconnects);
+            slot.client.connect();
+        }
+    }
+
+    void count(uint64_t ConnectionPoolStats::*counter) {
+        std::lock_guard lock(mutex_);
+        ++(stats_.*counter);
+    }
+
+    // a slot that couldnt be connected leaves the pool: it doesnt count against max_size
+    void discard(Slot* slot) {
+        std::unique_ptr<Slot> removed;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = std::find_if(slots_.begin(), slots_.end(),
+                                   [slot](const auto& owned) { return owned.get() == slot; });
+            removed = std::move(*it);
+            slots_.erase(it);
+        }
+        released_.notify_one();
+    }
+
+    // closes the idle connections above min_size unused for idle_timeout, oldest first (idle_
+    // is oldest first, acquire takes from the back). only erases, never allocates: release() is
+    // noexcept. closing a Client is a close() - cheap enough under mutex_
+    void trim(SteadyClock::time_point now) noexcept {
+        while (slots_.size() > options_.min_size && !idle_.empty() &&
+               now - idle_.front()->last_used >= options_.idle_timeout) {
+            Slot* slot = idle_.front();
+            idle_.erase(idle_.begin());
+            auto it = std::find_if(slots_.begin(), slots_.end(),
+                                   [slot](const auto& owned) { return owned.get() == slot; });
+            slots_.erase(it);
+        }
+    }
+
+    ConnectionPoolOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable released_;  // a slot went idle, or left the pool
+    std::vector<std::unique_ptr<Slot>> slots_;  // every connection, leased or idle
+    std::vector<Slot*> idle_;  // least recently used first
+    ConnectionPoolStats stats_;
+};
+
+// POOL -----------------------------------------------------------------------------------
+ConnectionPool::ConnectionPool(const ConnectionPoolOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+ConnectionPool::~ConnectionPool() = default;
+ConnectionPool::Lease ConnectionPool::acquire() {
+    return acquire(impl_->acquire_timeout());
+}
+ConnectionPool::Lease ConnectionPool::acquire(util::Duration timeout) {
+    return Lease(impl_.get(), impl_->acquire(timeout));
+}
+ConnectionPoolStats ConnectionPool::stats() const {
+    return impl_->stats();
+}
+
+// LEASE ----------------------------------------------------------------------------------
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(std::exchange(other.pool_, nullptr)), slot_(std::exchange(other.slot_, nullptr)) {}
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = std::exchange(other.pool_, nullptr);
+        slot_ = std::exchange(other.slot_, nullptr);
+    }
+    return *this;
+}
+ConnectionPool::Lease::~Lease() {
+    release();
+}
+Client& ConnectionPool::Lease::client() const noexcept {
+    return slot_->client;
+}
+void ConnectionPool::Lease::release() noexcept {
+    if (slot_ != nullptr) {
+        pool_->release(slot_);
+        slot_ = nullptr;
+        pool_ = nullptr;
+    }
+}
+
+}  // namespace kvstore::net::client
@@ -0,0 +1,139 @@
+#include "kvstore/net/client/pipeline.hpp"
+
+#include <stdexcept>
+
+#include "kvstore/net/text_protocol.hpp"
+
+namespace kvstore::net::client {
+
+namespace {
+
+// "GET failed: ..." - what the matching Client call throws
+[[noreturn]] void throw_failed(const PipelineResult& result) {
+    throw std::runtime_error(TextProtocol::command_to_string(result.command) +
+                             " failed: " + result.data);
+}
+
+}  // namespace
+
+void PipelineResult::check() const {
+    if (status != Status::Ok) {
+        throw_failed(*this);
+    }
+}
+
+std::optional<std::string> PipelineResult::value() const {
+    if (status == Status::NotFound) {
+        return std::nullopt;
+    }
+    check();
+    return data;
+}
+
+bool PipelineResult::removed() const {
+    if (status == Status::NotFound) {
+        return false;
+    }
+    check();
+    return true;
+}
+
+bool PipelineResult::exists() const {
+    check();
+    return data == "1";
+}
+
+class Pipeline::Impl {
+   public:
+    explicit Impl(Client& client) : client_(&client) {}
+
+    void queue(const RequestView& request) {
+        client_->append_request(out_, request);
+        ends_.push_back(out_.size());
+        commands_.push_back(request.command);
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return commands_.size();
+    }
+
+    void clear() noexcept {
+        out_.clear();  // keeps its capacity for the next batch
+        ends_.clear();
+        commands_.clear();
+    }
+
+    std::vector<PipelineResult> execute() {
+        std::vector<PipelineResult> results;
+        results.reserve(commands_.size());
+        try {
+            std::size_t sent = 0;  // bytes of out_ written
+            std::size_t next = 0;  // the first call not written
+            while (next < ends_.size()) {
+                // whole calls up to kMaxWriteBytes - at least one, however large
+                std::size_t last = next + 1;
+                while (last < ends_.size() && ends_[last] - sent <= kMaxWriteBytes) {
+                    ++last;
+                }
+                std::string_view batch(out_.data() + sent, ends_[last - 1] - sent);
+                client_->write_encoded(batch);
+                for (; next < last; ++next) {
+                    Response resp = client_->read_response();
+                    results.push_back({commands_[next], resp.status, std::move(resp.data)});
+                }
+                sent = ends_[last - 1];
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+        clear();
+        return results;
+    }
+
+   private:
+    Client* client_;
+    std::string out_;                // the queued calls, encoded back to back
+    std::vector<std::size_t> ends_;  // where each call's bytes end in out_
+    std::vector<Command> commands_;
+};
+
+// PIMPL INTERFACE ------------------------------------------------------------------------
+Pipeline::Pipeline(Client& client) : impl_(std::make_unique<Impl>(client)) {}
+Pipeline::~Pipeline() = default;
+Pipeline::Pipeline(Pipeline&&) noexcept = default;
+Pipeline& Pipeline::operator=(Pipeline&&) noexcept = default;
+Pipeline& Pipeline::put(std::string_view key, std::string_view value) {
+    impl_->queue({Command::Put, key, value, 0});
+    return *this;
+}
+Pipeline& Pipeline::put(std::string_view key, std::string_view value, util::Duration ttl) {
+    impl_->queue({Command::PutEx, key, value, ttl.count()});
+    return *this;
+}
+Pipeline& Pipeline::get(std::string_view key) {
+    impl_->queue({Command::Get, key, {}, 0});
+    return *this;
+}
+Pipeline& Pipeline::remove(std::string_view key) {
+    impl_->queue({Command::Del, key, {}, 0});
+    return *this;
+}
+Pipeline& Pipeline::contains(std::string_view key) {
+    impl_->queue({Command::Exists, key, {}, 0});
+    return *this;
+}
+std::size_t Pipeline::size() const noexcept {
+    return impl_->size();
+}
+bool Pipeline::empty() const noexcept {
+    return impl_->size() == 0;
+}
+void Pipeline::clear() noexcept {
+    impl_->clear();
+}
+std::vector<PipelineResult> Pipeline::execute() {
+    return impl_->execute();
+}
+
+}  // namespace kvstore::net::client
@@ -1,83 +1,98 @@
 #include "kvstore/net/client/protocol_handler.hpp"
 
-#include <sys/socket.h>
+#include <cstring>
 
 #include "kvstore/net/binary_protocol.hpp"
 #include "kvstore/net/text_protocol.hpp"
+#include "kvstore/util/binary_io.hpp"
 
 namespace kvstore::net::client {
 
-namespace {
+namespace util = kvstore::util;
 
-bool send_all(int fd, const void* data, size_t len) {
-    const uint8_t* ptr = static_cast<const uint8_t*>(data);
-    size_t total_sent = 0;
-    while (total_sent < len) {
-        ssize_t sent = send(fd, ptr + total_sent, len - total_sent, 0);
-        if (sent <= 0) {
-            return false;
-        }
-        total_sent += sent;
+bool TextProtocolHandler::write_request(BufferedConnection& conn, const RequestView& request) {
+    EncodedRequest encoded;
+    TextProtocol::encode_request(request, encoded);
+    return conn.write(encoded.view());
+}
+
+void TextProtocolHandler::append_request(std::string& out, const RequestView& request) {
+    EncodedRequest encoded;
+    TextProtocol::encode_request(request, encoded);
+    for (std::string_view piece : encoded.view()) {
+        out += piece;
     }
-    return true;
 }
 
-std::string read_line(int fd, std::string& buffer) {
-    char c;
+std::optional<Response> TextProtocolHandler::read_response(BufferedConnection& conn) {
+    ReadBuffer& in = conn.in();
     while (true) {
-        size_t pos = buffer.find('\n');
-        if (pos != std::string::npos) {
-            std::string line = buffer.substr(0, pos);
-            buffer.erase(0, pos + 1);
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            return line;
+        std::size_t consumed = 0;
+        if (auto resp = parse_response(in.data(), consumed)) {
+            in.consume(consumed);
+            return resp;
         }
-
-        ssize_t n = recv(fd, &c, 1, 0);
-        if (n <= 0) {
-            return "";
+        if (conn.fill() <= 0) {
+            return std::nullopt;
         }
-        buffer += c;
     }
 }
 
-}  // namespace
-
-bool TextProtocolHandler::write_request(int fd, const Request& request) {
-    std::string data = TextProtocol::encode_request(request);
-    return send_all(fd, data.data(), data.size());
-}
-
-std::optional<Response> TextProtocolHandler::read_response(int fd) {
-    std::string line = read_line(fd, buffer_);
-    if (line.empty() && buffer_.empty()) {
+std::optional<Response> TextProtocolHandler::parse_response(std::string_view data,
+                                                            std::size_t& consumed) {
+    const void* newline = std::memchr(data.data(), '\n', data.size());
+    if (newline == nullptr) {
         return std::nullopt;
     }
+    auto pos = static_cast<std::size_t>(static_cast<const char*>(newline) - data.data());
+    consumed = pos + 1;
+    std::string_view line = data.substr(0, pos);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
     return TextProtocol::decode_response(line);
 }
 
-bool BinaryProtocolHandler::write_request(int fd, const Request& request) {
-    auto data = BinaryProtocol::encode_request(request);
-    return send_all(fd, data.data(), data.size());
+bool BinaryProtocolHandler::write_request(BufferedConnection& conn, const RequestView& request) {
+    EncodedRequest encoded;
+    BinaryProtocol::encode_request(request, encoded);
+    return conn.write(encoded.view());
 }
 
-std::optional<Response> BinaryProtocolHandler::read_response(int fd) {
-    uint8_t chunk[256];
+void BinaryProtocolHandler::append_request(std::string& out, const RequestView& request) {
+    EncodedRequest encoded;
+    BinaryProtocol::encode_request(request, encoded);
+    for (std::string_view piece : encoded.view()) {
+        out += piece;
+    }
+}
 
-    while (!BinaryProtocol::has_complete_message(buffer_)) {
-        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
-        if (n <= 0) {
+std::optional<Response> BinaryProtocolHandler::read_response(BufferedConnection& conn) {
+    ReadBuffer& in = conn.in();
+    while (true) {
+        std::string_view data = in.data();
+        std::size_t consumed = 0;
+        if (auto resp = parse_response(data, consumed)) {
+            in.consume(consumed);
+            return resp;
+        }
+        // once the length is in, make room for the whole response: a large value then grows the
+        // buffer once instead of doubling its way up
+        std::size_t missing = 1;
+        if (data.size() >= 4) {
+            auto length = util::read_int<uint32_t>(reinterpret_cast<const uint8_t*>(data.data()));
+            missing = 4 + static_cast<std::size_t>(length) - data.size();
+        }
+        if (conn.fill(missing) <= 0) {
             return std::nullopt;
         }
-        buffer_.insert(buffer_.end(), chunk, chunk + n);
     }
+}
 
-    size_t consumed = 0;
-    auto resp = BinaryProtocol::decode_response(buffer_, consumed);
-    buffer_.erase(buffer_.begin(), buffer_.begin() + consumed);
-    return resp;
+std::optional<Response> BinaryProtocolHandler::parse_response(std::string_view data,
+                                                              std::size_t& consumed) {
+    return BinaryProtocol::decode_response(reinterpret_cast<const uint8_t*>(data.data()),
+                                           data.size(), consumed);
 }
 
 std::unique_ptr<IProtocolHandler> create_protocol_handler(bool binary) {
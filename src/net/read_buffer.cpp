@@ -0,0 +1,89 @@
+#include "kvstore/net/read_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace kvstore::net {
+
+ReadBuffer::ReadBuffer(std::size_t base_capacity)
+    : base_capacity_(std::max<std::size_t>(base_capacity, 1)) {}
+
+std::span<char> ReadBuffer::prepare(std::size_t min_free) {
+    min_free = std::max<std::size_t>(min_free, 1);
+    if (!buffer_) {
+        reallocate(std::max({base_capacity_, target_capacity_, min_free}));
+    } else if (drained_) {
+        // a whole round of small reads since the last drain: back to the base size
+        drained_ = false;
+        if (!big_reads_ && capacity_ > base_capacity_) {
+            target_capacity_ = base_capacity_;
+            reallocate(std::max(base_capacity_, min_free));
+        }
+        big_reads_ = false;
+    }
+
+    std::size_t wanted = std::max(capacity_, target_capacity_);
+    if (size() + min_free > wanted) {
+        // a request larger than the buffer: grow to fit, doubling so a huge one takes few steps
+        wanted = std::max(size() + min_free, capacity_ * 2);
+        big_reads_ = true;
+    }
+
+    if (wanted > capacity_) {
+        reallocate(wanted);
+    } else if (capacity_ - end_ < min_free) {
+        // the partial request at the back goes to the front - a few bytes, not the buffer
+        std::memmove(buffer_.get(), buffer_.get() + begin_, size());
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    offered_ = capacity_ - end_;
+    return {buffer_.get() + end_, offered_};
+}
+
+void ReadBuffer::commit(std::size_t n) noexcept {
+    end_ += n;
+    if (n > 0 && n == offered_ && capacity_ < kMaxAdaptiveCapacity) {
+        // the read filled everything offered: the socket likely had more
+        target_capacity_ = std::min(capacity_ * 2, kMaxAdaptiveCapacity);
+        big_reads_ = true;
+    }
+    offered_ = 0;
+}
+
+void ReadBuffer::append(std::string_view bytes) {
+    if (bytes.empty()) {
+        return;
+    }
+    std::span<char> space = prepare(bytes.size());
+    std::memcpy(space.data(), bytes.data(), bytes.size());
+    // a copy fills what it needs, not what it was offered - that says nothing about the socket
+    offered_ = 0;
+    commit(bytes.size());
+}
+
+void ReadBuffer::consume(std::size_t n) noexcept {
+    begin_ += std::min(n, size());
+    if (begin_ == end_) {
+        clear();
+    }
+}
+
+void ReadBuffer::clear() noexcept {
+    begin_ = 0;
+    end_ = 0;
+    drained_ = true;
+}
+
+void ReadBuffer::reallocate(std::size_t capacity) {
+    auto buffer = std::make_unique_for_overwrite<char[]>(capacity);
+    if (size() > 0) {
+        std::memcpy(buffer.get(), buffer_.get() + begin_, size());
+    }
+    end_ -= begin_;
+    begin_ = 0;
+    buffer_ = std::move(buffer);
+    capacity_ = capacity;
+}
+
+}  // namespace kvstore::net
@@ -0,0 +1,556 @@
+#include "kvstore/net/server/event_loop.hpp"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "kvstore/net/read_buffer.hpp"
+#include "kvstore/net/server/protocol_handler.hpp"
+#include "kvstore/util/logger.hpp"
+
+namespace kvstore::net::server {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// a read is offered at least this much free space. the buffer adapts up from there
+constexpr std::size_t kMinReadSpace = 4 * 1024;
+// stop reading a connection while this much of its output is still queued
+constexpr std::size_t kMaxPendingOutput = 1024 * 1024;
+// pipelined requests answered with one handle_batch call at most
+constexpr std::size_t kMaxRun = 64;
+constexpr int kMaxEvents = 256;
+constexpr int kSweepIntervalMs = 1000;
+
+// epoll_event.data.ptr tags for the two fds that are not connections
+char listen_tag;
+char wake_tag;
+
+// one piece of queued output: bytes, or a file region that goes out with sendfile
+struct OutChunk {
+    std::string bytes;
+    std::optional<core::ValueRegion> region;
+    uint64_t sent = 0;
+
+    [[nodiscard]] uint64_t size() const {
+        return region ? region->size() : bytes.size();
+    }
+};
+
+struct Connection {
+    explicit Connection(int fd_) : fd(fd_), last_active(SteadyClock::now()) {}
+
+    int fd;
+    std::unique_ptr<IProtocolHandler> protocol;  // picked from the first byte
+    ReadBuffer in;                               // bytes not yet a complete request
+    std::deque<OutChunk> out;
+    std::size_t out_bytes = 0;  // unsent bytes in out
+    uint32_t interest = 0;      // what epoll watches for now
+    bool closing = false;       // QUIT: close once out is sent
+    bool peer_closed = false;   // read side hit EOF
+    SteadyClock::time_point last_active;
+};
+
+// the state every reactor shares
+struct Shared {
+    int listen_fd = -1;
+    int wake_fd = -1;
+    RequestHandler* handler = nullptr;
+    EventLoopOptions options;
+    std::atomic<bool> running{false};
+    std::atomic<std::size_t> connections{0};
+};
+
+class Reactor {
+   public:
+    explicit Reactor(Shared& shared) : shared_(shared) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            throw std::runtime_error("epoll_create1 failed: " + std::string(strerror(errno)));
+        }
+        epoll_event ev{};
+        // EPOLLEXCLUSIVE: a new connection wakes one of the reactors, not all of them
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.ptr = &listen_tag;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, shared_.listen_fd, &ev) < 0) {
+            int err = errno;
+            close(epoll_fd_);
+            throw std::runtime_error("epoll_ctl(listen) failed: " + std::string(strerror(err)));
+        }
+        // the wake eventfd is never read: once stop() writes it, it stays readable and wakes
+        // every reactor
+        ev.events = EPOLLIN;
+        ev.data.ptr = &wake_tag;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, shared_.wake_fd, &ev) < 0) {
+            int err = errno;
+            close(epoll_fd_);
+            throw std::runtime_error("epoll_ctl(wake) failed: " + std::string(strerror(err)));
+        }
+    }
+
+    ~Reactor() {
+        for (auto& [fd, conn] : connections_) {
+            close(fd);
+            shared_.connections.fetch_sub(1);
+        }
+        close(epoll_fd_);
+    }
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // read by stop() once the reactor thread is joined
+    [[nodiscard]] const ServerStats& stats() const noexcept {
+        return stats_;
+    }
+
+    void run() {
+        epoll_event events[kMaxEvents];
+        auto next_sweep = SteadyClock::now() + std::chrono::milliseconds(kSweepIntervalMs);
+
+        while (shared_.running) {
+            ++stats_.syscalls;
+            int n = epoll_wait(epoll_fd_, events, kMaxEvents, kSweepIntervalMs);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERROR("epoll_wait failed: " + std::string(strerror(errno)));
+                break;
+            }
+
+            for (int i = 0; i < n; ++i) {
+                void* tag = events[i].data.ptr;
+                if (tag == &wake_tag) {
+                    continue;  // running is false now, the loop ends below
+                }
+                if (tag == &listen_tag) {
+                    accept_all();
+                    continue;
+                }
+                // one event per fd per epoll_wait, so a connection closed here is never seen
+                // again in this batch
+                service(*static_cast<Connection*>(tag), events[i].events);
+            }
+
+            auto now = SteadyClock::now();
+            if (now >= next_sweep) {
+                close_idle(now);
+                next_sweep = now + std::chrono::milliseconds(kSweepIntervalMs);
+            }
+        }
+    }
+
+   private:
+    void accept_all() {
+        while (true) {
+            ++stats_.syscalls;
+            int fd = accept4(shared_.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK && shared_.running) {
+                    // EMFILE and friends: leave the rest in the backlog until an fd frees up
+                    LOG_ERROR("Accept failed: " + std::string(strerror(errno)));
+                }
+                return;
+            }
+
+            if (shared_.connections.fetch_add(1) >= shared_.options.max_connections) {
+                shared_.connections.fetch_sub(1);
+                ++stats_.syscalls;
+                close(fd);
+                LOG_WARN("connection limit reached, closing new connection");
+                continue;
+            }
+
+            auto conn = std::make_unique<Connection>(fd);
+            conn->interest = EPOLLIN | EPOLLRDHUP;
+            epoll_event ev{};
+            ev.events = conn->interest;
+            ev.data.ptr = conn.get();
+            ++stats_.syscalls;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                LOG_ERROR("epoll_ctl(add) failed: " + std::string(strerror(errno)));
+                shared_.connections.fetch_sub(1);
+                close(fd);
+                continue;
+            }
+            LOG_DEBUG("Client connected, fd=" + std::to_string(fd));
+            connections_.emplace(fd, std::move(conn));
+        }
+    }
+
+    void service(Connection& conn, uint32_t events) {
+        if ((events & EPOLLERR) != 0) {
+            close_connection(conn);
+            return;
+        }
+        try {
+            if ((events & EPOLLIN) != 0) {
+                read_input(conn);
+            }
+            if ((events & (EPOLLHUP | EPOLLRDHUP)) != 0) {
+                // still read whatever arrived before the FIN, on the next event
+                conn.peer_closed = conn.peer_closed || (events & EPOLLIN) == 0;
+            }
+            // answer until the input runs out or the output backs up. after a flush empties
+            // the queue there may be requests left over from a backed up round
+            while (true) {
+                bool more = process_input(conn);
+                if (!flush(conn)) {
+                    close_connection(conn);
+                    return;
+                }
+                if (!more || conn.out_bytes >= kMaxPendingOutput) {
+                    break;
+                }
+            }
+        } catch (const std::exception& e) {
+            // a malformed request: the stream cant be resynced
+            LOG_ERROR("Client handle error: " + std::string(e.what()));
+            close_connection(conn);
+            return;
+        }
+
+        if (conn.out.empty() && (conn.closing || conn.peer_closed)) {
+            close_connection(conn);
+            return;
+        }
+        update_interest(conn);
+    }
+
+    void read_input(Connection& conn) {
+        // one recv per wakeup: epoll is level-triggered, so whatever is left wakes us again, and
+        // one busy connection cant starve the others
+        std::span<char> space = conn.in.prepare(kMinReadSpace);
+        ++stats_.syscalls;
+        ssize_t n = recv(conn.fd, space.data(), space.size(), 0);
+        conn.in.commit(n > 0 ? static_cast<std::size_t>(n) : 0);
+        if (n > 0) {
+            conn.last_active = SteadyClock::now();
+        } else if (n == 0) {
+            conn.peer_closed = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            conn.peer_closed = true;
+            conn.in.clear();
+        }
+    }
+
+    // answers every complete request in conn.in. true = stopped with requests possibly left,
+    // because the output backed up
+    bool process_input(Connection& conn) {
+        if (conn.in.empty() || conn.closing) {
+            return false;
+        }
+        if (!conn.protocol) {
+            conn.protocol = shared_.options.binary_only
+                                ? std::make_unique<BinaryProtocolHandler>()
+                                : protocol_handler_for(static_cast<uint8_t>(conn.in.data()[0]));
+        }
+
+        // the run points into conn.in: nothing is consumed until it is answered
+        std::string_view data = conn.in.data();
+        std::size_t pos = 0;
+        bool backed_up = false;
+        while (!conn.closing) {
+            if (conn.out_bytes >= kMaxPendingOutput) {
+                backed_up = true;
+                break;
+            }
+            // a run of requests for one handle_batch, cut at QUIT. large values come back from it
+            // as file regions, in order with the rest
+            run_.clear();
+            while (run_.size() < kMaxRun) {
+                std::size_t consumed = 0;
+                auto request = conn.protocol->parse_request(data.substr(pos), consumed);
+                if (!request) {
+                    break;
+                }
+                pos += consumed;
+                ++stats_.requests;
+                run_.push_back(*request);
+                if (request->command == Command::Quit) {
+                    break;
+                }
+            }
+            if (run_.empty()) {
+                break;
+            }
+            answer(conn);
+        }
+        conn.in.consume(pos);
+        return backed_up;
+    }
+
+    void answer(Connection& conn) {
+        responses_.clear();
+        regions_.clear();
+        shared_.handler->handle_batch(run_, responses_, &regions_);
+        for (std::size_t i = 0; i < responses_.size(); ++i) {
+            const Response& response = responses_[i];
+            if (regions_[i]) {
+                answer_from_file(conn, std::move(*regions_[i]));
+                continue;
+            }
+            std::string& buf = tail_bytes(conn);
+            std::size_t before = buf.size();
+            conn.protocol->append_response(buf, response);
+            conn.out_bytes += buf.size() - before;
+            if (response.close_connection) {
+                conn.closing = true;
+            }
+        }
+    }
+
+    void answer_from_file(Connection& conn, core::ValueRegion region) {
+        FileValueFraming framing = conn.protocol->file_value_framing(region.size());
+        append_bytes(conn, framing.prefix);
+        conn.out_bytes += region.size();
+        conn.out.push_back(OutChunk{{}, std::move(region), 0});
+        append_bytes(conn, framing.suffix);
+    }
+
+    // the byte chunk at the end of the queue, so consecutive responses share one send
+    static std::string& tail_bytes(Connection& conn) {
+        if (conn.out.empty() || conn.out.back().region) {
+            conn.out.emplace_back();
+        }
+        return conn.out.back().bytes;
+    }
+
+    static void append_bytes(Connection& conn, const std::string& bytes) {
+        if (bytes.empty()) {
+            return;
+        }
+        tail_bytes(conn) += bytes;
+        conn.out_bytes += bytes.size();
+    }
+
+    // sends as much of the queue as the socket takes. false = connection broken
+    bool flush(Connection& conn) {
+        while (!conn.out.empty()) {
+            OutChunk& chunk = conn.out.front();
+            uint64_t remaining = chunk.size() - chunk.sent;
+            ssize_t n;
+            ++stats_.syscalls;
+            if (chunk.region) {
+                off_t offset = static_cast<off_t>(chunk.region->offset() + chunk.sent);
+                n = sendfile(conn.fd, chunk.region->fd(), &offset, remaining);
+                if (n == 0) {
+                    return false;  // the file is shorter than the region: response half sent
+                }
+            } else {
+                // MSG_MORE before a file region: header and first value bytes share a segment
+                int flags = MSG_NOSIGNAL;
+                if (conn.out.size() > 1 && conn.out[1].region) {
+                    flags |= MSG_MORE;
+                }
+                n = send(conn.fd, chunk.bytes.data() + chunk.sent, remaining, flags);
+            }
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            conn.last_active = SteadyClock::now();
+            chunk.sent += static_cast<uint64_t>(n);
+            conn.out_bytes -= static_cast<std::size_t>(n);
+            if (chunk.sent == chunk.size()) {
+                conn.out.pop_front();
+            }
+        }
+        return true;
+    }
+
+    void update_interest(Connection& conn) {
+        // after EOF, EPOLLRDHUP would fire on every wait (level-triggered) - only EPOLLOUT is
+        // interesting then
+        uint32_t interest = conn.peer_closed ? 0u : static_cast<uint32_t>(EPOLLRDHUP);
+        if (!conn.closing && !conn.peer_closed && conn.out_bytes < kMaxPendingOutput) {
+            interest |= EPOLLIN;
+        }
+        if (!conn.out.empty()) {
+            interest |= EPOLLOUT;
+        }
+        if (interest == conn.interest) {
+            return;
+        }
+        epoll_event ev{};
+        ev.events = interest;
+        ev.data.ptr = &conn;
+        ++stats_.syscalls;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev) < 0) {
+            LOG_ERROR("epoll_ctl(mod) failed: " + std::string(strerror(errno)));
+            close_connection(conn);
+            return;
+        }
+        conn.interest = interest;
+    }
+
+    void close_idle(SteadyClock::time_point now) {
+        if (shared_.options.client_timeout_seconds <= 0) {
+            return;
+        }
+        auto timeout = std::chrono::seconds(shared_.options.client_timeout_seconds);
+        std::vector<Connection*> idle;
+        for (auto& [fd, conn] : connections_) {
+            if (now - conn->last_active > timeout) {
+                idle.push_back(conn.get());
+            }
+        }
+        for (Connection* conn : idle) {
+            LOG_DEBUG("Closing idle client, fd=" + std::to_string(conn->fd));
+            close_connection(*conn);
+        }
+    }
+
+    // conn is gone after this
+    void close_connection(Connection& conn) {
+        int fd = conn.fd;
+        // closing the fd drops it from the epoll set
+        ++stats_.syscalls;
+        close(fd);
+        connections_.erase(fd);
+        shared_.connections.fetch_sub(1);
+        LOG_DEBUG("Client disconnected, fd=" + std::to_string(fd));
+    }
+
+    Shared& shared_;
+    ServerStats stats_;
+    int epoll_fd_ = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    // process_input's current run (views into a connection's read buffer) and its answers, kept
+    // to reuse the allocations
+    std::vector<RequestView> run_;
+    std::vector<Response> responses_;
+    std::vector<std::optional<core::ValueRegion>> regions_;  // one per response: sendfile it
+};
+
+}  // namespace
+
+class EventLoop::Impl {
+   public:
+    Impl(int listen_fd, RequestHandler& handler, const EventLoopOptions& options) {
+        shared_.listen_fd = listen_fd;
+        shared_.handler = &handler;
+        shared_.options = options;
+        if (shared_.options.threads == 0) {
+            shared_.options.threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    ~Impl() {
+        stop();
+    }
+
+    void start() {
+        if (shared_.running) {
+            return;
+        }
+        int flags = fcntl(shared_.listen_fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(shared_.listen_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            throw std::runtime_error("failed to make listening socket non-blocking: " +
+                                     std::string(strerror(errno)));
+        }
+        shared_.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (shared_.wake_fd < 0) {
+            throw std::runtime_error("eventfd failed: " + std::string(strerror(errno)));
+        }
+
+        try {
+            for (std::size_t i = 0; i < shared_.options.threads; ++i) {
+                reactors_.push_back(std::make_unique<Reactor>(shared_));
+            }
+        } catch (...) {
+            reactors_.clear();
+            close(shared_.wake_fd);
+            shared_.wake_fd = -1;
+            throw;
+        }
+
+        shared_.running = true;
+        for (auto& reactor : reactors_) {
+            threads_.emplace_back(&Reactor::run, reactor.get());
+        }
+    }
+
+    void stop() {
+        if (!shared_.running.exchange(false)) {
+            return;
+        }
+        uint64_t one = 1;
+        (void)!write(shared_.wake_fd, &one, sizeof(one));
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+        for (auto& reactor : reactors_) {
+            stats_.requests += reactor->stats().requests;
+            stats_.syscalls += reactor->stats().syscalls;
+        }
+        reactors_.clear();  // closes their connections
+        close(shared_.wake_fd);
+        shared_.wake_fd = -1;
+    }
+
+    [[nodiscard]] std::size_t threads() const noexcept {
+        return shared_.options.threads;
+    }
+
+    [[nodiscard]] std::size_t connections() const noexcept {
+        return shared_.connections.load();
+    }
+
+    [[nodiscard]] ServerStats stats() const noexcept {
+        return stats_;
+    }
+
+   private:
+    Shared shared_;
+    ServerStats stats_;
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::vector<std::thread> threads_;
+};
+
+// PIMPL INTERFACE -------------------------------------------------------------------------------
+EventLoop::EventLoop(int listen_fd, RequestHandler& handler, const EventLoopOptions& options)
+    : impl_(std::make_unique<Impl>(listen_fd, handler, options)) {}
+EventLoop::~EventLoop() = default;
+void EventLoop::start() {
+    impl_->start();
+}
+void EventLoop::stop() {
+    impl_->stop();
+}
+std::size_t EventLoop::threads() const noexcept {
+    return impl_->threads();
+}
+std::size_t EventLoop::connections() const noexcept {
+    return impl_->connections();
+}
+ServerStats EventLoop::stats() const noexcept {
+    return impl_->stats();
+}
+
+}  // namespace kvstore::net::server
@@ -2,82 +2,135 @@
 
 #include <sys/socket.h>
 
+#include <cstring>
+
 #include "kvstore/net/binary_protocol.hpp"
 #include "kvstore/net/text_protocol.hpp"
+#include "kvstore/util/binary_io.hpp"
 
 namespace kvstore::net::server {
-namespace {
-
-bool send_all(int fd, const void* data, size_t len) {
-    const uint8_t* ptr = static_cast<const uint8_t*>(data);
-    size_t total_sent = 0;
-    while (total_sent < len) {
-        ssize_t sent = send(fd, ptr + total_sent, len - total_sent, MSG_NOSIGNAL);
-        if (sent <= 0) {
-            return false;
-        }
-        total_sent += sent;
+
+namespace util = kvstore::util;
+
+BufferedConnection& IProtocolHandler::connection(int fd) noexcept {
+    if (conn_.fd() != fd) {
+        conn_.reset(fd);
     }
-    return true;
+    return conn_;
 }
 
-std::string read_line(int fd, std::string& buffer) {
-    char chunk[1024];
-
+std::span<const RequestView> IProtocolHandler::read_requests(int fd) {
+    BufferedConnection& conn = connection(fd);
+    ReadBuffer& in = conn.in();
+    requests_.clear();
     while (true) {
-        size_t pos = buffer.find('\n');
-        if (pos != std::string::npos) {
-            std::string line = buffer.substr(0, pos);
-            buffer.erase(0, pos + 1);
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
+        // the bytes of what we hand out stay in the buffer until the next call: consuming doesnt
+        // move them, only the next read (prepare) does
+        std::string_view data = in.data();
+        std::size_t pos = 0;
+        while (pos < data.size()) {
+            std::size_t consumed = 0;
+            std::optional<RequestView> request;
+            try {
+                request = parse_request(data.substr(pos), consumed);
+            } catch (...) {
+                if (requests_.empty()) {
+                    throw;
+                }
+                break;  // answer the good ones first, the next call throws
             }
-            return line;
+            if (!request) {
+                break;
+            }
+            requests_.push_back(*request);
+            pos += consumed;
+        }
+        in.consume(pos);
+        if (!requests_.empty()) {
+            return requests_;
         }
-        ssize_t n = recv(fd, chunk, sizeof(chunk) - 1, 0);
-        if (n <= 0) {
-            return "";
+        if (conn.fill() <= 0) {
+            return requests_;
         }
-        chunk[n] = '\0';
-        buffer += chunk;
     }
 }
 
-}  // namespace
+void IProtocolHandler::queue_response(const Response& response) {
+    append_response(out_, response);
+}
 
-std::optional<Request> TextProtocolHandler::read_request(int fd) {
-    std::string line = read_line(fd, buffer_);
-    if (line.empty() && buffer_.empty()) {
-        return std::nullopt;
-    }
-    return TextProtocol::decode_request(line);
+bool IProtocolHandler::queue_file_value(int fd, int file_fd, uint64_t offset, std::size_t size) {
+    BufferedConnection& conn = connection(fd);
+    FileValueFraming framing = file_value_framing(size);
+    // MSG_MORE: the queued responses and the framing leave in one segment with the first bytes
+    // of the value
+    const std::string_view pieces[] = {out_, framing.prefix};
+    bool sent = conn.write(pieces, MSG_MORE) && conn.send_file(file_fd, offset, size);
+    out_ = std::move(framing.suffix);
+    return sent;
 }
 
-bool TextProtocolHandler::write_response(int fd, const Response& response) {
-    std::string data = TextProtocol::encode_response(response);
-    return send_all(fd, data.data(), data.size());
+bool IProtocolHandler::flush(int fd) {
+    bool sent = connection(fd).write(out_);
+    out_.clear();
+    return sent;
 }
 
-std::optional<Request> BinaryProtocolHandler::read_request(int fd) {
-    uint8_t chunk[1024];
+bool IProtocolHandler::write_response(int fd, const Response& response) {
+    queue_response(response);
+    return flush(fd);
+}
 
-    while (!BinaryProtocol::has_complete_message(buffer_)) {
-        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
-        if (n <= 0) {
-            return std::nullopt;
-        }
-        buffer_.insert(buffer_.end(), chunk, chunk + n);
+bool IProtocolHandler::write_file_value(int fd, int file_fd, uint64_t offset, std::size_t size) {
+    return queue_file_value(fd, file_fd, offset, size) && flush(fd);
+}
+
+std::optional<RequestView> TextProtocolHandler::parse_request(std::string_view data,
+                                                              std::size_t& consumed) {
+    const void* newline = std::memchr(data.data(), '\n', data.size());
+    if (newline == nullptr) {
+        return std::nullopt;
     }
+    std::size_t pos = static_cast<std::size_t>(static_cast<const char*>(newline) - data.data());
+    consumed = pos + 1;
+    return TextProtocol::decode_request_view(data.substr(0, pos));  // a '\r' is whitespace to it
+}
+
+void TextProtocolHandler::append_response(std::string& out, const Response& response) {
+    out += TextProtocol::encode_response(response);
+}
+
+FileValueFraming TextProtocolHandler::file_value_framing(std::size_t /*size*/) {
+    // same bytes as encode_response(Response::ok(value)): "OK <value>\n"
+    return {"OK ", "\n"};
+}
 
-    size_t consumed = 0;
-    auto req = BinaryProtocol::decode_request(buffer_, consumed);
-    buffer_.erase(buffer_.begin(), buffer_.begin() + consumed);
-    return req;
+std::optional<RequestView> BinaryProtocolHandler::parse_request(std::string_view data,
+                                                                std::size_t& consumed) {
+    return BinaryProtocol::decode_request_view(reinterpret_cast<const uint8_t*>(data.data()),
+                                               data.size(), consumed);
 }
 
-bool BinaryProtocolHandler::write_response(int fd, const Response& response) {
+void BinaryProtocolHandler::append_response(std::string& out, const Response& response) {
     auto data = BinaryProtocol::encode_response(response);
-    return send_all(fd, data.data(), data.size());
+    out.append(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+FileValueFraming BinaryProtocolHandler::file_value_framing(std::size_t size) {
+    // same bytes as encode_response(Response::ok(value)): [len][status][value len][value]
+    std::vector<uint8_t> header;
+    header.reserve(9);
+    util::write_int<uint32_t>(header, static_cast<uint32_t>(1 + 4 + size));
+    util::write_int<uint8_t>(header, static_cast<uint8_t>(Status::Ok));
+    util::write_int<uint32_t>(header, static_cast<uint32_t>(size));
+    return {std::string(header.begin(), header.end()), ""};
+}
+
+std::unique_ptr<IProtocolHandler> protocol_handler_for(uint8_t first_byte) {
+    if (first_byte == 0x00 || first_byte > 127) {
+        return std::make_unique<BinaryProtocolHandler>();
+    }
+    return std::make_unique<TextProtocolHandler>();
 }
 
 std::unique_ptr<IProtocolHandler> create_protocol_handler(int fd, bool force_binary) {
@@ -91,12 +144,7 @@ std::unique_ptr<IProtocolHandler> create_protocol_handler(int fd, bool force_bin
     if (n <= 0) {
         return nullptr;
     }
-
-    if (first_byte == 0x00 || first_byte > 127) {
-        return std::make_unique<BinaryProtocolHandler>();
-    }
-
-    return std::make_unique<TextProtocolHandler>();
+    return protocol_handler_for(first_byte);
 }
 
-}  // namespace kvstore::net::server
\ No newline at end of file
+}  // namespace kvstore::net::server
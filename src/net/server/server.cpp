@@ -9,12 +9,17 @@
 #include <atomic>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <thread>
 #include <vector>
 
+#include "kvstore/core/disk_store.hpp"
+#include "kvstore/net/server/event_loop.hpp"
 #include "kvstore/net/server/protocol_handler.hpp"
+#include "kvstore/net/server/uring_loop.hpp"
 #include "kvstore/util/logger.hpp"
 #include "kvstore/util/types.hpp"
 
@@ -40,13 +45,19 @@ struct SigpipeIgnorer {
 
 static SigpipeIgnorer sigpipe_ignorer;
 
+// thread per connection: queued responses of a pipelined batch are sent once they reach this
+constexpr std::size_t kMaxQueuedOutput = 256 * 1024;
+// pipelined requests answered with one handle_batch call at most
+constexpr std::size_t kMaxRun = 64;
+
 }  // namespace
 
-class Server::Impl {
+class Server::Impl : public RequestHandler {
    public:
-    Impl(core::IStore& store, const ServerOptions& options) : store_(store), options_(options) {}
+    Impl(core::IStore& store, const ServerOptions& options)
+        : store_(store), options_(options), disk_store_(dynamic_cast<core::DiskStore*>(&store)) {}
 
-    ~Impl() {
+    ~Impl() override {
         stop();
     }
     /*
@@ -133,10 +144,23 @@ class Server::Impl {
             throw std::runtime_error("failed to listen: " + std::string(strerror(errno)));
         }
 
-        // set running flag, spawn thread to accept connections
         server_fd_.store(fd);
-        running_ = true;
-        accept_thread_ = std::thread(&Impl::accept_loop, this);
+        if (options_.mode != ServerMode::ThreadPerConnection) {
+            try {
+                start_loop(fd);
+            } catch (...) {
+                uring_loop_.reset();
+                event_loop_.reset();
+                server_fd_.store(-1);
+                close(fd);
+                throw;
+            }
+            running_ = true;
+        } else {
+            // set running flag, spawn thread to accept connections
+            running_ = true;
+            accept_thread_ = std::thread(&Impl::accept_loop, this);
+        }
 
         LOG_INFO("Server started on " + options_.host + ":" + std::to_string(options_.port));
     }
@@ -150,6 +174,18 @@ class Server::Impl {
 
         LOG_INFO("Server stopping...");
 
+        // reactors first: they poll the listening socket
+        if (uring_loop_) {
+            uring_loop_->stop();
+            add_stats(uring_loop_->stats());
+            uring_loop_.reset();
+        }
+        if (event_loop_) {
+            event_loop_->stop();
+            add_stats(event_loop_->stats());
+            event_loop_.reset();
+        }
+
         int fd = server_fd_.exchange(-1);
         // shutdown stops reads and writes, unblocking any threads stuck in accept()
         // close releases fd
@@ -184,7 +220,42 @@ class Server::Impl {
         return actual_port_;
     }
 
+    [[nodiscard]] ServerStats stats() const noexcept {
+        return {requests_.load(), syscalls_.load()};
+    }
+
    private:
+    // IoUring if the kernel has it, else (or if its rings fail to set up) EventLoop
+    void start_loop(int fd) {
+        EventLoopOptions loop_options;
+        loop_options.threads = options_.reactor_threads;
+        loop_options.max_connections = options_.max_connections;
+        loop_options.client_timeout_seconds = options_.client_timeout_seconds;
+        loop_options.binary_only = options_.binary_only;
+
+        if (options_.mode == ServerMode::IoUring) {
+            if (UringLoop::supported()) {
+                try {
+                    uring_loop_ = std::make_unique<UringLoop>(fd, *this, loop_options);
+                    uring_loop_->start();
+                    return;
+                } catch (const std::exception& e) {
+                    uring_loop_.reset();
+                    LOG_WARN(std::string(e.what()) + " - serving clients from the epoll loop");
+                }
+            } else {
+                LOG_WARN("io_uring networking not available - serving clients from the epoll loop");
+            }
+        }
+        event_loop_ = std::make_unique<EventLoop>(fd, *this, loop_options);
+        event_loop_->start();
+    }
+
+    void add_stats(const ServerStats& stats) {
+        requests_.fetch_add(stats.requests, std::memory_order_relaxed);
+        syscalls_.fetch_add(stats.syscalls, std::memory_order_relaxed);
+    }
+
     struct ClientInfo {
         std::thread thread;
         std::atomic<bool> finished{false};
@@ -212,6 +283,7 @@ class Server::Impl {
                 break;
             }
 
+            syscalls_.fetch_add(1, std::memory_order_relaxed);
             int client_fd =
                 accept(server_fd_, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
 
@@ -274,30 +346,65 @@ class Server::Impl {
     }
 
     void handle_client(int client_fd, ClientInfo* info) {
+        // this connection's share of stats(): the first-byte peek and the close, plus whatever
+        // the handler counted
+        ServerStats stats{0, 2};
+        std::unique_ptr<IProtocolHandler> handler;
         try {
-            auto handler = create_protocol_handler(client_fd, options_.binary_only);
+            handler = create_protocol_handler(client_fd, options_.binary_only);
             if (!handler) {
                 close(client_fd);
+                add_stats(stats);
                 info->finished.store(true);
                 return;
             }
             // note: running_ is atomic<bool>. when you use atomic in a boolean context, it
             // implicitly calls load()
-            while (running_) {
-                auto request = handler->read_request(client_fd);
-                if (!request) {
+            bool open = true;
+            std::vector<Response> responses;
+            std::vector<std::optional<core::ValueRegion>> regions;
+            while (open && running_) {
+                // everything the client pipelined: answered in order, the responses go out with
+                // one send (a send per kMaxQueuedOutput if they are large)
+                auto requests = handler->read_requests(client_fd);
+                if (requests.empty()) {
                     break;
                 }
-                Response response;
-                try {
-                    response = process_request(*request);
-                } catch (const std::exception& e) {
-                    response = Response::error(std::string("internal error: ") + e.what());
-                } catch (...) {
-                    response = Response::error("internal error");
+                // runs of requests go to handle_batch, cut at QUIT. a large DiskStore value comes
+                // back as a file region and goes straight from its file to the socket
+                std::size_t run_begin = 0;
+                auto answer_run = [&](std::size_t run_end) {
+                    responses.clear();
+                    regions.clear();
+                    handle_batch(requests.subspan(run_begin, run_end - run_begin), responses,
+                                 &regions);
+                    for (std::size_t i = 0; open && i < responses.size(); ++i) {
+                        const Response& response = responses[i];
+                        if (const auto& region = regions[i]) {
+                            open = handler->queue_file_value(client_fd, region->fd(),
+                                                             region->offset(), region->size());
+                        } else {
+                            handler->queue_response(response);
+                            open = !response.close_connection;
+                        }
+                        if (open && handler->queued() >= kMaxQueuedOutput &&
+                            !handler->flush(client_fd)) {
+                            open = false;
+                        }
+                    }
+                    stats.requests += responses.size();
+                    run_begin = run_end;
+                };
+                for (std::size_t i = 0; open && i < requests.size(); ++i) {
+                    if (requests[i].command == Command::Quit || i + 1 - run_begin == kMaxRun) {
+                        answer_run(i + 1);
+                    }
                 }
-
-                if (!handler->write_response(client_fd, response) || response.close_connection) {
+                if (open && run_begin < requests.size()) {
+                    answer_run(requests.size());
+                }
+                // QUIT's BYE still goes out
+                if (!handler->flush(client_fd)) {
                     break;
                 }
             }
@@ -308,11 +415,118 @@ class Server::Impl {
         }
 
         close(client_fd);
+        if (handler) {
+            stats.syscalls += handler->syscalls();
+        }
+        add_stats(stats);
         info->finished.store(true);
         LOG_DEBUG("Client disconnected, fd=" + std::to_string(client_fd));
     }
 
-    Response process_request(const Request& req) {
+    Response handle(const RequestView& req) {
+        try {
+            return process_request(req);
+        } catch (const std::exception& e) {
+            return Response::error(std::string("internal error: ") + e.what());
+        } catch (...) {
+            return Response::error("internal error");
+        }
+    }
+
+    void handle_batch(std::span<const RequestView> requests, std::vector<Response>& responses,
+                      std::vector<std::optional<core::ValueRegion>>* regions) override {
+        // a GET of a DiskStore value past sendfile_threshold becomes a file region - found in the
+        // same index lookup as the small values, so even a lone GET goes through process_run
+        auto* file_regions =
+            disk_store_ != nullptr && options_.sendfile_threshold > 0 ? regions : nullptr;
+        std::size_t i = 0;
+        while (i < requests.size()) {
+            Command command = requests[i].command;
+            auto joins = [command](const RequestView& req) {
+                return req.command == command && !req.key.empty();
+            };
+            std::size_t end = i + 1;
+            if ((command == Command::Get || command == Command::Put) && joins(requests[i])) {
+                while (end < requests.size() && joins(requests[end])) {
+                    ++end;
+                }
+            }
+            bool region_get = file_regions != nullptr && command == Command::Get &&
+                              joins(requests[i]);
+            if (end - i == 1 && !region_get) {
+                responses.push_back(handle(requests[i]));
+                if (responses.back().close_connection) {
+                    break;
+                }
+            } else {
+                process_run(requests.subspan(i, end - i), responses, file_regions);
+            }
+            i = end;
+        }
+        if (regions != nullptr) {
+            regions->resize(responses.size());
+        }
+    }
+
+    // consecutive GETs -> one multi_get, consecutive PUTs -> one multi_put. regions: large
+    // DiskStore values are answered with their file region (sendfile), not read
+    void process_run(std::span<const RequestView> run, std::vector<Response>& responses,
+                     std::vector<std::optional<core::ValueRegion>>* regions) {
+        try {
+            if (run.front().command == Command::Get) {
+                std::vector<std::string_view> keys;
+                keys.reserve(run.size());
+                for (const RequestView& req : run) {
+                    keys.push_back(req.key);
+                }
+                if (regions != nullptr) {
+                    get_with_regions(keys, responses, *regions);
+                    return;
+                }
+                for (auto& value : store_.multi_get(keys)) {
+                    responses.push_back(value ? Response::ok(*value) : Response::not_found());
+                }
+            } else {
+                std::vector<core::KeyValue> entries;
+                entries.reserve(run.size());
+                for (const RequestView& req : run) {
+                    entries.push_back({req.key, req.value});
+                }
+                store_.multi_put(entries);
+                responses.insert(responses.end(), run.size(), Response::ok());
+            }
+        } catch (const std::exception& e) {
+            // where a batch failed is unknown: every request of it gets the error
+            responses.insert(responses.end(), run.size(),
+                             Response::error(std::string("internal error: ") + e.what()));
+        }
+    }
+
+    // regions gets one entry per response, the Ok placeholder of a file value included
+    void get_with_regions(std::span<const std::string_view> keys,
+                          std::vector<Response>& responses,
+                          std::vector<std::optional<core::ValueRegion>>& regions) {
+        std::vector<std::optional<core::ValueRegion>> found;
+        auto values = disk_store_->multi_get(keys, options_.sendfile_threshold, found);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (found[i] && found[i]->size() > std::numeric_limits<uint32_t>::max() - 5) {
+                // the binary protocol frames a response with a u32 length: read it instead
+                found[i].reset();
+                values[i] = store_.get(keys[i]);
+            }
+        }
+        regions.resize(responses.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (found[i]) {
+                responses.push_back(Response::ok());
+            } else {
+                responses.push_back(values[i] ? Response::ok(*values[i]) : Response::not_found());
+            }
+            regions.push_back(std::move(found[i]));
+        }
+    }
+
+    Response process_request(const RequestView& req) {
         switch (req.command) {
             case Command::Get: {
                 if (req.key.empty()) {
@@ -379,6 +593,7 @@ class Server::Impl {
 
     core::IStore& store_;
     ServerOptions options_;
+    core::DiskStore* disk_store_;  // store_ if it is a DiskStore - for the sendfile GET path
 
     uint16_t actual_port_{0};
 
@@ -388,6 +603,11 @@ class Server::Impl {
     std::atomic<bool> running_{false};
 
     std::thread accept_thread_;
+    std::unique_ptr<EventLoop> event_loop_;  // ServerMode::EventLoop, or IoUring falling back
+    std::unique_ptr<UringLoop> uring_loop_;  // ServerMode::IoUring
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> syscalls_{0};
 
     // important note: we use std::vector<std::unique_ptr<>> bceause vector reallocation will
     // invalidate address of stored objects. using a pointer alleviates this - heap objects have
@@ -414,5 +634,8 @@ bool Server::running() const noexcept {
 uint16_t Server::port() const noexcept {
     return impl_->port();
 }
+ServerStats Server::stats() const noexcept {
+    return impl_->stats();
+}
 
 }  // namespace kvstore::net::server
\ No newline at end of file
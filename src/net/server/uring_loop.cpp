@@ -0,0 +1,932 @@
+#include "kvstore/net/server/uring_loop.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef KVSTORE_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "kvstore/net/read_buffer.hpp"
+#include "kvstore/net/server/protocol_handler.hpp"
+#include "kvstore/util/logger.hpp"
+#endif
+
+namespace kvstore::net::server {
+
+#ifdef KVSTORE_HAVE_IO_URING
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+constexpr unsigned kSqEntries = 1024;
+constexpr unsigned kCqEntries = 8192;  // multishot recvs can post many completions per round
+// provided buffers: the kernel picks one per recv completion. count must be a power of two
+constexpr unsigned kBufferCount = 1024;
+constexpr std::size_t kBufferSize = 4096;
+constexpr uint16_t kBufferGroup = 0;
+// cancel a connection's recv while this much of its output is still unsent
+constexpr std::size_t kMaxPendingOutput = 1024 * 1024;
+// pipelined requests answered with one handle_batch call at most
+constexpr std::size_t kMaxRun = 64;
+constexpr long kSweepIntervalSeconds = 1;
+constexpr long kDrainTimeoutSeconds = 2;
+constexpr uint64_t kDrainTimer = 1;  // Op::Timer id of drain()'s timeout, the sweep one is 0
+
+// user_data: the op in the top byte, the connection id below
+enum class Op : uint8_t { Accept = 1, Wake, Timer, Recv, Send, Cancel };
+
+uint64_t tag(Op op, uint64_t id = 0) {
+    return (static_cast<uint64_t>(op) << 56) | id;
+}
+
+Op tag_op(uint64_t user_data) {
+    return static_cast<Op>(user_data >> 56);
+}
+
+uint64_t tag_id(uint64_t user_data) {
+    return user_data & ((uint64_t{1} << 56) - 1);
+}
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int ring_fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+// ring indices are shared with the kernel: acquire what it publishes, release what we publish
+template <typename T>
+T load_acquire(T* p) {
+    return std::atomic_ref<T>(*p).load(std::memory_order_acquire);
+}
+
+template <typename T>
+void store_release(T* p, T value) {
+    std::atomic_ref<T>(*p).store(value, std::memory_order_release);
+}
+
+/*
+    one ring, used by one thread only (IORING_SETUP_SINGLE_ISSUER - the thread that creates it
+   has to be the one that submits): the submission and completion queues plus a provided buffer
+   ring for recvs. the same raw-syscall setup as util::IoEngine's io_uring backend, minus the
+   locking
+*/
+class Ring {
+   public:
+    Ring() {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+        params.cq_entries = kCqEntries;
+        fd_ = sys_io_uring_setup(kSqEntries, &params);
+        if (fd_ < 0) {
+            throw std::runtime_error("io_uring_setup failed: " + std::string(strerror(errno)));
+        }
+        try {
+            if ((params.features & IORING_FEAT_NODROP) == 0) {
+                throw std::runtime_error("io_uring without IORING_FEAT_NODROP");
+            }
+            map_rings(params);
+            setup_buffers();
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    ~Ring() {
+        release();
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    // a zeroed sqe on the submission queue. a full queue is handed to the kernel first
+    io_uring_sqe& next_sqe() {
+        unsigned tail = *sq_tail_;
+        while (tail - load_acquire(sq_head_) >= sq_entries_) {
+            enter(0);
+        }
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sq_array_[index] = index;
+        store_release(sq_tail_, tail + 1);
+        ++unsubmitted_;
+        return sqe;
+    }
+
+    // submit everything queued and wait for at least wait_nr completions. one syscall
+    void enter(unsigned wait_nr) {
+        ++syscalls_;
+        unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int submitted = sys_io_uring_enter(fd_, unsubmitted_, wait_nr, flags);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                return;  // completions are waiting to be reaped - the next round submits
+            }
+            throw std::runtime_error("io_uring_enter failed: " + std::string(strerror(errno)));
+        }
+        unsubmitted_ -= std::min(unsubmitted_, static_cast<unsigned>(submitted));
+    }
+
+    template <typename Fn>
+    void for_each_completion(Fn&& fn) {
+        unsigned head = *cq_head_;
+        unsigned tail = load_acquire(cq_tail_);
+        for (; head != tail; ++head) {
+            fn(cqes_[head & cq_mask_]);
+        }
+        store_release(cq_head_, head);
+    }
+
+    [[nodiscard]] const char* buffer(uint16_t bid) const {
+        return buffers_ + static_cast<std::size_t>(bid) * kBufferSize;
+    }
+
+    // hand a buffer back to the kernel - visible after publish_buffers()
+    void recycle_buffer(uint16_t bid) {
+        // not buf_ring_->bufs: in C++ the header's flexible array member lands 8 bytes past the
+        // start of the ring. the entries start at the ring itself, the tail overlays the first
+        auto* bufs = reinterpret_cast<io_uring_buf*>(buf_ring_);
+        io_uring_buf& buf = bufs[buf_tail_ & (kBufferCount - 1)];
+        buf.addr = reinterpret_cast<uint64_t>(buffer(bid));
+        buf.len = static_cast<uint32_t>(kBufferSize);
+        buf.bid = bid;
+        ++buf_tail_;
+    }
+
+    void publish_buffers() {
+        store_release(&buf_ring_->tail, buf_tail_);
+    }
+
+    [[nodiscard]] uint64_t syscalls() const noexcept {
+        return syscalls_;
+    }
+
+   private:
+    void map_rings(const io_uring_params& params) {
+        sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+        }
+        sq_ring_ = map(sq_ring_bytes_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_bytes_, IORING_OFF_CQ_RING);
+        sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_bytes_, IORING_OFF_SQES));
+        sq_entries_ = params.sq_entries;
+
+        auto* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* map(std::size_t bytes, off_t offset) {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                         offset);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error("io_uring mmap failed: " + std::string(strerror(errno)));
+        }
+        return p;
+    }
+
+    // the buffer ring (page aligned, shared with the kernel) and the buffers it hands out
+    void setup_buffers() {
+        buf_ring_bytes_ = kBufferCount * sizeof(io_uring_buf);
+        void* ring = ::mmap(nullptr, buf_ring_bytes_, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED) {
+            throw std::runtime_error("buffer ring mmap failed: " + std::string(strerror(errno)));
+        }
+        buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+        buffers_bytes_ = kBufferCount * kBufferSize;
+        void* buffers = ::mmap(nullptr, buffers_bytes_, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffers == MAP_FAILED) {
+            throw std::runtime_error("recv buffers mmap failed: " + std::string(strerror(errno)));
+        }
+        buffers_ = static_cast<char*>(buffers);
+
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+        reg.ring_entries = kBufferCount;
+        reg.bgid = kBufferGroup;
+        if (sys_io_uring_register(fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+            throw std::runtime_error("registering the buffer ring failed: " +
+                                     std::string(strerror(errno)));
+        }
+        for (unsigned bid = 0; bid < kBufferCount; ++bid) {
+            recycle_buffer(static_cast<uint16_t>(bid));
+        }
+        publish_buffers();
+    }
+
+    // closing the ring cancels whatever is still in flight
+    void release() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqes_bytes_);
+        }
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_bytes_);
+        }
+        if (sq_ring_ != nullptr) {
+            ::munmap(sq_ring_, sq_ring_bytes_);
+        }
+        if (buf_ring_ != nullptr) {
+            ::munmap(buf_ring_, buf_ring_bytes_);
+        }
+        if (buffers_ != nullptr) {
+            ::munmap(buffers_, buffers_bytes_);
+        }
+        sqes_ = nullptr;
+        cq_ring_ = sq_ring_ = nullptr;
+        buf_ring_ = nullptr;
+        buffers_ = nullptr;
+    }
+
+    int fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sq_ring_bytes_ = 0;
+    std::size_t cq_ring_bytes_ = 0;
+    std::size_t sqes_bytes_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+    unsigned unsubmitted_ = 0;
+
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    std::size_t buf_ring_bytes_ = 0;
+    char* buffers_ = nullptr;
+    std::size_t buffers_bytes_ = 0;
+    uint16_t buf_tail_ = 0;
+
+    uint64_t syscalls_ = 0;
+};
+
+struct Connection {
+    Connection(int fd_, uint64_t id_) : fd(fd_), id(id_), last_active(SteadyClock::now()) {}
+
+    int fd;
+    uint64_t id;
+    std::unique_ptr<IProtocolHandler> protocol;  // picked from the first byte
+    ReadBuffer in;                               // bytes not yet a complete request
+    std::string pending;                         // responses not handed to the kernel yet
+    std::string sending;                         // the send in flight
+    std::size_t sending_done = 0;
+    bool recv_armed = false;  // a multishot recv is in flight
+    bool recv_cancelled = false;
+    bool send_in_flight = false;
+    bool queued = false;       // in the reactor's to-send list
+    bool closing = false;      // QUIT: close once the output is sent
+    bool peer_closed = false;  // recv hit EOF
+    bool shut = false;         // shutdown() issued, waiting for the last completions
+    SteadyClock::time_point last_active;
+
+    [[nodiscard]] std::size_t unsent() const {
+        return pending.size() + sending.size() - sending_done;
+    }
+};
+
+struct Shared {
+    int listen_fd = -1;
+    int wake_fd = -1;
+    RequestHandler* handler = nullptr;
+    EventLoopOptions options;
+    std::atomic<bool> running{false};
+    std::atomic<std::size_t> connections{0};
+};
+
+class Reactor {
+   public:
+    explicit Reactor(Shared& shared) : shared_(shared) {
+        arm_accept();
+        arm_wake();
+        arm_timer();
+        ring_.enter(0);
+    }
+
+    ~Reactor() {
+        for (auto& [id, conn] : connections_) {
+            ::close(conn->fd);
+            shared_.connections.fetch_sub(1);
+        }
+    }
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    void run() {
+        while (shared_.running) {
+            round(1);
+        }
+        drain();
+    }
+
+    [[nodiscard]] ServerStats stats() const noexcept {
+        return {requests_, ring_.syscalls() + syscalls_};
+    }
+
+   private:
+    // queue the sends, then one io_uring_enter submits everything and waits
+    void round(unsigned wait_nr) {
+        queue_sends();
+        ring_.enter(wait_nr);
+        ring_.for_each_completion([this](const io_uring_cqe& cqe) { complete(cqe); });
+        ring_.publish_buffers();
+    }
+
+    void complete(const io_uring_cqe& cqe) {
+        bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        switch (tag_op(cqe.user_data)) {
+            case Op::Accept:
+                accepted(cqe.res);
+                if (!more) {
+                    accept_armed_ = false;
+                    if (shared_.running) {
+                        arm_accept();
+                    }
+                }
+                break;
+            case Op::Wake:
+                break;  // running is false now, run() ends after this round
+            case Op::Timer:
+                if (tag_id(cqe.user_data) == kDrainTimer) {
+                    drain_expired_ = true;
+                    break;
+                }
+                timer_armed_ = false;
+                close_idle();
+                if (shared_.running) {
+                    arm_timer();
+                }
+                break;
+            case Op::Recv:
+                received(tag_id(cqe.user_data), cqe, more);
+                break;
+            case Op::Send:
+                sent(tag_id(cqe.user_data), cqe.res);
+                break;
+            case Op::Cancel:
+                break;
+        }
+    }
+
+    void accepted(int fd) {
+        if (fd < 0) {
+            if (fd != -ECANCELED && shared_.running) {
+                // EMFILE and friends: the multishot accept ends, the re-arm retries
+                LOG_ERROR("Accept failed: " + std::string(strerror(-fd)));
+            }
+            return;
+        }
+        if (shared_.connections.fetch_add(1) >= shared_.options.max_connections) {
+            shared_.connections.fetch_sub(1);
+            ++syscalls_;
+            ::close(fd);
+            LOG_WARN("connection limit reached, closing new connection");
+            return;
+        }
+        uint64_t id = next_id_++;
+        auto [it, inserted] = connections_.emplace(id, std::make_unique<Connection>(fd, id));
+        LOG_DEBUG("Client connected, fd=" + std::to_string(fd));
+        arm_recv(*it->second);
+    }
+
+    void received(uint64_t id, const io_uring_cqe& cqe, bool more) {
+        auto it = connections_.find(id);
+        if ((cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+            auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (it != connections_.end() && cqe.res > 0) {
+                it->second->in.append(
+                    std::string_view(ring_.buffer(bid), static_cast<std::size_t>(cqe.res)));
+            }
+            ring_.recycle_buffer(bid);
+        }
+        if (it == connections_.end()) {
+            return;
+        }
+        Connection& conn = *it->second;
+        if (!more) {
+            conn.recv_armed = false;
+        }
+        if (cqe.res > 0) {
+            conn.last_active = SteadyClock::now();
+        } else if (cqe.res == 0) {
+            conn.peer_closed = true;
+        } else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+            conn.peer_closed = true;  // reset or the like: nothing more to read
+            conn.in.clear();
+        }
+        if (!conn.shut) {
+            try {
+                process_input(conn);
+            } catch (const std::exception& e) {
+                // a malformed request: the stream cant be resynced
+                LOG_ERROR("Client handle error: " + std::string(e.what()));
+                conn.pending.clear();
+                shut_down(conn);
+            }
+        }
+        settle(conn);
+    }
+
+    void sent(uint64_t id, int res) {
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            return;
+        }
+        Connection& conn = *it->second;
+        conn.send_in_flight = false;
+        if (res < 0) {
+            conn.sending.clear();
+            conn.pending.clear();
+            shut_down(conn);
+        } else {
+            conn.last_active = SteadyClock::now();
+            conn.sending_done += static_cast<std::size_t>(res);
+            if (conn.sending_done < conn.sending.size()) {
+                send_queued(conn);  // short send: the rest goes out first
+            } else {
+                conn.sending.clear();
+                conn.sending_done = 0;
+                if (!conn.shut) {
+                    process_input(conn);  // requests left over from a backed up round
+                }
+            }
+        }
+        settle(conn);
+    }
+
+    // answers every complete request in conn.in, until the output backs up
+    void process_input(Connection& conn) {
+        if (conn.in.empty() || conn.closing) {
+            return;
+        }
+        if (!conn.protocol) {
+            conn.protocol = shared_.options.binary_only
+                                ? std::make_unique<BinaryProtocolHandler>()
+                                : protocol_handler_for(static_cast<uint8_t>(conn.in.data()[0]));
+        }
+        // the run points into conn.in: nothing is consumed until it is answered
+        std::string_view data = conn.in.data();
+        std::size_t pos = 0;
+        while (!conn.closing && conn.unsent() < kMaxPendingOutput) {
+            // a run of requests for one handle_batch, cut at QUIT. no sendfile here: every value
+            // comes back as bytes
+            run_.clear();
+            while (run_.size() < kMaxRun) {
+                std::size_t consumed = 0;
+                auto request = conn.protocol->parse_request(data.substr(pos), consumed);
+                if (!request) {
+                    break;
+                }
+                pos += consumed;
+                ++requests_;
+                run_.push_back(*request);
+                if (request->command == Command::Quit) {
+                    break;
+                }
+            }
+            if (run_.empty()) {
+                break;
+            }
+            responses_.clear();
+            shared_.handler->handle_batch(run_, responses_, nullptr);
+            for (const Response& response : responses_) {
+                conn.protocol->append_response(conn.pending, response);
+                conn.closing = conn.closing || response.close_connection;
+            }
+        }
+        conn.in.consume(pos);
+    }
+
+    // after every completion of conn: queue its output, keep its recv armed or cancelled, close
+    // it once it is done. conn may be gone after this
+    void settle(Connection& conn) {
+        if (!conn.shut) {
+            bool output_done = conn.pending.empty() && !conn.send_in_flight;
+            if (output_done && (conn.closing || conn.peer_closed)) {
+                shut_down(conn);
+            } else {
+                if (!conn.pending.empty() && !conn.send_in_flight && !conn.queued) {
+                    conn.queued = true;
+                    to_send_.push_back(conn.id);
+                }
+                bool backed_up = conn.unsent() >= kMaxPendingOutput;
+                if (backed_up && conn.recv_armed && !conn.recv_cancelled) {
+                    cancel(conn);
+                } else if (!backed_up && !conn.recv_armed && !conn.closing && !conn.peer_closed) {
+                    arm_recv(conn);
+                }
+            }
+        }
+        if (conn.shut && !conn.recv_armed && !conn.send_in_flight) {
+            release(conn);
+        }
+    }
+
+    void queue_sends() {
+        for (uint64_t id : to_send_) {
+            auto it = connections_.find(id);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& conn = *it->second;
+            conn.queued = false;
+            if (conn.shut || conn.send_in_flight || conn.pending.empty()) {
+                continue;
+            }
+            conn.sending.swap(conn.pending);
+            conn.pending.clear();
+            conn.sending_done = 0;
+            send_queued(conn);
+        }
+        to_send_.clear();
+    }
+
+    void send_queued(Connection& conn) {
+        io_uring_sqe& sqe = ring_.next_sqe();
+        sqe.opcode = IORING_OP_SEND;
+        sqe.fd = conn.fd;
+        sqe.addr = reinterpret_cast<uint64_t>(conn.sending.data() + conn.sending_done);
+        sqe.len = static_cast<uint32_t>(
+            std::min<std::size_t>(conn.sending.size() - conn.sending_done, 1u << 30));
+        sqe.msg_flags = MSG_NOSIGNAL;
+        sqe.user_data = tag(Op::Send, conn.id);
+        conn.send_in_flight = true;
+    }
+
+    void arm_recv(Connection& conn) {
+        io_uring_sqe& sqe = ring_.next_sqe();
+        sqe.opcode = IORING_OP_RECV;
+        sqe.fd = conn.fd;
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = kBufferGroup;
+        sqe.user_data = tag(Op::Recv, conn.id);
+        conn.recv_armed = true;
+        conn.recv_cancelled = false;
+    }
+
+    void cancel(Connection& conn) {
+        io_uring_sqe& sqe = ring_.next_sqe();
+        sqe.opcode = IORING_OP_ASYNC_CANCEL;
+        sqe.addr = tag(Op::Recv, conn.id);
+        sqe.user_data = tag(Op::Cancel);
+        conn.recv_cancelled = true;
+    }
+
+    void arm_accept() {
+        io_uring_sqe& sqe = ring_.next_sqe();
+        sqe.opcode = IORING_OP_ACCEPT;
+        sqe.fd = shared_.listen_fd;
+        sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe.accept_flags = SOCK_CLOEXEC;
+        sqe.user_data = tag(Op::Accept);
+        accept_armed_ = true;
+    }
+
+    // one shot poll on the wake eventfd - it stays readable once stop() wrote it
+    void arm_wake() {
+        io_uring_sqe& sqe = ring_.next_sqe();
+        sqe.opcode = IORING_OP_POLL_ADD;
+        sqe.fd = shared_.wake_fd;
+        sqe.poll32_events = POLLIN;
+        sqe.user_data = tag(Op::Wake);
+    }
+
+    void arm_timer() {
+        sweep_interval_.tv_sec = kSweepIntervalSeconds;
+        sweep_interval_.tv_nsec = 0;
+        io_uring_sqe& sqe = ring_.next_sqe();
+        sqe.opcode = IORING_OP_TIMEOUT;
+        sqe.addr = reinterpret_cast<uint64_t>(&sweep_interval_);
+        sqe.len = 1;
+        sqe.user_data = tag(Op::Timer);
+        timer_armed_ = true;
+    }
+
+    void close_idle() {
+        if (shared_.options.client_timeout_seconds <= 0) {
+            return;
+        }
+        auto now = SteadyClock::now();
+        auto timeout = std::chrono::seconds(shared_.options.client_timeout_seconds);
+        std::vector<Connection*> idle;
+        for (auto& [id, conn] : connections_) {
+            if (!conn->shut && now - conn->last_active > timeout) {
+                idle.push_back(conn.get());
+            }
+        }
+        for (Connection* conn : idle) {
+            LOG_DEBUG("Closing idle client, fd=" + std::to_string(conn->fd));
+            shut_down(*conn);
+            settle(*conn);
+        }
+    }
+
+    // ends the connection's recv and send - it is released once their completions are in, so the
+    // kernel never writes into a freed connection
+    void shut_down(Connection& conn) {
+        if (conn.shut) {
+            return;
+        }
+        conn.shut = true;
+        ++syscalls_;
+        ::shutdown(conn.fd, SHUT_RDWR);
+    }
+
+    // conn is gone after this
+    void release(Connection& conn) {
+        int fd = conn.fd;
+        ++syscalls_;
+        ::close(fd);
+        connections_.erase(conn.id);
+        shared_.connections.fetch_sub(1);
+        LOG_DEBUG("Client disconnected, fd=" + std::to_string(fd));
+    }
+
+    // stop: close every connection and wait for the kernel to be done with their buffers
+    void drain() {
+        std::vector<Connection*> open;
+        for (auto& [id, conn] : connections_) {
+            open.push_back(conn.get());
+        }
+        for (Connection* conn : open) {
+            shut_down(*conn);
+            settle(*conn);
+        }
+        if (accept_armed_) {
+            io_uring_sqe& sqe = ring_.next_sqe();
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.addr = tag(Op::Accept);
+            sqe.user_data = tag(Op::Cancel);
+        }
+        if (timer_armed_) {
+            io_uring_sqe& sqe = ring_.next_sqe();
+            sqe.opcode = IORING_OP_TIMEOUT_REMOVE;
+            sqe.addr = tag(Op::Timer);
+            sqe.user_data = tag(Op::Cancel);
+        }
+        // round() blocks until something completes - this timer bounds the wait
+        drain_timeout_.tv_sec = kDrainTimeoutSeconds;
+        drain_timeout_.tv_nsec = 0;
+        io_uring_sqe& sqe = ring_.next_sqe();
+        sqe.opcode = IORING_OP_TIMEOUT;
+        sqe.addr = reinterpret_cast<uint64_t>(&drain_timeout_);
+        sqe.len = 1;
+        sqe.user_data = tag(Op::Timer, kDrainTimer);
+        while ((!connections_.empty() || accept_armed_ || timer_armed_) && !drain_expired_) {
+            round(1);
+        }
+        if (!connections_.empty()) {
+            LOG_WARN("io_uring loop stopped with " + std::to_string(connections_.size()) +
+                     " connections still busy");
+        }
+    }
+
+    Shared& shared_;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+    std::vector<uint64_t> to_send_;  // connections with output to queue this round
+    uint64_t next_id_ = 1;
+    bool accept_armed_ = false;
+    bool timer_armed_ = false;
+    bool drain_expired_ = false;
+    __kernel_timespec sweep_interval_{};
+    __kernel_timespec drain_timeout_{};
+    // process_input's current run (views into a connection's read buffer) and its answers, kept
+    // to reuse the allocations
+    std::vector<RequestView> run_;
+    std::vector<Response> responses_;
+    uint64_t requests_ = 0;
+    uint64_t syscalls_ = 0;  // outside io_uring_enter: shutdown/close
+    // last: destroyed (closed) first, while the buffers of anything still in flight are alive
+    Ring ring_;
+};
+
+}  // namespace
+
+class UringLoop::Impl {
+   public:
+    Impl(int listen_fd, RequestHandler& handler, const EventLoopOptions& options) {
+        shared_.listen_fd = listen_fd;
+        shared_.handler = &handler;
+        shared_.options = options;
+        if (shared_.options.threads == 0) {
+            shared_.options.threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    ~Impl() {
+        stop();
+    }
+
+    void start() {
+        if (shared_.running) {
+            return;
+        }
+        shared_.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (shared_.wake_fd < 0) {
+            throw std::runtime_error("eventfd failed: " + std::string(strerror(errno)));
+        }
+        shared_.running = true;
+        stats_.resize(shared_.options.threads);
+
+        // SINGLE_ISSUER: each ring is set up on the thread that uses it, which reports back
+        std::vector<std::future<void>> ready;
+        for (std::size_t i = 0; i < shared_.options.threads; ++i) {
+            std::promise<void> promise;
+            ready.push_back(promise.get_future());
+            threads_.emplace_back(&Impl::run, this, std::move(promise), &stats_[i]);
+        }
+        try {
+            for (auto& future : ready) {
+                future.get();
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    void stop() {
+        if (!shared_.running.exchange(false)) {
+            return;
+        }
+        uint64_t one = 1;
+        (void)!write(shared_.wake_fd, &one, sizeof(one));
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+        close(shared_.wake_fd);
+        shared_.wake_fd = -1;
+    }
+
+    [[nodiscard]] std::size_t threads() const noexcept {
+        return shared_.options.threads;
+    }
+
+    [[nodiscard]] std::size_t connections() const noexcept {
+        return shared_.connections.load();
+    }
+
+    [[nodiscard]] ServerStats stats() const noexcept {
+        ServerStats total;
+        if (shared_.running) {
+            return total;  // the threads still write theirs
+        }
+        for (const ServerStats& stats : stats_) {
+            total.requests += stats.requests;
+            total.syscalls += stats.syscalls;
+        }
+        return total;
+    }
+
+   private:
+    void run(std::promise<void> ready, ServerStats* stats) {
+        std::unique_ptr<Reactor> reactor;
+        try {
+            reactor = std::make_unique<Reactor>(shared_);
+        } catch (...) {
+            ready.set_exception(std::current_exception());
+            return;
+        }
+        ready.set_value();
+        try {
+            reactor->run();
+        } catch (const std::exception& e) {
+            LOG_ERROR("io_uring loop failed: " + std::string(e.what()));
+        }
+        *stats = reactor->stats();
+    }
+
+    Shared shared_;
+    std::vector<std::thread> threads_;
+    std::vector<ServerStats> stats_;  // one per thread, written as it ends
+};
+
+bool UringLoop::supported() {
+    // ring setup with SINGLE_ISSUER needs 6.0 - the release that added multishot recv too - and
+    // the buffer ring registration 5.19. a ring that sets up here is one run() can use.
+    // probed on a thread of its own: the kernel tears a ring down asynchronously and notifies
+    // its issuer when done, which would interrupt a blocking call of the caller with EINTR
+    static const bool supported = [] {
+        bool ok = false;
+        std::thread probe([&ok] {
+            try {
+                Ring ring;
+                ok = true;
+            } catch (const std::exception& e) {
+                LOG_DEBUG(std::string("io_uring networking unavailable: ") + e.what());
+            }
+        });
+        probe.join();
+        return ok;
+    }();
+    return supported;
+}
+
+#else  // KVSTORE_HAVE_IO_URING
+
+class UringLoop::Impl {
+   public:
+    Impl(int /*listen_fd*/, RequestHandler& /*handler*/, const EventLoopOptions& options)
+        : threads_(options.threads) {}
+
+    void start() {
+        throw std::runtime_error("built without io_uring support");
+    }
+
+    void stop() {}
+
+    [[nodiscard]] std::size_t threads() const noexcept {
+        return threads_;
+    }
+
+    [[nodiscard]] std::size_t connections() const noexcept {
+        return 0;
+    }
+
+    [[nodiscard]] ServerStats stats() const noexcept {
+        return {};
+    }
+
+   private:
+    std::size_t threads_;
+};
+
+bool UringLoop::supported() {
+    return false;
+}
+
+#endif  // KVSTORE_HAVE_IO_URING
+
+// PIMPL INTERFACE -------------------------------------------------------------------------------
+UringLoop::UringLoop(int listen_fd, RequestHandler& handler, const EventLoopOptions& options)
+    : impl_(std::make_unique<Impl>(listen_fd, handler, options)) {}
+UringLoop::~UringLoop() = default;
+void UringLoop::start() {
+    impl_->start();
+}
+void UringLoop::stop() {
+    impl_->stop();
+}
+std::size_t UringLoop::threads() const noexcept {
+    return impl_->threads();
+}
+std::size_t UringLoop::connections() const noexcept {
+    return impl_->connections();
+}
+ServerStats UringLoop::stats() const noexcept {
+    return impl_->stats();
+}
+
+}  // namespace kvstore::net::server
@@ -1,43 +1,128 @@
 #include "kvstore/net/text_protocol.hpp"
 
-#include <algorithm>
-#include <cctype>
-#include <sstream>
+#include <charconv>
 
 namespace kvstore::net {
 
 namespace {
-std::string to_upper(std::string str) {
-    std::transform(str.begin(), str.end(), str.begin(), ::toupper);
-    return str;
+
+// what istringstream >> skips (a line has no newline left in it)
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// the next word from pos on, pos moves past it. empty = the line ran out
+std::string_view next_word(std::string_view line, std::size_t& pos) {
+    while (pos < line.size() && is_space(line[pos])) {
+        ++pos;
+    }
+    std::size_t begin = pos;
+    while (pos < line.size() && !is_space(line[pos])) {
+        ++pos;
+    }
+    return line.substr(begin, pos - begin);
+}
+
+// everything from pos on without the whitespace around it
+std::string_view rest_of_line(std::string_view line, std::size_t pos) {
+    while (pos < line.size() && is_space(line[pos])) {
+        ++pos;
+    }
+    std::size_t end = line.size();
+    while (end > pos && is_space(line[end - 1])) {
+        --end;
+    }
+    return line.substr(pos, end - pos);
+}
+
+// word == upper, ignoring the case of word. upper is all letters: clearing bit 5 upper-cases a
+// letter, and no other byte turns into one
+bool equals_upper(std::string_view word, std::string_view upper) {
+    if (word.size() != upper.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < word.size(); ++i) {
+        if ((static_cast<unsigned char>(word[i]) & 0xDF) != static_cast<unsigned char>(upper[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a literal, so encoded requests can point at it
+std::string_view command_name(Command cmd) {
+    switch (cmd) {
+        case Command::Get:
+            return "GET";
+        case Command::Put:
+            return "PUT";
+        case Command::PutEx:
+            return "PUTEX";
+        case Command::Del:
+            return "DEL";
+        case Command::Exists:
+            return "EXISTS";
+        case Command::Size:
+            return "SIZE";
+        case Command::Clear:
+            return "CLEAR";
+        case Command::Ping:
+            return "PING";
+        case Command::Quit:
+            return "QUIT";
+        case Command::Unknown:
+            return "UNKNOWN";
+    }
+    return "UNKNOWN";
 }
 
 }  // namespace
 
 std::string TextProtocol::encode_request(const Request& req) {
-    std::string line = command_to_string(req.command);
+    EncodedRequest encoded;
+    encode_request(RequestView::of(req), encoded);
+    return encoded.join();
+}
+
+void TextProtocol::encode_request(const RequestView& req, EncodedRequest& out) {
+    // "COMMAND key value\n": the words and the separators between them, only the PUTEX ttl is
+    // written into the frame
+    out.count = 0;
+    out.add(command_name(req.command));
 
     switch (req.command) {
         case Command::Get:
         case Command::Del:
         case Command::Exists:
-            line += " " + req.key;
+            out.add(" ");
+            out.add(req.key);
             break;
 
         case Command::Put:
-            line += " " + req.key + " " + req.value;
+            out.add(" ");
+            out.add(req.key);
+            out.add(" ");
+            out.add(req.value);
             break;
 
-        case Command::PutEx:
-            line += " " + req.key + " " + std::to_string(req.ttl_ms) + " " + req.value;
+        case Command::PutEx: {
+            out.add(" ");
+            out.add(req.key);
+            char* frame = out.frame.data();
+            frame[0] = ' ';
+            // an int64 always fits: 20 characters at most
+            char* end = std::to_chars(frame + 1, frame + out.frame.size() - 1, req.ttl_ms).ptr;
+            *end++ = ' ';
+            out.add({frame, static_cast<std::size_t>(end - frame)});
+            out.add(req.value);
             break;
+        }
 
         default:
             break;
     }
 
-    line += "\n";
-    return line;
+    out.add("\n");
 }
 
 std::string TextProtocol::encode_response(const Response& resp) {
@@ -62,65 +147,40 @@ std::string TextProtocol::encode_response(const Response& resp) {
     return line;
 }
 
-Request TextProtocol::decode_request(const std::string& line) {
-    std::istringstream iss(line);
-    std::string cmd_str;
-
-    if (!(iss >> cmd_str)) {
-        return {Command::Unknown, "", "", 0};
-    }
-
-    Request req;
-    req.command = parse_command(cmd_str);
-
-    std::vector<std::string> args;
-    std::string arg;
-    while (iss >> arg) {
-        args.push_back(arg);
-    }
+RequestView TextProtocol::decode_request_view(std::string_view line) {
+    std::size_t pos = 0;
+    RequestView req;
+    req.command = parse_command(next_word(line, pos));
 
     switch (req.command) {
         case Command::Get:
         case Command::Del:
         case Command::Exists:
-            if (args.empty()) {
+            req.key = next_word(line, pos);
+            if (req.key.empty()) {
                 req.command = Command::Unknown;
-            } else {
-                req.key = args[0];
             }
             break;
 
         case Command::Put:
-            if (args.size() < 2) {
-                req.command = Command::Unknown;
-            } else {
-                req.key = args[0];
-                for (size_t i = 1; i < args.size(); ++i) {
-                    if (i > 1)
-                        req.value += " ";
-                    req.value += args[i];
-                }
+            req.key = next_word(line, pos);
+            req.value = rest_of_line(line, pos);
+            if (req.value.empty()) {
+                req.command = Command::Unknown;  // no key, or no value after it
             }
             break;
 
-        case Command::PutEx:
-            if (args.size() < 3) {
+        case Command::PutEx: {
+            req.key = next_word(line, pos);
+            std::string_view ttl = next_word(line, pos);
+            req.value = rest_of_line(line, pos);
+            // the whole word has to be a number - out of range counts as invalid too
+            auto [end, ec] = std::from_chars(ttl.data(), ttl.data() + ttl.size(), req.ttl_ms);
+            if (req.value.empty() || ec != std::errc() || end != ttl.data() + ttl.size()) {
                 req.command = Command::Unknown;
-            } else {
-                req.key = args[0];
-                try {
-                    req.ttl_ms = std::stoll(args[1]);
-                } catch (const std::exception&) {
-                    req.command = Command::Unknown;  // invalid TTL
-                    break;
-                }
-                for (size_t i = 2; i < args.size(); ++i) {
-                    if (i > 2)
-                        req.value += " ";
-                    req.value += args[i];
-                }
             }
             break;
+        }
 
         default:
             break;
@@ -129,7 +189,11 @@ Request TextProtocol::decode_request(const std::string& line) {
     return req;
 }
 
-Response TextProtocol::decode_response(const std::string& line) {
+Request TextProtocol::decode_request(std::string_view line) {
+    return decode_request_view(line).to_request();
+}
+
+Response TextProtocol::decode_response(std::string_view line) {
     Response resp;
 
     if (line.substr(0, 2) == "OK") {
@@ -149,59 +213,78 @@ Response TextProtocol::decode_response(const std::string& line) {
         resp.close_connection = true;
     } else {
         resp.status = Status::Error;
-        resp.data = "Unknown response: " + line;
+        resp.data = "Unknown response: " + std::string(line);
     }
 
     return resp;
 }
 
 std::string TextProtocol::command_to_string(Command cmd) {
-    switch (cmd) {
-        case Command::Get:
-            return "GET";
-        case Command::Put:
-            return "PUT";
-        case Command::PutEx:
-            return "PUTEX";
-        case Command::Del:
-            return "DEL";
-        case Command::Exists:
-            return "EXISTS";
-        case Command::Size:
-            return "SIZE";
-        case Command::Clear:
-            return "CLEAR";
-        case Command::Ping:
-            return "PING";
-        case Command::Quit:
-            return "QUIT";
-        case Command::Unknown:
-            return "UNKNOWN";
-    }
-    return "UNKNOWN";
+    return std::string(command_name(cmd));
 }
 
-Command TextProtocol::parse_command(const std::string& str) {
-    std::string upper = to_upper(str);
-    if (upper == "GET")
-        return Command::Get;
-    if (upper == "PUT" || upper == "SET")
-        return Command::Put;
-    if (upper == "PUTEX" || upper == "SETEX")
-        return Command::PutEx;
-    if (upper == "DEL" || upper == "DELETE" || upper == "REMOVE")
-        return Command::Del;
-    if (upper == "EXISTS" || upper == "CONTAINS")
-        return Command::Exists;
-    if (upper == "SIZE" || upper == "COUNT")
-        return Command::Size;
-    if (upper == "CLEAR")
-        return Command::Clear;
-    if (upper == "PING")
-        return Command::Ping;
-    if (upper == "QUIT" || upper == "EXIT")
-        return Command::Quit;
-    return Command::Unknown;
+Command TextProtocol::parse_command(std::string_view str) {
+    // the length and the first letter leave at most two candidates, one compare settles it
+    if (str.empty()) {
+        return Command::Unknown;
+    }
+    auto is = [str](std::string_view upper) { return equals_upper(str, upper); };
+    switch (str.size()) {
+        case 3:
+            switch (str[0] | 0x20) {
+                case 'g':
+                    return is("GET") ? Command::Get : Command::Unknown;
+                case 'p':
+                    return is("PUT") ? Command::Put : Command::Unknown;
+                case 's':
+                    return is("SET") ? Command::Put : Command::Unknown;
+                case 'd':
+                    return is("DEL") ? Command::Del : Command::Unknown;
+                default:
+                    return Command::Unknown;
+            }
+        case 4:
+            switch (str[0] | 0x20) {
+                case 'p':
+                    return is("PING") ? Command::Ping : Command::Unknown;
+                case 's':
+                    return is("SIZE") ? Command::Size : Command::Unknown;
+                case 'q':
+                    return is("QUIT") ? Command::Quit : Command::Unknown;
+                case 'e':
+                    return is("EXIT") ? Command::Quit : Command::Unknown;
+                default:
+                    return Command::Unknown;
+            }
+        case 5:
+            switch (str[0] | 0x20) {
+                case 'p':
+                    return is("PUTEX") ? Command::PutEx : Command::Unknown;
+                case 's':
+                    return is("SETEX") ? Command::PutEx : Command::Unknown;
+                case 'c':
+                    return is("CLEAR") ? Command::Clear
+                           : is("COUNT") ? Command::Size
+                                         : Command::Unknown;
+                default:
+                    return Command::Unknown;
+            }
+        case 6:
+            switch (str[0] | 0x20) {
+                case 'd':
+                    return is("DELETE") ? Command::Del : Command::Unknown;
+                case 'r':
+                    return is("REMOVE") ? Command::Del : Command::Unknown;
+                case 'e':
+                    return is("EXISTS") ? Command::Exists : Command::Unknown;
+                default:
+                    return Command::Unknown;
+            }
+        case 8:
+            return is("CONTAINS") ? Command::Exists : Command::Unknown;
+        default:
+            return Command::Unknown;
+    }
 }
 
 }  // namespace kvstore::net
\ No newline at end of file
@@ -68,6 +68,12 @@ std::optional<Config> Config::load_file(const std::filesystem::path& path) {
             config.max_connections = std::stoull(value);
         } else if (key == "client_timeout_seconds") {
             config.client_timeout_seconds = std::stoi(value);
+        } else if (key == "event_loop") {
+            config.event_loop = (value == "true" || value == "1");
+        } else if (key == "reactor_threads") {
+            config.reactor_threads = std::stoull(value);
+        } else if (key == "io_uring") {
+            config.io_uring = (value == "true" || value == "1");
         } else if (key == "data_dir") {
             config.data_dir = value;
         } else if (key == "snapshot_threshold") {
@@ -76,6 +82,30 @@ std::optional<Config> Config::load_file(const std::filesystem::path& path) {
             config.compaction_threshold = std::stoull(value);
         } else if (key == "use_disk_store") {
             config.use_disk_store = (value == "true" || value == "1");
+        } else if (key == "compact_index") {
+            config.compact_index = (value == "true" || value == "1");
+        } else if (key == "blob_threshold") {
+            config.blob_threshold = std::stoull(value);
+        } else if (key == "use_io_uring") {
+            config.use_io_uring = (value == "true" || value == "1");
+        } else if (key == "direct_io") {
+            config.direct_io = (value == "true" || value == "1");
+        } else if (key == "block_cache_mb") {
+            config.block_cache_mb = std::stoull(value);
+        } else if (key == "value_cache_mb") {
+            config.value_cache_mb = std::stoull(value);
+        } else if (key == "use_tiered_store") {
+            config.use_tiered_store = (value == "true" || value == "1");
+        } else if (key == "hot_tier_mb") {
+            config.hot_tier_mb = std::stoull(value);
+        } else if (key == "ingest_dir") {
+            config.ingest_dir = value;
+        } else if (key == "use_lsm_store") {
+            config.use_lsm_store = (value == "true" || value == "1");
+        } else if (key == "use_btree_store") {
+            config.use_btree_store = (value == "true" || value == "1");
+        } else if (key == "use_mmap_store") {
+            config.use_mmap_store = (value == "true" || value == "1");
         } else if (key == "log_level") {
             config.log_level = parse_log_level(value);
         }
@@ -100,9 +130,24 @@ std::optional<Config> Config::parse_args(int argc, char* argv[]) {
                 << "  -l, --log-level LEVEL      Log level: debug, info, warn, error, none\n"
                 << "  --max-connections N        Max client connections (default: 1000)\n"
                 << "  --client-timeout SEC       Client timeout seconds (default: 300)\n"
+                << "  --event-loop               Serve clients from epoll reactor threads\n"
+                << "  --reactor-threads N        Event loop: reactor threads (default: cores)\n"
+                << "  --io-uring                 Event loop on io_uring (epoll if unavailable)\n"
                 << "  --snapshot-threshold N     WAL entries before snapshot (default: 10000)\n"
                 << "  --compaction-threshold N   Tombstones before compaction (default: 1000)\n"
                 << "  --disk-store               Use disk-based storage\n"
+                << "  --compact-index            Disk store: keep hashes, not keys, in memory\n"
+                << "  --blob-threshold N         Disk store: blob log for values >= N bytes\n"
+                << "  --io-uring                 Disk store: batched reads through io_uring\n"
+                << "  --direct-io                Disk store: O_DIRECT reads, own block cache\n"
+                << "  --block-cache-mb N         Disk store: block cache size (default: 64)\n"
+                << "  --value-cache-mb N         Disk store: hot value cache size (default: 0)\n"
+                << "  --tiered-store             Use in-memory hot tier over disk storage\n"
+                << "  --hot-tier-mb N            Tiered store: hot tier budget (default: 64)\n"
+                << "  --ingest-dir DIR           Disk store: adopt kvstore-ingest data on SIGHUP\n"
+                << "  --lsm-store                Use LSM-tree storage\n"
+                << "  --btree-store              Use B+tree storage\n"
+                << "  --mmap-store               Use memory-mapped hash table storage\n"
                 << "  -h, --help                 Show this help\n";
             return std::nullopt;
         }
@@ -118,12 +163,42 @@ std::optional<Config> Config::parse_args(int argc, char* argv[]) {
             config.max_connections = std::stoull(argv[++i]);
         } else if (arg == "--client-timeout" && i + 1 < argc) {
             config.client_timeout_seconds = std::stoi(argv[++i]);
+        } else if (arg == "--event-loop") {
+            config.event_loop = true;
+        } else if (arg == "--reactor-threads" && i + 1 < argc) {
+            config.reactor_threads = std::stoull(argv[++i]);
+        } else if (arg == "--io-uring") {
+            config.io_uring = true;
         } else if (arg == "--snapshot-threshold" && i + 1 < argc) {
             config.snapshot_threshold = std::stoull(argv[++i]);
         } else if (arg == "--compaction-threshold" && i + 1 < argc) {
             config.compaction_threshold = std::stoull(argv[++i]);
         } else if (arg == "--disk-store") {
             config.use_disk_store = true;
+        } else if (arg == "--compact-index") {
+            config.compact_index = true;
+        } else if (arg == "--blob-threshold" && i + 1 < argc) {
+            config.blob_threshold = std::stoull(argv[++i]);
+        } else if (arg == "--io-uring") {
+            config.use_io_uring = true;
+        } else if (arg == "--direct-io") {
+            config.direct_io = true;
+        } else if (arg == "--block-cache-mb" && i + 1 < argc) {
+            config.block_cache_mb = std::stoull(argv[++i]);
+        } else if (arg == "--value-cache-mb" && i + 1 < argc) {
+            config.value_cache_mb = std::stoull(argv[++i]);
+        } else if (arg == "--tiered-store") {
+            config.use_tiered_store = true;
+        } else if (arg == "--hot-tier-mb" && i + 1 < argc) {
+            config.hot_tier_mb = std::stoull(argv[++i]);
+        } else if (arg == "--ingest-dir" && i + 1 < argc) {
+            config.ingest_dir = argv[++i];
+        } else if (arg == "--lsm-store") {
+            config.use_lsm_store = true;
+        } else if (arg == "--btree-store") {
+            config.use_btree_store = true;
+        } else if (arg == "--mmap-store") {
+            config.use_mmap_store = true;
         } else if ((arg == "-c" || arg == "--config") && i + 1 < argc) {
             // Config file handled separately in main
             ++i;
@@ -144,6 +219,12 @@ Config Config::merge(const Config& file_config, const Config& cli_config, const
         result.max_connections = file_config.max_connections;
     if (file_config.client_timeout_seconds != defaults.client_timeout_seconds)
         result.client_timeout_seconds = file_config.client_timeout_seconds;
+    if (file_config.event_loop != defaults.event_loop)
+        result.event_loop = file_config.event_loop;
+    if (file_config.reactor_threads != defaults.reactor_threads)
+        result.reactor_threads = file_config.reactor_threads;
+    if (file_config.io_uring != defaults.io_uring)
+        result.io_uring = file_config.io_uring;
     if (file_config.data_dir != defaults.data_dir)
         result.data_dir = file_config.data_dir;
     if (file_config.snapshot_threshold != defaults.snapshot_threshold)
@@ -152,6 +233,30 @@ Config Config::merge(const Config& file_config, const Config& cli_config, const
         result.compaction_threshold = file_config.compaction_threshold;
     if (file_config.use_disk_store != defaults.use_disk_store)
         result.use_disk_store = file_config.use_disk_store;
+    if (file_config.compact_index != defaults.compact_index)
+        result.compact_index = file_config.compact_index;
+    if (file_config.blob_threshold != defaults.blob_threshold)
+        result.blob_threshold = file_config.blob_threshold;
+    if (file_config.use_io_uring != defaults.use_io_uring)
+        result.use_io_uring = file_config.use_io_uring;
+    if (file_config.direct_io != defaults.direct_io)
+        result.direct_io = file_config.direct_io;
+    if (file_config.block_cache_mb != defaults.block_cache_mb)
+        result.block_cache_mb = file_config.block_cache_mb;
+    if (file_config.value_cache_mb != defaults.value_cache_mb)
+        result.value_cache_mb = file_config.value_cache_mb;
+    if (file_config.use_tiered_store != defaults.use_tiered_store)
+        result.use_tiered_store = file_config.use_tiered_store;
+    if (file_config.hot_tier_mb != defaults.hot_tier_mb)
+        result.hot_tier_mb = file_config.hot_tier_mb;
+    if (file_config.ingest_dir != defaults.ingest_dir)
+        result.ingest_dir = file_config.ingest_dir;
+    if (file_config.use_lsm_store != defaults.use_lsm_store)
+        result.use_lsm_store = file_config.use_lsm_store;
+    if (file_config.use_btree_store != defaults.use_btree_store)
+        result.use_btree_store = file_config.use_btree_store;
+    if (file_config.use_mmap_store != defaults.use_mmap_store)
+        result.use_mmap_store = file_config.use_mmap_store;
     if (file_config.log_level != defaults.log_level)
         result.log_level = file_config.log_level;
 
@@ -164,6 +269,12 @@ Config Config::merge(const Config& file_config, const Config& cli_config, const
         result.max_connections = cli_config.max_connections;
     if (cli_config.client_timeout_seconds != defaults.client_timeout_seconds)
         result.client_timeout_seconds = cli_config.client_timeout_seconds;
+    if (cli_config.event_loop != defaults.event_loop)
+        result.event_loop = cli_config.event_loop;
+    if (cli_config.reactor_threads != defaults.reactor_threads)
+        result.reactor_threads = cli_config.reactor_threads;
+    if (cli_config.io_uring != defaults.io_uring)
+        result.io_uring = cli_config.io_uring;
     if (cli_config.data_dir != defaults.data_dir)
         result.data_dir = cli_config.data_dir;
     if (cli_config.snapshot_threshold != defaults.snapshot_threshold)
@@ -172,6 +283,30 @@ Config Config::merge(const Config& file_config, const Config& cli_config, const
         result.compaction_threshold = cli_config.compaction_threshold;
     if (cli_config.use_disk_store != defaults.use_disk_store)
         result.use_disk_store = cli_config.use_disk_store;
+    if (cli_config.compact_index != defaults.compact_index)
+        result.compact_index = cli_config.compact_index;
+    if (cli_config.blob_threshold != defaults.blob_threshold)
+        result.blob_threshold = cli_config.blob_threshold;
+    if (cli_config.use_io_uring != defaults.use_io_uring)
+        result.use_io_uring = cli_config.use_io_uring;
+    if (cli_config.direct_io != defaults.direct_io)
+        result.direct_io = cli_config.direct_io;
+    if (cli_config.block_cache_mb != defaults.block_cache_mb)
+        result.block_cache_mb = cli_config.block_cache_mb;
+    if (cli_config.value_cache_mb != defaults.value_cache_mb)
+        result.value_cache_mb = cli_config.value_cache_mb;
+    if (cli_config.use_tiered_store != defaults.use_tiered_store)
+        result.use_tiered_store = cli_config.use_tiered_store;
+    if (cli_config.hot_tier_mb != defaults.hot_tier_mb)
+        result.hot_tier_mb = cli_config.hot_tier_mb;
+    if (cli_config.ingest_dir != defaults.ingest_dir)
+        result.ingest_dir = cli_config.ingest_dir;
+    if (cli_config.use_lsm_store != defaults.use_lsm_store)
+        result.use_lsm_store = cli_config.use_lsm_store;
+    if (cli_config.use_btree_store != defaults.use_btree_store)
+        result.use_btree_store = cli_config.use_btree_store;
+    if (cli_config.use_mmap_store != defaults.use_mmap_store)
+        result.use_mmap_store = cli_config.use_mmap_store;
     if (cli_config.log_level != defaults.log_level)
         result.log_level = cli_config.log_level;
 
@@ -0,0 +1,102 @@
+#include "kvstore/util/crc32c.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace kvstore::util {
+
+namespace {
+
+constexpr uint32_t kPolynomial = 0x82F63B78;  // Castagnoli, bit reversed
+
+// tables[0] is the classic byte-at-a-time table. tables[k][b] = crc of byte b followed by k zero
+// bytes, which lets the loop below fold 8 input bytes per step with independent lookups
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Tables make_tables() {
+    Tables tables{};
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t crc = b;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) != 0 ? kPolynomial : 0);
+        }
+        tables[0][b] = crc;
+    }
+    for (std::size_t k = 1; k < 8; ++k) {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t prev = tables[k - 1][b];
+            tables[k][b] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr Tables kTables = make_tables();
+
+// crc here is the raw register (already inverted by the caller)
+uint32_t extend_portable(uint32_t crc, const uint8_t* p, std::size_t n) {
+    while (n >= 8) {
+        uint32_t lo = 0;
+        uint32_t hi = 0;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= crc;  // little endian: the first byte is the low byte
+        crc = kTables[7][lo & 0xFF] ^ kTables[6][(lo >> 8) & 0xFF] ^
+              kTables[5][(lo >> 16) & 0xFF] ^ kTables[4][lo >> 24] ^ kTables[3][hi & 0xFF] ^
+              kTables[2][(hi >> 8) & 0xFF] ^ kTables[1][(hi >> 16) & 0xFF] ^ kTables[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while (n-- > 0) {
+        crc = (crc >> 8) ^ kTables[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t extend_sse42(uint32_t crc, const uint8_t* p,
+                                                         std::size_t n) {
+    uint64_t crc64 = crc;
+    while (n >= 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        n -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while (n-- > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+using ExtendFn = uint32_t (*)(uint32_t, const uint8_t*, std::size_t);
+
+ExtendFn pick_extend() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return extend_sse42;
+    }
+#endif
+    return extend_portable;
+}
+
+}  // namespace
+
+uint32_t crc32c_extend(uint32_t crc, std::string_view data) {
+    static const ExtendFn extend = pick_extend();
+    return ~extend(~crc, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+uint32_t crc32c(std::string_view data) {
+    return crc32c_extend(0, data);
+}
+
+}  // namespace kvstore::util
@@ -0,0 +1,104 @@
+#include "kvstore/util/file_io.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace kvstore::util {
+
+int open_file(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open " + path.string() + ": " +
+                                 std::string(strerror(errno)));
+    }
+    return fd;
+}
+
+void pwrite_all(int fd, const char* data, std::size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("file write failed: " + std::string(strerror(errno)));
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+}
+
+void pread_all(int fd, char* data, std::size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pread(fd, data, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("file read failed at offset " + std::to_string(offset));
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+}
+
+// macOS has no fdatasync - plain fsync is the closest equivalent
+void sync_file(int fd) {
+#ifdef __APPLE__
+    int rc = ::fsync(fd);
+#else
+    int rc = ::fdatasync(fd);
+#endif
+    if (rc != 0) {
+        throw std::runtime_error("file sync failed: " + std::string(strerror(errno)));
+    }
+}
+
+uint64_t file_size(int fd) {
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("fstat failed: " + std::string(strerror(errno)));
+    }
+    return static_cast<uint64_t>(st.st_size);
+}
+
+void sync_directory(const std::filesystem::path& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open " + dir.string() + ": " +
+                                 std::string(strerror(errno)));
+    }
+    int rc = ::fsync(fd);
+    int sync_errno = errno;
+    ::close(fd);
+    if (rc != 0) {
+        throw std::runtime_error("directory sync failed: " + std::string(strerror(sync_errno)));
+    }
+}
+
+// posix_fallocate is no use here: without filesystem support it writes zeros, and it grows the file
+bool preallocate(int fd, uint64_t offset, uint64_t len) {
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    int rc = 0;
+    do {
+        rc = ::fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+                         static_cast<off_t>(len));
+    } while (rc != 0 && errno == EINTR);
+    return rc == 0;
+#else
+    (void)fd;
+    (void)offset;
+    (void)len;
+    return false;
+#endif
+}
+
+}  // namespace kvstore::util
@@ -0,0 +1,580 @@
+#include "kvstore/util/io_engine.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "kvstore/util/file_io.hpp"
+#include "kvstore/util/logger.hpp"
+
+#ifdef KVSTORE_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#endif
+
+namespace kvstore::util {
+
+namespace {
+
+// one pread/pwrite, EINTR retried. bytes transferred or -errno - the raw result submit() hands out
+int64_t transfer_once(const IoOp& op) {
+    while (true) {
+        ssize_t n = op.kind == IoOp::Kind::Read
+                        ? ::pread(op.fd, op.data, op.len, static_cast<off_t>(op.offset))
+                        : ::pwrite(op.fd, op.data, op.len, static_cast<off_t>(op.offset));
+        if (n >= 0) {
+            return n;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+// finish an op that already moved `done` bytes
+void transfer_rest(const IoOp& op, std::size_t done) {
+    if (op.kind == IoOp::Kind::Read) {
+        pread_all(op.fd, op.data + done, op.len - done, op.offset + done);
+    } else {
+        pwrite_all(op.fd, op.data + done, op.len - done, op.offset + done);
+    }
+}
+
+class SyncIoEngine : public IoEngine {
+   public:
+    void run(std::span<const IoOp> ops) override {
+        for (const IoOp& op : ops) {
+            transfer_rest(op, 0);
+        }
+    }
+
+    // the op is done before this returns - only the callback is deferred, so both backends call
+    // back from poll() alike
+    void submit(const IoOp& op, IoCallback callback) override {
+        int64_t result = transfer_once(op);
+        std::lock_guard lock(mutex_);
+        ready_.emplace_back(std::move(callback), result);
+    }
+
+    std::size_t poll(bool /*wait*/) override {
+        std::deque<std::pair<IoCallback, int64_t>> ready;
+        {
+            std::lock_guard lock(mutex_);
+            ready.swap(ready_);
+        }
+        for (auto& [callback, result] : ready) {
+            callback(result);
+        }
+        return ready.size();
+    }
+
+    bool register_file(int /*fd*/) override {
+        return false;
+    }
+
+    void unregister_file(int /*fd*/) override {}
+
+    bool register_buffers(const std::vector<std::span<char>>& /*buffers*/) override {
+        return false;
+    }
+
+    [[nodiscard]] IoBackend backend() const override {
+        return IoBackend::Sync;
+    }
+
+   private:
+    std::mutex mutex_;
+    std::deque<std::pair<IoCallback, int64_t>> ready_;
+};
+
+#ifdef KVSTORE_HAVE_IO_URING
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int ring_fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+// ring indices are shared with the kernel: acquire what it publishes, release what we publish
+unsigned load_acquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+void store_release(unsigned* p, unsigned value) {
+    std::atomic_ref<unsigned>(*p).store(value, std::memory_order_release);
+}
+
+/*
+    io_uring backend. one ring shared by every thread, all ring state under mutex_:
+    - run() queues its batch, submits it with one io_uring_enter and waits for its completions
+    - only one thread at a time blocks in the kernel for completions (the reaper, reaping_). it
+   drops mutex_ while blocked, so others keep submitting, and hands every completion it reaps to
+   its owner: batch ops count down their run(), submit()s move to ready_ for poll()
+    - ops in flight never exceed the completion queue size, so completions cant overflow it
+    - the registered file table is sparse (kMaxFiles slots, -1 = free) and updated in place
+*/
+class IoUringEngine : public IoEngine {
+   public:
+    explicit IoUringEngine(unsigned queue_depth) {
+        io_uring_params params{};
+        ring_fd_ = sys_io_uring_setup(std::max(queue_depth, 2u), &params);
+        if (ring_fd_ < 0) {
+            throw std::runtime_error("io_uring_setup failed: " + std::string(strerror(errno)));
+        }
+        try {
+            map_rings(params);
+        } catch (...) {
+            unmap_rings();
+            ::close(ring_fd_);
+            throw;
+        }
+        sq_entries_ = params.sq_entries;
+        max_in_flight_ = params.cq_entries;
+
+        // empty sparse table - register_file fills slots. old kernels refuse -1 entries, then
+        // files just go unregistered
+        files_.assign(kMaxFiles, -1);
+        files_registered_ = sys_io_uring_register(ring_fd_, IORING_REGISTER_FILES, files_.data(),
+                                                  static_cast<unsigned>(files_.size())) == 0;
+    }
+
+    ~IoUringEngine() override {
+        // the kernel may still write into buffers of unpolled submit()s - let it finish first
+        try {
+            std::unique_lock lock(mutex_);
+            while (in_flight_ > 0) {
+                reap_or_wait(lock);
+            }
+        } catch (const std::exception& e) {
+            LOG_WARN("io_uring shutdown: " + std::string(e.what()));
+        }
+        for (Pending* pending : ready_) {
+            delete pending;
+        }
+        unmap_rings();
+        ::close(ring_fd_);
+    }
+
+    IoUringEngine(const IoUringEngine&) = delete;
+    IoUringEngine& operator=(const IoUringEngine&) = delete;
+
+    void run(std::span<const IoOp> ops) override {
+        if (ops.empty()) {
+            return;
+        }
+        std::vector<Pending> pending(ops.size());
+        Batch batch{ops.size()};
+        {
+            std::unique_lock lock(mutex_);
+            for (std::size_t i = 0; i < ops.size(); ++i) {
+                pending[i].op = ops[i];
+                pending[i].batch = &batch;
+                queue(lock, &pending[i]);
+            }
+            submit_pending();
+            while (batch.remaining > 0) {
+                reap_or_wait(lock);
+            }
+        }
+
+        // short transfers (EOF, > 1GB ops, interrupted) and -EAGAIN: finish them like pread_all
+        // / pwrite_all would. the kernel is done with every buffer by now, so throwing is safe
+        std::string error;
+        for (const Pending& p : pending) {
+            if (p.result >= 0 && static_cast<std::size_t>(p.result) == p.op.len) {
+                continue;
+            }
+            try {
+                if (p.result < 0 && p.result != -EAGAIN && p.result != -EINTR) {
+                    throw std::runtime_error("io_uring " + std::string(kind_name(p.op)) +
+                                             " failed: " + strerror(static_cast<int>(-p.result)));
+                }
+                transfer_rest(p.op, p.result > 0 ? static_cast<std::size_t>(p.result) : 0);
+            } catch (const std::exception& e) {
+                if (error.empty()) {
+                    error = e.what();
+                }
+            }
+        }
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+
+    void submit(const IoOp& op, IoCallback callback) override {
+        auto pending = std::make_unique<Pending>();
+        pending->op = op;
+        pending->callback = std::move(callback);
+
+        std::unique_lock lock(mutex_);
+        queue(lock, pending.get());
+        ++async_outstanding_;
+        pending.release();  // owned by the ring until poll() runs it
+        submit_pending();
+    }
+
+    std::size_t poll(bool wait) override {
+        std::deque<Pending*> ready;
+        {
+            std::unique_lock lock(mutex_);
+            if (!reaping_) {
+                reap_locked();
+            }
+            while (wait && ready_.empty() && async_outstanding_ > 0) {
+                reap_or_wait(lock);
+            }
+            ready.swap(ready_);
+        }
+        for (Pending* pending : ready) {
+            std::unique_ptr<Pending> owned(pending);
+            owned->callback(owned->result);
+        }
+        return ready.size();
+    }
+
+    bool register_file(int fd) override {
+        std::lock_guard lock(mutex_);
+        if (!files_registered_) {
+            return false;
+        }
+        if (file_slot(fd) >= 0) {
+            return true;
+        }
+        auto free_slot = std::find(files_.begin(), files_.end(), -1);
+        if (free_slot == files_.end()) {
+            return false;
+        }
+        auto slot = static_cast<unsigned>(free_slot - files_.begin());
+        if (!update_file_slot(slot, fd)) {
+            return false;
+        }
+        files_[slot] = fd;
+        return true;
+    }
+
+    void unregister_file(int fd) override {
+        std::lock_guard lock(mutex_);
+        int slot = file_slot(fd);
+        if (slot < 0) {
+            return;
+        }
+        update_file_slot(static_cast<unsigned>(slot), -1);
+        files_[static_cast<std::size_t>(slot)] = -1;
+    }
+
+    bool register_buffers(const std::vector<std::span<char>>& buffers) override {
+        std::lock_guard lock(mutex_);
+        if (!buffers_.empty()) {
+            sys_io_uring_register(ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+            buffers_.clear();
+        }
+        if (buffers.empty()) {
+            return true;
+        }
+        std::vector<iovec> iovecs;
+        iovecs.reserve(buffers.size());
+        for (const auto& buffer : buffers) {
+            iovecs.push_back(iovec{buffer.data(), buffer.size()});
+        }
+        // pinned memory counts against RLIMIT_MEMLOCK - failing here just means unregistered I/O
+        if (sys_io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                                  static_cast<unsigned>(iovecs.size())) != 0) {
+            return false;
+        }
+        buffers_ = buffers;
+        return true;
+    }
+
+    [[nodiscard]] IoBackend backend() const override {
+        return IoBackend::IoUring;
+    }
+
+   private:
+    static constexpr std::size_t kMaxFiles = 64;
+    static constexpr std::size_t kMaxOpBytes = std::size_t{1} << 30;  // sqe len is 32 bits
+
+    struct Batch {
+        std::size_t remaining;
+    };
+
+    struct Pending {
+        IoOp op;
+        int64_t result = 0;
+        Batch* batch = nullptr;  // run() op, else a submit() with a callback
+        IoCallback callback;
+    };
+
+    static const char* kind_name(const IoOp& op) {
+        return op.kind == IoOp::Kind::Read ? "read" : "write";
+    }
+
+    void map_rings(const io_uring_params& params) {
+        sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+        }
+
+        sq_ring_ = map(sq_ring_bytes_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_bytes_, IORING_OFF_CQ_RING);
+        sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_bytes_, IORING_OFF_SQES));
+
+        auto* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* map(std::size_t bytes, off_t offset) {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring_fd_, offset);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error("io_uring mmap failed: " + std::string(strerror(errno)));
+        }
+        return p;
+    }
+
+    void unmap_rings() {
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqes_bytes_);
+        }
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_bytes_);
+        }
+        if (sq_ring_ != nullptr) {
+            ::munmap(sq_ring_, sq_ring_bytes_);
+        }
+        sqes_ = nullptr;
+        cq_ring_ = sq_ring_ = nullptr;
+    }
+
+    // mutex_ held. put one sqe on the submission queue - io_uring_enter comes later
+    void queue(std::unique_lock<std::mutex>& lock, Pending* pending) {
+        while (in_flight_ >= max_in_flight_) {
+            reap_or_wait(lock);
+        }
+        unsigned tail = *sq_tail_;
+        if (tail - load_acquire(sq_head_) >= sq_entries_) {
+            submit_pending();  // no SQPOLL: the kernel has consumed every sqe once enter returns
+        }
+
+        const IoOp& op = pending->op;
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        bool is_read = op.kind == IoOp::Kind::Read;
+        sqe.opcode = is_read ? IORING_OP_READ : IORING_OP_WRITE;
+        sqe.fd = op.fd;
+        sqe.addr = reinterpret_cast<uint64_t>(op.data);
+        sqe.len = static_cast<uint32_t>(std::min(op.len, kMaxOpBytes));
+        sqe.off = op.offset;
+        sqe.user_data = reinterpret_cast<uint64_t>(pending);
+        if (int slot = file_slot(op.fd); slot >= 0) {
+            sqe.fd = slot;
+            sqe.flags |= IOSQE_FIXED_FILE;
+        }
+        if (int buffer = buffer_index(op.data, sqe.len); buffer >= 0) {
+            sqe.opcode = is_read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+            sqe.buf_index = static_cast<uint16_t>(buffer);
+        }
+
+        sq_array_[index] = index;
+        store_release(sq_tail_, tail + 1);
+        ++unsubmitted_;
+        ++in_flight_;
+    }
+
+    // mutex_ held
+    void submit_pending() {
+        while (unsubmitted_ > 0) {
+            int submitted = sys_io_uring_enter(ring_fd_, unsubmitted_, 0, 0);
+            if (submitted < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    continue;
+                }
+                throw std::runtime_error("io_uring_enter failed: " + std::string(strerror(errno)));
+            }
+            unsubmitted_ -= static_cast<unsigned>(submitted);
+        }
+    }
+
+    // mutex_ held, caller waits for some op to finish. either become the reaper and block in the
+    // kernel until something completes, or sleep until the current reaper hands out completions
+    void reap_or_wait(std::unique_lock<std::mutex>& lock) {
+        submit_pending();
+        if (reaping_) {
+            cv_.wait(lock);
+            return;
+        }
+        if (reap_locked() > 0 || in_flight_ == 0) {
+            return;
+        }
+        reaping_ = true;
+        lock.unlock();
+        int rc = sys_io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        int wait_errno = errno;
+        lock.lock();
+        reaping_ = false;
+        reap_locked();
+        cv_.notify_all();  // someone else may have to take over reaping
+        if (rc < 0 && wait_errno != EINTR && wait_errno != EAGAIN && wait_errno != EBUSY) {
+            throw std::runtime_error("io_uring_enter failed: " + std::string(strerror(wait_errno)));
+        }
+    }
+
+    // mutex_ held and nobody else is reaping. returns the number of completions handed out
+    std::size_t reap_locked() {
+        unsigned head = *cq_head_;
+        unsigned tail = load_acquire(cq_tail_);
+        std::size_t reaped = 0;
+        for (; head != tail; ++head, ++reaped) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            auto* pending = reinterpret_cast<Pending*>(cqe.user_data);
+            pending->result = cqe.res;
+            if (pending->batch != nullptr) {
+                --pending->batch->remaining;
+            } else {
+                --async_outstanding_;
+                ready_.push_back(pending);
+            }
+        }
+        store_release(cq_head_, head);
+        in_flight_ -= reaped;
+        if (reaped > 0) {
+            cv_.notify_all();
+        }
+        return reaped;
+    }
+
+    int file_slot(int fd) const {
+        if (!files_registered_ || fd < 0) {
+            return -1;
+        }
+        auto it = std::find(files_.begin(), files_.end(), fd);
+        return it == files_.end() ? -1 : static_cast<int>(it - files_.begin());
+    }
+
+    bool update_file_slot(unsigned slot, int fd) {
+        io_uring_files_update update{};
+        update.offset = slot;
+        update.fds = reinterpret_cast<uint64_t>(&fd);
+        return sys_io_uring_register(ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1;
+    }
+
+    int buffer_index(const char* data, std::size_t len) const {
+        for (std::size_t i = 0; i < buffers_.size(); ++i) {
+            const char* begin = buffers_[i].data();
+            if (data >= begin && data + len <= begin + buffers_[i].size()) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    int ring_fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sq_ring_bytes_ = 0;
+    std::size_t cq_ring_bytes_ = 0;
+    std::size_t sqes_bytes_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool reaping_ = false;
+    unsigned unsubmitted_ = 0;         // queued sqes the kernel hasnt seen yet
+    std::size_t in_flight_ = 0;        // queued or submitted, completion not reaped yet
+    std::size_t max_in_flight_ = 0;    // completion queue size
+    std::size_t async_outstanding_ = 0;
+    std::deque<Pending*> ready_;       // reaped submit()s, owned until poll() runs them
+
+    bool files_registered_ = false;
+    std::vector<int> files_;  // slot -> fd
+    std::vector<std::span<char>> buffers_;
+};
+
+#endif  // KVSTORE_HAVE_IO_URING
+
+}  // namespace
+
+std::unique_ptr<IoEngine> make_io_engine(IoBackend backend, unsigned queue_depth) {
+    if (backend == IoBackend::IoUring) {
+#ifdef KVSTORE_HAVE_IO_URING
+        try {
+            return std::make_unique<IoUringEngine>(queue_depth);
+        } catch (const std::exception& e) {
+            LOG_WARN(std::string(e.what()) + " - falling back to synchronous I/O");
+        }
+#else
+        (void)queue_depth;
+        LOG_WARN("built without io_uring support - falling back to synchronous I/O");
+#endif
+    }
+    return std::make_unique<SyncIoEngine>();
+}
+
+bool io_uring_available() {
+#ifdef KVSTORE_HAVE_IO_URING
+    static const bool available = [] {
+        io_uring_params params{};
+        int fd = sys_io_uring_setup(2, &params);
+        if (fd < 0) {
+            return false;
+        }
+        ::close(fd);
+        return true;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+std::string_view to_string(IoBackend backend) {
+    switch (backend) {
+        case IoBackend::Sync:
+            return "sync";
+        case IoBackend::IoUring:
+            return "io_uring";
+    }
+    return "unknown";
+}
+
+}  // namespace kvstore::util
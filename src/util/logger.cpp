@@ -61,7 +61,10 @@ std::string Logger::timestamp() const {
 
     std::ostringstream oss;
     // format: "2024-01-15 10:30:45"
-    oss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
+    // localtime_r: localtime's static result would race between logging threads
+    std::tm local{};
+    localtime_r(&time, &local);
+    oss << std::put_time(&local, "%Y-%m-%d %H:%M:%S");
 
     // append ".123" for milliseconds
     oss << '.' << std::setfill('0') << std::setw(3) << ms.count();
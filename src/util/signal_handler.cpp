@@ -7,6 +7,7 @@
 namespace kvstore::util {
 
 std::atomic<bool> SignalHandler::shutdown_requested_{false};
+std::atomic<bool> SignalHandler::reload_requested_{false};
 
 namespace {
 
@@ -14,7 +15,10 @@ std::mutex shutdown_mutex;
 std::condition_variable shutdown_cv;
 
 void signal_handler(int signal) {
-    (void)signal;
+    if (signal == SIGHUP) {
+        SignalHandler::request_reload();
+        return;
+    }
     SignalHandler::request_shutdown();
 }
 
@@ -23,6 +27,7 @@ void signal_handler(int signal) {
 void SignalHandler::install() {
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
+    std::signal(SIGHUP, signal_handler);
 }
 
 bool SignalHandler::should_shutdown() {
@@ -39,8 +44,25 @@ void SignalHandler::request_shutdown() {
     shutdown_cv.notify_all();
 }
 
+void SignalHandler::request_reload() {
+    reload_requested_.store(true);
+    shutdown_cv.notify_all();
+}
+
+SignalEvent SignalHandler::wait_for_event() {
+    std::unique_lock lock(shutdown_mutex);
+    shutdown_cv.wait(lock,
+                     [] { return shutdown_requested_.load() || reload_requested_.load(); });
+    if (shutdown_requested_.load()) {
+        return SignalEvent::Shutdown;
+    }
+    reload_requested_.store(false);
+    return SignalEvent::Reload;
+}
+
 void SignalHandler::reset() {
     shutdown_requested_.store(false);
+    reload_requested_.store(false);
 }
 
 }  // namespace kvstore::util
\ No newline at end of file
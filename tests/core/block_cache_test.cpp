@@ -0,0 +1,149 @@
+#include "kvstore/core/block_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kvstore::core::test {
+
+class BlockCacheTest : public ::testing::Test {
+   protected:
+    static constexpr std::size_t kBlock = BlockCache::kBlockSize;
+
+    // block content derived from its key, so any read can be checked
+    static std::string block_data(uint64_t file_id, uint64_t block) {
+        return std::string(kBlock, static_cast<char>('a' + (file_id * 7 + block) % 26));
+    }
+
+    static void insert(BlockCache& cache, uint64_t file_id, uint64_t block) {
+        cache.insert(file_id, block, block_data(file_id, block).data());
+    }
+};
+
+TEST_F(BlockCacheTest, MissThenHit) {
+    BlockCache cache(16 * kBlock, 1);
+    std::string out(100, '\0');
+    EXPECT_FALSE(cache.read(0, 3, 0, out.data(), out.size()));
+
+    insert(cache, 0, 3);
+    ASSERT_TRUE(cache.read(0, 3, 1000, out.data(), out.size()));
+    EXPECT_EQ(out, block_data(0, 3).substr(1000, 100));
+
+    BlockCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.used_bytes, kBlock);
+    EXPECT_DOUBLE_EQ(stats.hit_ratio(), 0.5);
+}
+
+TEST_F(BlockCacheTest, FileIdsAreSeparate) {
+    BlockCache cache(16 * kBlock, 4);
+    insert(cache, 1, 0);
+    std::string out(kBlock, '\0');
+    EXPECT_FALSE(cache.read(2, 0, 0, out.data(), out.size()));
+    ASSERT_TRUE(cache.read(1, 0, 0, out.data(), out.size()));
+    EXPECT_EQ(out, block_data(1, 0));
+}
+
+TEST_F(BlockCacheTest, InsertReplacesBlock) {
+    BlockCache cache(16 * kBlock, 1);
+    insert(cache, 0, 0);
+    std::string updated(kBlock, 'z');
+    cache.insert(0, 0, updated.data());
+
+    std::string out(kBlock, '\0');
+    ASSERT_TRUE(cache.read(0, 0, 0, out.data(), out.size()));
+    EXPECT_EQ(out, updated);
+    EXPECT_EQ(cache.stats().used_bytes, kBlock);
+}
+
+// the capacity is allocated up front and never exceeded
+TEST_F(BlockCacheTest, EvictsAtCapacity) {
+    BlockCache cache(8 * kBlock, 2);
+    EXPECT_EQ(cache.stats().capacity_bytes, 8 * kBlock);
+    for (uint64_t block = 0; block < 100; ++block) {
+        insert(cache, 0, block);
+    }
+    BlockCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.used_bytes, 8 * kBlock);
+    EXPECT_EQ(stats.evictions, 92);
+
+    // whatever survived still reads back right
+    std::string out(kBlock, '\0');
+    int cached = 0;
+    for (uint64_t block = 0; block < 100; ++block) {
+        if (cache.read(0, block, 0, out.data(), out.size())) {
+            ++cached;
+            ASSERT_EQ(out, block_data(0, block));
+        }
+    }
+    EXPECT_EQ(cached, 8);
+}
+
+// CLOCK: a block that was hit since the hand last passed survives the next eviction
+TEST_F(BlockCacheTest, ReferencedBlocksSurvive) {
+    BlockCache cache(4 * kBlock, 1);
+    for (uint64_t block = 0; block < 4; ++block) {
+        insert(cache, 0, block);
+    }
+    char byte = 0;
+    ASSERT_TRUE(cache.read(0, 0, 0, &byte, 1));
+
+    insert(cache, 0, 4);
+    EXPECT_TRUE(cache.read(0, 0, 0, &byte, 1));
+    EXPECT_FALSE(cache.read(0, 1, 0, &byte, 1));
+}
+
+TEST_F(BlockCacheTest, Clear) {
+    BlockCache cache(16 * kBlock);
+    for (uint64_t block = 0; block < 10; ++block) {
+        insert(cache, 0, block);
+    }
+    cache.clear();
+    EXPECT_EQ(cache.stats().used_bytes, 0);
+    char byte = 0;
+    EXPECT_FALSE(cache.read(0, 5, 0, &byte, 1));
+
+    insert(cache, 0, 5);
+    EXPECT_TRUE(cache.read(0, 5, 0, &byte, 1));
+}
+
+TEST_F(BlockCacheTest, AlignedBuffer) {
+    AlignedBuffer buffer = make_aligned_buffer(10000);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.get()) % kBlock, 0);
+}
+
+TEST_F(BlockCacheTest, ConcurrentReadersAndInserters) {
+    BlockCache cache(64 * kBlock, 8);
+    std::atomic<int> corrupt{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            std::string out(kBlock, '\0');
+            for (int i = 0; i < 2000; ++i) {
+                uint64_t block = static_cast<uint64_t>((i * 7 + t * 13) % 200);
+                if (cache.read(1, block, 0, out.data(), out.size())) {
+                    if (out != block_data(1, block)) {
+                        ++corrupt;
+                    }
+                } else {
+                    insert(cache, 1, block);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(corrupt, 0);
+    BlockCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 8000);
+    EXPECT_LE(stats.used_bytes, stats.capacity_bytes);
+}
+
+}  // namespace kvstore::core::test
@@ -0,0 +1,110 @@
+#include "kvstore/core/buffer_pool.hpp"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "kvstore/util/file_io.hpp"
+
+namespace kvstore::core::test {
+
+namespace util = kvstore::util;
+
+class BufferPoolTest : public ::testing::Test {
+   protected:
+    static constexpr std::size_t kPageSize = 1024;
+
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "buffer_pool_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        fd_ = util::open_file(test_dir_ / "pages.db");
+    }
+
+    void TearDown() override {
+        ::close(fd_);
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    static void fill(BufferPool::PageRef& page, char c) {
+        std::memset(page.mutable_data(), c, kPageSize);
+    }
+
+    std::filesystem::path test_dir_;
+    int fd_ = -1;
+};
+
+TEST_F(BufferPoolTest, CreateThenFetchHits) {
+    BufferPool pool(fd_, kPageSize, 4);
+    {
+        auto page = pool.create(3);
+        fill(page, 'a');
+    }
+    auto page = pool.fetch(3);
+    EXPECT_EQ(page.data()[0], 'a');
+    EXPECT_EQ(pool.hits(), 1);
+    EXPECT_EQ(pool.misses(), 0);
+}
+
+TEST_F(BufferPoolTest, EvictionWritesBackDirtyPages) {
+    BufferPool pool(fd_, kPageSize, 2);
+    for (uint32_t id = 0; id < 8; ++id) {
+        auto page = pool.create(id);
+        fill(page, static_cast<char>('a' + id));
+    }
+    // only 2 frames - most pages were evicted and must come back from disk
+    for (uint32_t id = 0; id < 8; ++id) {
+        auto page = pool.fetch(id);
+        EXPECT_EQ(page.data()[kPageSize - 1], static_cast<char>('a' + id)) << id;
+    }
+    EXPECT_GT(pool.misses(), 0);
+}
+
+TEST_F(BufferPoolTest, FlushAllPersists) {
+    {
+        BufferPool pool(fd_, kPageSize, 8);
+        auto page = pool.create(1);
+        fill(page, 'z');
+        page = BufferPool::PageRef();
+        pool.flush_all();
+    }
+    std::vector<char> buf(kPageSize);
+    util::pread_all(fd_, buf.data(), buf.size(), kPageSize);
+    EXPECT_EQ(buf[0], 'z');
+}
+
+TEST_F(BufferPoolTest, DiscardDropsChanges) {
+    BufferPool pool(fd_, kPageSize, 4);
+    {
+        auto page = pool.create(0);
+        fill(page, 'x');
+    }
+    pool.flush_all();
+    {
+        auto page = pool.fetch(0);
+        fill(page, 'y');
+        page.mark_dirty();
+    }
+    pool.discard(0);
+    auto page = pool.fetch(0);
+    EXPECT_EQ(page.data()[0], 'x');
+}
+
+TEST_F(BufferPoolTest, PinnedPagesAreNeverEvicted) {
+    BufferPool pool(fd_, kPageSize, 2);
+    std::vector<BufferPool::PageRef> pinned;
+    for (uint32_t id = 0; id < 4; ++id) {
+        pinned.push_back(pool.create(id));
+        fill(pinned.back(), static_cast<char>('a' + id));
+    }
+    // more pins than capacity: the pool grows instead of handing out a pinned frame
+    for (uint32_t id = 0; id < 4; ++id) {
+        EXPECT_EQ(pinned[id].id(), id);
+        EXPECT_EQ(pinned[id].data()[0], static_cast<char>('a' + id));
+    }
+}
+
+}  // namespace kvstore::core::test
@@ -0,0 +1,103 @@
+#include "kvstore/core/compact_index.hpp"
+
+#include <gtest/gtest.h>
+
+#include <unordered_map>
+
+#include "kvstore/util/hash.hpp"
+
+namespace kvstore::core::test {
+
+namespace util = kvstore::util;
+
+namespace {
+
+auto same(uint64_t offset) {
+    return [offset](uint64_t candidate) { return candidate == offset; };
+}
+
+}  // namespace
+
+TEST(CompactIndexTest, EmptyTableFindsNothingAndIsFull) {
+    CompactIndex index;
+    EXPECT_FALSE(index.find(util::hash64("key"), same(8)).has_value());
+    EXPECT_TRUE(index.full());
+    EXPECT_EQ(index.size(), 0);
+}
+
+TEST(CompactIndexTest, InsertFindReplaceErase) {
+    CompactIndex index(16);
+    uint64_t hash = util::hash64("key");
+    index.insert(hash, 100);
+    EXPECT_EQ(index.find(hash, same(100)), 100);
+    EXPECT_EQ(index.size(), 1);
+
+    EXPECT_TRUE(index.replace(hash, 100, 200));
+    EXPECT_FALSE(index.find(hash, same(100)).has_value());
+    EXPECT_EQ(index.find(hash, same(200)), 200);
+    EXPECT_FALSE(index.replace(hash, 100, 300));
+
+    EXPECT_TRUE(index.erase(hash, 200));
+    EXPECT_FALSE(index.erase(hash, 200));
+    EXPECT_EQ(index.size(), 0);
+}
+
+// same hash = same tag and home: every candidate goes to the caller, who tells them apart
+TEST(CompactIndexTest, CollidingEntriesAreAllOffered) {
+    CompactIndex index(16);
+    uint64_t hash = util::hash64("same");
+    index.insert(hash, 10);
+    index.insert(hash, 20);
+    index.insert(hash, 30);
+
+    int offered = 0;
+    auto found = index.find(hash, [&](uint64_t candidate) {
+        ++offered;
+        return candidate == 30;
+    });
+    EXPECT_EQ(found, 30);
+    EXPECT_EQ(offered, 3);
+
+    // erasing the middle one must not cut the probe sequence
+    EXPECT_TRUE(index.erase(hash, 20));
+    EXPECT_EQ(index.find(hash, same(30)), 30);
+}
+
+TEST(CompactIndexTest, DeletedSlotsCountTowardsFull) {
+    CompactIndex index(16);
+    int inserted = 0;
+    while (!index.full()) {
+        index.insert(util::hash64("key" + std::to_string(inserted)), 8 + inserted);
+        ++inserted;
+    }
+    EXPECT_EQ(inserted, 14);  // 7/8 of 16 slots
+
+    // the marker left behind still occupies its slot - only a rebuild frees it
+    EXPECT_TRUE(index.erase(util::hash64("key0"), 8));
+    EXPECT_EQ(index.size(), 13);
+    EXPECT_TRUE(index.full());
+    EXPECT_THROW(index.insert(util::hash64("one more"), 100), std::logic_error);
+}
+
+TEST(CompactIndexTest, ManyKeys) {
+    const int n = 100000;
+    CompactIndex index(CompactIndex::capacity_for(n));
+    for (int i = 0; i < n; ++i) {
+        index.insert(util::hash64("key" + std::to_string(i)), 8 + static_cast<uint64_t>(i));
+    }
+    for (int i = 0; i < n; ++i) {
+        uint64_t offset = 8 + static_cast<uint64_t>(i);
+        ASSERT_EQ(index.find(util::hash64("key" + std::to_string(i)), same(offset)), offset);
+    }
+    EXPECT_EQ(index.size(), n);
+    // 8 bytes a slot, at most half full after sizing
+    EXPECT_LE(index.memory_usage(), 4 * n * sizeof(uint64_t));
+}
+
+TEST(CompactIndexTest, RejectsOffsetsItCannotEncode) {
+    CompactIndex index(16);
+    EXPECT_THROW(index.insert(1, CompactIndex::kMaxOffset + 1), std::invalid_argument);
+    EXPECT_THROW(index.insert(1, 0), std::invalid_argument);
+}
+
+}  // namespace kvstore::core::test
@@ -0,0 +1,216 @@
+#include "kvstore/core/data_file.hpp"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace kvstore::core::data_file::test {
+
+class DataFileTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "data_file_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        path_ = test_dir_ / "data.kvds";
+    }
+
+    void TearDown() override {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    // header + count records of varying sizes, every 10th a tombstone, every 7th with a TTL.
+    // fills offsets_ with where each record starts
+    void write_file(int count) {
+        std::string buf;
+        append_header(buf);
+        offsets_.clear();
+        for (int i = 0; i < count; ++i) {
+            offsets_.push_back(buf.size());
+            uint8_t type = i % 10 == 9 ? kEntryTombstone : kEntryRegular;
+            util::ExpirationTime expires_at_ms = std::nullopt;
+            if (i % 7 == 0) {
+                expires_at_ms = 1000 + i;
+            }
+            encode_record(buf, type, key(i), type == kEntryRegular ? value(i) : "",
+                          expires_at_ms);
+        }
+        end_ = buf.size();
+        std::ofstream(path_, std::ios::binary | std::ios::trunc) << buf;
+        reopen();
+    }
+
+    void reopen() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = ::open(path_.c_str(), O_RDONLY);
+        ASSERT_GE(fd_, 0);
+    }
+
+    // the records a scan hands out, copied - the views die with the scan
+    struct Seen {
+        uint64_t offset;
+        uint8_t type;
+        std::string key;
+        std::string value;
+        util::ExpirationTime expires_at_ms;
+    };
+
+    uint64_t scan_all(std::vector<Seen>& seen, std::size_t threads, std::size_t chunk_bytes,
+                      uint64_t from = kHeaderSize, uint64_t end = UINT64_MAX) {
+        ScanOptions options;
+        options.threads = threads;
+        options.chunk_bytes = chunk_bytes;
+        return scan(fd_, from, end, options, [&seen](const ScannedRecord& record) {
+            seen.push_back({record.offset, record.type, std::string(record.key),
+                            std::string(record.value), record.expires_at_ms});
+        });
+    }
+
+    void flip_byte(uint64_t offset) {
+        std::fstream f(path_, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekg(static_cast<std::streamoff>(offset));
+        char c = 0;
+        f.read(&c, 1);
+        c = static_cast<char>(c ^ 0x5a);
+        f.seekp(static_cast<std::streamoff>(offset));
+        f.write(&c, 1);
+    }
+
+    static std::string key(int i) {
+        return "key" + std::to_string(i);
+    }
+
+    static std::string value(int i) {
+        return std::string(static_cast<std::size_t>(i % 300), static_cast<char>('a' + i % 26));
+    }
+
+    std::filesystem::path test_dir_;
+    std::filesystem::path path_;
+    int fd_ = -1;
+    std::vector<uint64_t> offsets_;
+    uint64_t end_ = 0;
+};
+
+TEST_F(DataFileTest, ScanReturnsEveryRecordInOrder) {
+    write_file(2000);
+    std::vector<Seen> seen;
+    EXPECT_EQ(scan_all(seen, 1, 8 * 1024 * 1024), end_);
+
+    ASSERT_EQ(seen.size(), 2000);
+    for (int i = 0; i < 2000; ++i) {
+        const Seen& record = seen[static_cast<std::size_t>(i)];
+        ASSERT_EQ(record.offset, offsets_[static_cast<std::size_t>(i)]) << i;
+        EXPECT_EQ(record.key, key(i));
+        if (i % 10 == 9) {
+            EXPECT_EQ(record.type, kEntryTombstone);
+        } else {
+            EXPECT_EQ(record.type, kEntryRegular);
+            EXPECT_EQ(record.value, value(i));
+        }
+        EXPECT_EQ(record.expires_at_ms.has_value(), i % 7 == 0);
+    }
+}
+
+// small chunks, several threads: the callback still sees the file in order
+TEST_F(DataFileTest, ParallelScanMatchesSequential) {
+    write_file(5000);
+    std::vector<Seen> sequential;
+    std::vector<Seen> parallel;
+    EXPECT_EQ(scan_all(sequential, 1, 8 * 1024 * 1024), end_);
+    EXPECT_EQ(scan_all(parallel, 4, 4096), end_);
+
+    ASSERT_EQ(parallel.size(), sequential.size());
+    for (std::size_t i = 0; i < parallel.size(); ++i) {
+        ASSERT_EQ(parallel[i].offset, sequential[i].offset) << i;
+        EXPECT_EQ(parallel[i].key, sequential[i].key);
+        EXPECT_EQ(parallel[i].value, sequential[i].value);
+        EXPECT_EQ(parallel[i].expires_at_ms, sequential[i].expires_at_ms);
+    }
+}
+
+TEST_F(DataFileTest, ScanHonoursRange) {
+    write_file(100);
+    std::vector<Seen> seen;
+    EXPECT_EQ(scan_all(seen, 2, 512, offsets_[10], offsets_[20]), offsets_[20]);
+    ASSERT_EQ(seen.size(), 10);
+    EXPECT_EQ(seen.front().key, key(10));
+    EXPECT_EQ(seen.back().key, key(19));
+
+    seen.clear();
+    EXPECT_EQ(scan_all(seen, 1, 512, end_), end_);
+    EXPECT_TRUE(seen.empty());
+}
+
+// a bad checksum in a chunk other threads are already past stops the scan right there
+TEST_F(DataFileTest, ScanStopsAtCorruptRecord) {
+    write_file(3000);
+    flip_byte(offsets_[1500] + kFrameSize + 2);  // inside the key length
+    std::vector<Seen> seen;
+    EXPECT_EQ(scan_all(seen, 4, 2048), offsets_[1500]);
+    ASSERT_EQ(seen.size(), 1500);
+    EXPECT_EQ(seen.back().key, key(1499));
+}
+
+TEST_F(DataFileTest, ScanStopsAtImpossibleLength) {
+    write_file(1000);
+    flip_byte(offsets_[400] + 7);  // top byte of the body length
+    std::vector<Seen> seen;
+    EXPECT_EQ(scan_all(seen, 3, 1024), offsets_[400]);
+    EXPECT_EQ(seen.size(), 400);
+}
+
+TEST_F(DataFileTest, ScanStopsAtTornTail) {
+    write_file(1000);
+    std::filesystem::resize_file(path_, offsets_[999] + 5);
+    reopen();
+    std::vector<Seen> seen;
+    EXPECT_EQ(scan_all(seen, 4, 1024), offsets_[999]);
+    EXPECT_EQ(seen.size(), 999);
+}
+
+TEST_F(DataFileTest, EstimatesRecordCount) {
+    write_file(4000);
+    ScanOptions options;
+    options.threads = 2;
+    options.chunk_bytes = 16 * 1024;
+    int calls = 0;
+    uint64_t estimate = 0;
+    options.on_estimate = [&](uint64_t records) {
+        ++calls;
+        estimate = records;
+    };
+    int records = 0;
+    (void)scan(fd_, kHeaderSize, UINT64_MAX, options, [&](const ScannedRecord&) { ++records; });
+    EXPECT_EQ(calls, 1);
+    EXPECT_GT(estimate, 2000);
+    EXPECT_LT(estimate, 8000);
+    EXPECT_EQ(records, 4000);
+}
+
+TEST_F(DataFileTest, CallbackExceptionPropagates) {
+    write_file(2000);
+    ScanOptions options;
+    options.threads = 4;
+    options.chunk_bytes = 1024;
+    int records = 0;
+    EXPECT_THROW((void)scan(fd_, kHeaderSize, UINT64_MAX, options,
+                            [&](const ScannedRecord&) {
+                                if (++records == 100) {
+                                    throw std::runtime_error("stop");
+                                }
+                            }),
+                 std::runtime_error);
+    EXPECT_EQ(records, 100);
+}
+
+}  // namespace kvstore::core::data_file::test
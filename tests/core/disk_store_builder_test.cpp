@@ -0,0 +1,221 @@
+#include "kvstore/core/disk_store_builder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "kvstore/core/disk_store.hpp"
+#include "kvstore/util/clock.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core::test {
+
+namespace util = kvstore::util;
+
+class DiskStoreBuilderTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "disk_store_builder_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        build_dir_ = test_dir_ / "build";
+        store_dir_ = test_dir_ / "store";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    DiskStoreBuilder make_builder(std::size_t threads = 4) {
+        DiskStoreBuilderOptions opts;
+        opts.output_dir = build_dir_;
+        opts.threads = threads;
+        return DiskStoreBuilder(opts);
+    }
+
+    std::unique_ptr<DiskStore> open(const std::filesystem::path& dir,
+                                    IndexMode mode = IndexMode::Full) {
+        DiskStoreOptions opts;
+        opts.data_dir = dir;
+        opts.index_mode = mode;
+        opts.clock = clock_;
+        return std::make_unique<DiskStore>(opts);
+    }
+
+    static std::string key(int i) {
+        return "key" + std::to_string(i);
+    }
+
+    static std::string value(int i) {
+        return "value" + std::to_string(i) + std::string(static_cast<std::size_t>(i % 50), 'x');
+    }
+
+    std::filesystem::path test_dir_;
+    std::filesystem::path build_dir_;
+    std::filesystem::path store_dir_;
+    std::shared_ptr<util::MockClock> clock_ = std::make_shared<util::MockClock>();
+};
+
+TEST_F(DiskStoreBuilderTest, BuildsAStoreDirectory) {
+    auto builder = make_builder();
+    for (int i = 999; i >= 0; --i) {  // unsorted input
+        builder.add(key(i), value(i));
+    }
+    DiskStoreBuildStats stats = builder.finish();
+    EXPECT_EQ(stats.records, 1000);
+    EXPECT_EQ(stats.keys, 1000);
+    EXPECT_EQ(stats.data_bytes, std::filesystem::file_size(build_dir_ / "data.kvds"));
+    EXPECT_TRUE(std::filesystem::exists(build_dir_ / "data.hint"));
+
+    auto store = open(build_dir_);
+    EXPECT_EQ(store->size(), 1000);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(store->get(key(i)), value(i)) << i;
+    }
+    EXPECT_FALSE(store->get("missing").has_value());
+}
+
+TEST_F(DiskStoreBuilderTest, LastAddWins) {
+    auto builder = make_builder();
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            builder.add(key(i), value(i) + "-" + std::to_string(round));
+        }
+    }
+    DiskStoreBuildStats stats = builder.finish();
+    EXPECT_EQ(stats.records, 300);
+    EXPECT_EQ(stats.keys, 100);
+
+    auto store = open(build_dir_);
+    EXPECT_EQ(store->size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(store->get(key(i)), value(i) + "-2");
+    }
+}
+
+// the partitioning only decides where records go in the file, not what the store holds
+TEST_F(DiskStoreBuilderTest, ThreadCountDoesNotChangeTheContents) {
+    uint64_t data_bytes[2];
+    std::size_t threads[2] = {1, 7};
+    for (int run = 0; run < 2; ++run) {
+        build_dir_ = test_dir_ / ("build" + std::to_string(run));
+        auto builder = make_builder(threads[run]);
+        for (int i = 0; i < 2000; ++i) {
+            builder.add(key(i % 1500), value(i));
+        }
+        data_bytes[run] = builder.finish().data_bytes;
+    }
+    EXPECT_EQ(data_bytes[0], data_bytes[1]);
+
+    auto single = open(test_dir_ / "build0");
+    auto parallel = open(test_dir_ / "build1");
+    EXPECT_EQ(single->size(), 1500);
+    EXPECT_EQ(parallel->size(), 1500);
+    for (int i = 0; i < 1500; ++i) {
+        ASSERT_EQ(single->get(key(i)), parallel->get(key(i))) << i;
+    }
+}
+
+TEST_F(DiskStoreBuilderTest, KeepsExpiration) {
+    int64_t now_ms = util::to_epoch_ms(clock_->now());
+    auto builder = make_builder();
+    builder.add("forever", "1");
+    builder.add("soon", "2", now_ms + 1000);
+    builder.add("gone", "3", now_ms - 1000);
+    (void)builder.finish();
+
+    auto store = open(build_dir_);
+    EXPECT_EQ(store->get("forever"), "1");
+    EXPECT_EQ(store->get("soon"), "2");
+    EXPECT_FALSE(store->get("gone").has_value());
+
+    clock_->advance(util::Duration(2000));
+    EXPECT_FALSE(store->get("soon").has_value());
+    EXPECT_EQ(store->get("forever"), "1");
+}
+
+// without the hint the file is scanned like any other, in either index mode
+TEST_F(DiskStoreBuilderTest, OpensWithoutHintAndInCompactMode) {
+    auto builder = make_builder();
+    for (int i = 0; i < 500; ++i) {
+        builder.add(key(i), value(i));
+    }
+    (void)builder.finish();
+    std::filesystem::remove(build_dir_ / "data.hint");
+
+    {
+        auto store = open(build_dir_, IndexMode::Compact);
+        EXPECT_EQ(store->size(), 500);
+        for (int i = 0; i < 500; ++i) {
+            ASSERT_EQ(store->get(key(i)), value(i)) << i;
+        }
+    }
+    auto store = open(build_dir_);
+    EXPECT_EQ(store->size(), 500);
+    EXPECT_EQ(store->get(key(123)), value(123));
+}
+
+TEST_F(DiskStoreBuilderTest, RefusesToOverwriteADataFile) {
+    auto first = make_builder();
+    first.add("a", "1");
+    (void)first.finish();
+
+    auto second = make_builder();
+    second.add("a", "2");
+    EXPECT_THROW((void)second.finish(), std::runtime_error);
+
+    auto store = open(build_dir_);
+    EXPECT_EQ(store->get("a"), "1");
+}
+
+TEST_F(DiskStoreBuilderTest, AdoptReplacesContents) {
+    auto store = open(store_dir_);
+    store->put("old", "gone after adopt");
+    store->put(key(1), "overwritten");
+
+    auto builder = make_builder();
+    for (int i = 0; i < 300; ++i) {
+        builder.add(key(i), value(i));
+    }
+    (void)builder.finish();
+
+    store->adopt(build_dir_);
+    EXPECT_FALSE(std::filesystem::exists(build_dir_ / "data.kvds"));
+    EXPECT_FALSE(store->get("old").has_value());
+    EXPECT_EQ(store->size(), 300);
+    EXPECT_EQ(store->get(key(1)), value(1));
+
+    // the adopted file is the store's own now: writes append to it and survive a reopen
+    store->put("new", "after adopt");
+    EXPECT_TRUE(store->remove(key(2)));
+    store.reset();
+
+    store = open(store_dir_);
+    EXPECT_EQ(store->size(), 300);
+    EXPECT_EQ(store->get("new"), "after adopt");
+    EXPECT_FALSE(store->get(key(2)).has_value());
+    EXPECT_EQ(store->get(key(299)), value(299));
+    EXPECT_FALSE(store->get("old").has_value());
+}
+
+TEST_F(DiskStoreBuilderTest, AdoptRejectsBadInput) {
+    auto store = open(store_dir_);
+    store->put("a", "1");
+
+    EXPECT_THROW(store->adopt(build_dir_), std::runtime_error);  // nothing there
+
+    std::filesystem::create_directories(build_dir_);
+    {
+        std::ofstream f(build_dir_ / "data.kvds", std::ios::binary);
+        f << "not a data file";
+    }
+    EXPECT_THROW(store->adopt(build_dir_), std::runtime_error);
+
+    EXPECT_EQ(store->get("a"), "1");
+    store->put("b", "2");
+    EXPECT_EQ(store->size(), 2);
+}
+
+}  // namespace kvstore::core::test
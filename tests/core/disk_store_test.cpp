@@ -2,15 +2,29 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
 
+#include "kvstore/util/binary_io.hpp"
 #include "kvstore/util/clock.hpp"
+#include "kvstore/util/file_io.hpp"
 #include "kvstore/util/types.hpp"
 
 namespace kvstore::core::test {
 
 namespace util = kvstore::util;
 
+// what a ValueRegion would send
+std::string read_region(const ValueRegion& region) {
+    std::string bytes(region.size(), '\0');
+    util::pread_all(region.fd(), bytes.data(), bytes.size(), region.offset());
+    return bytes;
+}
+
 class DiskStoreTest : public ::testing::Test {
    protected:
     void SetUp() override {
@@ -195,6 +209,1212 @@ TEST_F(DiskStoreTest, Compaction) {
     EXPECT_EQ(*result, "value19");
 }
 
+TEST_F(DiskStoreTest, HintWrittenOnCompactionAndClose) {
+    store_->put("key1", "value1");
+    store_->compact();
+    EXPECT_TRUE(std::filesystem::exists(test_dir_ / "data.hint"));
+
+    std::filesystem::remove(test_dir_ / "data.hint");
+    store_->put("key2", "value2");
+    store_.reset();
+    EXPECT_TRUE(std::filesystem::exists(test_dir_ / "data.hint"));
+}
+
+TEST_F(DiskStoreTest, HintDisabled) {
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    opts.use_hint_file = false;
+    store_ = std::make_unique<DiskStore>(opts);
+
+    store_->put("key1", "value1");
+    store_->compact();
+    store_.reset();
+    EXPECT_FALSE(std::filesystem::exists(test_dir_ / "data.hint"));
+}
+
+TEST_F(DiskStoreTest, RecoversHintPlusTail) {
+    store_->put("key1", "value1");
+    store_->put("key2", "value2");
+    store_->compact();
+
+    // keep the hint as it was right after compaction - simulates a crash later on
+    auto hint_copy = test_dir_ / "hint.copy";
+    std::filesystem::copy_file(test_dir_ / "data.hint", hint_copy);
+
+    store_->put("key3", "value3");
+    store_->put("key2", "value2b");
+    (void)store_->remove("key1");
+    store_.reset();
+
+    std::filesystem::copy_file(hint_copy, test_dir_ / "data.hint",
+                               std::filesystem::copy_options::overwrite_existing);
+
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    store_ = std::make_unique<DiskStore>(opts);
+
+    EXPECT_EQ(store_->size(), 2);
+    EXPECT_FALSE(store_->contains("key1"));
+    EXPECT_EQ(store_->get("key2"), "value2b");
+    EXPECT_EQ(store_->get("key3"), "value3");
+}
+
+TEST_F(DiskStoreTest, IgnoresStaleHint) {
+    for (int i = 0; i < 100; ++i) {
+        store_->put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    store_.reset();
+
+    auto hint_copy = test_dir_ / "hint.copy";
+    std::filesystem::copy_file(test_dir_ / "data.hint", hint_copy);
+
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    store_ = std::make_unique<DiskStore>(opts);
+    store_->clear();
+    store_->put("only", "value");
+    store_.reset();
+
+    // hint now claims more data than the (cleared) data file holds
+    std::filesystem::copy_file(hint_copy, test_dir_ / "data.hint",
+                               std::filesystem::copy_options::overwrite_existing);
+
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->size(), 1);
+    EXPECT_EQ(store_->get("only"), "value");
+    EXPECT_FALSE(store_->contains("key0"));
+}
+
+// a hint that fails its checksum is ignored: the index comes from a full scan
+TEST_F(DiskStoreTest, IgnoresCorruptHint) {
+    for (int i = 0; i < 100; ++i) {
+        store_->put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    store_.reset();
+
+    auto hint_path = test_dir_ / "data.hint";
+    auto size = std::filesystem::file_size(hint_path);
+    {
+        std::fstream f(hint_path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekg(static_cast<std::streamoff>(size / 2));
+        char byte = 0;
+        f.read(&byte, 1);
+        byte = static_cast<char>(byte ^ 0x5a);
+        f.seekp(static_cast<std::streamoff>(size / 2));
+        f.write(&byte, 1);
+    }
+
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(store_->get("key" + std::to_string(i)), "value" + std::to_string(i));
+    }
+}
+
+TEST_F(DiskStoreTest, ConcurrentWriters) {
+    constexpr int kThreads = 8;
+    constexpr int kKeysPerThread = 200;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < kKeysPerThread; ++i) {
+                std::string suffix = std::to_string(t) + "_" + std::to_string(i);
+                store_->put("key" + suffix, "value" + suffix);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    EXPECT_EQ(store_->size(), kThreads * kKeysPerThread);
+
+    // every record must have landed intact in the file, not just in the index
+    store_.reset();
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    opts.use_hint_file = false;
+    std::filesystem::remove(test_dir_ / "data.hint");
+    store_ = std::make_unique<DiskStore>(opts);
+
+    EXPECT_EQ(store_->size(), kThreads * kKeysPerThread);
+    for (int t = 0; t < kThreads; ++t) {
+        for (int i = 0; i < kKeysPerThread; ++i) {
+            std::string suffix = std::to_string(t) + "_" + std::to_string(i);
+            EXPECT_EQ(store_->get("key" + suffix), "value" + suffix);
+        }
+    }
+}
+
+TEST_F(DiskStoreTest, ConcurrentRemoveOnlyOneWins) {
+    for (int round = 0; round < 20; ++round) {
+        store_->put("key", "value");
+
+        std::atomic<int> removed{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([this, &removed]() {
+                if (store_->remove("key")) {
+                    ++removed;
+                }
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+
+        EXPECT_EQ(removed.load(), 1);
+        EXPECT_FALSE(store_->contains("key"));
+    }
+}
+
+TEST_F(DiskStoreTest, SyncModes) {
+    for (auto mode : {SyncMode::Always, SyncMode::Batch, SyncMode::Os}) {
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+
+        DiskStoreOptions opts;
+        opts.data_dir = test_dir_;
+        opts.sync_mode = mode;
+        opts.sync_interval = util::Duration(0);
+        store_ = std::make_unique<DiskStore>(opts);
+
+        store_->put("key1", "value1");
+        store_->put("key2", "value2");
+        (void)store_->remove("key1");
+
+        store_.reset();
+        store_ = std::make_unique<DiskStore>(opts);
+
+        EXPECT_FALSE(store_->contains("key1"));
+        EXPECT_EQ(store_->get("key2"), "value2");
+    }
+}
+
+// one write and then nothing: SyncMode::Batch still syncs it, sync_interval later
+TEST_F(DiskStoreTest, BatchSyncsAfterIdleInterval) {
+    store_.reset();
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    opts.sync_mode = SyncMode::Batch;
+    opts.sync_interval = util::Duration(100);
+    store_ = std::make_unique<DiskStore>(opts);
+
+    store_->put("key", "value");
+    EXPECT_TRUE(store_->pending_sync());
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (store_->pending_sync() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_FALSE(store_->pending_sync());
+    EXPECT_EQ(store_->get("key"), "value");
+}
+
+TEST_F(DiskStoreTest, MultiGet) {
+    store_->put("a", "1");
+    store_->put("b", std::string(100000, 'b'));
+    store_->put("c", "");
+
+    std::vector<std::string_view> keys{"a", "missing", "b", "c", "a"};
+    auto values = store_->multi_get(keys);
+    ASSERT_EQ(values.size(), keys.size());
+    EXPECT_EQ(values[0], "1");
+    EXPECT_FALSE(values[1].has_value());
+    EXPECT_EQ(values[2], std::string(100000, 'b'));
+    EXPECT_EQ(values[3], "");
+    EXPECT_EQ(values[4], "1");
+    EXPECT_TRUE(store_->multi_get({}).empty());
+}
+
+TEST_F(DiskStoreTest, MultiPut) {
+    store_->put("a", "old");
+    std::string large(100000, 'b');
+    std::vector<KeyValue> entries{{"a", "1"}, {"b", large}, {"a", "2"}};
+    store_->multi_put(entries);
+    store_->multi_put({});
+    EXPECT_EQ(store_->size(), 2);
+    EXPECT_EQ(store_->get("a"), "2");
+
+    // more than one group commit batch of records
+    std::vector<std::string> keys;
+    std::vector<KeyValue> many;
+    for (int i = 0; i < 3000; ++i) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    std::string value(1000, 'v');
+    for (const std::string& key : keys) {
+        many.push_back({key, value});
+    }
+    store_->multi_put(many);
+    EXPECT_EQ(store_->size(), 3002);
+
+    store_.reset();
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->size(), 3002);
+    EXPECT_EQ(store_->get("a"), "2");
+    EXPECT_EQ(store_->get("b"), large);
+    EXPECT_EQ(store_->get("key2999"), value);
+}
+
+// batched reads (multi_get, compaction) give the same results on every I/O backend
+TEST_F(DiskStoreTest, IoBackends) {
+    for (auto backend : {util::IoBackend::Sync, util::IoBackend::IoUring}) {
+        SCOPED_TRACE(std::string(util::to_string(backend)));
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+
+        DiskStoreOptions opts;
+        opts.data_dir = test_dir_;
+        opts.io_backend = backend;
+        store_ = std::make_unique<DiskStore>(opts);
+
+        // enough data for several compaction read batches, plus one value bigger than a batch
+        std::vector<std::string> keys;
+        for (int i = 0; i < 600; ++i) {
+            keys.push_back("key" + std::to_string(i));
+            store_->put(keys.back(), std::string(4000, static_cast<char>('a' + i % 26)));
+        }
+        store_->put("huge", std::string(3 << 20, 'h'));
+        for (int i = 0; i < 600; i += 3) {
+            ASSERT_TRUE(store_->remove(keys[i]));
+        }
+        store_->compact();
+
+        std::vector<std::string_view> views(keys.begin(), keys.end());
+        auto values = store_->multi_get(views);
+        for (int i = 0; i < 600; ++i) {
+            if (i % 3 == 0) {
+                ASSERT_FALSE(values[i].has_value());
+            } else {
+                ASSERT_EQ(values[i], std::string(4000, static_cast<char>('a' + i % 26)));
+            }
+        }
+        EXPECT_EQ(store_->get("huge"), std::string(3 << 20, 'h'));
+
+        store_.reset();
+        store_ = std::make_unique<DiskStore>(opts);
+        EXPECT_EQ(store_->get("key1"), std::string(4000, 'b'));
+        EXPECT_EQ(store_->size(), 401);
+    }
+}
+
+// cached values never outlive an overwrite, a remove or compaction moving the records
+TEST_F(DiskStoreTest, ValueCache) {
+    store_.reset();
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    opts.value_cache_bytes = 1024 * 1024;
+    opts.blob_threshold = 1000;
+    opts.blob_gc_interval = util::Duration(0);
+    store_ = std::make_unique<DiskStore>(opts);
+
+    for (int i = 0; i < 100; ++i) {
+        store_->put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    store_->put("blob", std::string(5000, 'b'));
+    // two misses each: the first read only gets the key past the cache's doorkeeper
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(store_->get("key1"), "value1");
+        EXPECT_EQ(store_->get("blob"), std::string(5000, 'b'));
+    }
+    ValueCacheStats stats = store_->value_cache_stats();
+    EXPECT_EQ(stats.hits, 2);
+    EXPECT_EQ(stats.misses, 4);
+
+    store_->put("key1", "changed");
+    EXPECT_EQ(store_->get("key1"), "changed");
+    ASSERT_TRUE(store_->remove("blob"));
+    EXPECT_FALSE(store_->get("blob").has_value());
+
+    // multi_get reads through the cache and fills it
+    std::vector<std::string_view> keys{"key1", "key2", "missing"};
+    for (int i = 0; i < 2; ++i) {
+        auto values = store_->multi_get(keys);
+        EXPECT_EQ(values[0], "changed");
+        EXPECT_EQ(values[1], "value2");
+    }
+    EXPECT_EQ(store_->get("key2"), "value2");
+
+    for (int i = 50; i < 100; ++i) {
+        ASSERT_TRUE(store_->remove("key" + std::to_string(i)));
+    }
+    uint64_t hits_before = store_->value_cache_stats().hits;
+    store_->compact();
+    EXPECT_EQ(store_->get("key1"), "changed");
+    EXPECT_EQ(store_->get("key2"), "value2");
+    EXPECT_EQ(store_->value_cache_stats().hits, hits_before + 2);  // survived the compaction
+    store_->put("key2", "after compaction");
+    EXPECT_EQ(store_->get("key2"), "after compaction");
+
+    store_->clear();
+    EXPECT_FALSE(store_->get("key1").has_value());
+    EXPECT_EQ(store_->value_cache_stats().entries, 0);
+}
+
+TEST_F(DiskStoreTest, OpenValue) {
+    std::string large(100000, 'x');
+    store_->put("small", "value");
+    store_->put("large", large);
+    EXPECT_FALSE(store_->open_value("small", 1024).has_value());
+    EXPECT_FALSE(store_->open_value("missing", 0).has_value());
+
+    auto region = store_->open_value("large", 1024);
+    ASSERT_TRUE(region.has_value());
+    EXPECT_EQ(region->size(), large.size());
+    EXPECT_EQ(read_region(*region), large);
+}
+
+// one lookup per key: small values read, large ones handed back as regions
+TEST_F(DiskStoreTest, MultiGetWithRegions) {
+    std::string large(100000, 'x');
+    store_->put("small", "value");
+    store_->put("large", large);
+
+    std::vector<std::string_view> keys = {"small", "large", "missing"};
+    std::vector<std::optional<ValueRegion>> regions;
+    auto values = store_->multi_get(keys, 1024, regions);
+    ASSERT_EQ(values.size(), 3);
+    ASSERT_EQ(regions.size(), 3);
+    EXPECT_EQ(values[0], "value");
+    EXPECT_FALSE(regions[0].has_value());
+    EXPECT_FALSE(values[1].has_value());
+    ASSERT_TRUE(regions[1].has_value());
+    EXPECT_EQ(read_region(*regions[1]), large);
+    EXPECT_FALSE(values[2].has_value());
+    EXPECT_FALSE(regions[2].has_value());
+}
+
+// a transfer in flight keeps reading the old bytes after compaction replaced the data file
+TEST_F(DiskStoreTest, OpenValueSurvivesCompaction) {
+    std::string large(100000, 'x');
+    store_->put("large", large);
+    auto region = store_->open_value("large", 1024);
+    ASSERT_TRUE(region.has_value());
+
+    store_->put("large", std::string(100000, 'y'));
+    for (int i = 0; i < 10; ++i) {
+        store_->put("key" + std::to_string(i), "value");
+        (void)store_->remove("key" + std::to_string(i));
+    }
+    store_->compact();
+    EXPECT_EQ(read_region(*region), large);
+    EXPECT_EQ(read_region(*store_->open_value("large", 1024)), std::string(100000, 'y'));
+}
+
+// ... and after clear(), which swaps in a new file too: the old bytes, not the ones appended since
+TEST_F(DiskStoreTest, OpenValueSurvivesClear) {
+    std::string large(100000, 'x');
+    store_->put("large", large);
+    auto region = store_->open_value("large", 1024);
+    ASSERT_TRUE(region.has_value());
+
+    store_->clear();
+    store_->put("large", std::string(100000, 'y'));
+    EXPECT_EQ(read_region(*region), large);
+    EXPECT_EQ(read_region(*store_->open_value("large", 1024)), std::string(100000, 'y'));
+
+    // the new file is a complete store: reopened, it holds what was written after the clear
+    store_.reset();
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->size(), 1);
+    EXPECT_EQ(store_->get("large"), std::string(100000, 'y'));
+}
+
+// a crash mid append leaves a partial record behind: the next open cuts it off and appends
+// continue from the last intact record
+TEST_F(DiskStoreTest, TruncatesTornTail) {
+    store_->put("key1", "value1");
+    store_->put("key2", "value2");
+    store_.reset();
+    auto data_path = test_dir_ / "data.kvds";
+    uint64_t intact_size = std::filesystem::file_size(data_path);
+    {
+        std::ofstream out(data_path, std::ios::binary | std::ios::app);
+        out << std::string("\x1c\x00\x00\x00\x0f\x00\x00\x00\x00\x04", 10);
+    }
+
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(std::filesystem::file_size(data_path), intact_size);
+    EXPECT_EQ(store_->size(), 2);
+    store_->put("key3", "value3");
+    store_.reset();
+
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->get("key1"), "value1");
+    EXPECT_EQ(store_->get("key2"), "value2");
+    EXPECT_EQ(store_->get("key3"), "value3");
+}
+
+// a flipped bit fails the record's checksum - the store comes back as of the record before it
+TEST_F(DiskStoreTest, CorruptRecordEndsTheLog) {
+    store_.reset();
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    opts.use_hint_file = false;
+    store_ = std::make_unique<DiskStore>(opts);
+    auto data_path = test_dir_ / "data.kvds";
+    store_->put("key1", "value1");
+    uint64_t second_record = std::filesystem::file_size(data_path);
+    store_->put("key2", "value2");
+    store_->put("key3", "value3");
+    store_.reset();
+    {
+        std::fstream file(data_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(second_record + 16));
+        file.put('X');
+    }
+
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->size(), 1);
+    EXPECT_EQ(store_->get("key1"), "value1");
+    EXPECT_FALSE(store_->contains("key2"));
+    EXPECT_FALSE(store_->contains("key3"));
+    EXPECT_EQ(std::filesystem::file_size(data_path), second_record);
+}
+
+// a data file from before record checksums is rewritten in the current format on open
+TEST_F(DiskStoreTest, UpgradesVersion1File) {
+    store_.reset();
+    std::filesystem::remove_all(test_dir_);
+    std::filesystem::create_directories(test_dir_);
+    {
+        auto record = [](std::string& buf, uint8_t type, std::string_view key,
+                         std::string_view value, bool expires) {
+            util::append_int<uint8_t>(buf, type);
+            util::append_string(buf, key);
+            util::append_string(buf, value);
+            util::append_int<uint8_t>(buf, expires ? 1 : 0);
+            if (expires) {
+                util::append_int<uint64_t>(buf, 4102444800000);  // year 2100
+            }
+        };
+        std::string v1;
+        util::append_int<uint32_t>(v1, 0x4B564453);
+        util::append_int<uint32_t>(v1, 1);
+        record(v1, 0, "a", "1", false);
+        record(v1, 0, "b", "2", false);
+        record(v1, 1, "a", "", false);
+        record(v1, 0, "c", "3", true);
+        std::ofstream out(test_dir_ / "data.kvds", std::ios::binary);
+        out << v1;
+    }
+
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->size(), 2);
+    EXPECT_FALSE(store_->contains("a"));
+    EXPECT_EQ(store_->get("b"), "2");
+    EXPECT_EQ(store_->get("c"), "3");
+    store_->put("d", "4");
+    store_.reset();
+
+    std::ifstream in(test_dir_ / "data.kvds", std::ios::binary);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    ASSERT_TRUE(util::read_int<uint32_t>(in, magic));
+    ASSERT_TRUE(util::read_int<uint32_t>(in, version));
+    EXPECT_EQ(version, 2);
+
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->size(), 3);
+    EXPECT_EQ(store_->get("d"), "4");
+}
+
+// reserved blocks never show up in the file size - a reopen sees exactly the records
+TEST_F(DiskStoreTest, PreallocationKeepsFileSize) {
+    store_.reset();
+    std::filesystem::remove_all(test_dir_);
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_;
+    opts.preallocate_bytes = 1024 * 1024;
+    store_ = std::make_unique<DiskStore>(opts);
+    store_->put("key", "value");
+    EXPECT_LT(std::filesystem::file_size(test_dir_ / "data.kvds"), 100);
+    store_.reset();
+
+    opts.use_hint_file = false;
+    store_ = std::make_unique<DiskStore>(opts);
+    EXPECT_EQ(store_->get("key"), "value");
+}
+
+class DiskStoreCompactIndexTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "disk_store_compact_index_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        store_ = std::make_unique<DiskStore>(options());
+    }
+
+    void TearDown() override {
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    DiskStoreOptions options() {
+        DiskStoreOptions opts;
+        opts.data_dir = test_dir_;
+        opts.index_mode = IndexMode::Compact;
+        opts.clock = clock_;
+        return opts;
+    }
+
+    void reopen() {
+        store_.reset();
+        store_ = std::make_unique<DiskStore>(options());
+    }
+
+    std::filesystem::path test_dir_;
+    std::shared_ptr<util::MockClock> clock_ = std::make_shared<util::MockClock>();
+    std::unique_ptr<DiskStore> store_;
+};
+
+TEST_F(DiskStoreCompactIndexTest, BasicOperations) {
+    store_->put("key1", "value1");
+    store_->put("key1", "value2");
+    store_->put("key2", "value");
+    EXPECT_EQ(store_->get("key1"), "value2");
+    EXPECT_EQ(store_->size(), 2);
+
+    EXPECT_TRUE(store_->remove("key1"));
+    EXPECT_FALSE(store_->remove("key1"));
+    EXPECT_FALSE(store_->contains("key1"));
+    EXPECT_FALSE(store_->get("missing").has_value());
+    EXPECT_EQ(store_->size(), 1);
+}
+
+// values past the single-read window take a second pread - both for get and the expiry check
+TEST_F(DiskStoreCompactIndexTest, LargeValues) {
+    std::string large(100000, 'x');
+    store_->put("large", large, util::Duration(1000));
+    store_->put("last", "small");
+    EXPECT_EQ(store_->get("large"), large);
+    EXPECT_TRUE(store_->contains("large"));
+
+    clock_->advance(util::Duration(2000));
+    EXPECT_FALSE(store_->contains("large"));
+    EXPECT_EQ(store_->get("last"), "small");
+}
+
+// the deadline is stored with ms precision
+TEST_F(DiskStoreCompactIndexTest, GetWithExpiry) {
+    store_->put("ttl", "value", util::Duration(1000));
+    store_->put("plain", "value");
+    auto deadline = clock_->now() + util::Duration(1000);
+
+    std::optional<util::TimePoint> expires_at;
+    EXPECT_EQ(store_->get_with_expiry("ttl", expires_at), "value");
+    ASSERT_TRUE(expires_at.has_value());
+    EXPECT_LE(*expires_at, deadline);
+    EXPECT_GT(*expires_at, deadline - util::Duration(1));
+
+    EXPECT_EQ(store_->get_with_expiry("plain", expires_at), "value");
+    EXPECT_FALSE(expires_at.has_value());
+
+    clock_->advance(util::Duration(1000));
+    EXPECT_FALSE(store_->get_with_expiry("ttl", expires_at).has_value());
+}
+
+// no value sizes in the index - callers read those with get()
+TEST_F(DiskStoreCompactIndexTest, NoValueRegions) {
+    store_->put("large", std::string(100000, 'x'));
+    EXPECT_FALSE(store_->open_value("large", 0).has_value());
+
+    std::vector<std::string_view> keys = {"large"};
+    std::vector<std::optional<ValueRegion>> regions;
+    auto values = store_->multi_get(keys, 0, regions);
+    ASSERT_EQ(regions.size(), 1);
+    EXPECT_FALSE(regions[0].has_value());
+    EXPECT_EQ(values[0], std::string(100000, 'x'));
+}
+
+// thousands of keys force several rebuilds of the table from the data file
+TEST_F(DiskStoreCompactIndexTest, GrowsAndPersists) {
+    for (int i = 0; i < 5000; ++i) {
+        store_->put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    for (int i = 0; i < 5000; i += 3) {
+        store_->put("key" + std::to_string(i), "updated");
+    }
+    for (int i = 1; i < 5000; i += 3) {
+        ASSERT_TRUE(store_->remove("key" + std::to_string(i)));
+    }
+    reopen();
+
+    EXPECT_EQ(store_->size(), 5000 - 1667);
+    for (int i = 0; i < 5000; ++i) {
+        auto value = store_->get("key" + std::to_string(i));
+        if (i % 3 == 0) {
+            EXPECT_EQ(value, "updated") << i;
+        } else if (i % 3 == 1) {
+            EXPECT_FALSE(value.has_value()) << i;
+        } else {
+            EXPECT_EQ(value, "value" + std::to_string(i)) << i;
+        }
+    }
+}
+
+TEST_F(DiskStoreCompactIndexTest, CompactionKeepsLiveRecords) {
+    store_->put("expiring", "value", util::Duration(1000));
+    for (int i = 0; i < 100; ++i) {
+        store_->put("key" + std::to_string(i), "value" + std::to_string(i));
+        (void)store_->remove("key" + std::to_string(i - 1));
+    }
+    clock_->advance(util::Duration(2000));
+    store_->compact();
+
+    EXPECT_EQ(store_->size(), 1);
+    EXPECT_EQ(store_->get("key99"), "value99");
+    EXPECT_FALSE(store_->contains("expiring"));
+    EXPECT_FALSE(std::filesystem::exists(test_dir_ / "data.hint"));
+
+    reopen();
+    EXPECT_EQ(store_->size(), 1);
+    EXPECT_EQ(store_->get("key99"), "value99");
+}
+
+TEST_F(DiskStoreCompactIndexTest, OpensFullModeStoreWithHint) {
+    store_.reset();
+    {
+        DiskStoreOptions opts;
+        opts.data_dir = test_dir_;
+        DiskStore full(opts);
+        for (int i = 0; i < 100; ++i) {
+            full.put("key" + std::to_string(i), "value" + std::to_string(i));
+        }
+    }
+    ASSERT_TRUE(std::filesystem::exists(test_dir_ / "data.hint"));
+
+    store_ = std::make_unique<DiskStore>(options());
+    store_->put("key5", "changed");
+    reopen();
+
+    EXPECT_EQ(store_->size(), 100);
+    EXPECT_EQ(store_->get("key5"), "changed");
+    EXPECT_EQ(store_->get("key50"), "value50");
+}
+
+TEST_F(DiskStoreCompactIndexTest, UsesFarLessIndexMemory) {
+    constexpr int kKeys = 20000;
+    for (int i = 0; i < kKeys; ++i) {
+        store_->put("user:session:" + std::to_string(i), "v");
+    }
+
+    DiskStoreOptions opts;
+    opts.data_dir = test_dir_ / "full";
+    DiskStore full(opts);
+    for (int i = 0; i < kKeys; ++i) {
+        full.put("user:session:" + std::to_string(i), "v");
+    }
+
+    EXPECT_LT(store_->index_memory_usage() * 5, full.index_memory_usage());
+    EXPECT_LE(store_->index_memory_usage() / kKeys, 16);
+}
+
+TEST_F(DiskStoreCompactIndexTest, ConcurrentWritersAndReaders) {
+    constexpr int kThreads = 4;
+    constexpr int kKeysPerThread = 500;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < kKeysPerThread; ++i) {
+                std::string key = "key" + std::to_string(t) + "_" + std::to_string(i);
+                store_->put(key, "value");
+                EXPECT_EQ(store_->get(key), "value");
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    EXPECT_EQ(store_->size(), kThreads * kKeysPerThread);
+}
+
+class DiskStoreBlobTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "disk_store_blob_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        store_ = std::make_unique<DiskStore>(options());
+    }
+
+    void TearDown() override {
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    // small segments so a handful of values fill several of them. no background GC - the tests
+    // call collect_blob_garbage() themselves
+    DiskStoreOptions options() {
+        DiskStoreOptions opts;
+        opts.data_dir = test_dir_;
+        opts.blob_threshold = 512;
+        opts.blob_segment_size = 4096;
+        opts.blob_gc_rate = 0;
+        opts.blob_gc_interval = util::Duration(0);
+        opts.clock = clock_;
+        return opts;
+    }
+
+    void reopen() {
+        store_.reset();
+        store_ = std::make_unique<DiskStore>(options());
+    }
+
+    uint64_t blob_bytes() {
+        uint64_t total = 0;
+        for (const auto& file : std::filesystem::directory_iterator(test_dir_)) {
+            if (file.path().extension() == ".blob") {
+                total += file.file_size();
+            }
+        }
+        return total;
+    }
+
+    uint64_t data_bytes() {
+        return std::filesystem::file_size(test_dir_ / "data.kvds");
+    }
+
+    static std::string large_value(int i) {
+        return std::string(1000, static_cast<char>('a' + i % 26));
+    }
+
+    std::filesystem::path test_dir_;
+    std::shared_ptr<util::MockClock> clock_ = std::make_shared<util::MockClock>();
+    std::unique_ptr<DiskStore> store_;
+};
+
+TEST_F(DiskStoreBlobTest, SeparatesLargeValues) {
+    store_->put("small", "value");
+    store_->put("large", large_value(0));
+    EXPECT_EQ(store_->get("small"), "value");
+    EXPECT_EQ(store_->get("large"), large_value(0));
+    EXPECT_TRUE(store_->contains("large"));
+    EXPECT_EQ(store_->size(), 2);
+
+    // the data file only holds a pointer for the large value
+    EXPECT_LT(data_bytes(), 200);
+    EXPECT_GE(blob_bytes(), 1000);
+
+    EXPECT_TRUE(store_->remove("large"));
+    EXPECT_FALSE(store_->get("large").has_value());
+}
+
+// the region points into the blob segment - and keeps it readable after GC deleted it
+TEST_F(DiskStoreBlobTest, OpenValue) {
+    store_->put("large", large_value(0), util::Duration(1000));
+    auto region = store_->open_value("large", 512);
+    ASSERT_TRUE(region.has_value());
+    EXPECT_EQ(read_region(*region), large_value(0));
+
+    for (int i = 0; i < 20; ++i) {
+        store_->put("large", large_value(i + 1));
+    }
+    EXPECT_GT(store_->collect_blob_garbage(), 0);
+    EXPECT_EQ(read_region(*region), large_value(0));
+
+    store_->put("expiring", large_value(2), util::Duration(1000));
+    clock_->advance(util::Duration(1000));
+    EXPECT_FALSE(store_->open_value("expiring", 0).has_value());
+}
+
+TEST_F(DiskStoreBlobTest, PersistsAcrossReopen) {
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i));
+    }
+    store_->put("small", "value");
+
+    // clean close leaves a hint with the blob pointers
+    reopen();
+    ASSERT_TRUE(std::filesystem::exists(test_dir_ / "data.hint"));
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(i));
+    }
+
+    // and the same from a full data file scan
+    store_.reset();
+    std::filesystem::remove(test_dir_ / "data.hint");
+    store_ = std::make_unique<DiskStore>(options());
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(i));
+    }
+    EXPECT_EQ(store_->get("small"), "value");
+}
+
+TEST_F(DiskStoreBlobTest, CompactionCopiesOnlyPointers) {
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i));
+    }
+    for (int i = 0; i < 20; i += 2) {
+        ASSERT_TRUE(store_->remove("key" + std::to_string(i)));
+    }
+    uint64_t blobs_before = blob_bytes();
+
+    store_->compact();
+    EXPECT_EQ(blob_bytes(), blobs_before);
+    EXPECT_LT(data_bytes(), 1000);
+    EXPECT_EQ(store_->size(), 10);
+    for (int i = 1; i < 20; i += 2) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(i));
+    }
+}
+
+TEST_F(DiskStoreBlobTest, GarbageCollectionDeletesDeadSegments) {
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i));
+    }
+    // every value overwritten: the old segments hold nothing but garbage
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i + 1));
+    }
+    uint64_t blobs_before = blob_bytes();
+
+    std::size_t freed = store_->collect_blob_garbage();
+    EXPECT_GT(freed, 0);
+    EXPECT_EQ(blob_bytes(), blobs_before - freed);
+    EXPECT_LE(blob_bytes(), blobs_before / 2 + 4096);
+
+    reopen();
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(i + 1));
+    }
+}
+
+TEST_F(DiskStoreBlobTest, GarbageCollectionRelocatesLiveValues) {
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i), util::Duration(60000));
+    }
+    // half the keys die - the segments are ~50% garbage, the rest has to move
+    for (int i = 0; i < 20; i += 2) {
+        ASSERT_TRUE(store_->remove("key" + std::to_string(i)));
+    }
+    EXPECT_GT(store_->collect_blob_garbage(), 0);
+    for (int i = 1; i < 20; i += 2) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(i));
+    }
+
+    // relocation keeps the expiration time
+    clock_->advance(util::Duration(61000));
+    EXPECT_FALSE(store_->contains("key1"));
+
+    store_->put("after", large_value(3));
+    reopen();
+    EXPECT_EQ(store_->get("after"), large_value(3));
+    EXPECT_FALSE(store_->contains("key3"));
+}
+
+TEST_F(DiskStoreBlobTest, GarbageCollectionSkipsMostlyLiveSegments) {
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i));
+    }
+    store_->put("key0", "now small");
+    EXPECT_EQ(store_->collect_blob_garbage(), 0);
+}
+
+// a crash can leave pointers to blob bytes that never made it to disk
+TEST_F(DiskStoreBlobTest, DropsKeysWithMissingBlobs) {
+    store_->put("large", large_value(0));
+    store_->put("small", "value");
+    store_.reset();
+    for (const auto& file : std::filesystem::directory_iterator(test_dir_)) {
+        if (file.path().extension() == ".blob") {
+            std::filesystem::resize_file(file.path(), 8);
+        }
+    }
+
+    store_ = std::make_unique<DiskStore>(options());
+    EXPECT_FALSE(store_->get("large").has_value());
+    EXPECT_EQ(store_->get("small"), "value");
+    EXPECT_EQ(store_->size(), 1);
+}
+
+TEST_F(DiskStoreBlobTest, ClearRemovesBlobs) {
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i));
+    }
+    store_->clear();
+    EXPECT_EQ(store_->size(), 0);
+    EXPECT_LE(blob_bytes(), 8);
+
+    store_->put("key", large_value(1));
+    reopen();
+    EXPECT_EQ(store_->get("key"), large_value(1));
+}
+
+TEST_F(DiskStoreBlobTest, RejectsCompactIndexMode) {
+    DiskStoreOptions opts = options();
+    opts.index_mode = IndexMode::Compact;
+    EXPECT_THROW(DiskStore store(opts), std::invalid_argument);
+}
+
+TEST_F(DiskStoreBlobTest, BackgroundGarbageCollection) {
+    DiskStoreOptions opts = options();
+    opts.blob_gc_interval = util::Duration(5);
+    opts.blob_gc_rate = 1024 * 1024;
+    store_.reset();
+    store_ = std::make_unique<DiskStore>(opts);
+
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i));
+    }
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i + 1));
+    }
+    uint64_t blobs_before = blob_bytes();
+    for (int i = 0; i < 200 && blob_bytes() >= blobs_before; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_LT(blob_bytes(), blobs_before);
+    EXPECT_EQ(store_->get("key0"), large_value(1));
+}
+
+// a heavily throttled GC pass must not hold up shutdown
+TEST_F(DiskStoreBlobTest, ThrottledGarbageCollectionStopsOnClose) {
+    DiskStoreOptions opts = options();
+    opts.blob_gc_interval = util::Duration(1);
+    opts.blob_gc_rate = 1;
+    store_.reset();
+    store_ = std::make_unique<DiskStore>(opts);
+
+    for (int i = 0; i < 20; ++i) {
+        store_->put("key" + std::to_string(i), large_value(i));
+    }
+    for (int i = 0; i < 20; i += 2) {
+        store_->put("key" + std::to_string(i), "small");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto start = std::chrono::steady_clock::now();
+    store_.reset();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    store_ = std::make_unique<DiskStore>(options());
+    for (int i = 1; i < 20; i += 2) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(i));
+    }
+}
+
+// writers keep overwriting while GC relocates - whatever GC moves must never beat a newer write
+TEST_F(DiskStoreBlobTest, ConcurrentWritesDuringGarbageCollection) {
+    constexpr int kKeys = 20;
+    for (int i = 0; i < kKeys; ++i) {
+        store_->put("key" + std::to_string(i), large_value(0));
+    }
+
+    std::atomic<bool> done{false};
+    std::thread gc([&]() {
+        while (!done) {
+            store_->collect_blob_garbage();
+        }
+    });
+    for (int round = 1; round <= 20; ++round) {
+        for (int i = 0; i < kKeys; ++i) {
+            store_->put("key" + std::to_string(i), large_value(round));
+        }
+    }
+    done = true;
+    gc.join();
+
+    for (int i = 0; i < kKeys; ++i) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(20));
+    }
+    reopen();
+    for (int i = 0; i < kKeys; ++i) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), large_value(20));
+    }
+}
+
+class DiskStoreDirectIoTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "disk_store_direct_io_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        store_ = std::make_unique<DiskStore>(options());
+    }
+
+    void TearDown() override {
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    DiskStoreOptions options() {
+        DiskStoreOptions opts;
+        opts.data_dir = test_dir_;
+        opts.direct_io = true;
+        opts.block_cache_bytes = 1024 * 1024;
+        return opts;
+    }
+
+    void reopen(const DiskStoreOptions& opts) {
+        store_.reset();
+        store_ = std::make_unique<DiskStore>(opts);
+    }
+
+    static std::string value_of(int i) {
+        return std::string(100 + i % 50, static_cast<char>('a' + i % 26));
+    }
+
+    void put_keys(int count) {
+        for (int i = 0; i < count; ++i) {
+            store_->put("key" + std::to_string(i), value_of(i));
+        }
+    }
+
+    std::filesystem::path test_dir_;
+    std::unique_ptr<DiskStore> store_;
+};
+
+TEST_F(DiskStoreDirectIoTest, BasicOperationsAndPersistence) {
+    put_keys(2000);
+    ASSERT_TRUE(store_->remove("key7"));
+    store_->put("key8", "overwritten");
+    for (int i = 0; i < 2000; i += 97) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), value_of(i));
+    }
+
+    reopen(options());
+    EXPECT_EQ(store_->size(), 1999);
+    EXPECT_FALSE(store_->get("key7").has_value());
+    EXPECT_EQ(store_->get("key8"), "overwritten");
+    EXPECT_EQ(store_->get("key1999"), value_of(1999));
+}
+
+// second read of the same value comes from the block cache
+TEST_F(DiskStoreDirectIoTest, CountsHitsAndMisses) {
+    put_keys(1000);
+    EXPECT_EQ(store_->get("key10"), value_of(10));
+    BlockCacheStats first = store_->block_cache_stats();
+    EXPECT_GE(first.misses, 1);
+    EXPECT_EQ(first.hits, 0);
+
+    EXPECT_EQ(store_->get("key10"), value_of(10));
+    BlockCacheStats second = store_->block_cache_stats();
+    EXPECT_EQ(second.misses, first.misses);
+    EXPECT_GE(second.hits, 1);
+    EXPECT_EQ(second.capacity_bytes, 1024 * 1024);
+}
+
+// the last block is still being appended to - it must never be served stale from the cache
+TEST_F(DiskStoreDirectIoTest, TailBlockKeepsGrowing) {
+    for (int i = 0; i < 300; ++i) {
+        std::string key = "key" + std::to_string(i);
+        store_->put(key, value_of(i));
+        ASSERT_EQ(store_->get(key), value_of(i));
+        ASSERT_EQ(store_->get("key0"), value_of(0));
+    }
+    EXPECT_GT(store_->block_cache_stats().hits, 0);
+}
+
+TEST_F(DiskStoreDirectIoTest, CompactionAndClearInvalidateCache) {
+    put_keys(1000);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(store_->get("key" + std::to_string(i)), value_of(i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        ASSERT_TRUE(store_->remove("key" + std::to_string(i)));
+    }
+    store_->compact();
+    for (int i = 0; i < 1000; ++i) {
+        auto value = store_->get("key" + std::to_string(i));
+        if (i % 2 == 0) {
+            ASSERT_FALSE(value.has_value());
+        } else {
+            ASSERT_EQ(value, value_of(i));
+        }
+    }
+
+    store_->clear();
+    store_->put("fresh", "value");
+    EXPECT_EQ(store_->get("fresh"), "value");
+    EXPECT_FALSE(store_->get("key1").has_value());
+}
+
+// values bigger than one direct read, and bigger than the whole cache
+TEST_F(DiskStoreDirectIoTest, LargeValues) {
+    std::string large(3 * 1024 * 1024 + 17, 'x');
+    for (std::size_t i = 0; i < large.size(); i += 4093) {
+        large[i] = static_cast<char>('a' + i % 26);
+    }
+    store_->put("small", "s");
+    store_->put("large", large);
+    store_->put("after", "a");
+    EXPECT_EQ(store_->get("large"), large);
+    EXPECT_EQ(store_->get("large"), large);
+    EXPECT_EQ(store_->get("small"), "s");
+    EXPECT_EQ(store_->get("after"), "a");
+    EXPECT_LE(store_->block_cache_stats().used_bytes, 1024 * 1024);
+}
+
+TEST_F(DiskStoreDirectIoTest, MultiGetAndCompactIndex) {
+    put_keys(500);
+    std::vector<std::string_view> keys{"key1", "missing", "key499"};
+    auto values = store_->multi_get(keys);
+    EXPECT_EQ(values[0], value_of(1));
+    EXPECT_FALSE(values[1].has_value());
+    EXPECT_EQ(values[2], value_of(499));
+
+    store_.reset();
+    std::filesystem::remove_all(test_dir_);
+    DiskStoreOptions opts = options();
+    opts.index_mode = IndexMode::Compact;
+    reopen(opts);
+    put_keys(2000);
+    ASSERT_TRUE(store_->remove("key5"));
+    reopen(opts);
+    EXPECT_EQ(store_->size(), 1999);
+    EXPECT_FALSE(store_->get("key5").has_value());
+    EXPECT_EQ(store_->get("key1234"), value_of(1234));
+    EXPECT_TRUE(store_->contains("key0"));
+}
+
+// block_cache_bytes = 0: every read goes to the disk, nothing is counted
+TEST_F(DiskStoreDirectIoTest, WithoutBlockCache) {
+    DiskStoreOptions opts = options();
+    opts.block_cache_bytes = 0;
+    reopen(opts);
+    put_keys(100);
+    EXPECT_EQ(store_->get("key42"), value_of(42));
+    EXPECT_EQ(store_->get("key42"), value_of(42));
+    BlockCacheStats stats = store_->block_cache_stats();
+    EXPECT_EQ(stats.hits + stats.misses, 0);
+    EXPECT_EQ(stats.capacity_bytes, 0);
+}
+
+TEST_F(DiskStoreDirectIoTest, ConcurrentWritersAndReaders) {
+    constexpr int kThreads = 4;
+    constexpr int kKeysPerThread = 500;
+    put_keys(200);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < kKeysPerThread; ++i) {
+                std::string key = "t" + std::to_string(t) + "_" + std::to_string(i);
+                store_->put(key, value_of(i));
+                EXPECT_EQ(store_->get(key), value_of(i));
+                EXPECT_EQ(store_->get("key" + std::to_string(i % 200)), value_of(i % 200));
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    EXPECT_EQ(store_->size(), 200 + kThreads * kKeysPerThread);
+}
+
 class DiskStoreTTLTest : public ::testing::Test {
    protected:
     void SetUp() override {
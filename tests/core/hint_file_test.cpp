@@ -0,0 +1,201 @@
+#include "kvstore/core/hint_file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+namespace kvstore::core::test {
+
+using util::ExpirationTime;
+
+struct LoadedHint {
+    uint64_t offset;
+    uint32_t value_size;
+    ExpirationTime expires_at;
+    BlobPointer blob;
+};
+
+class HintFileTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "hint_file_test";
+        std::filesystem::create_directories(test_dir_);
+        hint_path_ = test_dir_ / "data.hint";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    std::optional<HintHeader> load(std::unordered_map<std::string, LoadedHint>& out) {
+        HintFile hint(hint_path_);
+        return hint.load([&out](std::string_view key, uint64_t offset, uint32_t value_size,
+                                ExpirationTime expires_at, const BlobPointer& blob) {
+            out[std::string(key)] = LoadedHint{offset, value_size, expires_at, blob};
+        });
+    }
+
+    std::filesystem::path test_dir_;
+    std::filesystem::path hint_path_;
+};
+
+TEST_F(HintFileTest, SaveAndLoad) {
+    {
+        HintFile hint(hint_path_);
+        hint.save(4096, 7, [](HintEmitter emit) {
+            emit("key1", 8, 6, std::nullopt, BlobPointer{});
+            emit("key2", 40, 100, 123456789, BlobPointer{});
+        });
+        EXPECT_TRUE(hint.exists());
+    }
+
+    std::unordered_map<std::string, LoadedHint> loaded;
+    auto header = load(loaded);
+
+    ASSERT_TRUE(header.has_value());
+    EXPECT_EQ(header->data_end, 4096);
+    EXPECT_EQ(header->tombstone_count, 7);
+    EXPECT_EQ(header->entry_count, 2);
+
+    ASSERT_EQ(loaded.size(), 2);
+    EXPECT_EQ(loaded["key1"].offset, 8);
+    EXPECT_EQ(loaded["key1"].value_size, 6);
+    EXPECT_FALSE(loaded["key1"].expires_at.has_value());
+    EXPECT_EQ(loaded["key2"].offset, 40);
+    EXPECT_EQ(loaded["key2"].value_size, 100);
+    ASSERT_TRUE(loaded["key2"].expires_at.has_value());
+    EXPECT_EQ(*loaded["key2"].expires_at, 123456789);
+}
+
+TEST_F(HintFileTest, BlobPointers) {
+    {
+        HintFile hint(hint_path_);
+        hint.save(4096, 0, [](HintEmitter emit) {
+            emit("inline", 8, 6, std::nullopt, BlobPointer{});
+            emit("blob", 40, 100000, 123456789, BlobPointer{3, 4096, 100000});
+        });
+    }
+
+    std::unordered_map<std::string, LoadedHint> loaded;
+    ASSERT_TRUE(load(loaded).has_value());
+    EXPECT_EQ(loaded["inline"].blob.segment, 0);
+    EXPECT_EQ(loaded["blob"].blob.segment, 3);
+    EXPECT_EQ(loaded["blob"].blob.offset, 4096);
+    EXPECT_EQ(loaded["blob"].blob.size, 100000);
+    EXPECT_EQ(*loaded["blob"].expires_at, 123456789);
+}
+
+// version 1 hints (no blob flag) are still accepted
+TEST_F(HintFileTest, LoadsVersion1) {
+    {
+        HintFile hint(hint_path_);
+        hint.save(4096, 0, [](HintEmitter emit) {
+            emit("key", 8, 6, 42, BlobPointer{});
+        });
+    }
+    {
+        std::fstream f(hint_path_, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(4);
+        uint32_t version = 1;
+        f.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+
+    std::unordered_map<std::string, LoadedHint> loaded;
+    ASSERT_TRUE(load(loaded).has_value());
+    EXPECT_EQ(*loaded["key"].expires_at, 42);
+}
+
+TEST_F(HintFileTest, MissingFile) {
+    std::unordered_map<std::string, LoadedHint> loaded;
+    EXPECT_FALSE(load(loaded).has_value());
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST_F(HintFileTest, BadHeader) {
+    {
+        std::ofstream f(hint_path_, std::ios::binary);
+        f << "not a hint file";
+    }
+    std::unordered_map<std::string, LoadedHint> loaded;
+    EXPECT_FALSE(load(loaded).has_value());
+}
+
+TEST_F(HintFileTest, TruncatedFile) {
+    {
+        HintFile hint(hint_path_);
+        hint.save(4096, 0, [](HintEmitter emit) {
+            for (int i = 0; i < 100; ++i) {
+                emit("key" + std::to_string(i), 8 + i, 10, std::nullopt, BlobPointer{});
+            }
+        });
+    }
+    std::filesystem::resize_file(hint_path_, std::filesystem::file_size(hint_path_) - 5);
+
+    std::unordered_map<std::string, LoadedHint> loaded;
+    EXPECT_FALSE(load(loaded).has_value());
+}
+
+// same length, one byte off: caught before any entry reaches the callback
+TEST_F(HintFileTest, CorruptEntryFailsChecksum) {
+    {
+        HintFile hint(hint_path_);
+        hint.save(4096, 0, [](HintEmitter emit) {
+            for (int i = 0; i < 100; ++i) {
+                emit("key" + std::to_string(i), 8 + i, 10, std::nullopt, BlobPointer{});
+            }
+        });
+    }
+    auto size = std::filesystem::file_size(hint_path_);
+    {
+        std::fstream f(hint_path_, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekg(static_cast<std::streamoff>(size / 2));
+        char byte = 0;
+        f.read(&byte, 1);
+        byte = static_cast<char>(byte ^ 0x5a);
+        f.seekp(static_cast<std::streamoff>(size / 2));
+        f.write(&byte, 1);
+    }
+    ASSERT_EQ(std::filesystem::file_size(hint_path_), size);
+
+    std::unordered_map<std::string, LoadedHint> loaded;
+    EXPECT_FALSE(load(loaded).has_value());
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST_F(HintFileTest, ZeroedFileFailsChecksum) {
+    {
+        HintFile hint(hint_path_);
+        hint.save(4096, 0, [](HintEmitter emit) {
+            emit("key", 8, 6, std::nullopt, BlobPointer{});
+        });
+    }
+    // keep the header, zero everything after it - what a lost write of the data looks like
+    auto size = std::filesystem::file_size(hint_path_);
+    {
+        std::fstream f(hint_path_, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(32);
+        std::string zeros(size - 32, '\0');
+        f.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+
+    std::unordered_map<std::string, LoadedHint> loaded;
+    EXPECT_FALSE(load(loaded).has_value());
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST_F(HintFileTest, Remove) {
+    HintFile hint(hint_path_);
+    hint.save(8, 0, [](HintEmitter) {});
+    EXPECT_TRUE(hint.exists());
+
+    hint.remove();
+    EXPECT_FALSE(hint.exists());
+
+    // removing a missing hint is a no-op
+    hint.remove();
+}
+
+}  // namespace kvstore::core::test
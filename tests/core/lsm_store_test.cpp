@@ -0,0 +1,246 @@
+#include "kvstore/core/lsm_store.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "kvstore/util/clock.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core::test {
+
+namespace util = kvstore::util;
+
+class LsmStoreTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "lsm_store_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        store_ = std::make_unique<LsmStore>(options());
+    }
+
+    void TearDown() override {
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    // tiny memtable/tables so a few thousand keys exercise flushes and multi-level compaction
+    LsmStoreOptions options() {
+        LsmStoreOptions opts;
+        opts.data_dir = test_dir_;
+        opts.memtable_size = 16 * 1024;
+        opts.block_size = 512;
+        opts.l0_compaction_trigger = 2;
+        opts.level_base_size = 32 * 1024;
+        opts.target_file_size = 8 * 1024;
+        opts.clock = clock_;
+        return opts;
+    }
+
+    void reopen() {
+        store_.reset();
+        store_ = std::make_unique<LsmStore>(options());
+    }
+
+    static std::string key(int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "key%06d", i);
+        return buf;
+    }
+
+    std::filesystem::path test_dir_;
+    std::shared_ptr<util::MockClock> clock_ = std::make_shared<util::MockClock>();
+    std::unique_ptr<LsmStore> store_;
+};
+
+TEST_F(LsmStoreTest, InitiallyEmpty) {
+    EXPECT_TRUE(store_->empty());
+    EXPECT_EQ(store_->size(), 0);
+}
+
+TEST_F(LsmStoreTest, PutGetOverwriteRemove) {
+    store_->put("key1", "value1");
+    store_->put("key1", "value2");
+    EXPECT_EQ(store_->get("key1"), "value2");
+    EXPECT_TRUE(store_->contains("key1"));
+
+    EXPECT_TRUE(store_->remove("key1"));
+    EXPECT_FALSE(store_->remove("key1"));
+    EXPECT_FALSE(store_->get("key1").has_value());
+    EXPECT_FALSE(store_->remove("missing"));
+    EXPECT_TRUE(store_->empty());
+}
+
+TEST_F(LsmStoreTest, FlushWritesLevel0Table) {
+    store_->put("a", "1");
+    store_->put("b", "2");
+    store_->flush();
+
+    EXPECT_EQ(store_->files_per_level()[0], 1);
+    EXPECT_EQ(store_->get("a"), "1");
+    EXPECT_EQ(store_->get("b"), "2");
+    EXPECT_EQ(store_->size(), 2);
+}
+
+TEST_F(LsmStoreTest, TombstoneShadowsFlushedValue) {
+    store_->put("a", "1");
+    store_->flush();
+    EXPECT_TRUE(store_->remove("a"));
+    EXPECT_FALSE(store_->get("a").has_value());
+
+    store_->flush();
+    EXPECT_FALSE(store_->get("a").has_value());
+    EXPECT_EQ(store_->size(), 0);
+}
+
+TEST_F(LsmStoreTest, ManyKeysAcrossLevels) {
+    for (int i = 0; i < 5000; ++i) {
+        store_->put(key(i), "value" + std::to_string(i));
+    }
+    // overwrite and delete some so compaction has shadowed versions to drop
+    for (int i = 0; i < 5000; i += 3) {
+        store_->put(key(i), "updated" + std::to_string(i));
+    }
+    for (int i = 1; i < 5000; i += 7) {
+        ASSERT_TRUE(store_->remove(key(i)));
+    }
+    store_->compact();
+
+    auto levels = store_->files_per_level();
+    EXPECT_LT(levels[0], 2);
+    std::size_t deeper = 0;
+    for (std::size_t level = 1; level < levels.size(); ++level) {
+        deeper += levels[level];
+    }
+    EXPECT_GT(deeper, 0);
+
+    std::size_t expected = 0;
+    for (int i = 0; i < 5000; ++i) {
+        auto value = store_->get(key(i));
+        if (i % 7 == 1) {
+            EXPECT_FALSE(value.has_value()) << key(i);
+            continue;
+        }
+        ++expected;
+        ASSERT_TRUE(value.has_value()) << key(i);
+        EXPECT_EQ(*value, (i % 3 == 0 ? "updated" : "value") + std::to_string(i));
+    }
+    EXPECT_EQ(store_->size(), expected);
+}
+
+TEST_F(LsmStoreTest, RecoversFromWal) {
+    store_->put("a", "1");
+    store_->put("b", "2");
+    EXPECT_TRUE(store_->remove("a"));
+    reopen();
+
+    EXPECT_FALSE(store_->get("a").has_value());
+    EXPECT_EQ(store_->get("b"), "2");
+    // recovered log is written out as a table on startup
+    EXPECT_EQ(store_->files_per_level()[0], 1);
+}
+
+TEST_F(LsmStoreTest, RecoversTablesAndWal) {
+    for (int i = 0; i < 2000; ++i) {
+        store_->put(key(i), "value" + std::to_string(i));
+    }
+    store_->compact();
+    store_->put("tail", "in the log");
+    reopen();
+
+    EXPECT_EQ(store_->size(), 2001);
+    EXPECT_EQ(store_->get(key(1234)), "value1234");
+    EXPECT_EQ(store_->get("tail"), "in the log");
+}
+
+TEST_F(LsmStoreTest, RemovesOrphanTables) {
+    store_->put("a", "1");
+    store_->flush();
+    store_.reset();
+
+    // leftover of a flush that crashed before the manifest update
+    std::filesystem::copy_file(test_dir_ / "000003.sst", test_dir_ / "000999.sst");
+    reopen();
+
+    EXPECT_FALSE(std::filesystem::exists(test_dir_ / "000999.sst"));
+    EXPECT_EQ(store_->get("a"), "1");
+}
+
+TEST_F(LsmStoreTest, TtlExpiresAcrossFlushAndCompaction) {
+    store_->put("short", "v", util::Duration(100));
+    store_->put("long", "v", util::Duration(100000));
+    store_->flush();
+    EXPECT_TRUE(store_->contains("short"));
+
+    clock_->advance(util::Duration(200));
+    EXPECT_FALSE(store_->get("short").has_value());
+    EXPECT_FALSE(store_->remove("short"));
+    EXPECT_TRUE(store_->contains("long"));
+    EXPECT_EQ(store_->size(), 1);
+
+    for (int i = 0; i < 3000; ++i) {
+        store_->put(key(i), "x");
+    }
+    store_->compact();
+    EXPECT_FALSE(store_->get("short").has_value());
+    EXPECT_TRUE(store_->contains("long"));
+}
+
+TEST_F(LsmStoreTest, ClearRemovesEverything) {
+    for (int i = 0; i < 2000; ++i) {
+        store_->put(key(i), "value");
+    }
+    store_->flush();
+    store_->clear();
+
+    EXPECT_TRUE(store_->empty());
+    EXPECT_FALSE(store_->get(key(5)).has_value());
+    for (auto count : store_->files_per_level()) {
+        EXPECT_EQ(count, 0);
+    }
+
+    store_->put("after", "clear");
+    reopen();
+    EXPECT_EQ(store_->size(), 1);
+    EXPECT_EQ(store_->get("after"), "clear");
+}
+
+TEST_F(LsmStoreTest, ConcurrentReadersAndWriters) {
+    constexpr int kWriters = 4;
+    constexpr int kPerWriter = 1000;
+    std::atomic<bool> done{false};
+    std::atomic<int> bad_reads{0};
+
+    std::thread reader([&] {
+        while (!done) {
+            auto value = store_->get(key(0));
+            if (value.has_value() && value->rfind("w", 0) != 0) {
+                ++bad_reads;
+            }
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < kWriters; ++w) {
+        writers.emplace_back([&, w] {
+            for (int i = 0; i < kPerWriter; ++i) {
+                store_->put(key(w * kPerWriter + i), "w" + std::to_string(w));
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(bad_reads, 0);
+    EXPECT_EQ(store_->size(), kWriters * kPerWriter);
+    EXPECT_EQ(store_->get(key(kPerWriter * 2 + 5)), "w2");
+}
+
+}  // namespace kvstore::core::test
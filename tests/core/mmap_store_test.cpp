@@ -0,0 +1,386 @@
+#include "kvstore/core/mmap_store.hpp"
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kvstore/util/clock.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core::test {
+
+namespace util = kvstore::util;
+
+class MmapStoreTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "mmap_store_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        store_ = std::make_unique<MmapStore>(options());
+    }
+
+    void TearDown() override {
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    // the smallest table, so a few thousand keys go through several rewrites
+    MmapStoreOptions options() {
+        MmapStoreOptions opts;
+        opts.data_dir = test_dir_;
+        opts.initial_capacity = 256;
+        opts.max_garbage_ratio = max_garbage_ratio_;
+        opts.sync_mode = SyncMode::Os;
+        opts.clock = clock_;
+        return opts;
+    }
+
+    void reopen() {
+        store_.reset();
+        store_ = std::make_unique<MmapStore>(options());
+    }
+
+    // runs fn against a store opened in a child process that then dies without closing it - the
+    // file is left exactly as a crash would leave it in the page cache
+    void crash_after(const std::function<void(MmapStore&)>& fn) {
+        store_.reset();
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            MmapStore store(options());
+            fn(store);
+            ::_exit(0);
+        }
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    // overwrite the bytes of a value in the file, like a record page that never hit the disk
+    void corrupt(std::string_view payload) {
+        auto path = test_dir_ / "mmap.kvm";
+        std::string data;
+        {
+            std::ifstream in(path, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        auto pos = data.find(payload);
+        ASSERT_NE(pos, std::string::npos);
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(static_cast<std::streamoff>(pos));
+        f.write(std::string(payload.size(), '#').data(),
+                static_cast<std::streamsize>(payload.size()));
+    }
+
+    static std::string key(int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "key%06d", i);
+        return buf;
+    }
+
+    std::filesystem::path test_dir_;
+    double max_garbage_ratio_ = 0.5;
+    std::shared_ptr<util::MockClock> clock_ = std::make_shared<util::MockClock>();
+    std::unique_ptr<MmapStore> store_;
+};
+
+TEST_F(MmapStoreTest, InitiallyEmpty) {
+    EXPECT_TRUE(store_->empty());
+    EXPECT_EQ(store_->size(), 0);
+    EXPECT_FALSE(store_->get("missing").has_value());
+    EXPECT_FALSE(store_->contains("missing"));
+}
+
+TEST_F(MmapStoreTest, PutGetOverwriteRemove) {
+    store_->put("key1", "value1");
+    store_->put("key1", "value2");
+    EXPECT_EQ(store_->get("key1"), "value2");
+    EXPECT_EQ(store_->size(), 1);
+
+    EXPECT_TRUE(store_->remove("key1"));
+    EXPECT_FALSE(store_->remove("key1"));
+    EXPECT_FALSE(store_->contains("key1"));
+    EXPECT_TRUE(store_->empty());
+
+    // a removed key can come back
+    store_->put("key1", "value3");
+    EXPECT_EQ(store_->get("key1"), "value3");
+    EXPECT_EQ(store_->size(), 1);
+}
+
+TEST_F(MmapStoreTest, EmptyKeyAndValue) {
+    store_->put("", "empty key");
+    store_->put("empty value", "");
+    EXPECT_EQ(store_->get(""), "empty key");
+    EXPECT_EQ(store_->get("empty value"), "");
+    reopen();
+    EXPECT_EQ(store_->get(""), "empty key");
+    EXPECT_EQ(store_->get("empty value"), "");
+}
+
+// random ops against a std::map model, across table growth, rewrites and reopens
+TEST_F(MmapStoreTest, MatchesModelUnderRandomOps) {
+    std::map<std::string, std::string> model;
+    std::mt19937 rng(42);
+    for (int op = 0; op < 20000; ++op) {
+        std::string k = key(static_cast<int>(rng() % 3000));
+        if (rng() % 4 == 0) {
+            EXPECT_EQ(store_->remove(k), model.erase(k) > 0) << k;
+        } else {
+            std::size_t len = rng() % 10 == 0 ? 3000 + rng() % 3000 : rng() % 100;
+            std::string v(len, static_cast<char>('a' + rng() % 26));
+            store_->put(k, v);
+            model[k] = v;
+        }
+        if (op % 7000 == 6999) {
+            reopen();
+        }
+    }
+
+    EXPECT_EQ(store_->size(), model.size());
+    for (const auto& [k, v] : model) {
+        ASSERT_EQ(store_->get(k), v) << k;
+    }
+    for (int i = 0; i < 3000; ++i) {
+        EXPECT_EQ(store_->contains(key(i)), model.count(key(i)) > 0) << i;
+    }
+}
+
+TEST_F(MmapStoreTest, PersistsAcrossReopen) {
+    for (int i = 0; i < 2000; ++i) {
+        store_->put(key(i), "value" + std::to_string(i));
+    }
+    for (int i = 0; i < 2000; i += 2) {
+        ASSERT_TRUE(store_->remove(key(i)));
+    }
+    reopen();
+
+    EXPECT_EQ(store_->size(), 1000);
+    EXPECT_FALSE(store_->get(key(10)).has_value());
+    EXPECT_EQ(store_->get(key(11)), "value11");
+}
+
+TEST_F(MmapStoreTest, TableGrowsWithTheKeys) {
+    std::size_t initial = store_->capacity();
+    EXPECT_EQ(initial, 256);
+    for (int i = 0; i < 5000; ++i) {
+        store_->put(key(i), "v");
+    }
+    EXPECT_GE(static_cast<double>(store_->capacity()) * 0.7, 5000.0);
+    EXPECT_EQ(store_->size(), 5000);
+    EXPECT_EQ(store_->get(key(0)), "v");
+    EXPECT_EQ(store_->get(key(4999)), "v");
+}
+
+TEST_F(MmapStoreTest, CompactDropsDeadRecords) {
+    max_garbage_ratio_ = 1.0;  // nothing rewrites on its own
+    reopen();
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+            store_->put(key(i), std::string(2000, static_cast<char>('a' + round)));
+        }
+    }
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_TRUE(store_->remove(key(i)));
+    }
+    auto before = store_->file_size();
+    store_->compact();
+    EXPECT_LT(store_->file_size(), before / 2);
+
+    EXPECT_EQ(store_->size(), 500);
+    EXPECT_FALSE(store_->get(key(0)).has_value());
+    EXPECT_EQ(store_->get(key(999)), std::string(2000, 'd'));
+    reopen();
+    EXPECT_EQ(store_->size(), 500);
+    EXPECT_EQ(store_->get(key(500)), std::string(2000, 'd'));
+}
+
+// overwriting the same keys must not grow the file forever
+TEST_F(MmapStoreTest, GarbageTriggersRewrite) {
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 200; ++i) {
+            store_->put(key(i), std::string(4000, static_cast<char>('a' + round)));
+        }
+    }
+    EXPECT_LT(store_->file_size(), 20u * 1024 * 1024);
+    EXPECT_EQ(store_->get(key(7)), std::string(4000, 't'));
+}
+
+TEST_F(MmapStoreTest, TtlExpiry) {
+    store_->put("short", "v", util::Duration(100));
+    store_->put("long", "v", util::Duration(100000));
+    EXPECT_TRUE(store_->contains("short"));
+
+    clock_->advance(util::Duration(200));
+    EXPECT_FALSE(store_->get("short").has_value());
+    EXPECT_TRUE(store_->contains("long"));
+    EXPECT_EQ(store_->size(), 1);
+
+    reopen();
+    EXPECT_FALSE(store_->contains("short"));
+    EXPECT_TRUE(store_->contains("long"));
+}
+
+TEST_F(MmapStoreTest, ClearRemovesEverything) {
+    for (int i = 0; i < 2000; ++i) {
+        store_->put(key(i), "value");
+    }
+    store_->clear();
+    EXPECT_TRUE(store_->empty());
+    EXPECT_EQ(store_->capacity(), 256);
+    EXPECT_FALSE(store_->get(key(5)).has_value());
+
+    store_->put("after", "clear");
+    reopen();
+    EXPECT_EQ(store_->size(), 1);
+    EXPECT_EQ(store_->get("after"), "clear");
+}
+
+// one write and then nothing: the checkpoint still comes, sync_interval later
+TEST_F(MmapStoreTest, BatchCheckpointsAfterIdleInterval) {
+    store_.reset();
+    auto opts = options();
+    opts.sync_mode = SyncMode::Batch;
+    opts.sync_interval = util::Duration(100);
+    store_ = std::make_unique<MmapStore>(opts);
+
+    store_->put("a", "1");
+    EXPECT_TRUE(store_->pending_sync());
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (store_->pending_sync() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_FALSE(store_->pending_sync());
+    EXPECT_EQ(store_->get("a"), "1");
+}
+
+TEST_F(MmapStoreTest, RecoversWritesAfterUncleanShutdown) {
+    store_->put("a", "1");
+    crash_after([this](MmapStore& store) {
+        store.flush();
+        for (int i = 0; i < 1000; ++i) {
+            store.put(key(i), "value" + std::to_string(i));
+        }
+        (void)store.remove("a");
+    });
+    store_ = std::make_unique<MmapStore>(options());
+
+    // nothing was torn - the page cache holds everything the child wrote
+    EXPECT_EQ(store_->size(), 1000);
+    EXPECT_FALSE(store_->contains("a"));
+    EXPECT_EQ(store_->get(key(999)), "value999");
+
+    // the recovered heap end must not let new writes overwrite recovered records
+    store_->put("b", "2");
+    reopen();
+    EXPECT_EQ(store_->get("b"), "2");
+    EXPECT_EQ(store_->get(key(0)), "value0");
+}
+
+TEST_F(MmapStoreTest, TornRecordsRollBackToTheLastCheckpoint) {
+    crash_after([](MmapStore& store) {
+        store.put("a", "checkpointed-a");
+        store.put("b", "checkpointed-b");
+        store.flush();
+        store.put("a", "torn-value-of-a");
+        store.put("b", "intact-value-of-b");
+        store.put("c", "torn-value-of-c");
+    });
+    // as if the table pages reached the disk but these record pages did not
+    corrupt("torn-value-of-a");
+    corrupt("torn-value-of-c");
+    store_ = std::make_unique<MmapStore>(options());
+
+    EXPECT_EQ(store_->get("a"), "checkpointed-a");
+    EXPECT_EQ(store_->get("b"), "intact-value-of-b");
+    EXPECT_FALSE(store_->contains("c"));
+    EXPECT_EQ(store_->size(), 2);
+
+    store_->put("c", "new");
+    reopen();
+    EXPECT_EQ(store_->get("c"), "new");
+    EXPECT_EQ(store_->size(), 3);
+}
+
+TEST_F(MmapStoreTest, TornMetaFallsBackToPreviousCheckpoint) {
+    store_->put("a", "1");
+    store_->flush();
+    store_->put("b", "2");
+    store_->flush();
+    store_.reset();
+
+    // damage the newest meta page: [magic u32][version u32][txn u64]...
+    {
+        std::fstream f(test_dir_ / "mmap.kvm", std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t txn[2] = {0, 0};
+        for (int page = 0; page < 2; ++page) {
+            f.seekg(page * 4096 + 8);
+            f.read(reinterpret_cast<char*>(&txn[page]), sizeof(uint64_t));
+        }
+        int newest = txn[1] > txn[0] ? 1 : 0;
+        f.seekp(newest * 4096 + 16);
+        f.write("garbage!", 8);
+    }
+    store_ = std::make_unique<MmapStore>(options());
+
+    // the older meta is behind the file - both keys survive the check, and later writes land
+    // after them
+    EXPECT_EQ(store_->size(), 2);
+    store_->put("c", "3");
+    reopen();
+    EXPECT_EQ(store_->get("a"), "1");
+    EXPECT_EQ(store_->get("b"), "2");
+    EXPECT_EQ(store_->get("c"), "3");
+}
+
+TEST_F(MmapStoreTest, RejectsCorruptFile) {
+    store_.reset();
+    {
+        std::ofstream f(test_dir_ / "mmap.kvm", std::ios::binary | std::ios::trunc);
+        f << std::string(64 * 1024, 'x');
+    }
+    EXPECT_THROW(MmapStore store(options()), std::runtime_error);
+}
+
+TEST_F(MmapStoreTest, ConcurrentReadersAndWriter) {
+    for (int i = 0; i < 1000; ++i) {
+        store_->put(key(i), "initial");
+    }
+    // the writer also adds keys, so readers run across table rewrites and file growth
+    std::atomic<int> bad_reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&, r] {
+            for (int i = r; i < 20000; i += 7) {
+                auto value = store_->get(key(i % 1000));
+                if (!value.has_value() || (*value != "initial" && *value != "updated")) {
+                    ++bad_reads;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 1000; ++i) {
+        store_->put(key(i), "updated");
+        store_->put(key(1000 + i), std::string(500, 'x'));
+    }
+    for (auto& t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(bad_reads, 0);
+    EXPECT_EQ(store_->size(), 2000);
+}
+
+}  // namespace kvstore::core::test
@@ -0,0 +1,187 @@
+#include "kvstore/core/sstable.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "kvstore/core/bloom_filter.hpp"
+#include "kvstore/util/hash.hpp"
+
+namespace kvstore::core::test {
+
+namespace util = kvstore::util;
+
+class SSTableTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "sstable_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        path_ = test_dir_ / "000001.sst";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    static std::string key(int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "key%06d", i);
+        return buf;
+    }
+
+    // small blocks so even a few hundred entries span many of them
+    void write_table(int count, std::size_t block_size = 256) {
+        SSTableWriter writer(path_, block_size, 10);
+        for (int i = 0; i < count; ++i) {
+            writer.add(TableEntry{key(i), "value" + std::to_string(i), false, std::nullopt});
+        }
+        writer.finish();
+    }
+
+    static std::vector<std::string> keys_of(TableIterator& it) {
+        std::vector<std::string> keys;
+        for (; it.valid(); it.next()) {
+            keys.push_back(it.entry().key);
+        }
+        return keys;
+    }
+
+    std::filesystem::path test_dir_;
+    std::filesystem::path path_;
+};
+
+TEST_F(SSTableTest, GetEveryKey) {
+    write_table(500);
+    auto table = SSTable::open(path_, 1);
+
+    EXPECT_EQ(table->entry_count(), 500);
+    EXPECT_EQ(table->smallest_key(), key(0));
+    EXPECT_EQ(table->largest_key(), key(499));
+    for (int i = 0; i < 500; ++i) {
+        auto entry = table->get(key(i));
+        ASSERT_TRUE(entry.has_value()) << key(i);
+        EXPECT_EQ(entry->value, "value" + std::to_string(i));
+        EXPECT_FALSE(entry->tombstone);
+    }
+}
+
+TEST_F(SSTableTest, GetMissingKey) {
+    write_table(100);
+    auto table = SSTable::open(path_, 1);
+
+    EXPECT_FALSE(table->get("aaa").has_value());
+    EXPECT_FALSE(table->get("key000050x").has_value());
+    EXPECT_FALSE(table->get("zzz").has_value());
+}
+
+TEST_F(SSTableTest, TombstonesAndExpiry) {
+    {
+        SSTableWriter writer(path_, 4096, 10);
+        writer.add(TableEntry{"a", "1", false, 12345});
+        writer.add(TableEntry{"b", "", true, std::nullopt});
+        writer.finish();
+    }
+    auto table = SSTable::open(path_, 1);
+
+    auto a = table->get("a");
+    ASSERT_TRUE(a.has_value());
+    EXPECT_EQ(a->expires_at_ms, 12345);
+    auto b = table->get("b");
+    ASSERT_TRUE(b.has_value());
+    EXPECT_TRUE(b->tombstone);
+}
+
+TEST_F(SSTableTest, IteratorReturnsAllInOrder) {
+    write_table(300);
+    auto table = SSTable::open(path_, 1);
+
+    auto it = table->iterator();
+    auto keys = keys_of(*it);
+    ASSERT_EQ(keys.size(), 300);
+    for (int i = 0; i < 300; ++i) {
+        EXPECT_EQ(keys[i], key(i));
+    }
+}
+
+TEST_F(SSTableTest, RejectsOutOfOrderKeys) {
+    SSTableWriter writer(path_, 4096, 10);
+    writer.add(TableEntry{"b", "1", false, std::nullopt});
+    EXPECT_THROW(writer.add(TableEntry{"a", "1", false, std::nullopt}), std::logic_error);
+    EXPECT_THROW(writer.add(TableEntry{"b", "1", false, std::nullopt}), std::logic_error);
+}
+
+TEST_F(SSTableTest, UnfinishedWriterLeavesNoFile) {
+    {
+        SSTableWriter writer(path_, 4096, 10);
+        writer.add(TableEntry{"a", "1", false, std::nullopt});
+    }
+    EXPECT_FALSE(std::filesystem::exists(path_));
+}
+
+TEST_F(SSTableTest, RejectsCorruptFile) {
+    {
+        std::ofstream out(path_, std::ios::binary);
+        out << std::string(200, 'x');
+    }
+    EXPECT_THROW(SSTable::open(path_, 1), std::runtime_error);
+}
+
+TEST_F(SSTableTest, MergingIteratorNewestWins) {
+    std::vector<std::unique_ptr<TableIterator>> children;
+    children.push_back(std::make_unique<VectorIterator>(std::vector<TableEntry>{
+        {"b", "new", false, std::nullopt}, {"d", "", true, std::nullopt}}));
+    children.push_back(std::make_unique<VectorIterator>(std::vector<TableEntry>{
+        {"a", "old", false, std::nullopt},
+        {"b", "old", false, std::nullopt},
+        {"d", "old", false, std::nullopt}}));
+    MergingIterator it(std::move(children));
+
+    std::vector<TableEntry> out;
+    for (; it.valid(); it.next()) {
+        out.push_back(it.entry());
+    }
+    ASSERT_EQ(out.size(), 3);
+    EXPECT_EQ(out[0].key, "a");
+    EXPECT_EQ(out[1].key, "b");
+    EXPECT_EQ(out[1].value, "new");
+    EXPECT_EQ(out[2].key, "d");
+    EXPECT_TRUE(out[2].tombstone);
+}
+
+TEST(BloomFilterTest, NoFalseNegatives) {
+    std::vector<uint64_t> hashes;
+    for (int i = 0; i < 1000; ++i) {
+        hashes.push_back(util::hash64("key" + std::to_string(i)));
+    }
+    BloomFilter filter(BloomFilter::build(hashes, 10));
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(filter.may_contain("key" + std::to_string(i)));
+    }
+}
+
+TEST(BloomFilterTest, FalsePositiveRateIsLow) {
+    std::vector<uint64_t> hashes;
+    for (int i = 0; i < 1000; ++i) {
+        hashes.push_back(util::hash64("key" + std::to_string(i)));
+    }
+    BloomFilter filter(BloomFilter::build(hashes, 10));
+    int false_positives = 0;
+    for (int i = 0; i < 10000; ++i) {
+        if (filter.may_contain("other" + std::to_string(i))) {
+            ++false_positives;
+        }
+    }
+    // ~1% expected at 10 bits per key
+    EXPECT_LT(false_positives, 300);
+}
+
+TEST(BloomFilterTest, EmptyFilterMatchesEverything) {
+    BloomFilter filter("");
+    EXPECT_TRUE(filter.may_contain("anything"));
+}
+
+}  // namespace kvstore::core::test
@@ -144,6 +144,25 @@ TEST_F(StoreTest, ConcurrentReadsAndWrites) {
     EXPECT_TRUE(store.contains("shared_key"));
 }
 
+TEST_F(StoreTest, MultiGetAndMultiPut) {
+    std::vector<KeyValue> entries{{"a", "1"}, {"b", "2"}, {"a", "3"}, {"c", ""}};
+    store.multi_put(entries);
+    EXPECT_EQ(store.size(), 3);
+
+    // later entries of a batch win, like separate puts
+    std::vector<std::string_view> keys{"a", "missing", "b", "c", "a"};
+    auto values = store.multi_get(keys);
+    ASSERT_EQ(values.size(), keys.size());
+    EXPECT_EQ(values[0], "3");
+    EXPECT_FALSE(values[1].has_value());
+    EXPECT_EQ(values[2], "2");
+    EXPECT_EQ(values[3], "");
+    EXPECT_EQ(values[4], "3");
+    EXPECT_TRUE(store.multi_get({}).empty());
+    store.multi_put({});
+    EXPECT_EQ(store.size(), 3);
+}
+
 class StorePersistenceTest : public ::testing::Test {
    protected:
     void SetUp() override {
@@ -248,4 +267,27 @@ TEST_F(StorePersistenceTest, PersistsOverwrite) {
     }
 }
 
-}  // namespace kvstore::core::test
\ No newline at end of file
+// a batch goes to the wal as one write and replays like separate puts
+TEST_F(StorePersistenceTest, PersistsMultiPut) {
+    {
+        StoreOptions opts;
+        opts.persistence_path = wal_path_;
+        Store store(opts);
+
+        store.put("key1", "value1");
+        std::vector<KeyValue> entries{{"key1", "value2"}, {"key2", "value2"}};
+        store.multi_put(entries);
+    }
+
+    {
+        StoreOptions opts;
+        opts.persistence_path = wal_path_;
+        Store store(opts);
+
+        EXPECT_EQ(store.size(), 2);
+        EXPECT_EQ(store.get("key1"), "value2");
+        EXPECT_EQ(store.get("key2"), "value2");
+    }
+}
+
+}  // namespace kvstore::core::test
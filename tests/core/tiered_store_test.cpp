@@ -0,0 +1,252 @@
+#include "kvstore/core/tiered_store.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kvstore/core/disk_store_builder.hpp"
+#include "kvstore/util/clock.hpp"
+#include "kvstore/util/types.hpp"
+
+namespace kvstore::core::test {
+
+namespace util = kvstore::util;
+
+class TieredStoreTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "tiered_store_test";
+        std::filesystem::remove_all(test_dir_);
+        std::filesystem::create_directories(test_dir_);
+        open();
+    }
+
+    void TearDown() override {
+        store_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    void open(std::size_t hot_tier_bytes = 1024 * 1024, std::size_t hot_tier_shards = 16) {
+        store_.reset();
+        TieredStoreOptions opts;
+        opts.disk.data_dir = test_dir_;
+        opts.disk.clock = clock_;
+        opts.hot_tier_bytes = hot_tier_bytes;
+        opts.hot_tier_shards = hot_tier_shards;
+        store_ = std::make_unique<TieredStore>(opts);
+    }
+
+    static std::string key(int i) {
+        return "k" + std::to_string(i);
+    }
+
+    std::filesystem::path test_dir_;
+    std::shared_ptr<util::MockClock> clock_ = std::make_shared<util::MockClock>();
+    std::unique_ptr<TieredStore> store_;
+};
+
+TEST_F(TieredStoreTest, ReadPromotesToHotTier) {
+    store_->put("a", "1");
+    EXPECT_EQ(store_->stats().hot_entries, 0);  // writes go to disk only
+
+    EXPECT_EQ(store_->get("a"), "1");
+    EXPECT_EQ(store_->get("a"), "1");
+    EXPECT_FALSE(store_->get("missing").has_value());
+
+    TieredStoreStats stats = store_->stats();
+    EXPECT_EQ(stats.cold_hits, 1);
+    EXPECT_EQ(stats.hot_hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.promotions, 1);
+    EXPECT_EQ(stats.hot_entries, 1);
+    EXPECT_DOUBLE_EQ(stats.hot_hit_ratio(), 1.0 / 3);
+}
+
+TEST_F(TieredStoreTest, WriteReplacesHotCopy) {
+    store_->put("a", "old");
+    (void)store_->get("a");
+    store_->put("a", "new");
+    EXPECT_EQ(store_->stats().hot_entries, 0);
+
+    EXPECT_EQ(store_->get("a"), "new");
+    EXPECT_EQ(store_->get("a"), "new");
+    EXPECT_EQ(store_->stats().hot_hits, 1);
+}
+
+TEST_F(TieredStoreTest, RemoveFromBothTiers) {
+    store_->put("a", "1");
+    (void)store_->get("a");
+    EXPECT_TRUE(store_->remove("a"));
+    EXPECT_FALSE(store_->get("a").has_value());
+    EXPECT_FALSE(store_->contains("a"));
+    EXPECT_FALSE(store_->remove("a"));
+    EXPECT_TRUE(store_->empty());
+}
+
+// a promoted key keeps the deadline it has on disk - not a fresh TTL from the promotion
+TEST_F(TieredStoreTest, TtlCarriesIntoHotTier) {
+    store_->put("a", "1", util::Duration(100));
+    clock_->advance(util::Duration(60));
+    EXPECT_EQ(store_->get("a"), "1");
+    EXPECT_EQ(store_->get("a"), "1");
+    EXPECT_EQ(store_->stats().hot_hits, 1);
+    EXPECT_TRUE(store_->contains("a"));
+
+    clock_->advance(util::Duration(40));
+    EXPECT_FALSE(store_->get("a").has_value());
+    EXPECT_FALSE(store_->contains("a"));
+    EXPECT_EQ(store_->stats().hot_entries, 0);
+}
+
+TEST_F(TieredStoreTest, PutWithoutTtlClearsIt) {
+    store_->put("a", "1", util::Duration(100));
+    (void)store_->get("a");
+    store_->put("a", "2");
+    clock_->advance(util::Duration(200));
+    EXPECT_EQ(store_->get("a"), "2");
+}
+
+// past the budget the least recently read keys leave memory, and still read fine from disk
+TEST_F(TieredStoreTest, DemotesLeastRecentlyRead) {
+    const std::string value(1000, 'v');
+    open(4 * 1200, 1);  // room for 4 of these. one shard: one LRU order over all the keys
+    for (int i = 0; i < 5; ++i) {
+        store_->put(key(i), value);
+    }
+    for (int i = 0; i < 4; ++i) {
+        (void)store_->get(key(i));
+    }
+    (void)store_->get(key(0));  // k1 is now the least recently read
+    (void)store_->get(key(4));
+
+    TieredStoreStats stats = store_->stats();
+    EXPECT_EQ(stats.demotions, 1);
+    EXPECT_EQ(stats.hot_entries, 4);
+    EXPECT_LE(stats.hot_bytes, stats.hot_capacity_bytes);
+
+    uint64_t hot_before = stats.hot_hits;
+    EXPECT_EQ(store_->get(key(0)), value);
+    EXPECT_EQ(store_->stats().hot_hits, hot_before + 1);
+    EXPECT_EQ(store_->get(key(1)), value);  // from disk again
+    EXPECT_EQ(store_->stats().hot_hits, hot_before + 1);
+}
+
+TEST_F(TieredStoreTest, LargeValueNotPromoted) {
+    open(1024);
+    store_->put("big", std::string(4096, 'b'));
+    EXPECT_EQ(store_->get("big"), std::string(4096, 'b'));
+    EXPECT_EQ(store_->stats().hot_entries, 0);
+}
+
+TEST_F(TieredStoreTest, ClearAndSize) {
+    for (int i = 0; i < 10; ++i) {
+        store_->put(key(i), "v");
+        (void)store_->get(key(i));
+    }
+    EXPECT_EQ(store_->size(), 10);
+    store_->clear();
+    EXPECT_TRUE(store_->empty());
+    EXPECT_FALSE(store_->get(key(3)).has_value());
+    EXPECT_EQ(store_->stats().hot_entries, 0);
+    EXPECT_EQ(store_->stats().hot_bytes, 0);
+}
+
+TEST_F(TieredStoreTest, AdoptDropsHotTier) {
+    store_->put("a", "old");
+    store_->put("b", "old");
+    (void)store_->get("a");
+    EXPECT_EQ(store_->stats().hot_entries, 1);
+
+    DiskStoreBuilder builder(DiskStoreBuilderOptions{.output_dir = test_dir_ / "ingest"});
+    builder.add("a", "new");
+    builder.add("c", "new");
+    (void)builder.finish();
+
+    store_->adopt(test_dir_ / "ingest");
+    EXPECT_EQ(store_->stats().hot_entries, 0);
+    EXPECT_EQ(store_->get("a"), "new");
+    EXPECT_FALSE(store_->get("b").has_value());
+    EXPECT_EQ(store_->get("c"), "new");
+    EXPECT_EQ(store_->size(), 2);
+}
+
+// every key is on disk, the hot tier starts empty after a restart
+TEST_F(TieredStoreTest, SurvivesReopen) {
+    store_->put("a", "1");
+    (void)store_->get("a");
+    open();
+    EXPECT_EQ(store_->get("a"), "1");
+    EXPECT_EQ(store_->stats().cold_hits, 1);
+}
+
+// hot hits of many threads, each counted once across the shards
+TEST_F(TieredStoreTest, ConcurrentHotReads) {
+    constexpr int kKeys = 100;
+    constexpr int kThreads = 4;
+    constexpr int kRounds = 50;
+    for (int i = 0; i < kKeys; ++i) {
+        store_->put(key(i), "v" + std::to_string(i));
+        (void)store_->get(key(i));
+    }
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < kThreads; ++t) {
+        readers.emplace_back([this]() {
+            for (int n = 0; n < kRounds; ++n) {
+                for (int i = 0; i < kKeys; ++i) {
+                    ASSERT_EQ(store_->get(key(i)), "v" + std::to_string(i));
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    TieredStoreStats stats = store_->stats();
+    EXPECT_EQ(stats.cold_hits, kKeys);
+    EXPECT_EQ(stats.hot_hits, kKeys * kThreads * kRounds);
+    EXPECT_EQ(stats.hot_entries, kKeys);
+}
+
+// readers racing writers never leave a stale value in the hot tier
+TEST_F(TieredStoreTest, ConcurrentReadersAndWriters) {
+    open(64 * 1024);
+    constexpr int kKeys = 20;
+    constexpr int kWrites = 200;
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&, t]() {
+            int i = t;
+            while (!done) {
+                (void)store_->get(key(i++ % kKeys));
+            }
+        });
+    }
+    std::thread writer([&]() {
+        for (int n = 0; n < kWrites; ++n) {
+            for (int i = 0; i < kKeys; ++i) {
+                store_->put(key(i), std::to_string(n));
+            }
+        }
+    });
+    writer.join();
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    for (int i = 0; i < kKeys; ++i) {
+        EXPECT_EQ(store_->get(key(i)), std::to_string(kWrites - 1));
+        EXPECT_EQ(store_->get(key(i)), std::to_string(kWrites - 1));
+    }
+}
+
+}  // namespace kvstore::core::test
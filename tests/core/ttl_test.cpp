@@ -40,6 +40,23 @@ TEST_F(TTLTest, KeyExpiresAfterTTL) {
     EXPECT_FALSE(result.has_value());
 }
 
+TEST_F(TTLTest, MultiGetSkipsExpired) {
+    store_->put("key1", "value1", Duration(1000));
+    store_->put("key2", "value2");
+    std::vector<KeyValue> entries{{"key1", "value3"}};
+
+    clock_->advance(Duration(1001));
+    std::vector<std::string_view> keys{"key1", "key2"};
+    auto values = store_->multi_get(keys);
+    EXPECT_FALSE(values[0].has_value());
+    EXPECT_EQ(values[1], "value2");
+
+    // a batched put clears the ttl like put() without one
+    store_->multi_put(entries);
+    clock_->advance(Duration(10000));
+    EXPECT_EQ(store_->get("key1"), "value3");
+}
+
 TEST_F(TTLTest, ContainsReturnsFalseForExpired) {
     store_->put("key1", "value1", Duration(1000));
 
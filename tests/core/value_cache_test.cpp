@@ -0,0 +1,184 @@
+#include "kvstore/core/value_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kvstore::core::test {
+
+class ValueCacheTest : public ::testing::Test {
+   protected:
+    static std::string key(int i) {
+        return "key" + std::to_string(i);
+    }
+    static std::string value(int i) {
+        return std::string(100, static_cast<char>('a' + i % 26));
+    }
+
+    // the first put of a key only gets it past the doorkeeper
+    static void admit(ValueCache& cache, std::string_view k, uint64_t version,
+                      std::string_view v) {
+        cache.put(k, version, v);
+        cache.put(k, version, v);
+    }
+};
+
+TEST_F(ValueCacheTest, MissThenHit) {
+    ValueCache cache(1024 * 1024, 1);
+    EXPECT_FALSE(cache.get("a", 10).has_value());
+    cache.put("a", 10, "value");
+    EXPECT_FALSE(cache.get("a", 10).has_value());  // first sighting - not admitted yet
+    cache.put("a", 10, "value");
+    EXPECT_EQ(cache.get("a", 10), "value");
+
+    ValueCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 2);
+    EXPECT_EQ(stats.entries, 1);
+    EXPECT_DOUBLE_EQ(stats.hit_ratio(), 1.0 / 3);
+}
+
+// a lookup with a different version is a miss and drops the stale entry
+TEST_F(ValueCacheTest, VersionMismatchIsMiss) {
+    ValueCache cache(1024 * 1024, 1);
+    admit(cache, "a", 10, "old");
+    EXPECT_FALSE(cache.get("a", 20).has_value());
+    EXPECT_FALSE(cache.get("a", 10).has_value());
+    EXPECT_EQ(cache.stats().entries, 0);
+
+    cache.put("a", 20, "new");
+    cache.put("a", 30, "newer");
+    EXPECT_EQ(cache.get("a", 30), "newer");
+    EXPECT_EQ(cache.stats().entries, 1);
+}
+
+TEST_F(ValueCacheTest, EraseAndClear) {
+    ValueCache cache(1024 * 1024);
+    for (int i = 0; i < 10; ++i) {
+        admit(cache, key(i), i, value(i));
+    }
+    cache.erase(key(3));
+    EXPECT_FALSE(cache.get(key(3), 3).has_value());
+    EXPECT_EQ(cache.get(key(4), 4), value(4));
+
+    cache.clear();
+    EXPECT_EQ(cache.stats().entries, 0);
+    EXPECT_EQ(cache.stats().used_bytes, 0);
+    EXPECT_FALSE(cache.get(key(4), 4).has_value());
+}
+
+TEST_F(ValueCacheTest, Remap) {
+    ValueCache cache(1024 * 1024);
+    for (int i = 0; i < 10; ++i) {
+        admit(cache, key(i), i, value(i));
+    }
+    cache.remap([](std::string_view k) -> std::optional<uint64_t> {
+        if (k == "key0") {
+            return std::nullopt;
+        }
+        return 1000 + std::stoull(std::string(k.substr(3)));
+    });
+    EXPECT_FALSE(cache.get(key(0), 1000).has_value());
+    EXPECT_FALSE(cache.get(key(5), 5).has_value());
+    EXPECT_EQ(cache.get(key(6), 1006), value(6));
+}
+
+TEST_F(ValueCacheTest, StaysWithinCapacity) {
+    ValueCache cache(64 * 1024, 4);
+    for (int i = 0; i < 5000; ++i) {
+        admit(cache, key(i), i, value(i));
+    }
+    ValueCacheStats stats = cache.stats();
+    EXPECT_LE(stats.used_bytes, stats.capacity_bytes);
+    EXPECT_GT(stats.evictions, 0);
+    EXPECT_GT(stats.entries, 0);
+
+    // too large for a shard: not cached, and not evicting everything else for it
+    cache.put("huge", 1, std::string(64 * 1024, 'h'));
+    EXPECT_FALSE(cache.get("huge", 1).has_value());
+    EXPECT_EQ(cache.stats().entries, stats.entries);
+}
+
+// the point of S3-FIFO: a scan of one-hit keys doesnt flush out the keys that keep getting hits
+TEST_F(ValueCacheTest, HotKeysSurviveScan) {
+    ValueCache cache(100 * 1024, 1);
+    for (int i = 0; i < 50; ++i) {
+        admit(cache, key(i), i, value(i));
+        (void)cache.get(key(i), i);
+    }
+    for (int i = 1000; i < 6000; ++i) {
+        admit(cache, key(i), i, value(i));
+        if (i % 10 == 0) {
+            for (int hot = 0; hot < 50; ++hot) {
+                (void)cache.get(key(hot), hot);
+            }
+        }
+    }
+    int hot_cached = 0;
+    for (int i = 0; i < 50; ++i) {
+        hot_cached += cache.get(key(i), i).has_value() ? 1 : 0;
+    }
+    EXPECT_EQ(hot_cached, 50);
+}
+
+// a scan of keys read once never gets into the cache at all
+TEST_F(ValueCacheTest, OneHitKeysNotAdmitted) {
+    ValueCache cache(1024 * 1024, 1);
+    for (int i = 0; i < 1000; ++i) {
+        cache.put(key(i), i, value(i));
+    }
+    EXPECT_LT(cache.stats().entries, 50);  // doorkeeper bit collisions only
+}
+
+// a key evicted from the small queue and seen again soon after goes to main
+TEST_F(ValueCacheTest, GhostHitGoesToMain) {
+    ValueCache cache(50 * 1024, 1);
+    admit(cache, key(0), 0, value(0));
+    for (int i = 1; i < 400; ++i) {
+        admit(cache, key(i), i, value(i));
+    }
+    ASSERT_FALSE(cache.get(key(0), 0).has_value());
+
+    // readmitted as a ghost: survives the next wave of one-hit keys without a single hit
+    admit(cache, key(0), 0, value(0));
+    for (int i = 400; i < 450; ++i) {
+        admit(cache, key(i), i, value(i));
+    }
+    EXPECT_EQ(cache.get(key(0), 0), value(0));
+}
+
+TEST_F(ValueCacheTest, ConcurrentAccess) {
+    ValueCache cache(256 * 1024, 8);
+    std::atomic<int> wrong{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int n = 0; n < 5000; ++n) {
+                int i = (n * 31 + t * 7) % 1000;
+                if (auto cached = cache.get(key(i), i)) {
+                    if (*cached != value(i)) {
+                        ++wrong;
+                    }
+                } else {
+                    cache.put(key(i), i, value(i));
+                }
+                if (n % 100 == 0) {
+                    cache.erase(key(i));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(wrong, 0);
+    ValueCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 20000);
+    EXPECT_LE(stats.used_bytes, stats.capacity_bytes);
+}
+
+}  // namespace kvstore::core::test
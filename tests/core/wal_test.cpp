@@ -51,6 +51,26 @@ TEST_F(WALTest, LogAndReplay) {
     EXPECT_EQ(std::get<1>(entries[2]), "key1");
 }
 
+TEST_F(WALTest, LogPutsReplaysInOrder) {
+    {
+        WriteAheadLog wal(wal_path_);
+        std::vector<KeyValue> batch{{"key1", "value1"}, {"key2", "value2"}, {"key1", "value3"}};
+        wal.log_puts(batch);
+        wal.log_puts({});
+    }
+    std::vector<std::pair<std::string, std::string>> entries;
+    {
+        WriteAheadLog wal(wal_path_);
+        wal.replay([&entries](EntryType type, std::string_view key, std::string_view value,
+                              ExpirationTime) {
+            EXPECT_EQ(type, EntryType::Put);
+            entries.emplace_back(std::string(key), std::string(value));
+        });
+    }
+    EXPECT_EQ(entries, (std::vector<std::pair<std::string, std::string>>{
+                           {"key1", "value1"}, {"key2", "value2"}, {"key1", "value3"}}));
+}
+
 TEST_F(WALTest, LogAndReplayWithTTL) {
     {
         WriteAheadLog wal(wal_path_);
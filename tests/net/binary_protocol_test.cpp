@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+
 namespace kvstore::net::test {
 
 TEST(BinaryProtocolTest, EncodeDecodeRequestGet) {
@@ -269,4 +271,54 @@ TEST(BinaryProtocolTest, PeekMessageLength) {
     EXPECT_EQ(len, 1);  // Just command byte
 }
 
+// the view decoder points into the buffer instead of copying, and fails like decode_request
+TEST(BinaryProtocolTest, DecodeRequestView) {
+    Request req{Command::PutEx, "mykey", "myvalue", 1500};
+    auto encoded = BinaryProtocol::encode_request(req);
+
+    size_t consumed = 0;
+    EXPECT_FALSE(BinaryProtocol::decode_request_view(encoded.data(), encoded.size() - 1, consumed)
+                     .has_value());
+    auto view = BinaryProtocol::decode_request_view(encoded.data(), encoded.size(), consumed);
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(consumed, encoded.size());
+    EXPECT_EQ(view->command, Command::PutEx);
+    EXPECT_EQ(view->key, "mykey");
+    EXPECT_EQ(view->value, "myvalue");
+    EXPECT_EQ(view->ttl_ms, 1500);
+    const char* bytes = reinterpret_cast<const char*>(encoded.data());
+    EXPECT_EQ(view->key.data(), bytes + 4 + 1 + 4);
+    EXPECT_EQ(view->value.data(), bytes + 4 + 1 + 4 + 5 + 4);
+
+    Request copy = view->to_request();
+    EXPECT_EQ(copy.key, "mykey");
+    EXPECT_EQ(copy.value, "myvalue");
+    EXPECT_EQ(copy.ttl_ms, 1500);
+
+    // a key length running past the message
+    std::vector<uint8_t> bad{0, 0, 0, 5, static_cast<uint8_t>(Command::Get), 0, 0, 0, 9};
+    EXPECT_THROW((void)BinaryProtocol::decode_request_view(bad.data(), bad.size(), consumed),
+                 std::runtime_error);
+}
+
+// the gathered encoding: the same bytes as encode_request, with key and value not copied
+TEST(BinaryProtocolTest, EncodeRequestPieces) {
+    for (Command command : {Command::Get, Command::Put, Command::PutEx, Command::Ping}) {
+        Request req{command, "mykey", "myvalue", 1500};
+        if (command == Command::Get) {
+            req.value.clear();
+        }
+        EncodedRequest encoded;
+        BinaryProtocol::encode_request(RequestView::of(req), encoded);
+        auto bytes = BinaryProtocol::encode_request(req);
+        EXPECT_EQ(encoded.join(), std::string(bytes.begin(), bytes.end()));
+        if (command != Command::Ping) {
+            EXPECT_EQ(encoded.pieces[1].data(), req.key.data());
+        }
+        if (command == Command::Put || command == Command::PutEx) {
+            EXPECT_EQ(encoded.pieces[3].data(), req.value.data());
+        }
+    }
+}
+
 }  // namespace kvstore::net::test
\ No newline at end of file
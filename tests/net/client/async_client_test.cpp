@@ -0,0 +1,283 @@
+#include "kvstore/net/client/async_client.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "kvstore/core/store.hpp"
+#include "kvstore/net/server/server.hpp"
+
+namespace kvstore::net::test {
+
+using namespace std::chrono_literals;
+
+// {binary protocol, server mode}
+using AsyncClientParam = std::tuple<bool, server::ServerMode>;
+
+class AsyncClientTest : public ::testing::TestWithParam<AsyncClientParam> {
+   protected:
+    void SetUp() override {
+        store_ = std::make_unique<core::Store>();
+        server::ServerOptions server_opts;
+        server_opts.port = 0;
+        server_opts.mode = std::get<1>(GetParam());
+        server_ = std::make_unique<server::Server>(*store_, server_opts);
+        server_->start();
+
+        client::AsyncClientOptions client_opts;
+        client_opts.port = server_->port();
+        client_opts.binary = std::get<0>(GetParam());
+        client_opts.request_timeout = util::Duration(10000);
+        client_ = std::make_unique<client::AsyncClient>(client_opts);
+        client_->connect();
+    }
+
+    void TearDown() override {
+        client_->disconnect();
+        server_->stop();
+    }
+
+    std::unique_ptr<core::Store> store_;
+    std::unique_ptr<server::Server> server_;
+    std::unique_ptr<client::AsyncClient> client_;
+};
+
+TEST_P(AsyncClientTest, BasicOperations) {
+    EXPECT_TRUE(client_->connected());
+    EXPECT_TRUE(client_->ping().get());
+
+    auto put = client_->put("a", "1");
+    auto put_ttl = client_->put("t", "2", util::Duration(60000));
+    auto get = client_->get("a");
+    auto missing = client_->get("missing");
+    put.get();
+    put_ttl.get();
+    EXPECT_EQ(get.get(), "1");
+    EXPECT_EQ(missing.get(), std::nullopt);
+
+    EXPECT_TRUE(client_->contains("t").get());
+    EXPECT_TRUE(client_->remove("t").get());
+    EXPECT_FALSE(client_->remove("t").get());
+    EXPECT_FALSE(client_->contains("t").get());
+    EXPECT_EQ(client_->in_flight(), 0);
+}
+
+// many more calls than connections in flight at once, all issued before any is waited on
+TEST_P(AsyncClientTest, ManyInFlight) {
+    const std::size_t count = 10000;
+    std::vector<std::future<void>> puts;
+    for (std::size_t i = 0; i < count; ++i) {
+        puts.push_back(client_->put("key" + std::to_string(i), "value" + std::to_string(i)));
+    }
+    for (auto& put : puts) {
+        put.get();
+    }
+    EXPECT_EQ(store_->size(), count);
+
+    std::vector<std::future<std::optional<std::string>>> gets;
+    for (std::size_t i = 0; i < count; ++i) {
+        gets.push_back(client_->get("key" + std::to_string(i)));
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(gets[i].get(), "value" + std::to_string(i));
+    }
+    // requests were sent and responses read many per syscall
+    EXPECT_LT(client_->syscalls(), count);
+}
+
+TEST_P(AsyncClientTest, LargeValues) {
+    const std::string large(300000, 'x');
+    auto put1 = client_->put("l1", large);
+    auto put2 = client_->put("l2", large);
+    auto get1 = client_->get("l1");
+    auto get2 = client_->get("l2");
+    put1.get();
+    put2.get();
+    EXPECT_TRUE(get1.get() == large);
+    EXPECT_TRUE(get2.get() == large);
+}
+
+TEST_P(AsyncClientTest, ConcurrentCallers) {
+    const int num_threads = 4;
+    const int ops = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([this, t]() {
+            std::vector<std::future<void>> puts;
+            for (int i = 0; i < ops; ++i) {
+                std::string key = "t" + std::to_string(t) + "_" + std::to_string(i);
+                puts.push_back(client_->put(key, std::to_string(i)));
+            }
+            for (auto& put : puts) {
+                put.get();
+            }
+            for (int i = 0; i < ops; ++i) {
+                std::string key = "t" + std::to_string(t) + "_" + std::to_string(i);
+                ASSERT_EQ(client_->get(key).get(), std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(store_->size(), num_threads * ops);
+}
+
+TEST_P(AsyncClientTest, Reconnect) {
+    client_->put("a", "1").get();
+    client_->disconnect();
+    EXPECT_FALSE(client_->connected());
+    EXPECT_THROW(client_->get("a").get(), std::runtime_error);
+
+    client_->connect();
+    EXPECT_EQ(client_->get("a").get(), "1");
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Protocols, AsyncClientTest,
+    ::testing::Combine(::testing::Bool(),
+                       ::testing::Values(server::ServerMode::ThreadPerConnection,
+                                         server::ServerMode::EventLoop)),
+    [](const ::testing::TestParamInfo<AsyncClientParam>& info) {
+        std::string name = std::get<0>(info.param) ? "Binary" : "Text";
+        return name + (std::get<1>(info.param) == server::ServerMode::EventLoop ? "EventLoop"
+                                                                                 : "Threads");
+    });
+
+// a listening socket the test answers by hand (text protocol)
+class FakeServer {
+   public:
+    FakeServer() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(listen_fd_, 4);
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+    }
+
+    ~FakeServer() {
+        close_client();
+        close(listen_fd_);
+    }
+
+    [[nodiscard]] uint16_t port() const {
+        return port_;
+    }
+
+    // the client's connection (connect() completed already, it is in the backlog)
+    void accept_client() {
+        client_fd_ = accept(listen_fd_, nullptr, nullptr);
+    }
+
+    // waits for lines requests: a response never comes before its request
+    void receive(std::size_t lines) {
+        char buf[4096];
+        while (lines > 0) {
+            ssize_t n = recv(client_fd_, buf, sizeof(buf), 0);
+            ASSERT_GT(n, 0);
+            lines -= std::count(buf, buf + n, '\n');
+        }
+    }
+
+    void send(const std::string& bytes) {
+        ASSERT_EQ(::send(client_fd_, bytes.data(), bytes.size(), 0),
+                  static_cast<ssize_t>(bytes.size()));
+    }
+
+    void close_client() {
+        if (client_fd_ >= 0) {
+            close(client_fd_);
+            client_fd_ = -1;
+        }
+    }
+
+   private:
+    int listen_fd_ = -1;
+    int client_fd_ = -1;
+    uint16_t port_ = 0;
+};
+
+class AsyncClientFakeServerTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        client::AsyncClientOptions opts;
+        opts.port = server_.port();
+        opts.connections = 1;
+        client_ = std::make_unique<client::AsyncClient>(opts);
+        client_->connect();
+        server_.accept_client();
+    }
+
+    FakeServer server_;
+    std::unique_ptr<client::AsyncClient> client_;
+};
+
+TEST_F(AsyncClientFakeServerTest, Timeout) {
+    auto start = std::chrono::steady_clock::now();
+    auto get = client_->get("a", {util::Duration(50)});
+    EXPECT_THROW(get.get(), client::TimeoutError);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+    EXPECT_EQ(client_->in_flight(), 0);
+}
+
+// the late response to a timed out call is dropped: the next call gets its own
+TEST_F(AsyncClientFakeServerTest, LateResponseIsDropped) {
+    auto first = client_->get("a", {util::Duration(50)});
+    EXPECT_THROW(first.get(), client::TimeoutError);
+
+    auto second = client_->get("b");
+    server_.receive(2);
+    server_.send("OK first\nOK second\n");
+    EXPECT_EQ(second.get(), "second");
+}
+
+TEST_F(AsyncClientFakeServerTest, ServerCloseFailsCalls) {
+    auto get = client_->get("a");
+    auto remove = client_->remove("b");
+    server_.close_client();
+    EXPECT_THROW(get.get(), std::runtime_error);
+    EXPECT_THROW(remove.get(), std::runtime_error);
+
+    // no connection left: calls fail right away
+    EXPECT_THROW(client_->ping().get(), std::runtime_error);
+    EXPECT_EQ(client_->in_flight(), 0);
+}
+
+TEST_F(AsyncClientFakeServerTest, ErrorResponse) {
+    auto put = client_->put("a", "1");
+    auto get = client_->get("a");
+    server_.receive(2);
+    server_.send("ERROR disk full\nOK 1\n");
+    EXPECT_THROW(put.get(), std::runtime_error);
+    EXPECT_EQ(get.get(), "1");
+}
+
+TEST(AsyncClientConnectTest, ConnectFails) {
+    client::AsyncClientOptions opts;
+    {
+        FakeServer closed;  // a port nothing listens on any more
+        opts.port = closed.port();
+    }
+    client::AsyncClient client(opts);
+    EXPECT_THROW(client.connect(), std::runtime_error);
+    EXPECT_FALSE(client.connected());
+    EXPECT_THROW(client.get("a").get(), std::runtime_error);
+}
+
+}  // namespace kvstore::net::test
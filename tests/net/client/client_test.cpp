@@ -133,6 +133,25 @@ TEST_F(ClientTest, MultipleOperations) {
     }
 }
 
+// a response comes in with one read, not a recv per byte: one write and one read per request
+TEST_F(ClientTest, OneReadPerResponse) {
+    client_->put("key1", "a value long enough to have cost dozens of reads");
+    uint64_t before = client_->syscalls();
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(client_->get("key1").has_value());
+    }
+    EXPECT_EQ(client_->syscalls() - before, 20);
+}
+
+TEST_F(ClientTest, LargeValue) {
+    const std::string value(300000, 'x');
+    client_->put("large", value);
+    auto result = client_->get("large");
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(*result == value);
+    EXPECT_TRUE(client_->ping());
+}
+
 TEST_F(ClientTest, ConnectDisconnectReconnect) {
     client_->put("key1", "value1");
     client_->disconnect();
@@ -358,6 +377,16 @@ TEST_F(BinaryClientTest, BinaryData) {
     EXPECT_EQ(*result, binary_value);
 }
 
+TEST_F(BinaryClientTest, LargeValue) {
+    std::string value(1024 * 1024, 'x');
+    value[12345] = '\0';
+    client_->put("large", value);
+    auto result = client_->get("large");
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(*result == value);
+    EXPECT_TRUE(client_->ping());
+}
+
 TEST_F(BinaryClientTest, PutWithTTL) {
     client_->put("ttlkey", "ttlvalue", util::Duration(60000));
 
@@ -0,0 +1,224 @@
+#include "kvstore/net/client/connection_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kvstore/core/store.hpp"
+#include "kvstore/net/server/server.hpp"
+
+namespace kvstore::net::test {
+
+using namespace std::chrono_literals;
+
+class ConnectionPoolTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        store_ = std::make_unique<core::Store>();
+        start_server(0);
+        options_.client.port = server_->port();
+        options_.client.timeout_seconds = 5;
+    }
+
+    void TearDown() override {
+        server_->stop();
+    }
+
+    // event loop: stop() closes the connections the pool still holds. a thread per connection
+    // would wait for them to time out on the server first
+    void start_server(uint16_t port) {
+        server::ServerOptions server_opts;
+        server_opts.port = port;
+        server_opts.mode = server::ServerMode::EventLoop;
+        server_ = std::make_unique<server::Server>(*store_, server_opts);
+        server_->start();
+    }
+
+    std::unique_ptr<core::Store> store_;
+    std::unique_ptr<server::Server> server_;
+    client::ConnectionPoolOptions options_;
+};
+
+TEST_F(ConnectionPoolTest, LeaseGivesConnectionBack) {
+    options_.min_size = 1;
+    client::ConnectionPool pool(options_);
+    EXPECT_EQ(pool.stats().open, 1);
+    EXPECT_EQ(pool.stats().idle, 1);
+
+    {
+        auto lease = pool.acquire();
+        ASSERT_TRUE(lease);
+        EXPECT_TRUE(lease->connected());
+        lease->put("a", "1");
+        EXPECT_EQ((*lease).get("a"), "1");
+        EXPECT_EQ(pool.stats().idle, 0);
+    }
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.open, 1);
+    EXPECT_EQ(stats.idle, 1);
+    EXPECT_EQ(stats.acquisitions, 1);
+    EXPECT_EQ(stats.waits, 0);
+    EXPECT_GT(stats.max_acquire_time.count(), 0);
+    EXPECT_LE(stats.avg_acquire_time(), stats.max_acquire_time);
+}
+
+TEST_F(ConnectionPoolTest, MoveAndRelease) {
+    options_.max_size = 1;
+    client::ConnectionPool pool(options_);
+    auto lease = pool.acquire();
+    auto moved = std::move(lease);
+    EXPECT_FALSE(lease);
+    EXPECT_TRUE(moved);
+
+    moved.release();
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(pool.stats().idle, 1);
+
+    // the one connection is free again
+    auto again = pool.acquire(100ms);
+    EXPECT_TRUE(again->ping());
+}
+
+// many threads, at most max_size server connections
+TEST_F(ConnectionPoolTest, ConcurrencyIsBounded) {
+    options_.min_size = 0;
+    options_.max_size = 2;
+    client::ConnectionPool pool(options_);
+
+    const int num_threads = 8;
+    const int ops = 200;
+    std::atomic<int> leased{0};
+    std::atomic<int> max_leased{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ops; ++i) {
+                auto lease = pool.acquire();
+                int now = ++leased;
+                int seen = max_leased.load();
+                while (now > seen && !max_leased.compare_exchange_weak(seen, now)) {
+                }
+                std::string key = "t" + std::to_string(t) + "_" + std::to_string(i);
+                lease->put(key, std::to_string(i));
+                ASSERT_EQ(lease->get(key), std::to_string(i));
+                --leased;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(store_->size(), num_threads * ops);
+    EXPECT_LE(max_leased.load(), 2);
+    auto stats = pool.stats();
+    EXPECT_LE(stats.open, 2);
+    EXPECT_EQ(stats.acquisitions, num_threads * ops);
+    EXPECT_EQ(stats.timeouts, 0);
+}
+
+TEST_F(ConnectionPoolTest, AcquireTimesOut) {
+    options_.max_size = 1;
+    client::ConnectionPool pool(options_);
+    auto lease = pool.acquire();
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW((void)pool.acquire(50ms), std::runtime_error);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+    EXPECT_EQ(pool.stats().timeouts, 1);
+}
+
+TEST_F(ConnectionPoolTest, WaitsForRelease) {
+    options_.max_size = 1;
+    client::ConnectionPool pool(options_);
+    auto lease = pool.acquire();
+
+    std::thread releaser([&lease]() {
+        std::this_thread::sleep_for(50ms);
+        lease.release();
+    });
+    auto waited = pool.acquire(5000ms);
+    releaser.join();
+    EXPECT_TRUE(waited->ping());
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.waits, 1);
+    EXPECT_GE(stats.max_acquire_time, 40ms);
+}
+
+// a connection that broke while leased is reopened by the next acquire
+TEST_F(ConnectionPoolTest, LazyReconnect) {
+    options_.max_size = 1;
+    client::ConnectionPool pool(options_);
+    {
+        auto lease = pool.acquire();
+        lease->disconnect();
+    }
+    EXPECT_EQ(pool.stats().open, 1);
+
+    auto lease = pool.acquire();
+    EXPECT_TRUE(lease->connected());
+    EXPECT_TRUE(lease->ping());
+    EXPECT_EQ(pool.stats().reconnects, 1);
+}
+
+// the server restarted while the connection sat idle: the ping before the lease finds out
+TEST_F(ConnectionPoolTest, HealthCheckReconnects) {
+    options_.max_size = 1;
+    options_.health_check_interval = util::Duration(0);
+    client::ConnectionPool pool(options_);
+    pool.acquire()->put("a", "1");
+
+    uint16_t port = server_->port();
+    server_->stop();
+    start_server(port);
+
+    auto lease = pool.acquire();
+    EXPECT_EQ(lease->get("a"), "1");
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.failed_health_checks, 1);
+    EXPECT_EQ(stats.reconnects, 1);
+}
+
+TEST_F(ConnectionPoolTest, IdleConnectionsAboveMinClose) {
+    options_.min_size = 1;
+    options_.max_size = 4;
+    options_.idle_timeout = util::Duration(0);
+    client::ConnectionPool pool(options_);
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        auto c = pool.acquire();
+        EXPECT_EQ(pool.stats().open, 3);
+    }
+    EXPECT_EQ(pool.stats().open, 1);
+    EXPECT_EQ(pool.stats().idle, 1);
+}
+
+TEST_F(ConnectionPoolTest, ConnectFailureDoesntTakeASlot) {
+    options_.min_size = 0;
+    options_.max_size = 1;
+    client::ConnectionPool pool(options_);
+    uint16_t port = server_->port();
+    server_->stop();
+
+    EXPECT_THROW((void)pool.acquire(), std::runtime_error);
+    EXPECT_EQ(pool.stats().open, 0);
+
+    start_server(port);
+    EXPECT_TRUE(pool.acquire(100ms)->ping());
+}
+
+TEST_F(ConnectionPoolTest, ConstructorThrowsWhenServerIsDown) {
+    server_->stop();
+    options_.min_size = 2;
+    EXPECT_THROW(client::ConnectionPool pool(options_), std::runtime_error);
+    start_server(0);  // for TearDown
+}
+
+}  // namespace kvstore::net::test
@@ -0,0 +1,179 @@
+#include "kvstore/net/client/pipeline.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include "kvstore/core/store.hpp"
+#include "kvstore/net/server/server.hpp"
+
+namespace kvstore::net::test {
+
+// {binary protocol, server mode}
+using PipelineParam = std::tuple<bool, server::ServerMode>;
+
+class PipelineTest : public ::testing::TestWithParam<PipelineParam> {
+   protected:
+    void SetUp() override {
+        store_ = std::make_unique<core::Store>();
+        server::ServerOptions server_opts;
+        server_opts.port = 0;
+        server_opts.mode = std::get<1>(GetParam());
+        server_ = std::make_unique<server::Server>(*store_, server_opts);
+        server_->start();
+
+        client::ClientOptions client_opts;
+        client_opts.port = server_->port();
+        client_opts.timeout_seconds = 5;
+        client_opts.binary = std::get<0>(GetParam());
+        client_ = std::make_unique<client::Client>(client_opts);
+        client_->connect();
+    }
+
+    void TearDown() override {
+        client_->disconnect();
+        server_->stop();
+    }
+
+    std::unique_ptr<core::Store> store_;
+    std::unique_ptr<server::Server> server_;
+    std::unique_ptr<client::Client> client_;
+};
+
+TEST_P(PipelineTest, ResultsInOrder) {
+    client::Pipeline pipeline(*client_);
+    pipeline.put("a", "1")
+        .put("b", "2")
+        .put("t", "3", util::Duration(60000))
+        .get("a")
+        .get("missing")
+        .contains("b")
+        .contains("missing")
+        .remove("b")
+        .remove("b")
+        .get("t");
+    EXPECT_EQ(pipeline.size(), 10);
+
+    uint64_t before = client_->syscalls();
+    auto results = pipeline.execute();
+    // one write, and the responses came in with a read or a few
+    EXPECT_LE(client_->syscalls() - before, 4);
+    EXPECT_TRUE(pipeline.empty());
+
+    ASSERT_EQ(results.size(), 10);
+    EXPECT_EQ(results[0].command, Command::Put);
+    EXPECT_NO_THROW(results[0].check());
+    EXPECT_NO_THROW(results[1].check());
+    EXPECT_EQ(results[2].command, Command::PutEx);
+    EXPECT_NO_THROW(results[2].check());
+    EXPECT_EQ(results[3].value(), "1");
+    EXPECT_EQ(results[4].value(), std::nullopt);
+    EXPECT_TRUE(results[5].exists());
+    EXPECT_FALSE(results[6].exists());
+    EXPECT_TRUE(results[7].removed());
+    EXPECT_FALSE(results[8].removed());
+    EXPECT_EQ(results[9].value(), "3");
+
+    // the connection is in step for plain calls afterwards
+    EXPECT_EQ(client_->get("a"), "1");
+    EXPECT_FALSE(client_->contains("b"));
+}
+
+// more than kMaxWriteBytes: sent in parts, each read before the next is written
+TEST_P(PipelineTest, LargeBatch) {
+    const std::size_t count = 5000;
+    const std::string value(100, 'v');
+    client::Pipeline pipeline(*client_);
+    for (std::size_t i = 0; i < count; ++i) {
+        pipeline.put("key" + std::to_string(i), value + std::to_string(i));
+    }
+    for (const auto& result : pipeline.execute()) {
+        ASSERT_TRUE(result.ok());
+    }
+    EXPECT_EQ(store_->size(), count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        pipeline.get("key" + std::to_string(i));
+    }
+    auto results = pipeline.execute();
+    ASSERT_EQ(results.size(), count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(results[i].value(), value + std::to_string(i));
+    }
+}
+
+// calls larger than kMaxWriteBytes go out one by one
+TEST_P(PipelineTest, LargeValues) {
+    const std::string large(300000, 'x');
+    client::Pipeline pipeline(*client_);
+    pipeline.put("l1", large).put("l2", large).get("l1").get("l2");
+    auto results = pipeline.execute();
+    ASSERT_EQ(results.size(), 4);
+    EXPECT_TRUE(results[2].value() == large);
+    EXPECT_TRUE(results[3].value() == large);
+}
+
+TEST_P(PipelineTest, EmptyAndCleared) {
+    client::Pipeline pipeline(*client_);
+    EXPECT_TRUE(pipeline.execute().empty());
+
+    pipeline.put("a", "1");
+    pipeline.clear();
+    EXPECT_TRUE(pipeline.execute().empty());
+    EXPECT_FALSE(client_->contains("a"));
+}
+
+TEST_P(PipelineTest, NotConnected) {
+    client::Pipeline pipeline(*client_);
+    pipeline.put("a", "1");
+    client_->disconnect();
+    EXPECT_THROW((void)pipeline.execute(), std::runtime_error);
+    EXPECT_TRUE(pipeline.empty());
+
+    client_->connect();
+    pipeline.get("a");
+    auto results = pipeline.execute();
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].value(), std::nullopt);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Protocols, PipelineTest,
+    ::testing::Combine(::testing::Bool(),
+                       ::testing::Values(server::ServerMode::ThreadPerConnection,
+                                         server::ServerMode::EventLoop)),
+    [](const ::testing::TestParamInfo<PipelineParam>& info) {
+        std::string name = std::get<0>(info.param) ? "Binary" : "Text";
+        return name + (std::get<1>(info.param) == server::ServerMode::EventLoop ? "EventLoop"
+                                                                                 : "Threads");
+    });
+
+// an error answers its own call only: the calls behind it still run (text: an empty value is a
+// malformed PUT)
+TEST(TextPipelineTest, ErrorDoesntStopTheBatch) {
+    core::Store store;
+    server::ServerOptions server_opts;
+    server_opts.port = 0;
+    server::Server server(store, server_opts);
+    server.start();
+    client::ClientOptions client_opts;
+    client_opts.port = server.port();
+    client::Client client(client_opts);
+    client.connect();
+
+    client::Pipeline pipeline(client);
+    pipeline.put("a", "").put("b", "2").get("b");
+    auto results = pipeline.execute();
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_FALSE(results[0].ok());
+    EXPECT_THROW(results[0].check(), std::runtime_error);
+    EXPECT_NO_THROW(results[1].check());
+    EXPECT_EQ(results[2].value(), "2");
+
+    client.disconnect();
+    server.stop();
+}
+
+}  // namespace kvstore::net::test
@@ -0,0 +1,237 @@
+#include "kvstore/net/server/protocol_handler.hpp"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kvstore/net/binary_protocol.hpp"
+#include "kvstore/net/text_protocol.hpp"
+
+namespace kvstore::net::test {
+
+// write_file_value must put the same bytes on the wire as write_response with the value copied
+class ServerProtocolHandlerTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets_), 0);
+        path_ = std::filesystem::temp_directory_path() / "protocol_handler_test.dat";
+        {
+            std::ofstream out(path_, std::ios::binary);
+            out << "xxhello worldyy";
+        }
+        file_fd_ = ::open(path_.c_str(), O_RDONLY);
+        ASSERT_GE(file_fd_, 0);
+    }
+
+    void TearDown() override {
+        ::close(sockets_[0]);
+        ::close(sockets_[1]);
+        ::close(file_fd_);
+        std::filesystem::remove(path_);
+    }
+
+    // everything written to the server end so far
+    std::string received() {
+        ::shutdown(sockets_[0], SHUT_WR);
+        std::string bytes;
+        char chunk[256];
+        ssize_t n = 0;
+        while ((n = ::recv(sockets_[1], chunk, sizeof(chunk), 0)) > 0) {
+            bytes.append(chunk, static_cast<std::size_t>(n));
+        }
+        return bytes;
+    }
+
+    int sockets_[2] = {-1, -1};
+    int file_fd_ = -1;
+    std::filesystem::path path_;
+};
+
+TEST_F(ServerProtocolHandlerTest, TextFileValue) {
+    server::TextProtocolHandler handler;
+    ASSERT_TRUE(handler.write_file_value(sockets_[0], file_fd_, 2, 11));
+    EXPECT_EQ(received(), TextProtocol::encode_response(Response::ok("hello world")));
+}
+
+TEST_F(ServerProtocolHandlerTest, BinaryFileValue) {
+    server::BinaryProtocolHandler handler;
+    ASSERT_TRUE(handler.write_file_value(sockets_[0], file_fd_, 2, 11));
+    auto expected = BinaryProtocol::encode_response(Response::ok("hello world"));
+    EXPECT_EQ(received(), std::string(expected.begin(), expected.end()));
+}
+
+// the file ended before size bytes (truncated by clear()) - the half sent response is an error
+TEST_F(ServerProtocolHandlerTest, ShortFileFails) {
+    server::TextProtocolHandler handler;
+    EXPECT_FALSE(handler.write_file_value(sockets_[0], file_fd_, 2, 100));
+}
+
+// blocking side, pipelined: every complete request of one read comes back at once, the partial
+// one waits for the rest
+TEST_F(ServerProtocolHandlerTest, ReadRequestsReturnsWholeBatch) {
+    server::TextProtocolHandler handler;
+    std::string batch = "PUT a 1\nGET a\nPI";
+    ASSERT_EQ(::send(sockets_[1], batch.data(), batch.size(), 0), batch.size());
+    auto requests = handler.read_requests(sockets_[0]);
+    ASSERT_EQ(requests.size(), 2);
+    EXPECT_EQ(requests[0].command, Command::Put);
+    EXPECT_EQ(requests[1].command, Command::Get);
+    EXPECT_EQ(handler.syscalls(), 1);
+
+    ASSERT_EQ(::send(sockets_[1], "NG\n", 3, 0), 3);
+    requests = handler.read_requests(sockets_[0]);
+    ASSERT_EQ(requests.size(), 1);
+    EXPECT_EQ(requests[0].command, Command::Ping);
+
+    ::shutdown(sockets_[1], SHUT_WR);
+    EXPECT_TRUE(handler.read_requests(sockets_[0]).empty());
+}
+
+// the requests ahead of a malformed one are still answered, the next read throws
+TEST_F(ServerProtocolHandlerTest, MalformedRequestAfterGoodOnes) {
+    server::BinaryProtocolHandler handler;
+    Request get;
+    get.command = Command::Get;
+    get.key = "k";
+    auto encoded = BinaryProtocol::encode_request(get);
+    std::string batch(encoded.begin(), encoded.end());
+    batch += std::string(4, '\0');  // length 0: "Empty message"
+    ASSERT_EQ(::send(sockets_[1], batch.data(), batch.size(), 0), batch.size());
+
+    auto requests = handler.read_requests(sockets_[0]);
+    ASSERT_EQ(requests.size(), 1);
+    EXPECT_EQ(requests[0].key, "k");
+    EXPECT_THROW((void)handler.read_requests(sockets_[0]), std::runtime_error);
+}
+
+// a request larger than the read buffer grows it, the requests of one read stay valid together
+TEST_F(ServerProtocolHandlerTest, ReadRequestsLargerThanTheBuffer) {
+    server::BinaryProtocolHandler handler;
+    Request put;
+    put.command = Command::Put;
+    put.key = "big";
+    put.value = std::string(300 * 1024, 'v');
+    Request get;
+    get.command = Command::Get;
+    get.key = "big";
+    auto encoded = BinaryProtocol::encode_request(put);
+    auto encoded_get = BinaryProtocol::encode_request(get);
+    std::string batch(encoded.begin(), encoded.end());
+    batch.append(encoded_get.begin(), encoded_get.end());
+
+    std::thread writer([&] {
+        std::size_t sent = 0;
+        while (sent < batch.size()) {
+            ssize_t n = ::send(sockets_[1], batch.data() + sent, batch.size() - sent, 0);
+            ASSERT_GT(n, 0);
+            sent += static_cast<std::size_t>(n);
+        }
+    });
+    std::vector<RequestView> requests;
+    while (requests.size() < 2) {
+        auto batch_requests = handler.read_requests(sockets_[0]);
+        ASSERT_FALSE(batch_requests.empty());
+        for (const RequestView& request : batch_requests) {
+            // checked before the next read_requests call invalidates them
+            if (request.command == Command::Put) {
+                EXPECT_EQ(request.value, put.value);
+            } else {
+                EXPECT_EQ(request.key, "big");
+            }
+            requests.push_back(request);
+        }
+    }
+    writer.join();
+    EXPECT_EQ(requests[0].command, Command::Put);
+    EXPECT_EQ(requests[1].command, Command::Get);
+}
+
+// queued responses, a file value among them, leave in order with one send before the sendfile
+// and one after
+TEST_F(ServerProtocolHandlerTest, QueuedResponsesFlushTogether) {
+    server::TextProtocolHandler handler;
+    handler.queue_response(Response::ok());
+    handler.queue_response(Response::not_found());
+    EXPECT_EQ(handler.syscalls(), 0);
+    ASSERT_TRUE(handler.queue_file_value(sockets_[0], file_fd_, 2, 11));
+    handler.queue_response(Response::ok("v"));
+    ASSERT_TRUE(handler.flush(sockets_[0]));
+    EXPECT_EQ(handler.syscalls(), 3);
+    EXPECT_EQ(handler.queued(), 0);
+    EXPECT_EQ(received(), TextProtocol::encode_response(Response::ok()) +
+                              TextProtocol::encode_response(Response::not_found()) +
+                              TextProtocol::encode_response(Response::ok("hello world")) +
+                              TextProtocol::encode_response(Response::ok("v")));
+}
+
+// the buffer side the event loop uses: parse from whatever arrived so far
+TEST(ServerProtocolParseTest, TextParsesCompleteLinesOnly) {
+    server::TextProtocolHandler handler;
+    std::size_t consumed = 0;
+    EXPECT_FALSE(handler.parse_request("PUT foo b", consumed).has_value());
+
+    std::string data = "PUT foo bar\r\nGET foo\nGE";
+    auto first = handler.parse_request(data, consumed);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->command, Command::Put);
+    EXPECT_EQ(first->value, "bar");
+    EXPECT_EQ(consumed, 13);
+
+    auto second = handler.parse_request(std::string_view(data).substr(13), consumed);
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(second->command, Command::Get);
+    EXPECT_EQ(second->key, "foo");
+    EXPECT_EQ(consumed, 8);
+    EXPECT_FALSE(handler.parse_request(std::string_view(data).substr(21), consumed));
+}
+
+TEST(ServerProtocolParseTest, BinaryParsesCompleteMessagesOnly) {
+    server::BinaryProtocolHandler handler;
+    Request put;
+    put.command = Command::Put;
+    put.key = "foo";
+    put.value = "bar";
+    auto encoded = BinaryProtocol::encode_request(put);
+    std::string data(encoded.begin(), encoded.end());
+
+    std::size_t consumed = 0;
+    EXPECT_FALSE(handler.parse_request(std::string_view(data).substr(0, data.size() - 1),
+                                       consumed));
+    std::string twice = data + data;
+    auto request = handler.parse_request(twice, consumed);
+    ASSERT_TRUE(request.has_value());
+    EXPECT_EQ(request->key, "foo");
+    EXPECT_EQ(request->value, "bar");
+    EXPECT_EQ(consumed, data.size());
+    // no copies: key and value are the bytes in the buffer
+    EXPECT_EQ(request->key.data(), twice.data() + 9);
+    EXPECT_EQ(request->value.data(), twice.data() + 16);
+}
+
+// append_response + file_value_framing produce what the blocking write_* calls send
+TEST(ServerProtocolParseTest, AppendMatchesEncode) {
+    server::TextProtocolHandler text;
+    std::string out = "x";
+    text.append_response(out, Response::ok("v"));
+    EXPECT_EQ(out, "x" + TextProtocol::encode_response(Response::ok("v")));
+
+    server::BinaryProtocolHandler binary;
+    out.clear();
+    binary.append_response(out, Response::not_found());
+    auto expected = BinaryProtocol::encode_response(Response::not_found());
+    EXPECT_EQ(out, std::string(expected.begin(), expected.end()));
+
+    auto framing = binary.file_value_framing(11);
+    expected = BinaryProtocol::encode_response(Response::ok("hello world"));
+    EXPECT_EQ(framing.prefix + "hello world" + framing.suffix,
+              std::string(expected.begin(), expected.end()));
+}
+
+}  // namespace kvstore::net::test
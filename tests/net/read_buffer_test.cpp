@@ -0,0 +1,116 @@
+#include "kvstore/net/read_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace kvstore::net::test {
+
+// what a recv of bytes into the buffer does
+std::size_t fill(ReadBuffer& buffer, std::string_view bytes, std::size_t min_free = 1) {
+    auto space = buffer.prepare(min_free);
+    std::size_t n = std::min(space.size(), bytes.size());
+    std::memcpy(space.data(), bytes.data(), n);
+    buffer.commit(n);
+    return n;
+}
+
+TEST(ReadBufferTest, StartsWithoutMemory) {
+    ReadBuffer buffer;
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.capacity(), 0);
+    EXPECT_TRUE(buffer.data().empty());
+    EXPECT_EQ(buffer.prepare().size(), ReadBuffer::kDefaultBaseCapacity);
+}
+
+TEST(ReadBufferTest, ReadAndConsume) {
+    ReadBuffer buffer(64);
+    fill(buffer, "GET a\nGET b\n");
+    EXPECT_EQ(buffer.data(), "GET a\nGET b\n");
+    buffer.consume(6);
+    EXPECT_EQ(buffer.data(), "GET b\n");
+    EXPECT_EQ(buffer.size(), 6);
+    buffer.append("PI");
+    EXPECT_EQ(buffer.data(), "GET b\nPI");
+    buffer.consume(8);
+    EXPECT_TRUE(buffer.empty());
+}
+
+// consuming doesnt move anything: views into the buffer outlive it, up to the next prepare
+TEST(ReadBufferTest, ViewsSurviveConsume) {
+    ReadBuffer buffer(64);
+    fill(buffer, "first second");
+    std::string_view first = buffer.data().substr(0, 5);
+    std::string_view second = buffer.data().substr(6);
+    buffer.consume(buffer.size());
+    EXPECT_EQ(first, "first");
+    EXPECT_EQ(second, "second");
+}
+
+// the partial request at the back moves to the front once the space behind it runs out, the
+// buffer doesnt grow for it
+TEST(ReadBufferTest, CompactsInsteadOfGrowing) {
+    ReadBuffer buffer(16);
+    buffer.append("0123456789ab");
+    buffer.consume(10);
+    auto space = buffer.prepare(8);
+    EXPECT_EQ(buffer.capacity(), 16);
+    EXPECT_EQ(space.size(), 14);
+    EXPECT_EQ(buffer.data(), "ab");
+}
+
+// a request larger than the buffer grows it to fit, keeping the bytes
+TEST(ReadBufferTest, GrowsForLargeRequests) {
+    ReadBuffer buffer(16);
+    buffer.append("head");
+    std::string large(1000, 'x');
+    buffer.append(large);
+    EXPECT_GE(buffer.capacity(), 1004);
+    EXPECT_EQ(buffer.data(), "head" + large);
+}
+
+// reads that fill the space they got double it, a drained buffer shrinks back after a round of
+// small reads
+TEST(ReadBufferTest, AdaptsToTheReadSize) {
+    ReadBuffer buffer(1024);
+    std::string burst(64 * 1024, 'b');
+    std::size_t capacity = 0;
+    for (int i = 0; i < 4; ++i) {
+        capacity = buffer.prepare().size();
+        EXPECT_EQ(fill(buffer, burst), capacity);
+        buffer.consume(buffer.size());
+    }
+    EXPECT_EQ(buffer.capacity(), 8 * 1024);
+
+    // the first drain after the burst keeps the size (and the growth the last read asked for),
+    // the next one lets it go
+    fill(buffer, "GET a\n");
+    EXPECT_EQ(buffer.capacity(), 16 * 1024);
+    buffer.consume(buffer.size());
+    fill(buffer, "GET a\n");
+    buffer.consume(buffer.size());
+    (void)buffer.prepare();
+    EXPECT_EQ(buffer.capacity(), 1024);
+}
+
+TEST(ReadBufferTest, AdaptiveGrowthIsCapped) {
+    ReadBuffer buffer(ReadBuffer::kMaxAdaptiveCapacity / 2);
+    std::string burst(ReadBuffer::kMaxAdaptiveCapacity * 2, 'b');
+    for (int i = 0; i < 4; ++i) {
+        fill(buffer, burst);
+        buffer.consume(buffer.size());
+    }
+    EXPECT_EQ(buffer.capacity(), ReadBuffer::kMaxAdaptiveCapacity);
+}
+
+TEST(ReadBufferTest, Clear) {
+    ReadBuffer buffer(64);
+    buffer.append("partial");
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.prepare().size(), 64);
+}
+
+}  // namespace kvstore::net::test
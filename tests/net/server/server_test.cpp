@@ -6,14 +6,44 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "kvstore/core/disk_store.hpp"
 #include "kvstore/core/store.hpp"
+#include "kvstore/net/client/client.hpp"
+#include "kvstore/net/client/pipeline.hpp"
 
 namespace kvstore::net::test {
+
+// runs of pipelined GETs and PUTs (batched store calls) mixed with other requests that end a run:
+// the requests and the responses each test expects, in order
+struct MixedBatch {
+    std::string requests;
+    std::vector<std::string> responses;
+};
+
+MixedBatch mixed_batch() {
+    MixedBatch batch;
+    for (int i = 0; i < 100; ++i) {
+        batch.requests += "PUT key" + std::to_string(i) + " value" + std::to_string(i) + "\n";
+        batch.responses.emplace_back("OK");
+    }
+    batch.requests += "PUT key0 again\nGET key0\nGET missing\nGET key99\nDEL key1\nGET key1\n";
+    batch.responses.insert(batch.responses.end(),
+                           {"OK", "OK again", "NOT_FOUND", "OK value99", "OK", "NOT_FOUND"});
+    for (int i = 2; i < 100; ++i) {
+        batch.requests += "GET key" + std::to_string(i) + "\n";
+        batch.responses.emplace_back("OK value" + std::to_string(i));
+    }
+    batch.requests += "PUT key2 x\nPUT key2 y\nGET key2\nSIZE\n";
+    batch.responses.insert(batch.responses.end(), {"OK", "OK", "OK y", "OK 99"});
+    return batch;
+}
+
 class ServerTest : public ::testing::Test {
    protected:
     void SetUp() override {
@@ -83,6 +113,48 @@ class ServerTest : public ::testing::Test {
         return response;
     }
 
+    // sends batch in one go and reads response lines until the server closes the connection
+    // (or count lines arrived)
+    std::vector<std::string> pipeline(const std::string& batch, std::size_t count) {
+        std::vector<std::string> lines;
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(16379);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(sock);
+            return lines;
+        }
+        timeval tv{5, 0};
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        std::size_t sent = 0;
+        while (sent < batch.size()) {
+            ssize_t n = send(sock, batch.data() + sent, batch.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+        std::string buf;
+        char chunk[4096];
+        while (lines.size() < count) {
+            std::size_t pos = buf.find('\n');
+            if (pos != std::string::npos) {
+                lines.push_back(buf.substr(0, pos));
+                buf.erase(0, pos + 1);
+                continue;
+            }
+            ssize_t n = recv(sock, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                break;
+            }
+            buf.append(chunk, static_cast<std::size_t>(n));
+        }
+        close(sock);
+        return lines;
+    }
+
     // we use std::unique_ptr so we can control construction timing in Setup() - if plain members,
     // object would be constructed during fixture construction, before Setup(). also allows
     // tearDown() to destroy early if needed
@@ -174,6 +246,56 @@ TEST_F(ServerTest, SetEx) {
     EXPECT_EQ(send_command("GET foo"), "OK bar");
 }
 
+// a connection's requests and syscalls count once its thread is done - stop() waits for that
+TEST_F(ServerTest, Stats) {
+    server_->start();
+    EXPECT_EQ(send_command("PUT foo bar"), "OK");
+    EXPECT_EQ(send_command("GET foo"), "OK bar");
+    server_->stop();
+    auto stats = server_->stats();
+    EXPECT_EQ(stats.requests, 2);
+    // per connection at least the accept, the peek, a read and a write of the request, the close
+    EXPECT_GE(stats.syscalls, 10);
+}
+
+// everything a client pipelines is answered in order, a batch of responses with one send
+TEST_F(ServerTest, PipelinedRequests) {
+    server_->start();
+    std::string batch;
+    for (int i = 0; i < 500; ++i) {
+        batch += "PUT key" + std::to_string(i) + " value" + std::to_string(i) + "\n";
+        batch += "GET key" + std::to_string(i) + "\n";
+    }
+    auto lines = pipeline(batch, 1000);
+    ASSERT_EQ(lines.size(), 1000);
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(lines[static_cast<std::size_t>(2 * i)], "OK");
+        EXPECT_EQ(lines[static_cast<std::size_t>(2 * i + 1)], "OK value" + std::to_string(i));
+    }
+    server_->stop();
+    auto stats = server_->stats();
+    EXPECT_EQ(stats.requests, 1000);
+    // a recv and a send per batch the kernel delivered, not per request
+    EXPECT_LT(stats.syscalls, 200);
+}
+
+// nothing after a pipelined QUIT is answered, the BYE before it still goes out
+TEST_F(ServerTest, PipelinedQuit) {
+    server_->start();
+    auto lines = pipeline("PING\nQUIT\nPUT foo bar\n", 3);
+    EXPECT_EQ(lines, (std::vector<std::string>{"OK PONG", "BYE"}));
+    EXPECT_FALSE(store_->get("foo").has_value());
+}
+
+// runs of GETs and PUTs see each other's writes in request order
+TEST_F(ServerTest, BatchedRunsKeepOrder) {
+    server_->start();
+    MixedBatch batch = mixed_batch();
+    EXPECT_EQ(pipeline(batch.requests, batch.responses.size()), batch.responses);
+    server_->stop();
+    EXPECT_EQ(server_->stats().requests, batch.responses.size());
+}
+
 // DiskStore tests
 
 class ServerDiskStoreTest : public ::testing::Test {
@@ -299,4 +421,384 @@ TEST_F(ServerDiskStoreTest, PutExWithSpaces) {
     EXPECT_EQ(send_command("GET foo"), "OK hello world");
 }
 
+// values past sendfile_threshold skip the copy - the bytes on the wire must not change
+TEST_F(ServerDiskStoreTest, LargeValueFromFile) {
+    server_->start();
+    std::string large(100 * 1024, 'v');  // past the default 64KB sendfile_threshold
+    store_->put("large", large);
+    for (bool binary : {false, true}) {
+        client::ClientOptions opts;
+        opts.port = 16382;
+        opts.binary = binary;
+        client::Client client(opts);
+        client.connect();
+
+        EXPECT_EQ(client.get("large"), large);
+        client.put("small", "value");
+        EXPECT_EQ(client.get("small"), "value");
+        // the connection is still in sync after a sendfile response
+        EXPECT_EQ(client.get("large"), large);
+        EXPECT_FALSE(client.get("missing").has_value());
+    }
+}
+
+// a GET of a large value pipelined behind a PUT or DEL of the same key sees that write, not the
+// value still in the file
+TEST_F(ServerDiskStoreTest, LargeValueReadsPipelinedWrites) {
+    server_->start();
+    std::string large(100 * 1024, 'v');
+    for (bool binary : {false, true}) {
+        store_->put("k", large);
+        client::ClientOptions opts;
+        opts.port = 16382;
+        opts.binary = binary;
+        client::Client client(opts);
+        client.connect();
+
+        client::Pipeline pipeline(client);
+        pipeline.put("k", "small").get("k").put("k", large).get("k").remove("k").get("k");
+        auto results = pipeline.execute();
+        ASSERT_EQ(results.size(), 6);
+        EXPECT_EQ(results[1].value(), "small");
+        EXPECT_TRUE(results[3].value() == large);
+        EXPECT_EQ(results[5].value(), std::nullopt);
+    }
+}
+
+// event loop servers: same protocol, reactors instead of a thread per connection. every test runs
+// against the epoll loop and the io_uring one (which is the epoll loop again where the kernel has
+// no io_uring)
+
+class EventLoopServerTest : public ::testing::TestWithParam<server::ServerMode> {
+   protected:
+    static constexpr uint16_t kPort = 16383;
+
+    void SetUp() override {
+        test_dir_ = std::filesystem::temp_directory_path() / "event_loop_server_test";
+        std::filesystem::remove_all(test_dir_);
+        options_.port = kPort;
+        options_.mode = GetParam();
+        options_.reactor_threads = 2;
+    }
+
+    void TearDown() override {
+        for (int sock : sockets_) {
+            close(sock);
+        }
+        if (server_) {
+            server_->stop();
+        }
+        disk_store_.reset();
+        std::filesystem::remove_all(test_dir_);
+    }
+
+    void start(bool disk_store = false) {
+        if (disk_store) {
+            std::filesystem::create_directories(test_dir_);
+            core::DiskStoreOptions store_opts;
+            store_opts.data_dir = test_dir_;
+            disk_store_ = std::make_unique<core::DiskStore>(store_opts);
+            server_ = std::make_unique<server::Server>(*disk_store_, options_);
+        } else {
+            server_ = std::make_unique<server::Server>(store_, options_);
+        }
+        server_->start();
+    }
+
+    // connected raw socket, closed in TearDown. -1 if the connect failed
+    int open_socket() {
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(sock);
+            return -1;
+        }
+        timeval tv{5, 0};  // a hung server fails the test instead of hanging it
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sockets_.push_back(sock);
+        return sock;
+    }
+
+    static void send_raw(int sock, const std::string& data) {
+        std::size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            ASSERT_GT(n, 0);
+            sent += static_cast<std::size_t>(n);
+        }
+    }
+
+    // the next count response lines. fewer if the server closes the connection
+    static std::vector<std::string> read_lines(int sock, std::size_t count) {
+        std::vector<std::string> lines;
+        std::string buf;
+        char chunk[4096];
+        while (lines.size() < count) {
+            std::size_t pos = buf.find('\n');
+            if (pos != std::string::npos) {
+                lines.push_back(buf.substr(0, pos));
+                buf.erase(0, pos + 1);
+                continue;
+            }
+            ssize_t n = recv(sock, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                break;
+            }
+            buf.append(chunk, static_cast<std::size_t>(n));
+        }
+        return lines;
+    }
+
+    // true if the server closed the connection (EOF) within the receive timeout
+    static bool closed_by_server(int sock) {
+        char c;
+        return recv(sock, &c, 1, 0) == 0;
+    }
+
+    std::filesystem::path test_dir_;
+    server::ServerOptions options_;
+    core::Store store_;
+    std::unique_ptr<core::DiskStore> disk_store_;
+    std::unique_ptr<server::Server> server_;
+    std::vector<int> sockets_;
+};
+
+TEST_P(EventLoopServerTest, TextCommands) {
+    start();
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    send_raw(sock, "PING\n");
+    EXPECT_EQ(read_lines(sock, 1), std::vector<std::string>{"OK PONG"});
+    send_raw(sock, "PUT foo bar\r\n");
+    EXPECT_EQ(read_lines(sock, 1), std::vector<std::string>{"OK"});
+    send_raw(sock, "GET foo\n");
+    EXPECT_EQ(read_lines(sock, 1), std::vector<std::string>{"OK bar"});
+    send_raw(sock, "DEL foo\nGET foo\nSIZE\n");
+    EXPECT_EQ(read_lines(sock, 3), (std::vector<std::string>{"OK", "NOT_FOUND", "OK 0"}));
+}
+
+TEST_P(EventLoopServerTest, BinaryClient) {
+    start();
+    client::ClientOptions opts;
+    opts.port = kPort;
+    opts.binary = true;
+    client::Client client(opts);
+    client.connect();
+    EXPECT_TRUE(client.ping());
+    client.put("key", "value");
+    EXPECT_EQ(client.get("key"), "value");
+    EXPECT_TRUE(client.contains("key"));
+    EXPECT_EQ(client.size(), 1);
+    EXPECT_TRUE(client.remove("key"));
+    EXPECT_FALSE(client.get("key").has_value());
+}
+
+// every request of one write is answered, in order
+TEST_P(EventLoopServerTest, PipelinedRequests) {
+    start();
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    std::string batch;
+    for (int i = 0; i < 500; ++i) {
+        batch += "PUT key" + std::to_string(i) + " value" + std::to_string(i) + "\n";
+        batch += "GET key" + std::to_string(i) + "\n";
+    }
+    send_raw(sock, batch);
+    auto lines = read_lines(sock, 1000);
+    ASSERT_EQ(lines.size(), 1000);
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(lines[static_cast<std::size_t>(2 * i)], "OK");
+        EXPECT_EQ(lines[static_cast<std::size_t>(2 * i + 1)], "OK value" + std::to_string(i));
+    }
+}
+
+// a request split over many reads is buffered until it is complete
+TEST_P(EventLoopServerTest, RequestSplitAcrossReads) {
+    start();
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    for (char c : std::string("PUT split value\nGET split\n")) {
+        send_raw(sock, std::string(1, c));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(read_lines(sock, 2), (std::vector<std::string>{"OK", "OK value"}));
+}
+
+// responses the client doesnt read yet back up in the server, which stops reading and picks up
+// again once the client drains them
+TEST_P(EventLoopServerTest, SlowReaderGetsEveryResponse) {
+    start();
+    store_.put("big", std::string(64 * 1024, 'x'));
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    std::string batch;
+    for (int i = 0; i < 200; ++i) {
+        batch += "GET big\n";
+    }
+    // ~13MB of responses, far past the socket buffers and the server's output limit
+    std::thread writer([&] { send_raw(sock, batch); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto lines = read_lines(sock, 200);
+    writer.join();
+    ASSERT_EQ(lines.size(), 200);
+    EXPECT_EQ(lines.back(), "OK " + std::string(64 * 1024, 'x'));
+}
+
+TEST_P(EventLoopServerTest, QuitClosesConnection) {
+    start();
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    send_raw(sock, "PING\nQUIT\nPING\n");
+    auto lines = read_lines(sock, 3);
+    ASSERT_EQ(lines.size(), 2);  // nothing after QUIT
+    EXPECT_EQ(lines[0], "OK PONG");
+    EXPECT_TRUE(closed_by_server(sock));
+}
+
+TEST_P(EventLoopServerTest, ManyConnections) {
+    start();
+    std::vector<int> socks;
+    for (int i = 0; i < 300; ++i) {
+        int sock = open_socket();
+        ASSERT_GE(sock, 0);
+        socks.push_back(sock);
+    }
+    for (std::size_t i = 0; i < socks.size(); ++i) {
+        send_raw(socks[i], "PUT conn" + std::to_string(i) + " " + std::to_string(i) + "\n");
+    }
+    for (std::size_t i = 0; i < socks.size(); ++i) {
+        EXPECT_EQ(read_lines(socks[i], 1), std::vector<std::string>{"OK"});
+    }
+    EXPECT_EQ(store_.size(), 300);
+}
+
+// over max_connections a new connection is closed, the ones already open keep working
+TEST_P(EventLoopServerTest, MaxConnections) {
+    options_.max_connections = 2;
+    start();
+    int first = open_socket();
+    int second = open_socket();
+    ASSERT_GE(first, 0);
+    ASSERT_GE(second, 0);
+    send_raw(first, "PING\n");
+    send_raw(second, "PING\n");
+    EXPECT_EQ(read_lines(first, 1), std::vector<std::string>{"OK PONG"});
+    EXPECT_EQ(read_lines(second, 1), std::vector<std::string>{"OK PONG"});
+
+    int third = open_socket();
+    ASSERT_GE(third, 0);  // the kernel completes the handshake before the server sees it
+    EXPECT_TRUE(closed_by_server(third));
+
+    // a slot frees up once a connection goes away
+    send_raw(first, "QUIT\n");
+    EXPECT_EQ(read_lines(first, 1), std::vector<std::string>{"BYE"});
+    EXPECT_TRUE(closed_by_server(first));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int fourth = open_socket();
+    ASSERT_GE(fourth, 0);
+    send_raw(fourth, "PING\n");
+    EXPECT_EQ(read_lines(fourth, 1), std::vector<std::string>{"OK PONG"});
+}
+
+TEST_P(EventLoopServerTest, IdleConnectionsTimeOut) {
+    options_.client_timeout_seconds = 1;
+    start();
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    send_raw(sock, "PING\n");
+    EXPECT_EQ(read_lines(sock, 1), std::vector<std::string>{"OK PONG"});
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_TRUE(closed_by_server(sock));
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(4));
+}
+
+TEST_P(EventLoopServerTest, LargeValueFromFile) {
+    start(true);
+    std::string large(100 * 1024, 'v');  // past the default 64KB sendfile_threshold
+    disk_store_->put("large", large);
+    for (bool binary : {false, true}) {
+        client::ClientOptions opts;
+        opts.port = kPort;
+        opts.binary = binary;
+        client::Client client(opts);
+        client.connect();
+
+        EXPECT_EQ(client.get("large"), large);
+        client.put("small", "value");
+        EXPECT_EQ(client.get("small"), "value");
+        EXPECT_EQ(client.get("large"), large);
+    }
+
+    // pipelined around a sendfile response: the framing stays in order
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    send_raw(sock, "GET small\nGET large\nGET small\n");
+    EXPECT_EQ(read_lines(sock, 3),
+              (std::vector<std::string>{"OK value", "OK " + large, "OK value"}));
+}
+
+// a GET of a large value pipelined behind a PUT or DEL of the same key sees that write, not the
+// value still in the file
+TEST_P(EventLoopServerTest, LargeValueReadsPipelinedWrites) {
+    start(true);
+    std::string large(100 * 1024, 'v');
+    disk_store_->put("k", large);
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    send_raw(sock, "PUT k small\nGET k\nPUT k " + large + "\nGET k\nDEL k\nGET k\n");
+    EXPECT_EQ(read_lines(sock, 6), (std::vector<std::string>{"OK", "OK small", "OK",
+                                                             "OK " + large, "OK", "NOT_FOUND"}));
+}
+
+// runs of GETs and PUTs see each other's writes in request order, on both stores
+TEST_P(EventLoopServerTest, BatchedRunsKeepOrder) {
+    for (bool disk_store : {false, true}) {
+        SCOPED_TRACE(disk_store ? "DiskStore" : "Store");
+        start(disk_store);
+        int sock = open_socket();
+        ASSERT_GE(sock, 0);
+        MixedBatch batch = mixed_batch();
+        send_raw(sock, batch.requests);
+        EXPECT_EQ(read_lines(sock, batch.responses.size()), batch.responses);
+        server_->stop();
+        EXPECT_EQ(server_->stats().requests, batch.responses.size());
+        server_.reset();
+    }
+}
+
+TEST_P(EventLoopServerTest, StopClosesConnections) {
+    start();
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    send_raw(sock, "PING\n");
+    EXPECT_EQ(read_lines(sock, 1), std::vector<std::string>{"OK PONG"});
+    server_->stop();
+    EXPECT_FALSE(server_->running());
+    EXPECT_TRUE(closed_by_server(sock));
+}
+
+// every request is counted, and so is every syscall it took
+TEST_P(EventLoopServerTest, Stats) {
+    start();
+    int sock = open_socket();
+    ASSERT_GE(sock, 0);
+    send_raw(sock, "PUT a 1\nGET a\nPING\n");
+    EXPECT_EQ(read_lines(sock, 3), (std::vector<std::string>{"OK", "OK 1", "OK PONG"}));
+    server_->stop();
+    auto stats = server_->stats();
+    EXPECT_EQ(stats.requests, 3);
+    EXPECT_GT(stats.syscalls, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, EventLoopServerTest,
+                         ::testing::Values(server::ServerMode::EventLoop,
+                                           server::ServerMode::IoUring),
+                         [](const ::testing::TestParamInfo<server::ServerMode>& info) {
+                             return info.param == server::ServerMode::IoUring ? "IoUring"
+                                                                              : "EventLoop";
+                         });
+
 }  // namespace kvstore::net::test
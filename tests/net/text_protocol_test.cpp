@@ -2,6 +2,34 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+
+// every operator new of this test binary, counted - DecodeRequestViewDoesntAllocate checks that
+// none happen while it decodes
+namespace {
+std::atomic<uint64_t> allocations{0};
+}  // namespace
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
 namespace kvstore::net::test {
 
 TEST(TextProtocolTest, EncodeRequestGet) {
@@ -19,6 +47,24 @@ TEST(TextProtocolTest, EncodeRequestPutEx) {
     EXPECT_EQ(TextProtocol::encode_request(req), "PUTEX mykey 5000 myvalue\n");
 }
 
+// the gathered encoding: the same line as encode_request, with key and value not copied
+TEST(TextProtocolTest, EncodeRequestPieces) {
+    const std::string key = "mykey";
+    const std::string value = "my value";
+    EncodedRequest encoded;
+    TextProtocol::encode_request(RequestView{Command::PutEx, key, value, -42}, encoded);
+    EXPECT_EQ(encoded.join(), "PUTEX mykey -42 my value\n");
+    EXPECT_EQ(encoded.pieces[2].data(), key.data());
+    EXPECT_EQ(encoded.pieces[4].data(), value.data());
+
+    TextProtocol::encode_request(RequestView{Command::Put, key, value, 0}, encoded);
+    EXPECT_EQ(encoded.join(), "PUT mykey my value\n");
+    TextProtocol::encode_request(RequestView{Command::Exists, key, {}, 0}, encoded);
+    EXPECT_EQ(encoded.join(), "EXISTS mykey\n");
+    TextProtocol::encode_request(RequestView{Command::Size, {}, {}, 0}, encoded);
+    EXPECT_EQ(encoded.join(), "SIZE\n");
+}
+
 TEST(TextProtocolTest, EncodeRequestPing) {
     Request req{Command::Ping, "", "", 0};
     EXPECT_EQ(TextProtocol::encode_request(req), "PING\n");
@@ -141,6 +187,66 @@ TEST(TextProtocolTest, DecodeRequestEmpty) {
     EXPECT_EQ(req.command, Command::Unknown);
 }
 
+// key and value are the bytes of the line, nothing is copied
+TEST(TextProtocolTest, DecodeRequestView) {
+    std::string line = "PUTEX mykey 5000 hello world";
+    auto req = TextProtocol::decode_request_view(line);
+    EXPECT_EQ(req.command, Command::PutEx);
+    EXPECT_EQ(req.key, "mykey");
+    EXPECT_EQ(req.ttl_ms, 5000);
+    EXPECT_EQ(req.value, "hello world");
+    EXPECT_EQ(req.key.data(), line.data() + 6);
+    EXPECT_EQ(req.value.data(), line.data() + 17);
+}
+
+TEST(TextProtocolTest, DecodeRequestViewDoesntAllocate) {
+    // long enough that a copy couldnt hide in a small string buffer
+    std::string key(64, 'k');
+    std::string value(256, 'v');
+    std::string get = "GET " + key;
+    std::string put = "PUT " + key + " " + value;
+    std::string del = "delete " + key;
+
+    uint64_t before = allocations.load();
+    auto get_req = TextProtocol::decode_request_view(get);
+    auto put_req = TextProtocol::decode_request_view(put);
+    auto del_req = TextProtocol::decode_request_view(del);
+    EXPECT_EQ(allocations.load(), before);
+
+    EXPECT_EQ(get_req.command, Command::Get);
+    EXPECT_EQ(put_req.value, value);
+    EXPECT_EQ(del_req.command, Command::Del);
+    EXPECT_EQ(del_req.key, key);
+
+    // the counting works: the copying decode_request is seen
+    Request copy = TextProtocol::decode_request(put);
+    EXPECT_GT(allocations.load(), before);
+}
+
+// the value keeps its inner spacing, the whitespace around words and at the ends doesnt count
+TEST(TextProtocolTest, DecodeRequestWhitespace) {
+    auto req = TextProtocol::decode_request("  put\tmykey   hello   world \r");
+    EXPECT_EQ(req.command, Command::Put);
+    EXPECT_EQ(req.key, "mykey");
+    EXPECT_EQ(req.value, "hello   world");
+
+    req = TextProtocol::decode_request("GET mykey extra words");
+    EXPECT_EQ(req.command, Command::Get);
+    EXPECT_EQ(req.key, "mykey");
+
+    EXPECT_EQ(TextProtocol::decode_request("PUT mykey   ").command, Command::Unknown);
+}
+
+// the whole ttl word has to be a number that fits
+TEST(TextProtocolTest, DecodeRequestPutExStrictTTL) {
+    EXPECT_EQ(TextProtocol::decode_request("PUTEX k 100ms v").command, Command::Unknown);
+    EXPECT_EQ(TextProtocol::decode_request("PUTEX k 99999999999999999999 v").command,
+              Command::Unknown);
+    auto req = TextProtocol::decode_request("PUTEX k -5 v");
+    EXPECT_EQ(req.command, Command::PutEx);
+    EXPECT_EQ(req.ttl_ms, -5);
+}
+
 TEST(TextProtocolTest, DecodeResponseOk) {
     auto resp = TextProtocol::decode_response("OK");
     EXPECT_EQ(resp.status, Status::Ok);
@@ -191,4 +297,38 @@ TEST(TextProtocolTest, ParseCommand) {
     EXPECT_EQ(TextProtocol::parse_command("INVALID"), Command::Unknown);
 }
 
+// every command and alias in any case, and nothing that only shares a length and first letter
+TEST(TextProtocolTest, ParseCommandEveryName) {
+    const std::pair<std::string, Command> names[] = {
+        {"GET", Command::Get},
+        {"PUT", Command::Put},
+        {"SET", Command::Put},
+        {"PUTEX", Command::PutEx},
+        {"SETEX", Command::PutEx},
+        {"DEL", Command::Del},
+        {"DELETE", Command::Del},
+        {"REMOVE", Command::Del},
+        {"EXISTS", Command::Exists},
+        {"CONTAINS", Command::Exists},
+        {"SIZE", Command::Size},
+        {"COUNT", Command::Size},
+        {"CLEAR", Command::Clear},
+        {"PING", Command::Ping},
+        {"QUIT", Command::Quit},
+        {"EXIT", Command::Quit},
+    };
+    for (const auto& [name, command] : names) {
+        std::string lower = name;
+        for (char& c : lower) {
+            c = static_cast<char>(c | 0x20);
+        }
+        EXPECT_EQ(TextProtocol::parse_command(name), command) << name;
+        EXPECT_EQ(TextProtocol::parse_command(lower), command) << lower;
+    }
+    for (const char* other : {"GOT", "PUX", "SIZ", "PINGS", "CLEAN", "DELETES", "EXIST", "G",
+                              "G\x05T", "QU1T", "CONTAINZ"}) {
+        EXPECT_EQ(TextProtocol::parse_command(other), Command::Unknown) << other;
+    }
+}
+
 }  // namespace kvstore::net::test
\ No newline at end of file
@@ -26,9 +26,24 @@ TEST_F(ConfigTest, DefaultValues) {
     EXPECT_EQ(config.host, "127.0.0.1");
     EXPECT_EQ(config.port, 6379);
     EXPECT_EQ(config.max_connections, 1000);
+    EXPECT_FALSE(config.event_loop);
+    EXPECT_EQ(config.reactor_threads, 0);
+    EXPECT_FALSE(config.io_uring);
     EXPECT_EQ(config.data_dir, "./data");
     EXPECT_EQ(config.log_level, LogLevel::Info);
     EXPECT_FALSE(config.use_disk_store);
+    EXPECT_FALSE(config.use_lsm_store);
+    EXPECT_FALSE(config.use_btree_store);
+    EXPECT_FALSE(config.use_mmap_store);
+    EXPECT_FALSE(config.compact_index);
+    EXPECT_EQ(config.blob_threshold, 0);
+    EXPECT_FALSE(config.use_io_uring);
+    EXPECT_FALSE(config.direct_io);
+    EXPECT_EQ(config.block_cache_mb, 64);
+    EXPECT_EQ(config.value_cache_mb, 0);
+    EXPECT_FALSE(config.use_tiered_store);
+    EXPECT_EQ(config.hot_tier_mb, 64);
+    EXPECT_TRUE(config.ingest_dir.empty());
 }
 
 TEST_F(ConfigTest, LoadFile) {
@@ -37,16 +52,46 @@ TEST_F(ConfigTest, LoadFile) {
         std::ofstream f(path);
         f << "host = \"0.0.0.0\"\n";
         f << "port = 8080\n";
+        f << "event_loop = true\n";
+        f << "reactor_threads = 4\n";
+        f << "io_uring = true\n";
         f << "log_level = debug\n";
         f << "use_disk_store = true\n";
+        f << "use_lsm_store = true\n";
+        f << "use_btree_store = true\n";
+        f << "use_mmap_store = true\n";
+        f << "compact_index = true\n";
+        f << "blob_threshold = 4096\n";
+        f << "use_io_uring = true\n";
+        f << "direct_io = true\n";
+        f << "block_cache_mb = 256\n";
+        f << "value_cache_mb = 32\n";
+        f << "use_tiered_store = true\n";
+        f << "hot_tier_mb = 128\n";
+        f << "ingest_dir = /tmp/ingest\n";
     }
 
     auto config = Config::load_file(path);
     ASSERT_TRUE(config.has_value());
     EXPECT_EQ(config->host, "0.0.0.0");
     EXPECT_EQ(config->port, 8080);
+    EXPECT_TRUE(config->event_loop);
+    EXPECT_EQ(config->reactor_threads, 4);
+    EXPECT_TRUE(config->io_uring);
     EXPECT_EQ(config->log_level, LogLevel::Debug);
     EXPECT_TRUE(config->use_disk_store);
+    EXPECT_TRUE(config->use_lsm_store);
+    EXPECT_TRUE(config->use_btree_store);
+    EXPECT_TRUE(config->use_mmap_store);
+    EXPECT_TRUE(config->compact_index);
+    EXPECT_EQ(config->blob_threshold, 4096);
+    EXPECT_TRUE(config->use_io_uring);
+    EXPECT_TRUE(config->direct_io);
+    EXPECT_EQ(config->block_cache_mb, 256);
+    EXPECT_EQ(config->value_cache_mb, 32);
+    EXPECT_TRUE(config->use_tiered_store);
+    EXPECT_EQ(config->hot_tier_mb, 128);
+    EXPECT_EQ(config->ingest_dir, "/tmp/ingest");
 }
 
 TEST_F(ConfigTest, LoadFileWithComments) {
@@ -0,0 +1,75 @@
+#include "kvstore/util/crc32c.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+
+namespace kvstore::util::test {
+
+namespace {
+
+// one bit at a time, straight from the definition
+uint32_t reference_crc32c(std::string_view data) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (unsigned char c : data) {
+        crc ^= c;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) != 0 ? 0x82F63B78 : 0);
+        }
+    }
+    return ~crc;
+}
+
+}  // namespace
+
+// check values from RFC 3720 (iSCSI) appendix B.4
+TEST(Crc32cTest, KnownValues) {
+    EXPECT_EQ(crc32c(""), 0x00000000U);
+    EXPECT_EQ(crc32c("123456789"), 0xE3069283U);
+    EXPECT_EQ(crc32c(std::string(32, '\0')), 0x8A9136AAU);
+    EXPECT_EQ(crc32c(std::string(32, '\xFF')), 0x62A8AB43U);
+
+    std::string ascending;
+    for (int i = 0; i < 32; ++i) {
+        ascending += static_cast<char>(i);
+    }
+    EXPECT_EQ(crc32c(ascending), 0x46DD794EU);
+}
+
+// every length and alignment around the 8 byte steps
+TEST(Crc32cTest, MatchesReference) {
+    std::mt19937 rng(42);
+    std::string data(1100, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(rng());
+    }
+    for (std::size_t offset = 0; offset < 8; ++offset) {
+        for (std::size_t len = 0; len < 40; ++len) {
+            std::string_view piece(data.data() + offset, len);
+            ASSERT_EQ(crc32c(piece), reference_crc32c(piece)) << offset << " " << len;
+        }
+    }
+    EXPECT_EQ(crc32c(data), reference_crc32c(data));
+}
+
+TEST(Crc32cTest, Extend) {
+    std::string data = "hello, checksummed world";
+    for (std::size_t split = 0; split <= data.size(); ++split) {
+        std::string_view view(data);
+        EXPECT_EQ(crc32c_extend(crc32c(view.substr(0, split)), view.substr(split)), crc32c(data));
+    }
+}
+
+TEST(Crc32cTest, DetectsSingleBitFlips) {
+    std::string data(64, 'x');
+    uint32_t original = crc32c(data);
+    for (std::size_t bit = 0; bit < data.size() * 8; ++bit) {
+        data[bit / 8] = static_cast<char>(data[bit / 8] ^ (1 << (bit % 8)));
+        EXPECT_NE(crc32c(data), original);
+        data[bit / 8] = static_cast<char>(data[bit / 8] ^ (1 << (bit % 8)));
+    }
+}
+
+}  // namespace kvstore::util::test
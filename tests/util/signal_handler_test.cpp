@@ -50,4 +50,20 @@ TEST_F(SignalHandlerTest, HandlesSIGTERM) {
     EXPECT_TRUE(SignalHandler::should_shutdown());
 }
 
+TEST_F(SignalHandlerTest, HandlesSIGHUPAsReload) {
+    SignalEvent event = SignalEvent::Shutdown;
+    std::thread waiter([&event] { event = SignalHandler::wait_for_event(); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    raise(SIGHUP);
+
+    waiter.join();
+    EXPECT_EQ(event, SignalEvent::Reload);
+    EXPECT_FALSE(SignalHandler::should_shutdown());
+
+    // the reload was consumed - the next event is the shutdown
+    SignalHandler::request_shutdown();
+    EXPECT_EQ(SignalHandler::wait_for_event(), SignalEvent::Shutdown);
+}
+
 }  // namespace kvstore::util::test
\ No newline at end of file